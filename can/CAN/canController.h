@@ -66,9 +66,22 @@ struct WNCAN_Controller
     UINT                 *chnMode; /* current way a message buffer is configured */
     UCHAR                numChn;   /* number of available channels */
     void                 *csData;  /* pointer to chip-specific data */    
+    ULONG                regWindow;/* register window of this controller,
+                                      set by the board; 0 if not used */
 };
 
 
+/*
+   Interrupt causes.
+   A controller's GetIntStatus routine reads its interrupt status once and
+   returns the OR of every pending WNCAN_INT_xxx cause; the ISR must then
+   service each cause in the mask before returning, since the status is
+   typically cleared by the read. WNCAN_INT_PENDING tests the mask for one
+   cause; WNCAN_INT_SPURIOUS is not a mask and never matches.
+*/
+#define WNCAN_INT_PENDING(intStatus, cause) \
+    (((intStatus) != WNCAN_INT_SPURIOUS) && (((intStatus) & (cause)) != 0))
+
 /* function prototypes */
 STATUS WNCAN_Controller_establishLinks(struct WNCAN_Device *pDev, 
     WNCAN_ControllerType ctrlType);
@@ -99,4 +99,20 @@ int can_fifo_put(
 	icp_can_handle_t	handle, 
 	icp_can_msg_t		*msg);
 
+/******************************************************************************
+ * Get up to num messages from the FIFO.
+ *****************************************************************************/
+int can_fifo_get_n(
+	icp_can_handle_t	handle, 
+	icp_can_msg_t		*msgs,
+	unsigned int		num);
+
+/******************************************************************************
+ * Put up to num messages into the FIFO.
+ *****************************************************************************/
+int can_fifo_put_n(
+	icp_can_handle_t	handle, 
+	icp_can_msg_t		*msgs,
+	unsigned int		num);
+
 #endif /* __CAN_FIFO_H__ */
@@ -23,6 +23,9 @@ extern "C" {
 
 #define PR6120_CAN_MAX_CONTROLLERS (2)
 
+/* bound of the passes over the controllers per board interrupt */
+#define PR6120_CAN_ISR_PASS_MAX    (16)
+
 
 struct PR6120_CAN_ChannelData
 {
@@ -36,15 +39,39 @@ struct PR6120_CAN_DeviceEntry
     struct PR6120_CAN_ChannelData  chData[PR6120_CAN_MAX_CONTROLLERS];
     struct WNCAN_Controller         canControllerArray[PR6120_CAN_MAX_CONTROLLERS];
     struct WNCAN_Board              canBoard;
-    struct TxMsg                    txMsg[PR6120_CAN_MAX_CONTROLLERS];
+    struct SJA1000_ChipData         chipData[PR6120_CAN_MAX_CONTROLLERS];
     int                             bus;
     int                             dev;
     int                             func;
     BOOL                            inUse;
     BOOL                            allocated[PR6120_CAN_MAX_CONTROLLERS];
     BOOL                            intConnect;
+
+    /* controllers whose interrupt enable register is not zero, one bit 
+       per controller; kept by PR6120_CAN_canOutByte() */
+    UINT                            intEnabled;
+
+    /* optional board-level summary of the controllers requesting an 
+       interrupt, one bit per controller; 0 if the board has none */
+    UINT                          (*intPending)
+                                      (struct PR6120_CAN_DeviceEntry *);
+
+    /* interrupt statistics; the register reads are only counted when 
+       pr6120_can.c is built with PR6120_CAN_REG_STATS defined */
+    ULONG                           regReads;     /* all register reads */
+    ULONG                           isrCount;     /* board interrupts */
+    ULONG                           isrIdle;      /* ... with nothing to do */
+    ULONG                           isrPasses;    /* passes over controllers */
+    ULONG                           isrRegReads;  /* register reads in ISR */
 };
 
+/* device entry of the board a controller is on */
+#define PR6120_CAN_DE_GET(pDev) \
+    ((struct PR6120_CAN_DeviceEntry *) ((char *) (pDev)->pBrd - \
+        offsetof(struct PR6120_CAN_DeviceEntry, canBoard)))
+
+void PR6120_CAN_IntService(struct PR6120_CAN_DeviceEntry *pDE);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -24,6 +24,8 @@ in the windnet_can.h header file.
 #ifndef SJA1000_H_
 #define SJA1000_H_
 
+#include <wdLib.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -85,12 +87,15 @@ extern "C" {
 /* max number of message objects for sja1000 */
 #define SJA1000_MAX_MSG_OBJ 2
 
-/* sja1000 channel types */
-#define TX_CHN_NUM 0
-#define RX_CHN_NUM 1
+/* sja1000 channel numbers, see g_sja1000chnType */
+#define RX_CHN_NUM 0
+#define TX_CHN_NUM 1
 
 extern const UINT g_sja1000chnType[SJA1000_MAX_MSG_OBJ];
 
+/* frame info, up to 4 identifier and 8 data bytes, starting at SJA1000_SFF */
+#define SJA1000_FRAME_SIZE 13
+
 struct TxMsg
 {
     ULONG id;
@@ -100,8 +105,103 @@ struct TxMsg
     UCHAR data[8];
 };
 
+/* upper bound of frames handed to the ISR callback per RX interrupt */
+#define SJA1000_RX_DRAIN_MAX 32
+
+/* receive statistics, see SJA1000_RxStatsGet() */
+struct SJA1000_RxStats
+{
+    ULONG rxInts;      /* RX interrupts serviced */
+    ULONG rxFrames;    /* frames handed to the ISR callback */
+    ULONG rxMaxBurst;  /* most frames serviced by a single RX interrupt */
+    ULONG pollEnters;  /* switches from RX interrupts to polling */
+    ULONG pollExits;   /* switches from polling back to RX interrupts */
+    ULONG pollCycles;  /* poll cycles run */
+    ULONG pollFrames;  /* frames handed to the ISR callback by polling */
+};
+
+/* hybrid interrupt/polled receive state, see SJA1000_RxPollSet() */
+struct SJA1000_RxPoll
+{
+    UINT          enterInts;   /* RX interrupts per window that start
+                                  polling, 0 disables polling */
+    UINT          window;      /* window length in ticks */
+    UINT          budget;      /* frames serviced per poll cycle */
+    UINT          idleCycles;  /* empty cycles before RX interrupts resume */
+    volatile BOOL polling;     /* RI masked, poll cycles service RX */
+    UINT          windowInts;  /* RX interrupts in the current window */
+    ULONG         windowStart; /* tick the current window started */
+    UINT          idle;        /* poll cycles in a row without a frame */
+    WDOG_ID       wd;          /* runs the next poll cycle, NULL while
+                                  polling is disabled */
+};
+
+/* dual filter candidates kept while rules are added, see SJA1000_AcceptAdd() */
+#define SJA1000_ACCEPT_GROUPS      8
+
+/* one dual filter candidate: the upper 16 bits of the rule images */
+struct SJA1000_AcceptGroup
+{
+    USHORT code;     /* image bits that must match */
+    USHORT care;     /* bits of code that are compared */
+    BOOL   hasStd;   /* covers a standard frame rule */
+};
+
+/*
+   Acceptance filter under construction. Rules are mapped to the image of
+   the acceptance code register in single filter mode: a standard ID in
+   bits 31..21, an extended ID in bits 31..3.
+*/
+struct SJA1000_Accept
+{
+    UINT   numRules;   /* rules added, 0 = accept all frames */
+    UINT32 code;       /* single filter: image bits that must match */
+    UINT32 care;       /* single filter: bits of code that are compared */
+    UINT   numGroups;  /* dual filter candidates in group */
+    struct SJA1000_AcceptGroup group[SJA1000_ACCEPT_GROUPS + 1];
+};
+
+/* acceptance filter last programmed by SJA1000_AcceptSet() */
+struct SJA1000_AcceptRegs
+{
+    BOOL  valid;    /* registers below were programmed */
+    BOOL  dual;     /* dual filter mode, else single filter mode */
+    UCHAR acr[4];   /* acceptance code registers */
+    UCHAR amr[4];   /* acceptance mask registers, 1 = don't care */
+};
+
+/*
+   Chip-specific data of a SJA1000 controller, pointed to by csData.
+   The transmit message copy must remain the first member: csData is also
+   accessed as a struct TxMsg pointer.
+*/
+struct SJA1000_ChipData
+{
+    struct TxMsg           txMsg;
+    BOOL                   rxDrain;  /* drain the RX FIFO per interrupt */
+    struct SJA1000_RxStats rxStats;
+    struct SJA1000_RxPoll  rxPoll;
+    struct SJA1000_AcceptRegs accept;
+};
+
 void sja1000_registration(void);
 void sja1000ISR(ULONG context);
+void sja1000IntDispatch(struct WNCAN_Device *pDev, WNCAN_IntType intStatus);
+UINT sja1000RxService(struct WNCAN_Device *pDev, UCHAR chnNum);
+void SJA1000_RxDrainSet(struct WNCAN_Device *pDev, BOOL enable);
+STATUS SJA1000_RxPollSet(struct WNCAN_Device *pDev, UINT enterInts,
+                         UINT window, UINT budget, UINT idleCycles);
+void SJA1000_RxStatsGet(struct WNCAN_Device *pDev, 
+                        struct SJA1000_RxStats *pStats, BOOL clear);
+void SJA1000_AcceptInit(struct SJA1000_Accept *pAcc);
+void SJA1000_AcceptAdd(struct SJA1000_Accept *pAcc, ULONG id, ULONG mask,
+                       BOOL ext);
+STATUS SJA1000_AcceptSet(struct WNCAN_Device *pDev,
+                         struct SJA1000_Accept *pAcc);
+UCHAR SJA1000_ErrorCapture(struct WNCAN_Device *pDev, 
+                           WNCAN_BusError *pBusError);
+void SJA1000_ErrorCountGet(struct WNCAN_Device *pDev, UCHAR *pRxErr, 
+                           UCHAR *pTxErr);
 
 #ifdef __cplusplus
 }
@@ -69,7 +69,7 @@ typedef UINT WNCAN_BusError;
 
 typedef UINT WNCAN_BusStatus;
 
-/* Interrupt status */
+/* Interrupt status; GetIntStatus returns an OR of these causes */
 #define WNCAN_INT_NONE     0
 #define WNCAN_INT_ERROR    0x1
 #define WNCAN_INT_BUS_OFF  0x2
@@ -78,11 +78,47 @@ typedef UINT WNCAN_BusStatus;
 #define WNCAN_INT_RX       0x10
 #define WNCAN_INT_RTR_RESPONSE 0x20
 #define WNCAN_INT_TXCLR    0x40
+#define WNCAN_INT_BUS_STATE 0x80  /* error state changed, not to bus off */
+#define WNCAN_INT_TX_ABORTED 0x100 /* transmission aborted, frame not sent;
+                                     delivered before WNCAN_INT_TXCLR */
 #define WNCAN_INT_SPURIOUS 0xffffeeee
 #define WNCAN_INT_ALL      0xffffffff 
 
 typedef UINT WNCAN_IntType;
 
+/* bus-off recovery, see WNCAN_BusOffRecoverySet */
+#define WNCAN_BUSOFF_TX_KEEP    0   /* queued frames are sent after recovery */
+#define WNCAN_BUSOFF_TX_FLUSH   1   /* queued frames are discarded at bus off */
+
+#define WNCAN_BUSOFF_ON_BUS     0   /* no recovery in progress */
+#define WNCAN_BUSOFF_WAIT       1   /* back-off delay before the restart */
+#define WNCAN_BUSOFF_RECOVER    2   /* restarted, bus idle not yet seen */
+
+#define WNCAN_BUSOFF_RECESSIVE  (128 * 11) /* recessive bits before the 
+                                              controller is error active */
+#define WNCAN_BUSOFF_PRIORITY   50  /* recovery task */
+#define WNCAN_BUSOFF_STACK      4096
+
+typedef struct tagCANBusOffCfg
+{
+    BOOL  enable;       /* restart the controller after bus off */
+    UINT  minDelay;     /* ms before the first restart, not 0 */
+    UINT  maxDelay;     /* ms, bound of the doubled delay */
+    UINT  stableTime;   /* ms error active after which the next bus off 
+                           waits minDelay again */
+    UINT  txPolicy;     /* WNCAN_BUSOFF_TX_xxx */
+} WNCAN_BusOffCfg;
+
+typedef struct tagCANBusOffStats
+{
+    UINT  state;        /* WNCAN_BUSOFF_ON_BUS, _WAIT or _RECOVER */
+    UINT  backoff;      /* delays doubled for the next bus off */
+    UINT  delay;        /* ms waited before the last restart */
+    ULONG busOffs;      /* bus-off events */
+    ULONG restarts;     /* controller restarts */
+    ULONG recoveries;   /* returns to error active after a restart */
+} WNCAN_BusOffStats;
+
 
 /*Macro definitions to be used with filtering*/
 #define COMPARE_ALL_STD_IDS 0x7FF
@@ -161,6 +197,7 @@ typedef UINT WNCAN_IntType;
 
 struct WNCAN_Controller;
 struct WNCAN_Board;
+struct WNCAN_BusOffRecovery;
 
 typedef struct WNCAN_Device
 {
@@ -255,6 +292,7 @@ typedef struct WNCAN_Device
     struct WNCAN_Controller *pCtrl;
     struct WNCAN_Board      *pBrd;
     void                    *userData;          /* user data context pointer */
+    struct WNCAN_BusOffRecovery *pBusOff;       /* bus-off recovery, or NULL */
 	
 } WNCAN_DEVICE;
 
@@ -282,6 +320,13 @@ STATUS WNCAN_GetRTRResponderChannel(struct WNCAN_Device *pDev,UCHAR *chnNum);
 
 STATUS WNCAN_FreeChannel(struct WNCAN_Device *pDev,UCHAR chnNum);
 
+STATUS WNCAN_BusOffRecoverySet(struct WNCAN_Device *pDev, 
+                               WNCAN_BusOffCfg *pCfg);
+
+STATUS WNCAN_BusOffRecoveryGet(struct WNCAN_Device *pDev, 
+                               WNCAN_BusOffCfg *pCfg, 
+                               WNCAN_BusOffStats *pStats);
+
 const WNCAN_VersionInfo* WNCAN_GetVersion(void);
 
 void wncan_core_init(void);
@@ -320,6 +365,10 @@ functions set by the installation routine of the device driver. */
 
 #define CAN_FreeChannel(a,b)        WNCAN_FreeChannel(a,b)
 
+#define CAN_BusOffRecoverySet(a,b)  WNCAN_BusOffRecoverySet(a,b)
+
+#define CAN_BusOffRecoveryGet(a,b,c) WNCAN_BusOffRecoveryGet(a,b,c)
+
 #define CAN_GetVersion()           WNCAN_GetVersion()
 
 /* controller dependent function prototypes */
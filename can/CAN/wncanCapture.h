@@ -0,0 +1,120 @@
+/* wncanCapture.h - CAN bus capture and replay */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+
+This file contains the definitions of the binary capture file written by
+wncCaptureStart() and played back by wncCaptureReplay().
+
+A capture file is a WNCAN_CAPHDR followed by fixed size WNCAN_CAPREC
+records, one per received frame, in the byte order of the target that
+wrote it; a reader on another host recognizes swapped files by the magic
+number. Timestamps are the DevIO receive timestamps, in ticks of the
+frequency stored in the header. Frames the capture missed, because the
+DevIO input buffer or both capture buffers were full, are recorded as a
+single WNCAN_CAP_LOST record at the point they were lost.
+
+INCLUDE FILES
+
+  CAN/wncanDevIO.h
+*/
+
+#ifndef __INCwncanCaptureh
+#define __INCwncanCaptureh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vxWorks.h>
+#include <semLib.h>
+#include <CAN/wncanDevIO.h>
+
+#define WNCAN_CAP_MAGIC         0x57434150  /* "WCAP" */
+#define WNCAN_CAP_VERSION       1
+
+/* WNCAN_CAPREC flags */
+
+#define WNCAN_CAP_EXT           0x01    /* extended ID */
+#define WNCAN_CAP_RTR           0x02    /* remote frame */
+#define WNCAN_CAP_LOST          0x80    /* no frame, "id" frames were lost */
+
+#define WNCAN_CAP_RX_PRIORITY   60      /* priority of the reader task */
+#define WNCAN_CAP_WR_PRIORITY   200     /* priority of the file writer task */
+#define WNCAN_CAP_STACK_SIZE    8192
+#define WNCAN_CAP_DEF_RECS      4096    /* default records per buffer */
+
+typedef struct wncan_caphdr
+{
+    UINT32  magic;      /* WNCAN_CAP_MAGIC */
+    UINT16  version;    /* WNCAN_CAP_VERSION */
+    UINT16  recSize;    /* sizeof(WNCAN_CAPREC) */
+    UINT32  tsFreq;     /* timestamp ticks per second */
+    UINT32  reserved;
+} WNCAN_CAPHDR;
+
+typedef struct wncan_caprec
+{
+    UINT64  timeStamp;  /* receive time, ticks of WNCAN_CAPHDR.tsFreq */
+    UINT32  id;         /* CAN ID, or number of frames lost */
+    UCHAR   flags;      /* WNCAN_CAP_xxx */
+    UCHAR   len;        /* data length */
+    UCHAR   data[WNCAN_MAX_DATA_LEN];
+    UCHAR   pad[2];
+} WNCAN_CAPREC;
+
+typedef struct wncan_capture
+{
+    int            fdChn;       /* DevIO channel read from */
+    int            fdFile;      /* capture file */
+    int            rxTask;      /* reader task */
+    int            wrTask;      /* file writer task */
+    SEM_ID         fullSem;     /* a buffer was handed to the writer */
+    SEM_ID         doneSem;     /* a task has exited */
+    volatile BOOL  rxStop;      /* reader task to exit */
+    volatile BOOL  wrStop;      /* writer task to exit when idle */
+    UINT           bufRecs;     /* records per buffer */
+    WNCAN_CAPREC  *buf[2];      /* the double buffer */
+    UINT           count[2];    /* records held by each buffer */
+    volatile BOOL  busy[2];     /* buffer waits for, or is in, the writer */
+    UINT           fill;        /* buffer the reader fills */
+    UINT           drain;       /* buffer the writer writes next */
+    UINT32         nextSeq;     /* expected DevIO sequence number */
+    BOOL           seqValid;    /* nextSeq is known */
+    UINT64         lastStamp;   /* timestamp of the last frame */
+    ULONG          lostPending; /* lost frames not yet recorded */
+
+    /* statistics */
+    ULONG          frames;      /* frames recorded */
+    ULONG          lost;        /* frames lost by the DevIO input buffer */
+    ULONG          overruns;    /* frames lost, both buffers full */
+    ULONG          flushes;     /* buffers written */
+    ULONG          writeErrors; /* buffers the file did not take */
+} WNCAN_CAPTURE;
+
+typedef WNCAN_CAPTURE *WNCAN_CAPTURE_ID;
+
+#if defined(__STDC__)
+extern WNCAN_CAPTURE_ID wncCaptureStart(char *chnName, char *fileName,
+                                        UINT bufRecs);
+extern STATUS wncCaptureStop(WNCAN_CAPTURE_ID cap);
+extern void wncCaptureShow(WNCAN_CAPTURE_ID cap);
+extern STATUS wncCaptureReplay(char *fileName, char *chnName, BOOL timed);
+#else
+extern WNCAN_CAPTURE_ID wncCaptureStart();
+extern STATUS wncCaptureStop();
+extern void wncCaptureShow();
+extern STATUS wncCaptureReplay();
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCwncanCaptureh */
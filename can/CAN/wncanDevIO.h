@@ -44,6 +44,7 @@ extern "C" {
 #include <rngLib.h>
 #include <semLib.h>
 #include <selectLib.h>
+#include <wdLib.h>
 #include <string.h>
 #include <CAN/wnCAN.h>
 
@@ -93,6 +94,80 @@ extern "C" {
 #define WNCAN_REG_SET            (DEVIO_CANCMD_BASE + 20)
 #define WNCAN_REG_GET            (DEVIO_CANCMD_BASE + 21)
 
+/* Channel read and write format commands */
+
+#define WNCAN_CHNMSGFMT_SET      (DEVIO_CANCMD_BASE + 22)
+#define WNCAN_CHNMSGFMT_GET      (DEVIO_CANCMD_BASE + 23)
+
+/* Statistics commands */
+
+#define WNCAN_STATS_GET          (DEVIO_CANCMD_BASE + 24)
+#define WNCAN_STATS_CLEAR        (DEVIO_CANCMD_BASE + 25)
+
+/* 
+   Zero-copy receive commands, kernel tasks only 
+   WNCAN_CHNRING_GET returns the channel's input buffer, a WNCAN_MSGRING_ID 
+   (see CAN/wncanRing.h), which the ISR fills in place. The task reads the 
+   messages in place with wncRingPeekRun() and passes the number it has 
+   consumed to WNCAN_CHNRING_RELEASE. The buffer stays shared until the 
+   task hands it back with WNCAN_CHNRING_PUT, passing the WNCAN_MSGRING_ID, 
+   and must not touch it afterwards, or until close(); FIORBUFSET and 
+   WNCAN_CHNMSGFMT_SET fail in the meantime.
+*/
+
+#define WNCAN_CHNRING_GET        (DEVIO_CANCMD_BASE + 26)
+#define WNCAN_CHNRING_RELEASE    (DEVIO_CANCMD_BASE + 27)
+#define WNCAN_CHNRING_PUT        (DEVIO_CANCMD_BASE + 40)
+
+/* select() wakeup threshold commands */
+
+#define WNCAN_CHNWAKEUP_SET      (DEVIO_CANCMD_BASE + 28)
+#define WNCAN_CHNWAKEUP_GET      (DEVIO_CANCMD_BASE + 29)
+
+/* 
+   Software receive filter commands 
+   Any number of descriptors may open a channel for reading, but only one 
+   for writing. Each reader has its own input buffer and filter: with no 
+   filter rules it receives every frame, otherwise only the frames that 
+   match one of its WNCAN_FILTER rules 
+*/
+
+#define WNCAN_CHNFILTER_ADD      (DEVIO_CANCMD_BASE + 30)
+#define WNCAN_CHNFILTER_REMOVE   (DEVIO_CANCMD_BASE + 31)
+#define WNCAN_CHNFILTER_CLEAR    (DEVIO_CANCMD_BASE + 32)
+
+/* 
+   Transmit scheduling commands 
+   In WNCAN_TXSCHED_PRIO mode the channel sends the pending frame that 
+   would win bus arbitration first instead of the oldest one; frames with 
+   the same ID are still sent in the order they were written 
+*/
+
+#define WNCAN_CHNTXSCHED_SET     (DEVIO_CANCMD_BASE + 33)
+#define WNCAN_CHNTXSCHED_GET     (DEVIO_CANCMD_BASE + 34)
+
+/* 
+   Deferred receive commands, device only 
+   With a staging buffer set, the ISR only reads received frames out of 
+   the controller and stages them; a task of priority WNCAN_DEFER_PRIORITY 
+   runs the software filters and queues the frames to the readers. The 
+   ISR handler run times can be recorded in either mode, see WNCAN_ISRHIST
+*/
+
+#define WNCAN_RXDEFER_SET        (DEVIO_CANCMD_BASE + 35)
+#define WNCAN_RXDEFER_GET        (DEVIO_CANCMD_BASE + 36)
+#define WNCAN_ISRHIST_GET        (DEVIO_CANCMD_BASE + 37)
+
+/* 
+   Bus-off recovery commands, device only 
+   WNCAN_BUSOFF_SET takes a WNCAN_BusOffCfg and makes the driver restart 
+   the controller after each bus off, with a delay doubled on repeated bus 
+   offs; WNCAN_BUSOFF_GET returns the WNCAN_BusOffStats
+*/
+
+#define WNCAN_BUSOFF_SET         (DEVIO_CANCMD_BASE + 38)
+#define WNCAN_BUSOFF_GET         (DEVIO_CANCMD_BASE + 39)
+
 /* ==== CAN configuration access options ==== */
 
 /* 
@@ -118,6 +193,68 @@ extern "C" {
 #define WNCAN_CHNCFG_MODE         0x800    /* selects channel mode only */
 #define WNCAN_CHNCFG_ALL          0xF00    /* selects all elements */
 
+/* 
+   CAN channel read and write formats 
+   Used in format and txFormat fields of WNCAN_MSGFMT struct
+*/
+
+#define WNCAN_MSGFMT_STD          0        /* read() and write() use WNCAN_CHNMSG */
+#define WNCAN_MSGFMT_TS           1        /* read() returns WNCAN_CHNMSG_TS */
+#define WNCAN_MSGFMT_DL           2        /* write() takes WNCAN_CHNMSG_DL,
+                                              txFormat only */
+
+/* 
+   CAN software filter rules 
+   Used in type and frames fields of WNCAN_FILTER struct
+*/
+
+#define WNCAN_FILTER_ID           0        /* rule matches one ID */
+#define WNCAN_FILTER_MASK         1        /* rule matches an ID/mask range */
+
+#define WNCAN_FILTER_STD          0x1      /* rule applies to standard frames */
+#define WNCAN_FILTER_EXT          0x2      /* rule applies to extended frames */
+
+/* 
+   CAN channel transmit scheduling modes 
+   Used as argument of WNCAN_CHNTXSCHED_SET
+*/
+
+#define WNCAN_TXSCHED_FIFO        0        /* frames are sent in write order */
+#define WNCAN_TXSCHED_PRIO        1        /* lowest ID is sent first */
+
+/* 
+   Deferred receive task and ISR run time histogram 
+   Used by WNCAN_RXDEFER_SET and WNCAN_ISRHIST_GET
+*/
+
+#define WNCAN_DEFER_PRIORITY      45       /* deferred receive task */
+#define WNCAN_DEFER_STACK         4096
+#define WNCAN_ISRHIST_BINS        16       /* bins of WNCAN_ISRHIST */
+
+/* 
+   CAN controller events 
+   Used in type, state, flags and errDir fields of WNCAN_EVENT struct
+*/
+
+#define WNCAN_EVENT_BUF_SIZE      32       /* default #events queued by the
+                                              device descriptor */
+
+#define WNCAN_EVENT_ERROR         1        /* bus error */
+#define WNCAN_EVENT_STATE         2        /* error state changed */
+#define WNCAN_EVENT_WAKEUP        3        /* controller woke up */
+
+#define WNCAN_ERRSTATE_ACTIVE     0        /* error active */
+#define WNCAN_ERRSTATE_WARNING    1        /* error warning limit reached */
+#define WNCAN_ERRSTATE_PASSIVE    2        /* error passive */
+#define WNCAN_ERRSTATE_BUS_OFF    3        /* bus off */
+
+#define WNCAN_EVFLAG_COUNTERS     0x1      /* rxErrCnt and txErrCnt are valid */
+#define WNCAN_EVFLAG_CAPTURE      0x2      /* errCode, errDir and errSeg are 
+                                              valid */
+
+#define WNCAN_ERRDIR_TX           0        /* error while transmitting */
+#define WNCAN_ERRDIR_RX           1        /* error while receiving */
+
 
 /* ==== Structures used for setting/getting CAN configuration ==== */
 
@@ -237,6 +374,38 @@ typedef struct _wncan_ctlrconfig
 
     } flexcanData;
 
+        struct
+        {
+            BOOL  rxDrain;     /* drain the RX FIFO on every RX interrupt,
+                                  input for SET, output for GET */
+            ULONG rxInts;      /* RX interrupts serviced, GET only */
+            ULONG rxFrames;    /* frames received, GET only */
+            ULONG rxMaxBurst;  /* most frames per RX interrupt, GET only */
+
+            /* hybrid interrupt/polled receive, input for SET, output for
+               GET; see SJA1000_RxPollSet() */
+            UINT  rxPollInts;   /* RX interrupts per window that start
+                                   polling, 0 = never poll */
+            UINT  rxPollWindow; /* window length in ticks */
+            UINT  rxPollBudget; /* frames serviced per poll cycle */
+            UINT  rxPollIdle;   /* empty poll cycles before RX interrupts
+                                   resume */
+
+            BOOL  rxPolling;    /* RX is currently polled, GET only */
+            ULONG pollEnters;   /* switches to polling, GET only */
+            ULONG pollExits;    /* switches back to interrupts, GET only */
+            ULONG pollCycles;   /* poll cycles run, GET only */
+            ULONG pollFrames;   /* frames received by polling, GET only */
+
+            /* hardware acceptance filter derived from the software filters
+               of the open channels; see SJA1000_AcceptSet() */
+            BOOL  autoAccept;   /* compute the filter automatically, input
+                                   for SET, output for GET */
+            BOOL  accDual;      /* dual filter mode in use, GET only */
+            UCHAR acr[4];       /* acceptance code registers, GET only */
+            UCHAR amr[4];       /* acceptance mask registers, GET only */
+        } sja1000Data;
+
         /* Other controller-specific structs can be defined here */
         ULONG  dummy;  /* placeholder for future defs */
 
@@ -256,6 +425,160 @@ typedef struct _wncan_chnmsg
 }  WNCAN_CHNMSG;
 
 
+/* CAN message with receive timestamp, see WNCAN_MSGFMT_TS */
+
+typedef struct _wncan_chnmsg_ts
+{
+    WNCAN_CHNMSG msg;        /* CAN message */
+    UINT32       seqNum;     /* receive sequence number of the channel; a
+                                gap means frames were lost */
+    UINT64       timeStamp;  /* receive time in ticks of WNCAN_MSGFMT.tsFreq,
+                                taken in the receive interrupt */
+}  WNCAN_CHNMSG_TS;
+
+
+/* CAN message with transmit deadline, see WNCAN_MSGFMT_DL */
+
+typedef struct _wncan_chnmsg_dl
+{
+    WNCAN_CHNMSG msg;        /* CAN message */
+    UINT32       lifetime;   /* microseconds after write() by which the
+                                frame must be sent, 0 for no deadline; a
+                                frame that is late is dropped, or aborted
+                                if it is already in the controller */
+}  WNCAN_CHNMSG_DL;
+
+
+/* CAN channel read and write formats */
+
+typedef struct _wncan_msgfmt
+{
+    UINT   format;    /* WNCAN_MSGFMT_STD or WNCAN_MSGFMT_TS */
+    UINT32 tsFreq;    /* timestamp ticks per second, GET only */
+    UINT   txFormat;  /* WNCAN_MSGFMT_STD or WNCAN_MSGFMT_DL */
+}  WNCAN_MSGFMT;
+
+
+/* 
+   CAN channel select() wakeup thresholds and receive coalescing 
+   A task pending in select() is woken once, when the count reaches the 
+   threshold or the input buffer fills (output buffer empties); a reader is 
+   also woken when a queued message has waited rxMaxLatency microseconds, 
+   rounded up to whole system clock ticks
+*/
+
+typedef struct _wncan_wakeup
+{
+    UINT rxThreshold;  /* #msgs queued before a reader is woken, >= 1 */
+    UINT txThreshold;  /* #msgs of free space before a writer is woken, >= 1 */
+    UINT rxMaxLatency; /* usec before a reader is woken anyway, 0 = none */
+}  WNCAN_WAKEUP;
+
+
+/* 
+   CAN software filter rule 
+   A WNCAN_FILTER_MASK rule with a zero mask selects all standard and/or 
+   extended frames 
+*/
+
+typedef struct _wncan_filter
+{
+    UINT  type;    /* WNCAN_FILTER_ID or WNCAN_FILTER_MASK */
+    UINT  frames;  /* WNCAN_FILTER_STD and/or WNCAN_FILTER_EXT */
+    ULONG id;      /* CAN ID */
+    ULONG mask;    /* WNCAN_FILTER_MASK only: bits of id that must match */
+}  WNCAN_FILTER;
+
+
+/* 
+   DevIO statistics, maintained by the ISR handler 
+   Channel counters are per channel descriptor and read as zero on the 
+   device descriptor; controller counters are shared by all descriptors
+*/
+
+typedef struct _wncan_stats
+{
+    /* channel counters */
+    ULONG rxFrames;      /* frames received */
+    ULONG rxDropped;     /* frames dropped, input buffer full */
+    ULONG rxFiltered;    /* frames rejected by the software filter */
+    ULONG rxHighWater;   /* most messages held by the input buffer */
+    ULONG txFrames;      /* frames sent, counted on their TX interrupt */
+    ULONG txRetries;     /* transmissions deferred, controller busy */
+    ULONG txDropped;     /* frames dropped on a transmit error, an abort
+                            or a bus off */
+    ULONG txExpired;     /* frames dropped or aborted past their deadline */
+
+    /* controller counters */
+    ULONG busErrors;     /* bus error interrupts */
+    ULONG busErrBit;     /* bit errors */
+    ULONG busErrAck;     /* acknowledgement errors */
+    ULONG busErrCrc;     /* CRC errors */
+    ULONG busErrForm;    /* form errors */
+    ULONG busErrStuff;   /* stuff errors */
+    ULONG busOff;        /* bus-off events */
+}  WNCAN_STATS;
+
+
+/* deferred receive configuration, see WNCAN_RXDEFER_SET */
+
+typedef struct _wncan_rxdefer
+{
+    UINT   stageSize;     /* frames the staging buffer holds, 0 to queue 
+                             received frames in the ISR */
+    BOOL   isrHist;       /* record the ISR run time histogram */
+}  WNCAN_RXDEFER;
+
+/* 
+   ISR run time histogram, see WNCAN_ISRHIST_GET 
+   Bin 0 counts the runs shorter than binNs, each further bin the runs 
+   shorter than twice the bound of the previous one, the last bin the rest
+*/
+
+typedef struct _wncan_isrhist
+{
+    UINT32 binNs;         /* upper bound of bin 0, nanoseconds */
+    UINT32 count[WNCAN_ISRHIST_BINS];
+    UINT32 maxNs;         /* longest run */
+    ULONG  staged;        /* frames staged by the ISR */
+    ULONG  stageDropped;  /* frames dropped, staging buffer full */
+    ULONG  deferRuns;     /* deferred receive task runs */
+}  WNCAN_ISRHIST;
+
+/* 
+   CAN controller event, read from the device descriptor 
+   The ISR queues an event on each bus error, error state change and wake 
+   up; read() returns as many as fit, and select() reports the descriptor 
+   readable while any are queued. FIORBUFSET sets the number of events 
+   queued, and seqNum skips the events lost while the queue was full
+*/
+
+typedef struct _wncan_event
+{
+    UINT64 timeStamp;     /* ticks of WNCAN_MSGFMT.tsFreq */
+    UINT32 seqNum;        /* event number */
+    UINT32 busError;      /* WNCAN_ERR_xxx of a WNCAN_EVENT_ERROR */
+    UCHAR  type;          /* WNCAN_EVENT_xxx */
+    UCHAR  state;         /* WNCAN_ERRSTATE_xxx after the event */
+    UCHAR  flags;         /* WNCAN_EVFLAG_xxx */
+    UCHAR  errCode;       /* raw error code capture, controller specific */
+    UCHAR  errDir;        /* WNCAN_ERRDIR_xxx */
+    UCHAR  errSeg;        /* frame segment of the error, controller specific */
+    UCHAR  rxErrCnt;      /* receive error counter */
+    UCHAR  txErrCnt;      /* transmit error counter */
+}  WNCAN_EVENT;
+
+
+/* receive timestamp source, see wncDevIOTimestampSet() */
+
+typedef UINT64 (*WNCAN_TSFUNC)(void);
+
+/* receives one ID/mask pair of wncDevIOAcceptWalk(); a zero mask selects
+   every frame of the format */
+
+typedef void (*WNCAN_ACCEPTFUNC)(void *arg, ULONG id, ULONG mask, BOOL extId);
+
+
 
 /* ==== Internal Device I/O Structures (maybe move to private header file?) ==== */
 
@@ -267,9 +590,35 @@ typedef enum
 } WNCAN_FD_TYPE;
 
 
+/* output buffer record of a channel in the WNCAN_MSGFMT_DL write format */
+
+typedef struct _wncan_txmsg
+{
+    WNCAN_CHNMSG msg;        /* CAN message */
+    UINT64       deadline;   /* timestamp by which the frame must be sent,
+                                0 for no deadline */
+}  WNCAN_TXMSG;
+
+
+/* staging buffer record of a device in deferred receive mode */
+
+typedef struct _wncan_stagemsg
+{
+    WNCAN_CHNMSG msg;        /* CAN message */
+    UINT64       timeStamp;  /* receive time, if a reader wants it */
+    UCHAR        chnNum;     /* channel the frame was received on */
+}  WNCAN_STAGEMSG;
+
+
 typedef STATUS (*CTRLRCONFIGFNTYPE)(void*, void*);
+typedef STATUS (*CTRLRACCEPTFNTYPE)(void*);
+typedef void (*CTRLREVENTFNTYPE)(void*, void*);
+
+struct wncan_msgring;  /* CAN message ring, see CAN/wncanRing.h */
+struct wncan_rxfilter; /* software receive filter, see CAN/wncanFilter.h */
+struct wncan_txqueue;  /* priority transmit queue, see CAN/wncanTxQueue.h */
 
-typedef struct  /* DevIO driver information */
+typedef struct _wncan_devio_drvinfo  /* DevIO driver information */
 {
     DEV_HDR           devHdr;         /* standard I/O System device header */
     WNCAN_BoardType   boardType;      /* CAN board type */
@@ -283,6 +632,13 @@ typedef struct  /* DevIO driver information */
 
     CTRLRCONFIGFNTYPE ctrlSetConfig;  /* controller-specific functions */
     CTRLRCONFIGFNTYPE ctrlGetConfig;  
+    CTRLRACCEPTFNTYPE ctrlAcceptUpdate; /* recompute the hardware acceptance
+                                           filter, NULL if not automatic */
+    CTRLREVENTFNTYPE  ctrlEventGet;   /* fill in the error counters and error
+                                         capture of a WNCAN_EVENT from the
+                                         ISR, NULL if not available */
+
+    struct _wncan_devio_drvinfo *next;  /* next created device */
 
 } WNCAN_DEVIO_DRVINFO;
 
@@ -293,12 +649,38 @@ typedef struct _devio_fdinfo           /* DevIO file descriptor table info */
     WNCAN_FD_TYPE        devType;     /* indicates which type of data stored here,
                                           device or channel */
     SEL_WAKEUP_LIST      selWakeupList; /* wakeup select list */
+    WNCAN_STATS          stats;       /* counters, written by the ISR only */
+    SEM_ID               rdMutex;     /* serializes the readers of the
+                                         descriptor, NULL if write-only */
+    SEM_ID               wrMutex;     /* serializes the writers of the
+                                         descriptor, NULL if read-only */
 
     union
     {
         /* CAN device info */
         struct {
             struct _devio_fdinfo **chnInfo; /* allocated channel infos */
+            struct wncan_msgring *rxStage;  /* frames read out by the ISR in
+                                               deferred receive mode, NULL
+                                               while the ISR queues them */
+            SEM_ID         deferSem;   /* wakes the deferred receive task */
+            SEM_ID         deferExit;  /* given by the task as it exits */
+            int            deferTask;  /* deferred receive task */
+            volatile BOOL  deferPosted; /* deferSem given, task not yet run */
+            volatile BOOL  deferStop;  /* deferred receive task to exit */
+            ULONG          staged;     /* see WNCAN_ISRHIST */
+            ULONG          stageDropped;
+            ULONG          deferRuns;
+            BOOL           isrHist;    /* record ISR run times */
+            BOOL           txStalled;  /* bus off, the output buffers wait
+                                          for the controller */
+            UINT32         isrBinTicks; /* bin 0 bound, timestamp ticks */
+            UINT64         isrMaxTicks; /* longest ISR run */
+            UINT32         isrCount[WNCAN_ISRHIST_BINS];
+            struct wncan_msgring *eventBuf; /* WNCAN_EVENT queue, filled by
+                                               the ISR */
+            UINT32         eventSeq;   /* next event number */
+            ULONG          eventsLost; /* events dropped, queue full */
         } device;
 
         /* CAN channel info */
@@ -308,8 +690,43 @@ typedef struct _devio_fdinfo           /* DevIO file descriptor table info */
             ULONG          channel;    /* channel identifier */
             WNCAN_IntType  intType;    /* interrupt status type, WNCAN_INT_TX
                                           or WNCAN_INT_RX */
-            RING_ID        inputBuf;   /* input data buffer */
-            RING_ID        outputBuf;  /* output data buffer */
+            struct wncan_msgring *inputBuf;   /* input data buffer, filled
+                                                 by the ISR */
+            struct wncan_msgring *outputBuf;  /* output data buffer, drained
+                                                 by the ISR */
+            volatile BOOL  txIdle;     /* no TX interrupt will load the
+                                          next frame, write() must */
+            BOOL           txLoaded;   /* a frame of the channel is in the
+                                          controller, not yet counted */
+            BOOL           txExpiring; /* the deadline timer aborted it */
+            UINT           msgFormat;  /* read format, WNCAN_MSGFMT_xxx */
+            UINT32         rxSeqNum;   /* next receive sequence number */
+            BOOL           ringShared; /* input buffer handed out by
+                                          WNCAN_CHNRING_GET, until
+                                          WNCAN_CHNRING_PUT */
+            UINT           rxWakeThresh; /* see WNCAN_WAKEUP */
+            UINT           txWakeThresh;
+            volatile BOOL  rxWaiting;  /* a select() reader is pending */
+            UINT           rxMaxLatency; /* see WNCAN_WAKEUP */
+            int            rxLatencyTicks; /* rxMaxLatency in clock ticks */
+            WDOG_ID        rxLatencyWd;  /* max-latency timer */
+            BOOL           rxWdArmed;    /* rxLatencyWd is running */
+            volatile BOOL  txWaiting;  /* a select() writer is pending */
+            struct wncan_rxfilter *rxFilter; /* software receive filter,
+                                                NULL until the first rule */
+            struct _devio_fdinfo *next; /* next descriptor open on the
+                                           channel; a writer is first */
+            UINT           txSched;    /* WNCAN_TXSCHED_xxx */
+            UINT           txFormat;   /* write format, WNCAN_MSGFMT_xxx */
+            UINT64         txDeadline; /* deadline of the frame in the
+                                          controller, 0 for none */
+            BOOL           txHandover; /* frame loaded by this TX 
+                                          interrupt, see WNCAN_INT_TX */
+            WDOG_ID        txDeadlineWd; /* aborts a frame in the 
+                                            controller past txDeadline */
+            struct wncan_txqueue *txQueue; /* frames moved out of outputBuf
+                                              in priority order, NULL until
+                                              WNCAN_TXSCHED_PRIO is set */
         } channel;
     } fdtype;
 
@@ -327,6 +744,9 @@ extern STATUS wncDevIOClose(WNCAN_DEVIO_FDINFO*);
 extern int wncDevIOReadBuf(WNCAN_DEVIO_FDINFO*, char*, size_t);
 extern int wncDevIOWriteBuf(WNCAN_DEVIO_FDINFO*, char*, size_t);
 STATUS wncDevIOIoctl(WNCAN_DEVIO_FDINFO*, int, int);
+extern STATUS wncDevIOTimestampSet(WNCAN_TSFUNC, UINT32);
+extern void wncDevIOAcceptWalk(WNCAN_DEVIO_DRVINFO*, WNCAN_ACCEPTFUNC, void*);
+extern void wncDevIOShow(void);
 #else
 extern STATUS wncDevIODevCreate();
 extern int wncDevIOCreate();
@@ -336,6 +756,9 @@ extern STATUS wncDevIOClose();
 extern int wncDevIOReadBuf();
 extern int wncDevIOWriteBuf();
 STATUS wncDevIOIoctl();
+extern STATUS wncDevIOTimestampSet();
+extern void wncDevIOAcceptWalk();
+extern void wncDevIOShow();
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,95 @@
+/* wncanFilter.h - software CAN acceptance filter */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+
+This file contains the definitions of the software acceptance filter used
+by the DevIO interface to decide, per channel descriptor, which received
+frames are queued to the reader. A filter is a set of rules; a frame is
+accepted if it matches any of them, and an empty filter accepts every frame.
+
+Exact standard IDs are kept in a bitmap of all 2048 IDs and exact extended
+IDs in an open-addressed hash set, so both are found in constant time. The
+few ID/mask rules, which also select all standard or all extended frames
+with a zero mask, are compared one by one.
+
+wncFilterMatch() may be called at interrupt level. The routines that change
+a filter lock interrupts around each update and must not be called from an
+ISR.
+
+INCLUDE FILES
+
+  CAN/wncanDevIO.h
+*/
+
+#ifndef __INCwncanFilterh
+#define __INCwncanFilterh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vxWorks.h>
+#include <CAN/wncanDevIO.h>
+
+#define WNCAN_FILTER_MAX_MASKS   8        /* ID/mask rules per filter */
+#define WNCAN_FILTER_MAX_EXTIDS  16384    /* exact extended IDs per filter */
+
+#define WNCAN_FILTER_STDID_WORDS ((COMPARE_ALL_STD_IDS + 1) / 32)
+
+typedef struct wncan_filter_range
+{
+    ULONG  id;       /* ID bits to compare */
+    ULONG  mask;     /* bits of id that must match */
+    UINT   frames;   /* WNCAN_FILTER_STD and/or WNCAN_FILTER_EXT */
+} WNCAN_FILTER_RANGE;
+
+typedef struct wncan_rxfilter
+{
+    UINT    numStd;      /* exact standard IDs set in stdIds */
+    UINT    numExt;      /* exact extended IDs held in extHash */
+    UINT    numMasks;    /* ID/mask rules in masks */
+    UINT32  stdIds[WNCAN_FILTER_STDID_WORDS];  /* standard ID bitmap */
+    UINT    extMask;     /* number of hash slots - 1 */
+    UINT    extShift;    /* 32 - log2(number of hash slots) */
+    ULONG  *extHash;     /* hash slots, all ones if unused */
+    WNCAN_FILTER_RANGE masks[WNCAN_FILTER_MAX_MASKS];
+} WNCAN_RXFILTER;
+
+typedef WNCAN_RXFILTER *WNCAN_RXFILTER_ID;
+
+/* no rules, every frame is accepted */
+#define wncFilterIsEmpty(f) \
+    (((f)->numStd | (f)->numExt | (f)->numMasks) == 0)
+
+#if defined(__STDC__)
+extern WNCAN_RXFILTER_ID wncFilterCreate(void);
+extern void wncFilterDelete(WNCAN_RXFILTER_ID filter);
+extern STATUS wncFilterAdd(WNCAN_RXFILTER_ID filter, const WNCAN_FILTER *pRule);
+extern STATUS wncFilterRemove(WNCAN_RXFILTER_ID filter,
+                              const WNCAN_FILTER *pRule);
+extern void wncFilterClear(WNCAN_RXFILTER_ID filter);
+extern BOOL wncFilterMatch(WNCAN_RXFILTER_ID filter, ULONG id, BOOL extId);
+extern void wncFilterWalk(WNCAN_RXFILTER_ID filter, WNCAN_ACCEPTFUNC rtn,
+                          void *arg);
+#else
+extern WNCAN_RXFILTER_ID wncFilterCreate();
+extern void wncFilterDelete();
+extern STATUS wncFilterAdd();
+extern STATUS wncFilterRemove();
+extern void wncFilterClear();
+extern BOOL wncFilterMatch();
+extern void wncFilterWalk();
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCwncanFilterh */
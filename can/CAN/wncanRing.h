@@ -0,0 +1,88 @@
+/* wncanRing.h - single-producer/single-consumer CAN message ring */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+
+This file contains the definitions of the CAN message ring used for the
+input and output data buffers of the DevIO channels. The ring holds whole
+message records of a fixed size, a WNCAN_CHNMSG or an extended record such
+as WNCAN_CHNMSG_TS, in a power-of-two array of slots. It is safe without
+locking as long as exactly one context adds messages (the producer) and
+exactly one context removes them (the consumer), e.g. the receive ISR and
+the reading task: each index is written by one side only and published
+with a memory barrier after the slot contents.
+
+Besides copying messages in and out, either side can work on the slots in
+place: the producer builds a message in the slot returned by
+wncRingReserve() and publishes it with wncRingCommit(), and the consumer
+processes the run returned by wncRingPeekRun() before it calls
+wncRingRemove().
+
+INCLUDE FILES
+
+  CAN/wncanDevIO.h
+*/
+
+#ifndef __INCwncanRingh
+#define __INCwncanRingh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vxWorks.h>
+#include <CAN/wncanDevIO.h>
+
+typedef struct wncan_msgring
+{
+    volatile UINT  head;     /* next slot to read; written by consumer only */
+    volatile UINT  tail;     /* next slot to write; written by producer only */
+    UINT           mask;     /* number of slots - 1 */
+    UINT           numMsgs;  /* capacity in messages, <= number of slots */
+    UINT           msgSize;  /* size of one message record in bytes */
+    char          *slots;    /* message slots */
+} WNCAN_MSGRING;
+
+typedef WNCAN_MSGRING *WNCAN_MSGRING_ID;
+
+/* number of queued messages; head and tail are free-running */
+#define wncRingCount(r)    ((UINT)((r)->tail - (r)->head))
+#define wncRingFree(r)     ((r)->numMsgs - wncRingCount(r))
+#define wncRingIsEmpty(r)  ((r)->tail == (r)->head)
+#define wncRingIsFull(r)   (wncRingCount(r) >= (r)->numMsgs)
+
+#if defined(__STDC__)
+extern WNCAN_MSGRING_ID wncRingCreate(int numMsgs, int msgSize);
+extern void wncRingDelete(WNCAN_MSGRING_ID ring);
+extern int wncRingPut(WNCAN_MSGRING_ID ring, const char *pMsgs, int numMsgs);
+extern char *wncRingReserve(WNCAN_MSGRING_ID ring);
+extern void wncRingCommit(WNCAN_MSGRING_ID ring, int numMsgs);
+extern int wncRingGet(WNCAN_MSGRING_ID ring, char *pMsgs, int numMsgs);
+extern char *wncRingPeek(WNCAN_MSGRING_ID ring);
+extern char *wncRingPeekRun(WNCAN_MSGRING_ID ring, int *pNumMsgs);
+extern void wncRingRemove(WNCAN_MSGRING_ID ring, int numMsgs);
+extern void wncRingFlush(WNCAN_MSGRING_ID ring);
+#else
+extern WNCAN_MSGRING_ID wncRingCreate();
+extern void wncRingDelete();
+extern int wncRingPut();
+extern char *wncRingReserve();
+extern void wncRingCommit();
+extern int wncRingGet();
+extern char *wncRingPeek();
+extern char *wncRingPeekRun();
+extern void wncRingRemove();
+extern void wncRingFlush();
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCwncanRingh */
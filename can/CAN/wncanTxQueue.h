@@ -0,0 +1,84 @@
+/* wncanTxQueue.h - CAN transmit queue ordered by arbitration priority */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+
+This file contains the definitions of the transmit queue used by DevIO
+channels in the WNCAN_TXSCHED_PRIO scheduling mode. The queue is a binary
+min-heap of CAN messages keyed by the order in which their identifiers would
+win arbitration on the bus: lower IDs first and, for the same base ID, a
+standard data frame before a standard remote frame before an extended frame.
+Messages with the same key leave the queue in the order they were added.
+
+The queue has no locking of its own. The DevIO transmit interrupt is its
+only user; task-level code may only touch it with interrupts locked.
+
+INCLUDE FILES
+
+  CAN/wncanDevIO.h
+*/
+
+#ifndef __INCwncanTxQueueh
+#define __INCwncanTxQueueh
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vxWorks.h>
+#include <CAN/wncanDevIO.h>
+
+typedef struct wncan_txentry
+{
+    UINT32        key;     /* arbitration key, lower is sent first */
+    UINT32        seqNum;  /* order of arrival, breaks ties */
+    UINT64        deadline; /* see WNCAN_TXMSG, 0 for none */
+    WNCAN_CHNMSG  msg;     /* queued message */
+} WNCAN_TXENTRY;
+
+typedef struct wncan_txqueue
+{
+    UINT           count;    /* queued messages */
+    UINT           numMsgs;  /* capacity in messages */
+    UINT32         seqNum;   /* sequence number of the next message */
+    WNCAN_TXENTRY *heap;     /* heap array, the first entry is sent next */
+} WNCAN_TXQUEUE;
+
+typedef WNCAN_TXQUEUE *WNCAN_TXQUEUE_ID;
+
+#define wncTxqCount(q)    ((q)->count)
+#define wncTxqFree(q)     ((q)->numMsgs - (q)->count)
+#define wncTxqIsEmpty(q)  ((q)->count == 0)
+#define wncTxqIsFull(q)   ((q)->count >= (q)->numMsgs)
+
+/* deadline of the message returned by wncTxqPeek() */
+#define wncTxqDeadline(q) ((q)->heap[0].deadline)
+
+#if defined(__STDC__)
+extern WNCAN_TXQUEUE_ID wncTxqCreate(int numMsgs);
+extern void wncTxqDelete(WNCAN_TXQUEUE_ID queue);
+extern STATUS wncTxqPut(WNCAN_TXQUEUE_ID queue, const WNCAN_CHNMSG *pMsg,
+                        UINT64 deadline);
+extern WNCAN_CHNMSG *wncTxqPeek(WNCAN_TXQUEUE_ID queue);
+extern void wncTxqRemove(WNCAN_TXQUEUE_ID queue);
+extern void wncTxqFlush(WNCAN_TXQUEUE_ID queue);
+#else
+extern WNCAN_TXQUEUE_ID wncTxqCreate();
+extern void wncTxqDelete();
+extern STATUS wncTxqPut();
+extern WNCAN_CHNMSG *wncTxqPeek();
+extern void wncTxqRemove();
+extern void wncTxqFlush();
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCwncanTxQueueh */
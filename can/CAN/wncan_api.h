@@ -49,6 +49,8 @@ extern "C" {
 #undef CAN_GetRTRRequesterChannel
 #undef CAN_GetRTRResponderChannel
 #undef CAN_FreeChannel
+#undef CAN_BusOffRecoverySet
+#undef CAN_BusOffRecoveryGet
 #undef CAN_GetVersion
 #undef CAN_GetBusStatus
 #undef CAN_GetBusError
@@ -110,6 +112,11 @@ STATUS CAN_GetRTRResponderChannel(struct WNCAN_Device *pDev, UCHAR *channelNum);
 
 STATUS CAN_FreeChannel(struct WNCAN_Device *pDev, UCHAR channelNum);
 
+STATUS CAN_BusOffRecoverySet(struct WNCAN_Device *pDev, WNCAN_BusOffCfg *pCfg);
+
+STATUS CAN_BusOffRecoveryGet(struct WNCAN_Device *pDev, WNCAN_BusOffCfg *pCfg,
+                             WNCAN_BusOffStats *pStats);
+
 const WNCAN_VersionInfo* CAN_GetVersion(void);
 
 /* controller dependent function prototypes */
@@ -126,6 +126,79 @@ struct WNCAN_Device *pDev
     return;
 }
 
+/************************************************************************
+*
+* WNCAN_Board_ReadFrame - read a block of consecutive controller registers
+*
+* This routine reads <len> consecutive controller registers starting at
+* <reg> into <pBuf>. It uses the board's canReadFrame accessor, which
+* transfers the whole block in one call, and falls back to one canInByte
+* call per register for boards that do not provide it.
+*
+* RETURNS: N/A
+*   
+* ERRNO: N/A
+*
+*/
+void WNCAN_Board_ReadFrame
+(
+    struct WNCAN_Device *pDev,
+    unsigned int reg,
+    UCHAR *pBuf,
+    UINT len
+)
+{
+    UINT i;
+
+    if (pDev->pBrd->canReadFrame)
+    {
+        pDev->pBrd->canReadFrame(pDev, reg, pBuf, len);
+    }
+    else
+    {
+        for (i = 0; i < len; i++)
+            pBuf[i] = pDev->pBrd->canInByte(pDev, reg + i);
+    }
+
+    return;
+}
+
+/************************************************************************
+*
+* WNCAN_Board_WriteFrame - write a block of consecutive controller registers
+*
+* This routine writes <len> bytes from <pBuf> to consecutive controller
+* registers starting at <reg>, using the board's canWriteFrame accessor if
+* there is one and one canOutByte call per register otherwise.
+*
+* RETURNS: N/A
+*   
+* ERRNO: N/A
+*
+*/
+void WNCAN_Board_WriteFrame
+(
+    struct WNCAN_Device *pDev,
+    unsigned int reg,
+    const UCHAR *pBuf,
+    UINT len
+)
+{
+    UINT i;
+
+    if (pDev->pBrd->canWriteFrame)
+    {
+        pDev->pBrd->canWriteFrame(pDev, reg, pBuf, len);
+    }
+    else
+    {
+        for (i = 0; i < len; i++)
+            pDev->pBrd->canOutByte(pDev, reg + i, pBuf[i]);
+    }
+
+    return;
+}
+
 /************************************************************************
 *
 * stringToUlong - helper function used by boards to 
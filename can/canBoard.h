@@ -12,6 +12,7 @@
 modification history 
 --------------------
 2016/05/27  Jonah Liu  Add PR6120 board CAN port support
+                      Added canReadFrame/canWriteFrame block accessors
 01c,30dec08,x_f  Added fsl_ads5121e CAN support
 01b,04dec07,d_z  Added tolapai can support
 01a,28dec05,jb3  Add WNCAN_MCF5485 for spring release
@@ -87,6 +88,12 @@ struct WNCAN_Board
     void (*enableIrq)(struct WNCAN_Device *);
     void (*disableIrq)(struct WNCAN_Device *);
 
+    /* optional block accessors for consecutive registers, may be 0;
+       see WNCAN_Board_ReadFrame() and WNCAN_Board_WriteFrame() */
+    void (*canReadFrame)(struct WNCAN_Device *, unsigned int, UCHAR *, UINT);
+    void (*canWriteFrame)(struct WNCAN_Device *, unsigned int, 
+                          const UCHAR *, UINT);
+
     WNCAN_BoardType brdType;
     UINT            irq;
     ULONG           ioAddress;
@@ -100,6 +107,9 @@ struct WNCAN_Board
 STATUS WNCAN_Board_establishLinks(struct WNCAN_Device *, WNCAN_BoardType);
 struct WNCAN_Device *WNCAN_Board_Open(UINT,UINT,UINT);
 void WNCAN_Board_Close(struct WNCAN_Device *);
+void WNCAN_Board_ReadFrame(struct WNCAN_Device *, unsigned int, UCHAR *, UINT);
+void WNCAN_Board_WriteFrame(struct WNCAN_Device *, unsigned int, 
+                            const UCHAR *, UINT);
 ULONG stringToUlong(const char *pStr);
 
 
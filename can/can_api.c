@@ -441,6 +441,9 @@ UINT CAN_GetBaudRate
 * WNCAN_INT_BUS_OFF: Enables interrupt indicating bus off condition.
 * \m -
 * WNCAN_INT_WAKE_UP: Enables interrupt on wake up.
+* \m -
+* WNCAN_INT_BUS_STATE: Enables interrupts on the other error state 
+* changes, such as entering error passive or leaving bus off.
 * \me
 *
 *
@@ -679,6 +682,52 @@ STATUS CAN_FreeChannel
        return(WNCAN_FreeChannel(pDev,channelNum));
     }
 
+/***************************************************************************
+* CAN_BusOffRecoverySet - configure automatic bus-off recovery
+*
+* This routine enables or disables the restart of the controller after it
+* went bus off. With <pCfg>->enable TRUE, each bus off is followed by a
+* delay of <minDelay> ms, doubled for each further bus off within
+* <stableTime> ms of the last recovery up to <maxDelay> ms, after which the
+* controller is restarted and rejoins the bus once it has seen
+* WNCAN_BUSOFF_RECESSIVE recessive bits. <txPolicy> WNCAN_BUSOFF_TX_FLUSH
+* discards the frames waiting for transmission at bus off,
+* WNCAN_BUSOFF_TX_KEEP sends them after the recovery.
+*
+* RETURNS: 'OK', or 'ERROR' if the configuration is invalid or the
+* recovery task cannot be created.
+*
+* ERRNO: S_can_invalid_parameter, S_can_out_of_memory
+*/
+STATUS CAN_BusOffRecoverySet
+    (
+    struct WNCAN_Device *pDev,       /* CAN device pointer */
+    WNCAN_BusOffCfg     *pCfg        /* recovery configuration */
+    )
+    {
+       return(WNCAN_BusOffRecoverySet(pDev,pCfg));
+    }
+
+/***************************************************************************
+* CAN_BusOffRecoveryGet - get the bus-off recovery configuration and counts
+*
+* This routine copies the recovery configuration to <pCfg> and the state
+* and counters of the recovery to <pStats>; either pointer may be NULL.
+*
+* RETURNS: 'OK', or 'ERROR' if automatic recovery is not enabled.
+*
+* ERRNO: S_can_invalid_parameter, S_can_no_op
+*/
+STATUS CAN_BusOffRecoveryGet
+    (
+    struct WNCAN_Device *pDev,       /* CAN device pointer */
+    WNCAN_BusOffCfg     *pCfg,       /* where to store the configuration */
+    WNCAN_BusOffStats   *pStats      /* where to store the state and counts */
+    )
+    {
+       return(WNCAN_BusOffRecoveryGet(pDev,pCfg,pStats));
+    }
+
 /************************************************************************
 * CAN_GetVersion - get the version number of the CAN drivers
 *
@@ -1013,7 +1062,8 @@ long CAN_GetLocalMsgFilter
 /***************************************************************************
 * CAN_GetIntStatus - get the interrupt status of a CAN interrupt
 *
-* This routine returns the interrupt status on the controller:
+* This routine returns the OR of all interrupt causes pending on the
+* controller; test individual causes with WNCAN_INT_PENDING():
 *
 *    WNCAN_INT_NONE = no interrupt occurred
 *    WNCAN_INT_ERROR = bus error
@@ -1022,6 +1072,7 @@ long CAN_GetLocalMsgFilter
 *    WNCAN_INT_BUS_OFF = interrupt resulting from bus off condition
 *    WNCAN_INT_WAKE_UP = interrupt resulting from controller waking up after
 *    being put in sleep mode
+*    WNCAN_INT_BUS_STATE = error state change other than to bus off
 *    WNCAN_INT_SPURIOUS = unknown interrupt
 *
 * NOTE: If the interrupt was caused by the transmission or reception of a
@@ -60,25 +60,22 @@
 #include <vxWorks.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <CAN/icp_can.h>
 #include <CAN/can_fifo.h>
 
 /******************************************************************************
- * A FIFO element is a CAN msg.
- *****************************************************************************/
-typedef struct can_fifo_item {
-	icp_can_msg_t		msg;
-	struct can_fifo_item	*next;
-} can_fifo_item_t;
-
-/******************************************************************************
- * The FIFO.
+ * The FIFO: a contiguous, power-of-two array of CAN msgs.  head is the next
+ * slot to put into and tail the next slot to get from; both run freely and
+ * are masked on access, so head - tail is the number of queued msgs.
  *****************************************************************************/
 typedef struct can_fifo {
-	can_fifo_item_t *head;
-	can_fifo_item_t *tail;
-	unsigned int size;
+	icp_can_msg_t	*items;
+	unsigned int	head;
+	unsigned int	tail;
+	unsigned int	mask;
+	unsigned int	size;	/* max # of queued msgs */
 } can_fifo_t;
 
 /******************************************************************************
@@ -98,18 +95,26 @@ int can_fifo_full(icp_can_handle_t handle)
 {
 	can_fifo_t *f = (can_fifo_t *) handle;
 
-	return (f->head->next==f->tail);
+	return ((f->head - f->tail) >= f->size);
 }
 
 /******************************************************************************
- * Create a CAN messsage FIFO of size specifified.
+ * Create a CAN messsage FIFO of size specifified.  As with the former
+ * linked-list FIFO, num_nodes slots hold up to num_nodes - 1 messages.
  *****************************************************************************/
 icp_can_handle_t can_fifo_create(unsigned int num_nodes)
 {
-	unsigned int i;
-	can_fifo_item_t  *curr;
+	unsigned int num_slots = 1;
 	can_fifo_t *f;
 	
+	if (num_nodes < 2) {
+		return (icp_can_handle_t) 0;
+	}
+	
+	while (num_slots < num_nodes - 1) {
+		num_slots <<= 1;
+	}
+	
 	f = (can_fifo_t *) CAN_MEM_ALLOC(sizeof(can_fifo_t));
 	
 	if (!f) {
@@ -117,32 +122,19 @@ icp_can_handle_t can_fifo_create(unsigned int num_nodes)
 		return (icp_can_handle_t) 0;
 	}
 	
-	f->head = (can_fifo_item_t *) CAN_MEM_ALLOC(sizeof(can_fifo_item_t));
-
-	f->tail = f->head;
+	f->items = (icp_can_msg_t *) 
+		CAN_MEM_ALLOC(num_slots * sizeof(icp_can_msg_t));
 	
-	if (!(f->head)) {
-		CAN_PRINT_DEBUG(ICP_CAN_ERR_ALLOC, "msg queue head");
+	if (!(f->items)) {
+		CAN_PRINT_DEBUG(ICP_CAN_ERR_ALLOC, "msg queue items");
 		CAN_MEM_FREE(f);
 		return (icp_can_handle_t) 0;
 	}
-	curr = f->head;
-	
-	for (i=1; i<num_nodes; i++) {
-		curr->next = (can_fifo_item_t *) CAN_MEM_ALLOC(sizeof(can_fifo_item_t));
-
-		if (!(curr->next)) {
-			CAN_PRINT_DEBUG(ICP_CAN_ERR_ALLOC, "msg queue node");
-			f->size = i-1; 
-			CAN_MEM_FREE(f);
-			return (icp_can_handle_t) 0;
-		}
-		
-		curr = curr->next;
-	}
 	
-	curr->next = f->head;
-	f->size = num_nodes;
+	f->head = 0;
+	f->tail = 0;
+	f->mask = num_slots - 1;
+	f->size = num_nodes - 1;
 	
 	return (icp_can_handle_t) f;
 }
@@ -152,25 +144,10 @@ icp_can_handle_t can_fifo_create(unsigned int num_nodes)
  *****************************************************************************/
 void can_fifo_destroy(icp_can_handle_t handle)
 {
-	unsigned int i;
-	can_fifo_item_t *curr;
-	can_fifo_item_t *next;
 	can_fifo_t *f = (can_fifo_t *) handle;
 		
 	if (handle) {
-		curr = f->head;
-		next = curr->next;
-		
-		for (i=0; i<f->size; i++) {
-			if (!curr) {
-				CAN_PRINT_DEBUG(ICP_CAN_ERR_FREE, 
-					"msg queue node");
-			}
-			CAN_MEM_FREE(curr);
-			curr = next;
-			next = (can_fifo_item_t *) curr->next;
-		}
-		
+		CAN_MEM_FREE(f->items);
 		CAN_MEM_FREE(f);
 	}
 }
@@ -182,9 +159,7 @@ int can_fifo_get(
 	icp_can_handle_t	handle, 
 	icp_can_msg_t		*msg)
 {
-	int i;
 	can_fifo_t *f = (can_fifo_t *) handle;
-	icp_can_msg_t msg_tmp = f->tail->msg;
 	
 	if ((!handle) || (!msg)) {
 		return -1;
@@ -200,16 +175,9 @@ int can_fifo_get(
 		return -1;
 	}
 		
-	msg->ide = msg_tmp.ide;
-	msg->id  = msg_tmp.id;
-	msg->dlc = msg_tmp.dlc;
-	msg->rtr = msg_tmp.rtr;
-	
-	for (i=0; i<ICP_CAN_MSG_DATA_LEN; i++) {
-		msg->data[i] = msg_tmp.data[i];
-	}
+	*msg = f->items[f->tail & f->mask];
 	
-	f->tail = f->tail->next;
+	f->tail++;
 	return 0;
 }
 
@@ -220,9 +188,7 @@ int can_fifo_put(
 	icp_can_handle_t	handle, 
 	icp_can_msg_t		*msg)
 {
-	int i;
 	can_fifo_t *f = (can_fifo_t *) handle;
-	icp_can_msg_t *msg_tmp = &(f->head->msg);
 	
 	if ((!handle) || (!msg)) {
 		return -1;
@@ -231,22 +197,90 @@ int can_fifo_put(
     printf("can_fifo_put() \n");
 #endif
 	
-	if (f->head->next==f->tail) {
+	if ((f->head - f->tail) >= f->size) {
 #if TOLAPAI_CAN_DRV_DEBUG
 	    printf("can_fifo_put() queue full\n");
 #endif
 		return -1;
 	}
 	
-	msg_tmp->ide = msg->ide;
-	msg_tmp->rtr = msg->rtr;
-	msg_tmp->id  = msg->id;
-	msg_tmp->dlc = msg->dlc;
+	f->items[f->head & f->mask] = *msg;
 	
-	for (i=0; i<ICP_CAN_MSG_DATA_LEN; i++) {
-		msg_tmp->data[i] = msg->data[i];
+	f->head++;
+	return 0;
+}
+
+/******************************************************************************
+ * Get up to num messages from the FIFO into the msgs array, oldest first.
+ * Returns the number of messages copied, or -1 on bad arguments.
+ *****************************************************************************/
+int can_fifo_get_n(
+	icp_can_handle_t	handle, 
+	icp_can_msg_t		*msgs,
+	unsigned int		num)
+{
+	unsigned int count;
+	unsigned int idx;
+	unsigned int first;
+	can_fifo_t *f = (can_fifo_t *) handle;
+	
+	if ((!handle) || (!msgs)) {
+		return -1;
 	}
 	
-	f->head = f->head->next;
-	return 0;
+	count = f->head - f->tail;
+	if (num > count) {
+		num = count;
+	}
+	
+	/* copy in up to two runs, split where the array wraps */
+	idx = f->tail & f->mask;
+	first = f->mask + 1 - idx;
+	if (first > num) {
+		first = num;
+	}
+	
+	memcpy(msgs, &f->items[idx], first * sizeof(icp_can_msg_t));
+	memcpy(msgs + first, &f->items[0], (num - first) * sizeof(icp_can_msg_t));
+	
+	f->tail += num;
+	return (int) num;
+}
+
+/******************************************************************************
+ * Put up to num messages from the msgs array into the FIFO, as many as there
+ * is room for.  Returns the number of messages queued, or -1 on bad
+ * arguments.
+ *****************************************************************************/
+int can_fifo_put_n(
+	icp_can_handle_t	handle, 
+	icp_can_msg_t		*msgs,
+	unsigned int		num)
+{
+	unsigned int room;
+	unsigned int idx;
+	unsigned int first;
+	can_fifo_t *f = (can_fifo_t *) handle;
+	
+	if ((!handle) || (!msgs)) {
+		return -1;
+	}
+	
+	room = f->size - (f->head - f->tail);
+	if (num > room) {
+		num = room;
+	}
+	
+	/* copy in up to two runs, split where the array wraps */
+	idx = f->head & f->mask;
+	first = f->mask + 1 - idx;
+	if (first > num) {
+		first = num;
+	}
+	
+	memcpy(&f->items[idx], msgs, first * sizeof(icp_can_msg_t));
+	memcpy(&f->items[0], msgs + first, (num - first) * sizeof(icp_can_msg_t));
+	
+	f->head += num;
+	return (int) num;
 }
@@ -0,0 +1,16 @@
+/* CAN/i82527.h - host build: Intel 82527 controller */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCi82527h
+#define __INCi82527h
+
+#include <vxWorks.h>
+
+/* the PR6120 sources include this header, but use nothing of it */
+
+#endif /* __INCi82527h */
@@ -0,0 +1,36 @@
+/* CAN/icp_can.h - host build: Intel EP80579 CAN driver types */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCicp_canh
+#define __INCicp_canh
+
+#include <vxWorks.h>
+#include <stdlib.h>
+
+/* the message and handle types can_fifo.c stores; the EP80579 (tolapai)
+   CAN driver that defines them is not part of the host build */
+#define ICP_CAN_MSG_DATA_LEN    8
+
+typedef void *icp_can_handle_t;
+
+typedef struct icp_can_msg_s
+{
+    unsigned int  ide;
+    unsigned int  id;
+    unsigned int  dlc;
+    unsigned int  rtr;
+    unsigned char data[ICP_CAN_MSG_DATA_LEN];
+} icp_can_msg_t;
+
+#define ICP_CAN_ERR_ALLOC       1
+
+#define CAN_MEM_ALLOC(size)     malloc (size)
+#define CAN_MEM_FREE(ptr)       free (ptr)
+#define CAN_PRINT_DEBUG(err, what)
+
+#endif /* __INCicp_canh */
@@ -0,0 +1,9 @@
+/* copyright_wrs.h - host build: Wind River copyright notice */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/* the notice is only a comment in the VxWorks header */
@@ -0,0 +1,21 @@
+/* drv/timer/timestampDev.h - host build: timestamp driver */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCtimestampDevh
+#define __INCtimestampDevh
+
+#include <vxWorks.h>
+
+/* a 1 MHz counter that restarts on every system clock tick */
+extern STATUS sysTimestampEnable (void);
+extern UINT32 sysTimestamp (void);
+extern UINT32 sysTimestampLock (void);
+extern UINT32 sysTimestampPeriod (void);
+extern UINT32 sysTimestampFreq (void);
+
+#endif /* __INCtimestampDevh */
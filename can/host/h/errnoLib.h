@@ -0,0 +1,19 @@
+/* errnoLib.h - host build: error status library */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCerrnoLibh
+#define __INCerrnoLibh
+
+#include <vxWorks.h>
+#include <errno.h>
+
+/* the error status of a task is the errno of its thread */
+extern STATUS errnoSet (int errorValue);
+extern int    errnoGet (void);
+
+#endif /* __INCerrnoLibh */
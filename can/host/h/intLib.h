@@ -0,0 +1,18 @@
+/* intLib.h - host build: interrupt lock */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCintLibh
+#define __INCintLibh
+
+#include <vxWorks.h>
+
+extern int  intLock (void);
+extern void intUnlock (int lockKey);
+extern BOOL intContext (void);
+
+#endif /* __INCintLibh */
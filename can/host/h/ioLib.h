@@ -0,0 +1,41 @@
+/* ioLib.h - host build: I/O interface */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCioLibh
+#define __INCioLibh
+
+#include <vxWorks.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* ioctl() function codes */
+#define FIONREAD            1
+#define FIOFLUSH            2
+#define FIOOPTIONS          3
+#define FIOSETOPTIONS       FIOOPTIONS
+#define FIONWRITE           12
+#define FIONBIO             16
+#define FIONMSGS            17
+#define FIOGETOPTIONS       19
+#define FIORBUFSET          24
+#define FIOWBUFSET          25
+#define FIORFLUSH           26
+#define FIOWFLUSH           27
+#define FIOSELECT           28
+#define FIOUNSELECT         29
+#define FIONFREE            30
+
+#define S_ioLib_NO_DRIVER           (M_ioLib | 1)
+#define S_ioLib_UNKNOWN_REQUEST     (M_ioLib | 3)
+#define S_ioLib_DEVICE_ERROR        (M_ioLib | 4)
+
+/* open(), read(), write() and close() are those of <unistd.h>, which the
+   host build routes to the drivers of iosLib for device names */
+extern int ioctl (int fd, int function, ...);
+
+#endif /* __INCioLibh */
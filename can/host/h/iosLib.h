@@ -0,0 +1,33 @@
+/* iosLib.h - host build: I/O system */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCiosLibh
+#define __INCiosLibh
+
+#include <vxWorks.h>
+#include <ioLib.h>
+
+#define S_iosLib_DEVICE_NOT_FOUND   (M_iosLib | 1)
+#define S_iosLib_INVALID_FILE_DESCRIPTOR (M_iosLib | 2)
+
+typedef struct devHdr
+{
+    struct devHdr *pNext;
+    short          drvNum;
+    char          *name;
+} DEV_HDR;
+
+extern int     iosDrvInstall (FUNCPTR pCreate, FUNCPTR pDelete, FUNCPTR pOpen,
+                              FUNCPTR pClose, FUNCPTR pRead, FUNCPTR pWrite,
+                              FUNCPTR pIoctl);
+extern STATUS  iosDrvRemove (int drvNum, BOOL forceClose);
+extern STATUS  iosDevAdd (DEV_HDR *pDevHdr, const char *name, int drvNum);
+extern void    iosDevDelete (DEV_HDR *pDevHdr);
+extern DEV_HDR *iosDevFind (const char *name, const char **pNameTail);
+
+#endif /* __INCiosLibh */
@@ -0,0 +1,18 @@
+/* iv.h - host build: interrupt vectors */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCivh
+#define __INCivh
+
+#include <vxWorks.h>
+
+/* the simulated board has no interrupt line, see sys_pr6120_can_sim.c */
+#define IVEC_TO_INUM(intVec)    ((int) (intVec))
+#define INUM_TO_IVEC(intNum)    ((VOIDFUNCPTR *) (long) (intNum))
+
+#endif /* __INCivh */
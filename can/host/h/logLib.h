@@ -0,0 +1,17 @@
+/* logLib.h - host build: message logging */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INClogLibh
+#define __INClogLibh
+
+#include <vxWorks.h>
+
+/* the six arguments are int, as in VxWorks; messages go to stderr */
+extern int logMsg (char *fmt, ...);
+
+#endif /* __INClogLibh */
@@ -0,0 +1,15 @@
+/* memLib.h - host build: memory allocation */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCmemLibh
+#define __INCmemLibh
+
+#include <vxWorks.h>
+#include <stdlib.h>
+
+#endif /* __INCmemLibh */
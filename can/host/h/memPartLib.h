@@ -0,0 +1,15 @@
+/* memPartLib.h - host build: memory partitions */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCmemPartLibh
+#define __INCmemPartLibh
+
+#include <vxWorks.h>
+#include <stdlib.h>
+
+#endif /* __INCmemPartLibh */
@@ -0,0 +1,15 @@
+/* private/selectLibP.h - host build: select facility, private */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCselectLibPh
+#define __INCselectLibPh
+
+#include <vxWorks.h>
+#include <selectLib.h>
+
+#endif /* __INCselectLibPh */
@@ -0,0 +1,17 @@
+/* rngLib.h - host build: ring buffer library */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCrngLibh
+#define __INCrngLibh
+
+#include <vxWorks.h>
+
+/* CAN/wncanDevIO.h includes this header; the rings are those of
+   wncanRing.c */
+
+#endif /* __INCrngLibh */
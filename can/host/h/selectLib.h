@@ -0,0 +1,48 @@
+/* selectLib.h - host build: select facility */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCselectLibh
+#define __INCselectLibh
+
+#include <vxWorks.h>
+#include <iosLib.h>
+#include <sys/select.h>
+
+typedef enum
+{
+    SELREAD,
+    SELWRITE
+} SELECT_TYPE;
+
+/* the wake-up node a select() call passes to FIOSELECT and FIOUNSELECT */
+typedef struct selWakeupNode
+{
+    struct selWakeupNode *pNext;
+    struct hostSelWaiter *pWaiter;  /* the select() call, see hostOs.c */
+    int                   fd;
+    SELECT_TYPE           type;
+} SEL_WAKEUP_NODE;
+
+typedef struct
+{
+    SEL_WAKEUP_NODE      *pFirst;
+} SEL_WAKEUP_LIST;
+
+extern void        selWakeup (SEL_WAKEUP_NODE *pWakeupNode);
+extern void        selWakeupAll (SEL_WAKEUP_LIST *pWakeupList, 
+                                 SELECT_TYPE type);
+extern STATUS      selNodeAdd (SEL_WAKEUP_LIST *pWakeupList, 
+                               SEL_WAKEUP_NODE *pWakeupNode);
+extern STATUS      selNodeDelete (SEL_WAKEUP_LIST *pWakeupList, 
+                                  SEL_WAKEUP_NODE *pWakeupNode);
+extern void        selWakeupListInit (SEL_WAKEUP_LIST *pWakeupList);
+extern void        selWakeupListTerm (SEL_WAKEUP_LIST *pWakeupList);
+extern int         selWakeupListLen (SEL_WAKEUP_LIST *pWakeupList);
+extern SELECT_TYPE selWakeupType (SEL_WAKEUP_NODE *pWakeupNode);
+
+#endif /* __INCselectLibh */
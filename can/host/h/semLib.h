@@ -0,0 +1,39 @@
+/* semLib.h - host build: semaphores */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCsemLibh
+#define __INCsemLibh
+
+#include <vxWorks.h>
+
+#define SEM_Q_FIFO          0x00
+#define SEM_Q_PRIORITY      0x01
+#define SEM_DELETE_SAFE     0x04
+#define SEM_INVERSION_SAFE  0x08
+
+typedef enum
+{
+    SEM_EMPTY,
+    SEM_FULL
+} SEM_B_STATE;
+
+#define S_objLib_OBJ_ID_ERROR       (M_objLib | 1)
+#define S_objLib_OBJ_UNAVAILABLE    (M_objLib | 2)
+#define S_objLib_OBJ_DELETED        (M_objLib | 3)
+#define S_objLib_OBJ_TIMEOUT        (M_objLib | 4)
+
+typedef struct semaphore *SEM_ID;
+
+extern SEM_ID semBCreate (int options, SEM_B_STATE initialState);
+extern SEM_ID semCCreate (int options, int initialCount);
+extern SEM_ID semMCreate (int options);
+extern STATUS semTake (SEM_ID semId, int timeout);
+extern STATUS semGive (SEM_ID semId);
+extern STATUS semDelete (SEM_ID semId);
+
+#endif /* __INCsemLibh */
@@ -0,0 +1,17 @@
+/* sysLib.h - host build: system clock */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCsysLibh
+#define __INCsysLibh
+
+#include <vxWorks.h>
+
+extern int    sysClkRateGet (void);
+extern STATUS sysClkRateSet (int ticksPerSecond);
+
+#endif /* __INCsysLibh */
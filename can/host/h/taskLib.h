@@ -0,0 +1,26 @@
+/* taskLib.h - host build: tasks */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCtaskLibh
+#define __INCtaskLibh
+
+#include <vxWorks.h>
+
+#define VX_FP_TASK          0x0008
+
+extern int    taskSpawn (char *name, int priority, int options, int stackSize,
+                         FUNCPTR entryPt, int arg1, int arg2, int arg3,
+                         int arg4, int arg5, int arg6, int arg7, int arg8,
+                         int arg9, int arg10);
+extern int    taskIdSelf (void);
+extern char  *taskName (int tid);
+extern STATUS taskDelay (int ticks);
+extern STATUS taskLock (void);
+extern STATUS taskUnlock (void);
+
+#endif /* __INCtaskLibh */
@@ -0,0 +1,17 @@
+/* tickLib.h - host build: tick counter */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCtickLibh
+#define __INCtickLibh
+
+#include <vxWorks.h>
+
+extern ULONG  tickGet (void);
+extern UINT64 tick64Get (void);
+
+#endif /* __INCtickLibh */
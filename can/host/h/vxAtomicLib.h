@@ -0,0 +1,19 @@
+/* vxAtomicLib.h - host build: memory barriers */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCvxAtomicLibh
+#define __INCvxAtomicLibh
+
+#include <vxWorks.h>
+
+/* the host is a multiprocessor, order the accesses of other CPUs too */
+#define VX_MEM_BARRIER_R()      __sync_synchronize ()
+#define VX_MEM_BARRIER_W()      __sync_synchronize ()
+#define VX_MEM_BARRIER_RW()     __sync_synchronize ()
+
+#endif /* __INCvxAtomicLibh */
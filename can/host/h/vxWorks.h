@@ -0,0 +1,93 @@
+/* vxWorks.h - host build: basic VxWorks types and definitions */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+The headers of this directory stand in for the VxWorks headers that the
+WNCAN sources, the PR6120 driver and the demo include when they are built
+for a Linux host, see ../hostOs.c. They declare what those sources use,
+with the types and values of VxWorks 6.8 where the sources depend on them.
+
+Addresses are passed to the VxWorks API as int, e.g. the argument of
+ioctl() and wdStart(); the host build is linked so that all memory the
+stack sees is below 2 GB, which keeps such casts lossless.
+*/
+
+#ifndef __INCvxWorksh
+#define __INCvxWorksh
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define _WRS_VXWORKS_MAJOR  6
+#define _WRS_VXWORKS_MINOR  8
+
+#define I80X86              80
+#define CPU_FAMILY          I80X86
+
+typedef signed char         INT8;
+typedef short               INT16;
+typedef int                 INT32;
+typedef long long           INT64;
+typedef unsigned char       UINT8;
+typedef unsigned short      UINT16;
+typedef unsigned int        UINT32;
+typedef unsigned long long  UINT64;
+
+typedef unsigned char       UCHAR;
+typedef unsigned short      USHORT;
+typedef unsigned int        UINT;
+typedef unsigned long       ULONG;
+
+typedef int                 BOOL;
+typedef int                 STATUS;
+typedef int                 ARGINT;
+
+typedef int                 (*FUNCPTR) ();
+typedef void                (*VOIDFUNCPTR) ();
+
+#define OK                  0
+#define ERROR               (-1)
+
+#ifndef TRUE
+#define TRUE                1
+#endif
+#ifndef FALSE
+#define FALSE               0
+#endif
+
+#ifndef NULL
+#define NULL                ((void *) 0)
+#endif
+
+#define EOS                 '\0'
+
+#define WAIT_FOREVER        (-1)
+#define NO_WAIT             0
+
+#define LOCAL               static
+#define IMPORT              extern
+#define FAST                register
+
+#define NELEMENTS(array)    (sizeof (array) / sizeof ((array) [0]))
+
+/* module numbers of the error codes, see errnoLib.h */
+#define M_errno             (0 << 16)
+#define M_iosLib            (12 << 16)
+#define M_ioLib             (13 << 16)
+#define M_objLib            (61 << 16)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCvxWorksh */
@@ -0,0 +1,22 @@
+/* wdLib.h - host build: watchdog timers */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+#ifndef __INCwdLibh
+#define __INCwdLibh
+
+#include <vxWorks.h>
+
+typedef struct wdog *WDOG_ID;
+
+extern WDOG_ID wdCreate (void);
+extern STATUS  wdStart (WDOG_ID wdId, int delay, FUNCPTR pRoutine, 
+                        int parameter);
+extern STATUS  wdCancel (WDOG_ID wdId);
+extern STATUS  wdDelete (WDOG_ID wdId);
+
+#endif /* __INCwdLibh */
@@ -0,0 +1,2609 @@
+/* hostOs.c - VxWorks kernel shim for the Linux host build */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+This file implements on POSIX threads the part of the VxWorks kernel that
+the WNCAN stack, the PR6120 driver on the simulated board of
+sys_pr6120_can_sim.c and the DevIO applications use, so that they build
+and run as Linux programs, see the Makefile of this directory.
+
+Tasks are threads. The interrupt level is a thread that runs the system
+clock: it announces sysClkRateGet() ticks per second and runs the expired
+watchdog routines, among them the model of the simulated board, which
+calls the board ISR. The interrupt lock is one mutex, held by that thread
+while it runs and by a task from intLock() to intUnlock(), so a task that
+locks interrupts excludes the interrupt level and every other task that
+locks interrupts, as on a uniprocessor. A task that pends with interrupts
+locked releases the lock until it runs again, as VxWorks unlocks
+interrupts on a task switch. Task priorities are not modelled; tasks and
+interrupts run in parallel wherever the stack does not lock.
+
+A program that defines hostClkManual as TRUE runs on a virtual clock
+instead: there is no clock thread, and hostTickAdvance() announces the
+ticks after every task has pended, so the timing of a test does not
+depend on the load of the host. The root task, which runs main(), drives
+that clock: when it pends with a timeout itself, e.g. in a taskDelay() of
+the driver, the ticks are announced the same way until it is woken.
+
+For the benchmarks, the shim counts the selWakeupAll() calls and the
+select() calls they wake, and the time spent in watchdog routines, which
+is the time at interrupt level; see hostOs.h.
+
+The I/O system keeps the drivers and devices of iosLib. open(), close(),
+read(), write(), ioctl() and select() are linked with --wrap: names below
+a device added with iosDevAdd() and the file descriptors opened on them
+go to the driver, everything else to the C library. A device file
+descriptor is a descriptor of /dev/null, which keeps it distinct from
+those of files.
+
+The stack casts addresses to int, e.g. for ioctl() and wdStart(). The
+programs are linked without PIE, the heap is kept in the program break
+and the stacks of all tasks and threads are mapped below 2 GB, so that
+these casts are lossless; the root task checks this before main() runs.
+
+INCLUDE FILES
+  the headers of h/
+*/
+
+#define _GNU_SOURCE
+
+/* includes */
+
+#include <vxWorks.h>
+#include <errnoLib.h>
+#include <intLib.h>
+#include <iosLib.h>
+#include <ioLib.h>
+#include <logLib.h>
+#include <selectLib.h>
+#include <semLib.h>
+#include <sysLib.h>
+#include <taskLib.h>
+#include <tickLib.h>
+#include <wdLib.h>
+#include <drv/timer/timestampDev.h>
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "hostOs.h"
+
+/* defines */
+
+#define HOST_CLK_RATE       1000        /* default system clock rate */
+#define HOST_TS_FREQ        1000000     /* timestamp counter, Hz */
+#define HOST_STACK_MIN      (256 * 1024)
+#define HOST_STACK_DEFAULT  (1024 * 1024)
+#define HOST_QUIET_MS       200         /* bound of hostTickAdvance() waits */
+#define HOST_NUM_DRV        16
+
+#define SEM_TYPE_BINARY     0
+#define SEM_TYPE_MUTEX      1
+#define SEM_TYPE_COUNTING   2
+
+/* typedefs */
+
+typedef struct hostTcb
+{
+    char     name[32];
+    BOOL     counted;           /* pends are seen by hostTickAdvance() */
+    FUNCPTR  entry;
+    int      args[10];
+    void  *(*start) (void *);   /* thread of pthread_create() */
+    void    *startArg;
+} HOST_TCB;
+
+/* a task or select() call pending in the kernel */
+
+typedef struct hostWait
+{
+    struct hostWait  *pNext;    /* in the queue of the object */
+    struct hostWait **ppQueue;  /* that queue, NULL if none */
+    struct hostWait  *pTimeNext;
+    BOOL              timed;    /* on hostTimeQ */
+    UINT64            deadline;
+    pthread_cond_t    cond;
+    BOOL              done;
+    int               error;    /* errno on return, 0 = OK */
+    HOST_TCB         *pTcb;
+} HOST_WAIT;
+
+struct semaphore
+{
+    int        type;
+    int        count;           /* mutex: recursion depth */
+    HOST_TCB  *pOwner;
+    HOST_WAIT *pQueue;
+};
+
+struct wdog
+{
+    struct wdog *pNext;         /* in hostWdQ or hostWdRun */
+    BOOL         armed;
+    BOOL         running;       /* expired, on hostWdRun */
+    UINT64       expire;
+    FUNCPTR      routine;
+    int          parameter;
+};
+
+/* the select() call a wake-up node belongs to */
+
+struct hostSelWaiter
+{
+    HOST_WAIT *pQueue;          /* the pending call */
+    BOOL       ready;
+    fd_set     readFds;
+    fd_set     writeFds;
+};
+
+typedef struct
+{
+    FUNCPTR pCreate;
+    FUNCPTR pDelete;
+    FUNCPTR pOpen;
+    FUNCPTR pClose;
+    FUNCPTR pRead;
+    FUNCPTR pWrite;
+    FUNCPTR pIoctl;
+    BOOL    inUse;
+} HOST_DRV;
+
+typedef struct
+{
+    BOOL     inUse;
+    int      drvNum;
+    int      value;             /* returned by the open routine */
+    DEV_HDR *pDevHdr;
+} HOST_FD;
+
+/* globals */
+
+/* define as TRUE to run the program on the clock of hostTickAdvance() */
+BOOL hostClkManual __attribute__((weak)) = FALSE;
+
+/* select() wake-up counters, for the benchmarks */
+ULONG hostSelWakeupAlls;        /* selWakeupAll() calls */
+ULONG hostSelWakes;             /* pending select() calls woken */
+UINT64 hostWdNs;                /* time spent in watchdog routines */
+
+/* locals */
+
+LOCAL pthread_mutex_t hostIntMutex = PTHREAD_MUTEX_INITIALIZER;
+LOCAL __thread int    hostIntDepth;
+LOCAL __thread BOOL   hostIntCtx;
+
+LOCAL pthread_mutex_t hostKernLock = PTHREAD_MUTEX_INITIALIZER;
+LOCAL pthread_cond_t  hostQuietCond = PTHREAD_COND_INITIALIZER;
+LOCAL int             hostReady;        /* counted tasks not pending */
+LOCAL HOST_WAIT      *hostTimeQ;
+LOCAL struct wdog    *hostWdQ;
+LOCAL struct wdog    *hostWdRun;
+
+LOCAL pthread_mutex_t hostTaskLockMutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+LOCAL __thread HOST_TCB *hostTcbSelf;
+LOCAL HOST_TCB       *hostRootTcb;      /* drives the virtual clock */
+
+LOCAL int             hostClkRate = HOST_CLK_RATE;
+LOCAL volatile UINT64 hostTicks;
+LOCAL UINT64          hostStartNs;
+
+LOCAL pthread_mutex_t hostIosLock = PTHREAD_MUTEX_INITIALIZER;
+LOCAL HOST_DRV        hostDrvTbl[HOST_NUM_DRV];
+LOCAL DEV_HDR        *hostDevList;
+LOCAL HOST_FD         hostFdTbl[FD_SETSIZE];
+
+LOCAL int             hostArgc;
+LOCAL char          **hostArgv;
+
+/* the routines the wrappers call */
+
+extern int     __real_main (int argc, char *argv[]);
+extern int     __real_open (const char *name, int flags, ...);
+extern int     __real_close (int fd);
+extern ssize_t __real_read (int fd, void *buffer, size_t maxBytes);
+extern ssize_t __real_write (int fd, const void *buffer, size_t nBytes);
+extern int     __real_ioctl (int fd, unsigned long function, ...);
+extern int     __real_select (int width, fd_set *pReadFds, fd_set *pWriteFds,
+                              fd_set *pExceptFds, struct timeval *pTimeOut);
+extern int     __real_pthread_create (pthread_t *pThread,
+                                      const pthread_attr_t *pAttr,
+                                      void *(*start) (void *), void *arg);
+
+/* the root of the system, see usrCanHost.c */
+
+extern void usrRoot (void);
+
+LOCAL void hostTickAnnounce (void);
+LOCAL void hostQuietWait (int self);
+
+
+/************************************************************************
+*
+* hostNowNs - CLOCK_MONOTONIC in ns
+*
+* RETURNS: the time
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL UINT64 hostNowNs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (UINT64) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/************************************************************************
+*
+* hostStackAlloc - map a stack below 2 GB
+*
+* RETURNS: the stack, or NULL
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void *hostStackAlloc
+(
+ size_t size
+ )
+{
+    void *pStack;
+
+    pStack = mmap (NULL, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT | MAP_STACK, -1, 0);
+
+    return (pStack == MAP_FAILED) ? NULL : pStack;
+}
+
+
+/************************************************************************
+*
+* intLock - lock out interrupts
+*
+* The lock nests; only the outermost intLock() and intUnlock() of a task
+* take and release the interrupt mutex.
+*
+* RETURNS: the lock key for intUnlock()
+*
+* ERRNO: N/A
+*
+*/
+
+int intLock (void)
+{
+    if (hostIntDepth == 0)
+        pthread_mutex_lock (&hostIntMutex);
+
+    return hostIntDepth++;
+}
+
+
+/************************************************************************
+*
+* intUnlock - cancel the effect of intLock()
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void intUnlock
+(
+ int lockKey
+ )
+{
+    if ((hostIntDepth > 0) && (--hostIntDepth == 0))
+        pthread_mutex_unlock (&hostIntMutex);
+}
+
+
+/************************************************************************
+*
+* intContext - determine if the caller runs at interrupt level
+*
+* RETURNS: TRUE in the clock thread, FALSE in a task
+*
+* ERRNO: N/A
+*
+*/
+
+BOOL intContext (void)
+{
+    return hostIntCtx;
+}
+
+
+/************************************************************************
+*
+* hostIntRelease - release the interrupt lock of a task that pends
+*
+* RETURNS: the nesting depth for hostIntRestore()
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL int hostIntRelease (void)
+{
+    int depth = hostIntDepth;
+
+    if (depth > 0)
+    {
+        hostIntDepth = 0;
+        pthread_mutex_unlock (&hostIntMutex);
+    }
+
+    return depth;
+}
+
+
+/************************************************************************
+*
+* hostIntRestore - take the interrupt lock back after a pend
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void hostIntRestore
+(
+ int depth
+ )
+{
+    if (depth > 0)
+    {
+        pthread_mutex_lock (&hostIntMutex);
+        hostIntDepth = depth;
+    }
+}
+
+
+/************************************************************************
+*
+* hostPend - pend the calling task
+*
+* This routine is called with hostKernLock held and returns with it
+* released. The task pends on the queue ppQueue, if not NULL, for at most
+* timeout ticks, until hostWake() wakes it.
+*
+* RETURNS: OK, or ERROR with errno set by the waker or to
+* S_objLib_OBJ_TIMEOUT
+*
+* ERRNO: S_objLib_OBJ_TIMEOUT, S_objLib_OBJ_DELETED
+*
+*/
+
+LOCAL STATUS hostPend
+(
+ HOST_WAIT **ppQueue,
+ int         timeout
+ )
+{
+    HOST_WAIT   wait;
+    HOST_WAIT **ppTail;
+    int         depth;
+
+    memset (&wait, 0, sizeof(wait));
+    pthread_cond_init (&wait.cond, NULL);
+    wait.pTcb = hostTcbSelf;
+    wait.error = S_objLib_OBJ_TIMEOUT;
+
+    if (ppQueue != NULL)
+    {
+        for (ppTail = ppQueue; *ppTail != NULL; ppTail = &(*ppTail)->pNext)
+            ;
+        *ppTail = &wait;
+        wait.ppQueue = ppQueue;
+    }
+
+    if (timeout != WAIT_FOREVER)
+    {
+        wait.timed = TRUE;
+        wait.deadline = hostTicks + (UINT64) timeout;
+        wait.pTimeNext = hostTimeQ;
+        hostTimeQ = &wait;
+    }
+
+    if ((hostTcbSelf != NULL) && hostTcbSelf->counted)
+    {
+        hostReady--;
+        pthread_cond_broadcast (&hostQuietCond);
+    }
+
+    depth = hostIntRelease ();
+
+    /* nobody else announces the ticks of the virtual clock */
+    while (!wait.done && wait.timed && hostClkManual &&
+           (hostTcbSelf != NULL) && (hostTcbSelf == hostRootTcb))
+    {
+        pthread_mutex_unlock (&hostKernLock);
+        hostQuietWait (0);
+        hostTickAnnounce ();
+        pthread_mutex_lock (&hostKernLock);
+    }
+
+    while (!wait.done)
+        pthread_cond_wait (&wait.cond, &hostKernLock);
+
+    pthread_mutex_unlock (&hostKernLock);
+    pthread_cond_destroy (&wait.cond);
+
+    hostIntRestore (depth);
+
+    if (wait.error != 0)
+    {
+        errno = wait.error;
+        return ERROR;
+    }
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* hostWake - wake a pending task
+*
+* This routine is called with hostKernLock held.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void hostWake
+(
+ HOST_WAIT *pWait,
+ int        error       /* errno of the task, 0 = OK */
+ )
+{
+    HOST_WAIT **ppWait;
+
+    if (pWait->ppQueue != NULL)
+    {
+        for (ppWait = pWait->ppQueue; *ppWait != pWait;
+             ppWait = &(*ppWait)->pNext)
+            ;
+        *ppWait = pWait->pNext;
+    }
+
+    if (pWait->timed)
+    {
+        for (ppWait = &hostTimeQ; *ppWait != pWait;
+             ppWait = &(*ppWait)->pTimeNext)
+            ;
+        *ppWait = pWait->pTimeNext;
+    }
+
+    if ((pWait->pTcb != NULL) && pWait->pTcb->counted)
+        hostReady++;
+
+    pWait->error = error;
+    pWait->done = TRUE;
+    pthread_cond_signal (&pWait->cond);
+}
+
+
+/************************************************************************
+*
+* hostTickAnnounce - announce a tick at interrupt level
+*
+* This routine wakes the tasks whose timeout has expired and runs the
+* watchdog routines that are due, with interrupts locked and intContext()
+* TRUE.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void hostTickAnnounce (void)
+{
+    HOST_WAIT    *pWait;
+    HOST_WAIT    *pNext;
+    struct wdog **ppWd;
+    struct wdog  *pWd;
+    FUNCPTR       routine;
+    int           parameter;
+    UINT64        start;
+
+    pthread_mutex_lock (&hostIntMutex);
+    hostIntDepth = 1;
+    hostIntCtx = TRUE;
+
+    pthread_mutex_lock (&hostKernLock);
+    hostTicks++;
+
+    for (pWait = hostTimeQ; pWait != NULL; pWait = pNext)
+    {
+        pNext = pWait->pTimeNext;
+        if (pWait->deadline <= hostTicks)
+            hostWake (pWait, S_objLib_OBJ_TIMEOUT);
+    }
+
+    /* move the due watchdogs to the run list, keeping their order */
+    for (ppWd = &hostWdQ; *ppWd != NULL; )
+    {
+        pWd = *ppWd;
+        if (pWd->expire <= hostTicks)
+        {
+            *ppWd = pWd->pNext;
+            pWd->armed = FALSE;
+            pWd->running = TRUE;
+            pWd->pNext = hostWdRun;
+            hostWdRun = pWd;
+        }
+        else
+            ppWd = &pWd->pNext;
+    }
+
+    /* a routine may cancel, restart or delete the others */
+    while (hostWdRun != NULL)
+    {
+        pWd = hostWdRun;
+        hostWdRun = pWd->pNext;
+        pWd->running = FALSE;
+        routine = pWd->routine;
+        parameter = pWd->parameter;
+
+        pthread_mutex_unlock (&hostKernLock);
+        start = hostNowNs ();
+        ((void (*) (long)) routine) ((long) parameter);
+        hostWdNs += hostNowNs () - start;
+        pthread_mutex_lock (&hostKernLock);
+    }
+
+    pthread_mutex_unlock (&hostKernLock);
+
+    hostIntCtx = FALSE;
+    hostIntDepth = 0;
+    pthread_mutex_unlock (&hostIntMutex);
+}
+
+
+/************************************************************************
+*
+* hostClkThread - the system clock
+*
+* RETURNS: never
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void *hostClkThread
+(
+ void *arg
+ )
+{
+    struct timespec next;
+    UINT64          ns;
+
+    for (;;)
+    {
+        ns = hostStartNs +
+            (hostTicks + 1) * 1000000000ULL / (UINT64) hostClkRate;
+        next.tv_sec = ns / 1000000000ULL;
+        next.tv_nsec = ns % 1000000000ULL;
+
+        while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL)
+            != 0)
+            ;
+
+        hostTickAnnounce ();
+    }
+
+    return NULL;
+}
+
+
+/************************************************************************
+*
+* hostQuietWait - wait until the other tasks have pended
+*
+* This routine waits until at most self tasks are ready to run, for at
+* most HOST_QUIET_MS of real time.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void hostQuietWait
+(
+ int self               /* 1 if the caller is counted and ready */
+ )
+{
+    struct timespec deadline;
+    UINT64          ns;
+
+    ns = hostNowNs () + HOST_QUIET_MS * 1000000ULL;
+    deadline.tv_sec = ns / 1000000000ULL;
+    deadline.tv_nsec = ns % 1000000000ULL;
+
+    pthread_mutex_lock (&hostKernLock);
+    while (hostReady > self)
+    {
+        if (pthread_cond_timedwait (&hostQuietCond, &hostKernLock,
+            &deadline) != 0)
+            break;
+    }
+    pthread_mutex_unlock (&hostKernLock);
+}
+
+
+/************************************************************************
+*
+* hostTickAdvance - announce ticks of the virtual clock
+*
+* This routine announces the given number of ticks when hostClkManual is
+* TRUE. Before each tick, and before it returns, it waits until all tasks
+* but the caller have pended, see hostQuietWait().
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void hostTickAdvance
+(
+ int ticks
+ )
+{
+    int self;
+
+    self = ((hostTcbSelf != NULL) && hostTcbSelf->counted) ? 1 : 0;
+
+    for (;;)
+    {
+        hostQuietWait (self);
+
+        if (ticks-- <= 0)
+            break;
+
+        hostTickAnnounce ();
+    }
+}
+
+
+/************************************************************************
+*
+* tickGet - get the value of the tick counter
+*
+* RETURNS: the number of ticks since the program started
+*
+* ERRNO: N/A
+*
+*/
+
+ULONG tickGet (void)
+{
+    return (ULONG) hostTicks;
+}
+
+
+/************************************************************************
+*
+* tick64Get - get the value of the tick counter as 64 bits
+*
+* RETURNS: the number of ticks since the program started
+*
+* ERRNO: N/A
+*
+*/
+
+UINT64 tick64Get (void)
+{
+    return hostTicks;
+}
+
+
+/************************************************************************
+*
+* sysClkRateGet - get the system clock rate
+*
+* RETURNS: ticks per second
+*
+* ERRNO: N/A
+*
+*/
+
+int sysClkRateGet (void)
+{
+    return hostClkRate;
+}
+
+
+/************************************************************************
+*
+* sysClkRateSet - set the system clock rate
+*
+* The rate can only be set before the clock starts, i.e. by a routine
+* that runs before main().
+*
+* RETURNS: OK, or ERROR once the clock runs
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS sysClkRateSet
+(
+ int ticksPerSecond
+ )
+{
+    if ((hostStartNs != 0) || (ticksPerSecond <= 0))
+        return ERROR;
+
+    hostClkRate = ticksPerSecond;
+    return OK;
+}
+
+
+/************************************************************************
+*
+* sysTimestampEnable - enable the timestamp counter
+*
+* RETURNS: OK
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS sysTimestampEnable (void)
+{
+    return OK;
+}
+
+
+/************************************************************************
+*
+* sysTimestamp - get the timestamp counter
+*
+* The counter runs at HOST_TS_FREQ from the last tick announced and stops
+* at the end of the tick period until the next one is. It stands still
+* on the virtual clock.
+*
+* RETURNS: counts since the last tick
+*
+* ERRNO: N/A
+*
+*/
+
+UINT32 sysTimestamp (void)
+{
+    UINT64 period = 1000000000ULL / (UINT64) hostClkRate;
+    UINT64 tickNs;
+    UINT64 now;
+
+    if (hostClkManual)
+        return 0;
+
+    tickNs = hostStartNs + hostTicks * period;
+    now = hostNowNs ();
+    if (now <= tickNs)
+        return 0;
+    if (now - tickNs >= period)
+        return sysTimestampPeriod () - 1;
+
+    return (UINT32) ((now - tickNs) * HOST_TS_FREQ / 1000000000ULL);
+}
+
+
+/************************************************************************
+*
+* sysTimestampLock - get the timestamp counter, interrupts locked
+*
+* RETURNS: counts since the last tick
+*
+* ERRNO: N/A
+*
+*/
+
+UINT32 sysTimestampLock (void)
+{
+    return sysTimestamp ();
+}
+
+
+/************************************************************************
+*
+* sysTimestampPeriod - get the period of the timestamp counter
+*
+* RETURNS: counts per tick
+*
+* ERRNO: N/A
+*
+*/
+
+UINT32 sysTimestampPeriod (void)
+{
+    return HOST_TS_FREQ / hostClkRate;
+}
+
+
+/************************************************************************
+*
+* sysTimestampFreq - get the frequency of the timestamp counter
+*
+* RETURNS: counts per second
+*
+* ERRNO: N/A
+*
+*/
+
+UINT32 sysTimestampFreq (void)
+{
+    return HOST_TS_FREQ;
+}
+
+
+/************************************************************************
+*
+* errnoSet - set the error status of the calling task
+*
+* RETURNS: OK
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS errnoSet
+(
+ int errorValue
+ )
+{
+    errno = errorValue;
+    return OK;
+}
+
+
+/************************************************************************
+*
+* errnoGet - get the error status of the calling task
+*
+* RETURNS: the error status
+*
+* ERRNO: N/A
+*
+*/
+
+int errnoGet (void)
+{
+    return errno;
+}
+
+
+/************************************************************************
+*
+* logMsg - log a formatted message to stderr
+*
+* As in VxWorks, the format takes six int arguments.
+*
+* RETURNS: the number of characters written
+*
+* ERRNO: N/A
+*
+*/
+
+int logMsg
+(
+ char *fmt,
+ ...
+ )
+{
+    va_list ap;
+    long    arg[6];
+    int     i;
+
+    va_start (ap, fmt);
+    for (i = 0; i < 6; i++)
+        arg[i] = va_arg (ap, int);
+    va_end (ap);
+
+    return fprintf (stderr, fmt, arg[0], arg[1], arg[2], arg[3], arg[4],
+        arg[5]);
+}
+
+
+/************************************************************************
+*
+* hostTaskEntry - start routine of the thread of a task
+*
+* RETURNS: NULL
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void *hostTaskEntry
+(
+ void *arg
+ )
+{
+    HOST_TCB *pTcb = (HOST_TCB *) arg;
+    int      *a = pTcb->args;
+    void     *result = NULL;
+
+    hostTcbSelf = pTcb;
+
+    if (pTcb->start != NULL)
+        result = pTcb->start (pTcb->startArg);
+    else
+        ((int (*) (long, long, long, long, long, long, long, long, long,
+            long)) pTcb->entry) (a[0], a[1], a[2], a[3], a[4], a[5], a[6],
+            a[7], a[8], a[9]);
+
+    if (pTcb->counted)
+    {
+        pthread_mutex_lock (&hostKernLock);
+        hostReady--;
+        pthread_cond_broadcast (&hostQuietCond);
+        pthread_mutex_unlock (&hostKernLock);
+    }
+
+    return result;
+}
+
+
+/************************************************************************
+*
+* hostThreadCreate - create the thread of a task or of pthread_create()
+*
+* The stack is mapped below 2 GB; it is not reclaimed when the thread
+* exits.
+*
+* RETURNS: 0, or an error number
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL int hostThreadCreate
+(
+ pthread_t            *pThread,
+ const pthread_attr_t *pAttr,     /* attributes to copy, or NULL */
+ size_t                stackSize,
+ HOST_TCB             *pTcb
+ )
+{
+    pthread_attr_t     attr;
+    struct sched_param param;
+    void              *pStack;
+    int                value;
+    int                rc;
+
+    stackSize = (stackSize + 0xfff) & ~(size_t) 0xfff;
+    if (stackSize < HOST_STACK_MIN)
+        stackSize = HOST_STACK_MIN;
+
+    pStack = hostStackAlloc (stackSize);
+    if (pStack == NULL)
+        return EAGAIN;
+
+    pthread_attr_init (&attr);
+    if (pAttr != NULL)
+    {
+        if (pthread_attr_getdetachstate (pAttr, &value) == 0)
+            pthread_attr_setdetachstate (&attr, value);
+        if (pthread_attr_getinheritsched (pAttr, &value) == 0)
+            pthread_attr_setinheritsched (&attr, value);
+        if (pthread_attr_getschedpolicy (pAttr, &value) == 0)
+            pthread_attr_setschedpolicy (&attr, value);
+        if (pthread_attr_getschedparam (pAttr, &param) == 0)
+            pthread_attr_setschedparam (&attr, &param);
+    }
+    pthread_attr_setstack (&attr, pStack, stackSize);
+
+    rc = __real_pthread_create (pThread, &attr, hostTaskEntry, pTcb);
+    pthread_attr_destroy (&attr);
+
+    if (rc != 0)
+        munmap (pStack, stackSize);
+
+    return rc;
+}
+
+
+/************************************************************************
+*
+* taskSpawn - spawn a task
+*
+* The priority and options are ignored.
+*
+* RETURNS: the task ID, or ERROR
+*
+* ERRNO: N/A
+*
+*/
+
+int taskSpawn
+(
+ char    *name,
+ int      priority,
+ int      options,
+ int      stackSize,
+ FUNCPTR  entryPt,
+ int      arg1,
+ int      arg2,
+ int      arg3,
+ int      arg4,
+ int      arg5,
+ int      arg6,
+ int      arg7,
+ int      arg8,
+ int      arg9,
+ int      arg10
+ )
+{
+    static int  taskNum;
+    HOST_TCB   *pTcb;
+    pthread_t   thread;
+
+    pTcb = (HOST_TCB *) calloc (1, sizeof(HOST_TCB));
+    if (pTcb == NULL)
+        return ERROR;
+
+    if (name != NULL)
+        strncpy (pTcb->name, name, sizeof(pTcb->name) - 1);
+    else
+        snprintf (pTcb->name, sizeof(pTcb->name), "t%d", ++taskNum);
+
+    pTcb->counted = TRUE;
+    pTcb->entry = entryPt;
+    pTcb->args[0] = arg1;
+    pTcb->args[1] = arg2;
+    pTcb->args[2] = arg3;
+    pTcb->args[3] = arg4;
+    pTcb->args[4] = arg5;
+    pTcb->args[5] = arg6;
+    pTcb->args[6] = arg7;
+    pTcb->args[7] = arg8;
+    pTcb->args[8] = arg9;
+    pTcb->args[9] = arg10;
+
+    /* the task is ready before its thread runs */
+    pthread_mutex_lock (&hostKernLock);
+    hostReady++;
+    pthread_mutex_unlock (&hostKernLock);
+
+    if (hostThreadCreate (&thread, NULL, (size_t) stackSize, pTcb) != 0)
+    {
+        pthread_mutex_lock (&hostKernLock);
+        hostReady--;
+        pthread_cond_broadcast (&hostQuietCond);
+        pthread_mutex_unlock (&hostKernLock);
+        free (pTcb);
+        return ERROR;
+    }
+
+    pthread_detach (thread);
+
+    return (int) (long) pTcb;
+}
+
+
+/************************************************************************
+*
+* taskIdSelf - get the task ID of the calling task
+*
+* RETURNS: the task ID
+*
+* ERRNO: N/A
+*
+*/
+
+int taskIdSelf (void)
+{
+    return (int) (long) hostTcbSelf;
+}
+
+
+/************************************************************************
+*
+* taskName - get the name of a task
+*
+* RETURNS: the name, or NULL
+*
+* ERRNO: N/A
+*
+*/
+
+char *taskName
+(
+ int tid
+ )
+{
+    HOST_TCB *pTcb = (HOST_TCB *) (long) tid;
+
+    if (tid == 0)
+        pTcb = hostTcbSelf;
+
+    return (pTcb != NULL) ? pTcb->name : NULL;
+}
+
+
+/************************************************************************
+*
+* taskDelay - delay the calling task
+*
+* RETURNS: OK, or ERROR at interrupt level
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS taskDelay
+(
+ int ticks
+ )
+{
+    if (hostIntCtx)
+        return ERROR;
+
+    if (ticks <= 0)
+    {
+        sched_yield ();
+        return OK;
+    }
+
+    pthread_mutex_lock (&hostKernLock);
+    hostPend (NULL, ticks);
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* taskLock - disable task rescheduling
+*
+* Tasks run in parallel on the host; taskLock() only excludes the other
+* tasks between their taskLock() and taskUnlock().
+*
+* RETURNS: OK
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS taskLock (void)
+{
+    pthread_mutex_lock (&hostTaskLockMutex);
+    return OK;
+}
+
+
+/************************************************************************
+*
+* taskUnlock - enable task rescheduling
+*
+* RETURNS: OK
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS taskUnlock (void)
+{
+    pthread_mutex_unlock (&hostTaskLockMutex);
+    return OK;
+}
+
+
+/************************************************************************
+*
+* hostSemCreate - create a semaphore
+*
+* RETURNS: the semaphore ID, or NULL
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL SEM_ID hostSemCreate
+(
+ int type,
+ int count
+ )
+{
+    SEM_ID semId;
+
+    semId = (SEM_ID) calloc (1, sizeof(struct semaphore));
+    if (semId == NULL)
+        return NULL;
+
+    semId->type = type;
+    semId->count = count;
+
+    return semId;
+}
+
+
+/************************************************************************
+*
+* semBCreate - create a binary semaphore
+*
+* RETURNS: the semaphore ID, or NULL
+*
+* ERRNO: N/A
+*
+*/
+
+SEM_ID semBCreate
+(
+ int         options,
+ SEM_B_STATE initialState
+ )
+{
+    return hostSemCreate (SEM_TYPE_BINARY, (initialState == SEM_FULL) ? 1 : 0);
+}
+
+
+/************************************************************************
+*
+* semCCreate - create a counting semaphore
+*
+* RETURNS: the semaphore ID, or NULL
+*
+* ERRNO: N/A
+*
+*/
+
+SEM_ID semCCreate
+(
+ int options,
+ int initialCount
+ )
+{
+    return hostSemCreate (SEM_TYPE_COUNTING, initialCount);
+}
+
+
+/************************************************************************
+*
+* semMCreate - create a mutual-exclusion semaphore
+*
+* Priority inheritance is not modelled.
+*
+* RETURNS: the semaphore ID, or NULL
+*
+* ERRNO: N/A
+*
+*/
+
+SEM_ID semMCreate
+(
+ int options
+ )
+{
+    return hostSemCreate (SEM_TYPE_MUTEX, 0);
+}
+
+
+/************************************************************************
+*
+* semTake - take a semaphore
+*
+* RETURNS: OK, or ERROR on timeout, deletion or at interrupt level
+*
+* ERRNO: S_objLib_OBJ_ID_ERROR, S_objLib_OBJ_UNAVAILABLE,
+* S_objLib_OBJ_TIMEOUT, S_objLib_OBJ_DELETED
+*
+*/
+
+STATUS semTake
+(
+ SEM_ID semId,
+ int    timeout
+ )
+{
+    if (semId == NULL)
+    {
+        errno = S_objLib_OBJ_ID_ERROR;
+        return ERROR;
+    }
+
+    if (hostIntCtx && ((timeout != NO_WAIT) ||
+        (semId->type == SEM_TYPE_MUTEX)))
+    {
+        errno = S_objLib_OBJ_UNAVAILABLE;
+        return ERROR;
+    }
+
+    pthread_mutex_lock (&hostKernLock);
+
+    if (semId->type == SEM_TYPE_MUTEX)
+    {
+        if ((semId->pOwner == NULL) || (semId->pOwner == hostTcbSelf))
+        {
+            semId->pOwner = hostTcbSelf;
+            semId->count++;
+            pthread_mutex_unlock (&hostKernLock);
+            return OK;
+        }
+    }
+    else if (semId->count > 0)
+    {
+        semId->count--;
+        pthread_mutex_unlock (&hostKernLock);
+        return OK;
+    }
+
+    if (timeout == NO_WAIT)
+    {
+        pthread_mutex_unlock (&hostKernLock);
+        errno = S_objLib_OBJ_UNAVAILABLE;
+        return ERROR;
+    }
+
+    /* semGive() hands the semaphore over to the task it wakes */
+    return hostPend (&semId->pQueue, timeout);
+}
+
+
+/************************************************************************
+*
+* semGive - give a semaphore
+*
+* RETURNS: OK, or ERROR if the caller does not own the mutex
+*
+* ERRNO: S_objLib_OBJ_ID_ERROR
+*
+*/
+
+STATUS semGive
+(
+ SEM_ID semId
+ )
+{
+    HOST_WAIT *pWait;
+
+    if (semId == NULL)
+    {
+        errno = S_objLib_OBJ_ID_ERROR;
+        return ERROR;
+    }
+
+    pthread_mutex_lock (&hostKernLock);
+
+    if (semId->type == SEM_TYPE_MUTEX)
+    {
+        if ((semId->pOwner != hostTcbSelf) || (semId->count == 0))
+        {
+            pthread_mutex_unlock (&hostKernLock);
+            errno = S_objLib_OBJ_ID_ERROR;
+            return ERROR;
+        }
+
+        if (--semId->count == 0)
+        {
+            semId->pOwner = NULL;
+            pWait = semId->pQueue;
+            if (pWait != NULL)
+            {
+                semId->pOwner = pWait->pTcb;
+                semId->count = 1;
+                hostWake (pWait, 0);
+            }
+        }
+    }
+    else if (semId->pQueue != NULL)
+        hostWake (semId->pQueue, 0);
+    else if (semId->type == SEM_TYPE_BINARY)
+        semId->count = 1;
+    else
+        semId->count++;
+
+    pthread_mutex_unlock (&hostKernLock);
+    return OK;
+}
+
+
+/************************************************************************
+*
+* semDelete - delete a semaphore
+*
+* The tasks pending on the semaphore return ERROR.
+*
+* RETURNS: OK, or ERROR
+*
+* ERRNO: S_objLib_OBJ_ID_ERROR
+*
+*/
+
+STATUS semDelete
+(
+ SEM_ID semId
+ )
+{
+    if (semId == NULL)
+    {
+        errno = S_objLib_OBJ_ID_ERROR;
+        return ERROR;
+    }
+
+    pthread_mutex_lock (&hostKernLock);
+    while (semId->pQueue != NULL)
+        hostWake (semId->pQueue, S_objLib_OBJ_DELETED);
+    pthread_mutex_unlock (&hostKernLock);
+
+    free (semId);
+    return OK;
+}
+
+
+/************************************************************************
+*
+* wdCreate - create a watchdog timer
+*
+* RETURNS: the watchdog ID, or NULL
+*
+* ERRNO: N/A
+*
+*/
+
+WDOG_ID wdCreate (void)
+{
+    return (WDOG_ID) calloc (1, sizeof(struct wdog));
+}
+
+
+/************************************************************************
+*
+* hostWdRemove - take a watchdog off the clock
+*
+* This routine is called with interrupts locked and hostKernLock held.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void hostWdRemove
+(
+ WDOG_ID wdId
+ )
+{
+    struct wdog **ppWd;
+
+    if (wdId->armed)
+        ppWd = &hostWdQ;
+    else if (wdId->running)
+        ppWd = &hostWdRun;
+    else
+        return;
+
+    for ( ; *ppWd != wdId; ppWd = &(*ppWd)->pNext)
+        ;
+    *ppWd = wdId->pNext;
+
+    wdId->armed = FALSE;
+    wdId->running = FALSE;
+}
+
+
+/************************************************************************
+*
+* wdStart - start a watchdog timer
+*
+* The routine runs at interrupt level on the tick <delay> ticks from now,
+* on the next tick if delay is 0.
+*
+* RETURNS: OK, or ERROR
+*
+* ERRNO: S_objLib_OBJ_ID_ERROR
+*
+*/
+
+STATUS wdStart
+(
+ WDOG_ID wdId,
+ int     delay,
+ FUNCPTR pRoutine,
+ int     parameter
+ )
+{
+    int key;
+
+    if (wdId == NULL)
+    {
+        errno = S_objLib_OBJ_ID_ERROR;
+        return ERROR;
+    }
+
+    key = intLock ();
+    pthread_mutex_lock (&hostKernLock);
+
+    hostWdRemove (wdId);
+    wdId->routine = pRoutine;
+    wdId->parameter = parameter;
+    wdId->expire = hostTicks + ((delay > 0) ? (UINT64) delay : 1);
+    wdId->armed = TRUE;
+    wdId->pNext = hostWdQ;
+    hostWdQ = wdId;
+
+    pthread_mutex_unlock (&hostKernLock);
+    intUnlock (key);
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* wdCancel - cancel a watchdog timer
+*
+* RETURNS: OK, or ERROR
+*
+* ERRNO: S_objLib_OBJ_ID_ERROR
+*
+*/
+
+STATUS wdCancel
+(
+ WDOG_ID wdId
+ )
+{
+    int key;
+
+    if (wdId == NULL)
+    {
+        errno = S_objLib_OBJ_ID_ERROR;
+        return ERROR;
+    }
+
+    key = intLock ();
+    pthread_mutex_lock (&hostKernLock);
+    hostWdRemove (wdId);
+    pthread_mutex_unlock (&hostKernLock);
+    intUnlock (key);
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* wdDelete - delete a watchdog timer
+*
+* RETURNS: OK, or ERROR
+*
+* ERRNO: S_objLib_OBJ_ID_ERROR
+*
+*/
+
+STATUS wdDelete
+(
+ WDOG_ID wdId
+ )
+{
+    if (wdCancel (wdId) != OK)
+        return ERROR;
+
+    free (wdId);
+    return OK;
+}
+
+
+/************************************************************************
+*
+* selWakeupListInit - initialize a select() wake-up list
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void selWakeupListInit
+(
+ SEL_WAKEUP_LIST *pWakeupList
+ )
+{
+    pWakeupList->pFirst = NULL;
+}
+
+
+/************************************************************************
+*
+* selWakeupListTerm - terminate a select() wake-up list
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void selWakeupListTerm
+(
+ SEL_WAKEUP_LIST *pWakeupList
+ )
+{
+    SEL_WAKEUP_NODE *pNode;
+
+    pthread_mutex_lock (&hostKernLock);
+    while ((pNode = pWakeupList->pFirst) != NULL)
+    {
+        pWakeupList->pFirst = pNode->pNext;
+        free (pNode);
+    }
+    pthread_mutex_unlock (&hostKernLock);
+}
+
+
+/************************************************************************
+*
+* selWakeupListLen - count the nodes of a select() wake-up list
+*
+* RETURNS: the number of nodes
+*
+* ERRNO: N/A
+*
+*/
+
+int selWakeupListLen
+(
+ SEL_WAKEUP_LIST *pWakeupList
+ )
+{
+    SEL_WAKEUP_NODE *pNode;
+    int              len = 0;
+
+    pthread_mutex_lock (&hostKernLock);
+    for (pNode = pWakeupList->pFirst; pNode != NULL; pNode = pNode->pNext)
+        len++;
+    pthread_mutex_unlock (&hostKernLock);
+
+    return len;
+}
+
+
+/************************************************************************
+*
+* selNodeAdd - add a copy of a wake-up node to a select() wake-up list
+*
+* RETURNS: OK, or ERROR if out of memory
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS selNodeAdd
+(
+ SEL_WAKEUP_LIST *pWakeupList,
+ SEL_WAKEUP_NODE *pWakeupNode
+ )
+{
+    SEL_WAKEUP_NODE *pNode;
+
+    pNode = (SEL_WAKEUP_NODE *) malloc (sizeof(SEL_WAKEUP_NODE));
+    if (pNode == NULL)
+        return ERROR;
+
+    *pNode = *pWakeupNode;
+
+    pthread_mutex_lock (&hostKernLock);
+    pNode->pNext = pWakeupList->pFirst;
+    pWakeupList->pFirst = pNode;
+    pthread_mutex_unlock (&hostKernLock);
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* selNodeDelete - remove a wake-up node from a select() wake-up list
+*
+* RETURNS: OK, or ERROR if the node is not in the list
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS selNodeDelete
+(
+ SEL_WAKEUP_LIST *pWakeupList,
+ SEL_WAKEUP_NODE *pWakeupNode
+ )
+{
+    SEL_WAKEUP_NODE **ppNode;
+    SEL_WAKEUP_NODE  *pNode;
+
+    pthread_mutex_lock (&hostKernLock);
+    for (ppNode = &pWakeupList->pFirst; (pNode = *ppNode) != NULL;
+         ppNode = &pNode->pNext)
+    {
+        if ((pNode->pWaiter == pWakeupNode->pWaiter) &&
+            (pNode->fd == pWakeupNode->fd) &&
+            (pNode->type == pWakeupNode->type))
+        {
+            *ppNode = pNode->pNext;
+            pthread_mutex_unlock (&hostKernLock);
+            free (pNode);
+            return OK;
+        }
+    }
+    pthread_mutex_unlock (&hostKernLock);
+
+    return ERROR;
+}
+
+
+/************************************************************************
+*
+* selWakeupType - get the type of a wake-up node
+*
+* RETURNS: SELREAD or SELWRITE
+*
+* ERRNO: N/A
+*
+*/
+
+SELECT_TYPE selWakeupType
+(
+ SEL_WAKEUP_NODE *pWakeupNode
+ )
+{
+    return pWakeupNode->type;
+}
+
+
+/************************************************************************
+*
+* hostSelWake - mark the file descriptor of a node ready
+*
+* This routine is called with hostKernLock held.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void hostSelWake
+(
+ SEL_WAKEUP_NODE *pWakeupNode
+ )
+{
+    struct hostSelWaiter *pWaiter = pWakeupNode->pWaiter;
+
+    if (pWakeupNode->type == SELREAD)
+        FD_SET (pWakeupNode->fd, &pWaiter->readFds);
+    else
+        FD_SET (pWakeupNode->fd, &pWaiter->writeFds);
+
+    pWaiter->ready = TRUE;
+    if (pWaiter->pQueue != NULL)
+    {
+        hostSelWakes++;
+        hostWake (pWaiter->pQueue, 0);
+    }
+}
+
+
+/************************************************************************
+*
+* selWakeup - wake the select() call of a wake-up node
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void selWakeup
+(
+ SEL_WAKEUP_NODE *pWakeupNode
+ )
+{
+    pthread_mutex_lock (&hostKernLock);
+    hostSelWake (pWakeupNode);
+    pthread_mutex_unlock (&hostKernLock);
+}
+
+
+/************************************************************************
+*
+* selWakeupAll - wake the select() calls of a list for one type
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void selWakeupAll
+(
+ SEL_WAKEUP_LIST *pWakeupList,
+ SELECT_TYPE      type
+ )
+{
+    SEL_WAKEUP_NODE *pNode;
+
+    pthread_mutex_lock (&hostKernLock);
+    hostSelWakeupAlls++;
+    for (pNode = pWakeupList->pFirst; pNode != NULL; pNode = pNode->pNext)
+    {
+        if (pNode->type == type)
+            hostSelWake (pNode);
+    }
+    pthread_mutex_unlock (&hostKernLock);
+}
+
+
+/************************************************************************
+*
+* iosDrvInstall - install a driver
+*
+* RETURNS: the driver number, or ERROR if the table is full
+*
+* ERRNO: N/A
+*
+*/
+
+int iosDrvInstall
+(
+ FUNCPTR pCreate,
+ FUNCPTR pDelete,
+ FUNCPTR pOpen,
+ FUNCPTR pClose,
+ FUNCPTR pRead,
+ FUNCPTR pWrite,
+ FUNCPTR pIoctl
+ )
+{
+    int drvNum;
+
+    pthread_mutex_lock (&hostIosLock);
+
+    /* driver number 0 is not used, as in VxWorks */
+    for (drvNum = 1; drvNum < HOST_NUM_DRV; drvNum++)
+    {
+        if (!hostDrvTbl[drvNum].inUse)
+        {
+            hostDrvTbl[drvNum].pCreate = pCreate;
+            hostDrvTbl[drvNum].pDelete = pDelete;
+            hostDrvTbl[drvNum].pOpen = pOpen;
+            hostDrvTbl[drvNum].pClose = pClose;
+            hostDrvTbl[drvNum].pRead = pRead;
+            hostDrvTbl[drvNum].pWrite = pWrite;
+            hostDrvTbl[drvNum].pIoctl = pIoctl;
+            hostDrvTbl[drvNum].inUse = TRUE;
+            pthread_mutex_unlock (&hostIosLock);
+            return drvNum;
+        }
+    }
+
+    pthread_mutex_unlock (&hostIosLock);
+    return ERROR;
+}
+
+
+/************************************************************************
+*
+* iosDrvRemove - remove a driver
+*
+* RETURNS: OK, or ERROR if a file of the driver is open and forceClose is
+* FALSE
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS iosDrvRemove
+(
+ int  drvNum,
+ BOOL forceClose
+ )
+{
+    int fd;
+
+    if ((drvNum <= 0) || (drvNum >= HOST_NUM_DRV))
+        return ERROR;
+
+    pthread_mutex_lock (&hostIosLock);
+    for (fd = 0; fd < FD_SETSIZE; fd++)
+    {
+        if (hostFdTbl[fd].inUse && (hostFdTbl[fd].drvNum == drvNum))
+        {
+            pthread_mutex_unlock (&hostIosLock);
+            if (!forceClose)
+                return ERROR;
+            close (fd);
+            pthread_mutex_lock (&hostIosLock);
+        }
+    }
+    hostDrvTbl[drvNum].inUse = FALSE;
+    pthread_mutex_unlock (&hostIosLock);
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* iosDevAdd - add a device to the I/O system
+*
+* RETURNS: OK, or ERROR if the name is taken
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS iosDevAdd
+(
+ DEV_HDR    *pDevHdr,
+ const char *name,
+ int         drvNum
+ )
+{
+    DEV_HDR *pDev;
+
+    pthread_mutex_lock (&hostIosLock);
+
+    for (pDev = hostDevList; pDev != NULL; pDev = pDev->pNext)
+    {
+        if (strcmp (pDev->name, name) == 0)
+        {
+            pthread_mutex_unlock (&hostIosLock);
+            return ERROR;
+        }
+    }
+
+    pDevHdr->name = strdup (name);
+    if (pDevHdr->name == NULL)
+    {
+        pthread_mutex_unlock (&hostIosLock);
+        return ERROR;
+    }
+
+    pDevHdr->drvNum = (short) drvNum;
+    pDevHdr->pNext = hostDevList;
+    hostDevList = pDevHdr;
+
+    pthread_mutex_unlock (&hostIosLock);
+    return OK;
+}
+
+
+/************************************************************************
+*
+* iosDevDelete - delete a device from the I/O system
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void iosDevDelete
+(
+ DEV_HDR *pDevHdr
+ )
+{
+    DEV_HDR **ppDev;
+
+    pthread_mutex_lock (&hostIosLock);
+    for (ppDev = &hostDevList; *ppDev != NULL; ppDev = &(*ppDev)->pNext)
+    {
+        if (*ppDev == pDevHdr)
+        {
+            *ppDev = pDevHdr->pNext;
+            free (pDevHdr->name);
+            pDevHdr->name = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock (&hostIosLock);
+}
+
+
+/************************************************************************
+*
+* iosDevFind - find the device of a file name
+*
+* The device is the one with the longest name that begins the file name;
+* pNameTail gets the rest of the file name.
+*
+* RETURNS: the device, or NULL
+*
+* ERRNO: N/A
+*
+*/
+
+DEV_HDR *iosDevFind
+(
+ const char  *name,
+ const char **pNameTail
+ )
+{
+    DEV_HDR *pDev;
+    DEV_HDR *pBest = NULL;
+    size_t   len;
+    size_t   bestLen = 0;
+
+    pthread_mutex_lock (&hostIosLock);
+    for (pDev = hostDevList; pDev != NULL; pDev = pDev->pNext)
+    {
+        len = strlen (pDev->name);
+        if ((len > bestLen) && (strncmp (pDev->name, name, len) == 0))
+        {
+            pBest = pDev;
+            bestLen = len;
+        }
+    }
+    pthread_mutex_unlock (&hostIosLock);
+
+    if (pNameTail != NULL)
+        *pNameTail = name + bestLen;
+
+    return pBest;
+}
+
+
+/************************************************************************
+*
+* hostFdDrv - get the driver of a device file descriptor
+*
+* RETURNS: the driver, or NULL if fd is not open on a device
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL HOST_DRV *hostFdDrv
+(
+ int  fd,
+ int *pValue
+ )
+{
+    if ((fd < 0) || (fd >= FD_SETSIZE) || !hostFdTbl[fd].inUse)
+        return NULL;
+
+    *pValue = hostFdTbl[fd].value;
+    return &hostDrvTbl[hostFdTbl[fd].drvNum];
+}
+
+
+/************************************************************************
+*
+* __wrap_open - open a file or device
+*
+* RETURNS: a file descriptor, or ERROR
+*
+* ERRNO: as set by the driver or the C library
+*
+*/
+
+int __wrap_open
+(
+ const char *name,
+ int         flags,
+ ...
+ )
+{
+    DEV_HDR    *pDev;
+    HOST_DRV   *pDrv;
+    const char *pTail;
+    va_list     ap;
+    int         mode = 0;
+    int         value;
+    int         fd;
+
+    if (flags & O_CREAT)
+    {
+        va_start (ap, flags);
+        mode = va_arg (ap, int);
+        va_end (ap);
+    }
+
+    pDev = iosDevFind (name, &pTail);
+    if (pDev == NULL)
+        return __real_open (name, flags, mode);
+
+    pDrv = &hostDrvTbl[pDev->drvNum];
+    if (pDrv->pOpen == NULL)
+    {
+        errno = S_ioLib_NO_DRIVER;
+        return ERROR;
+    }
+
+    fd = __real_open ("/dev/null", O_RDWR);
+    if (fd < 0)
+        return ERROR;
+    if (fd >= FD_SETSIZE)
+    {
+        __real_close (fd);
+        errno = EMFILE;
+        return ERROR;
+    }
+
+    value = pDrv->pOpen (pDev, pTail, flags, mode);
+    if (value == ERROR)
+    {
+        __real_close (fd);
+        return ERROR;
+    }
+
+    pthread_mutex_lock (&hostIosLock);
+    hostFdTbl[fd].drvNum = pDev->drvNum;
+    hostFdTbl[fd].value = value;
+    hostFdTbl[fd].pDevHdr = pDev;
+    hostFdTbl[fd].inUse = TRUE;
+    pthread_mutex_unlock (&hostIosLock);
+
+    return fd;
+}
+
+
+/************************************************************************
+*
+* __wrap_close - close a file or device
+*
+* RETURNS: OK, or ERROR
+*
+* ERRNO: as set by the driver or the C library
+*
+*/
+
+int __wrap_close
+(
+ int fd
+ )
+{
+    HOST_DRV *pDrv;
+    int       value;
+    int       status = OK;
+
+    pDrv = hostFdDrv (fd, &value);
+    if (pDrv == NULL)
+        return __real_close (fd);
+
+    pthread_mutex_lock (&hostIosLock);
+    hostFdTbl[fd].inUse = FALSE;
+    pthread_mutex_unlock (&hostIosLock);
+
+    if (pDrv->pClose != NULL)
+        status = pDrv->pClose ((long) value);
+
+    __real_close (fd);
+
+    return status;
+}
+
+
+/************************************************************************
+*
+* __wrap_read - read from a file or device
+*
+* RETURNS: the number of bytes read, or ERROR
+*
+* ERRNO: as set by the driver or the C library
+*
+*/
+
+ssize_t __wrap_read
+(
+ int     fd,
+ void   *buffer,
+ size_t  maxBytes
+ )
+{
+    HOST_DRV *pDrv;
+    int       value;
+
+    pDrv = hostFdDrv (fd, &value);
+    if (pDrv == NULL)
+        return __real_read (fd, buffer, maxBytes);
+
+    if (pDrv->pRead == NULL)
+    {
+        errno = S_ioLib_UNKNOWN_REQUEST;
+        return ERROR;
+    }
+
+    return pDrv->pRead ((long) value, buffer, maxBytes);
+}
+
+
+/************************************************************************
+*
+* __wrap_write - write to a file or device
+*
+* RETURNS: the number of bytes written, or ERROR
+*
+* ERRNO: as set by the driver or the C library
+*
+*/
+
+ssize_t __wrap_write
+(
+ int         fd,
+ const void *buffer,
+ size_t      nBytes
+ )
+{
+    HOST_DRV *pDrv;
+    int       value;
+
+    pDrv = hostFdDrv (fd, &value);
+    if (pDrv == NULL)
+        return __real_write (fd, buffer, nBytes);
+
+    if (pDrv->pWrite == NULL)
+    {
+        errno = S_ioLib_UNKNOWN_REQUEST;
+        return ERROR;
+    }
+
+    return pDrv->pWrite ((long) value, buffer, nBytes);
+}
+
+
+/************************************************************************
+*
+* __wrap_ioctl - perform an I/O control function
+*
+* The argument is an int, as in VxWorks.
+*
+* RETURNS: the driver's return value, or ERROR
+*
+* ERRNO: as set by the driver or the C library
+*
+*/
+
+int __wrap_ioctl
+(
+ int fd,
+ int function,
+ ...
+ )
+{
+    HOST_DRV *pDrv;
+    va_list   ap;
+    int       arg;
+    int       value;
+
+    va_start (ap, function);
+    arg = va_arg (ap, int);
+    va_end (ap);
+
+    pDrv = hostFdDrv (fd, &value);
+    if (pDrv == NULL)
+        return __real_ioctl (fd, (unsigned long) function, (long) arg);
+
+    if (pDrv->pIoctl == NULL)
+    {
+        errno = S_ioLib_UNKNOWN_REQUEST;
+        return ERROR;
+    }
+
+    return pDrv->pIoctl ((long) value, function, (long) arg);
+}
+
+
+/************************************************************************
+*
+* __wrap_select - pend on a set of file descriptors
+*
+* Device file descriptors are armed with FIOSELECT; when the sets also
+* hold other file descriptors, those are polled on every tick.
+*
+* RETURNS: the number of file descriptors ready, 0 on timeout, or ERROR
+*
+* ERRNO: as set by the drivers or the C library
+*
+*/
+
+int __wrap_select
+(
+ int             width,
+ fd_set         *pReadFds,
+ fd_set         *pWriteFds,
+ fd_set         *pExceptFds,
+ struct timeval *pTimeOut
+ )
+{
+    struct hostSelWaiter *pWaiter;
+    SEL_WAKEUP_NODE      *pNodes;
+    HOST_DRV             *pDrv;
+    fd_set                realRead;
+    fd_set                realWrite;
+    struct timeval        zero;
+    BOOL                  realFds = FALSE;
+    int                   numNodes = 0;
+    int                   numReady;
+    int                   ticks;
+    int                   value;
+    int                   fd;
+    int                   i;
+
+    if (width > FD_SETSIZE)
+        width = FD_SETSIZE;
+
+    FD_ZERO (&realRead);
+    FD_ZERO (&realWrite);
+    for (fd = 0; fd < width; fd++)
+    {
+        BOOL rd = (pReadFds != NULL) && FD_ISSET (fd, pReadFds);
+        BOOL wr = (pWriteFds != NULL) && FD_ISSET (fd, pWriteFds);
+
+        if (hostFdDrv (fd, &value) != NULL)
+            numNodes += (rd ? 1 : 0) + (wr ? 1 : 0);
+        else
+        {
+            if (rd)
+                FD_SET (fd, &realRead);
+            if (wr)
+                FD_SET (fd, &realWrite);
+            realFds |= rd || wr;
+        }
+    }
+
+    if (numNodes == 0)
+        return __real_select (width, pReadFds, pWriteFds, pExceptFds,
+            pTimeOut);
+
+    pWaiter = (struct hostSelWaiter *) calloc (1, sizeof(*pWaiter));
+    pNodes = (SEL_WAKEUP_NODE *) calloc (numNodes, sizeof(SEL_WAKEUP_NODE));
+    if ((pWaiter == NULL) || (pNodes == NULL))
+    {
+        free (pWaiter);
+        free (pNodes);
+        errno = ENOMEM;
+        return ERROR;
+    }
+
+    /* arm the devices; one that is ready wakes us right away */
+    for (fd = 0, i = 0; fd < width; fd++)
+    {
+        if ((pDrv = hostFdDrv (fd, &value)) == NULL)
+            continue;
+
+        if ((pReadFds != NULL) && FD_ISSET (fd, pReadFds))
+        {
+            pNodes[i].pWaiter = pWaiter;
+            pNodes[i].fd = fd;
+            pNodes[i].type = SELREAD;
+            pDrv->pIoctl ((long) value, FIOSELECT, (long) &pNodes[i++]);
+        }
+        if ((pWriteFds != NULL) && FD_ISSET (fd, pWriteFds))
+        {
+            pNodes[i].pWaiter = pWaiter;
+            pNodes[i].fd = fd;
+            pNodes[i].type = SELWRITE;
+            pDrv->pIoctl ((long) value, FIOSELECT, (long) &pNodes[i++]);
+        }
+    }
+
+    if (pTimeOut == NULL)
+        ticks = WAIT_FOREVER;
+    else
+        ticks = (int) (((UINT64) pTimeOut->tv_sec * 1000000 +
+            pTimeOut->tv_usec) * hostClkRate + 999999) / 1000000;
+
+    for (;;)
+    {
+        if (realFds)
+        {
+            fd_set rd = realRead;
+            fd_set wr = realWrite;
+
+            memset (&zero, 0, sizeof(zero));
+            if (__real_select (width, &rd, &wr, NULL, &zero) > 0)
+            {
+                pthread_mutex_lock (&hostKernLock);
+                for (fd = 0; fd < width; fd++)
+                {
+                    if (FD_ISSET (fd, &rd))
+                        FD_SET (fd, &pWaiter->readFds);
+                    if (FD_ISSET (fd, &wr))
+                        FD_SET (fd, &pWaiter->writeFds);
+                }
+                pWaiter->ready = TRUE;
+                pthread_mutex_unlock (&hostKernLock);
+            }
+        }
+
+        pthread_mutex_lock (&hostKernLock);
+        if (pWaiter->ready || (ticks == 0))
+        {
+            pthread_mutex_unlock (&hostKernLock);
+            break;
+        }
+
+        /* with other file descriptors, look at them again next tick */
+        hostPend (&pWaiter->pQueue, realFds ? 1 : ticks);
+
+        if (realFds && (ticks != WAIT_FOREVER))
+            ticks--;
+        else if (!realFds)
+            ticks = 0;
+    }
+
+    for (i = 0; i < numNodes; i++)
+    {
+        if ((pDrv = hostFdDrv (pNodes[i].fd, &value)) != NULL)
+            pDrv->pIoctl ((long) value, FIOUNSELECT, (long) &pNodes[i]);
+    }
+
+    pthread_mutex_lock (&hostKernLock);
+    numReady = 0;
+    for (fd = 0; fd < width; fd++)
+    {
+        if (pReadFds != NULL)
+        {
+            if (FD_ISSET (fd, pReadFds) && FD_ISSET (fd, &pWaiter->readFds))
+                numReady++;
+            else
+                FD_CLR (fd, pReadFds);
+        }
+        if (pWriteFds != NULL)
+        {
+            if (FD_ISSET (fd, pWriteFds) && FD_ISSET (fd, &pWaiter->writeFds))
+                numReady++;
+            else
+                FD_CLR (fd, pWriteFds);
+        }
+    }
+    pthread_mutex_unlock (&hostKernLock);
+
+    if (pExceptFds != NULL)
+        FD_ZERO (pExceptFds);
+
+    free (pNodes);
+    free (pWaiter);
+
+    return numReady;
+}
+
+
+/************************************************************************
+*
+* __wrap_pthread_create - create a thread with its stack below 2 GB
+*
+* RETURNS: 0, or an error number
+*
+* ERRNO: N/A
+*
+*/
+
+int __wrap_pthread_create
+(
+ pthread_t            *pThread,
+ const pthread_attr_t *pAttr,
+ void *             (*start) (void *),
+ void                 *arg
+ )
+{
+    HOST_TCB *pTcb;
+    size_t    stackSize = HOST_STACK_DEFAULT;
+    int       rc;
+
+    pTcb = (HOST_TCB *) calloc (1, sizeof(HOST_TCB));
+    if (pTcb == NULL)
+        return EAGAIN;
+
+    strcpy (pTcb->name, "pthread");
+    pTcb->start = start;
+    pTcb->startArg = arg;
+
+    if (pAttr != NULL)
+        pthread_attr_getstacksize (pAttr, &stackSize);
+
+    rc = hostThreadCreate (pThread, pAttr, stackSize, pTcb);
+    if (rc != 0)
+        free (pTcb);
+
+    return rc;
+}
+
+
+/************************************************************************
+*
+* hostRootTask - the root task
+*
+* This routine checks that the addresses the stack sees fit into an int,
+* initializes the system with usrRoot() and runs main().
+*
+* RETURNS: never; exits the program with the status of main()
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void hostRootTask (void)
+{
+    int   local;
+    void *pHeap = malloc (64);
+
+    if (((long) (int) (long) pHeap != (long) pHeap) ||
+        ((long) (int) (long) &local != (long) &local))
+    {
+        fprintf (stderr, "hostOs: memory above 2 GB (heap %p, stack %p), "
+            "link without PIE\n", pHeap, (void *) &local);
+        exit (EXIT_FAILURE);
+    }
+    free (pHeap);
+
+    hostRootTcb = hostTcbSelf;
+    usrRoot ();
+
+    exit (__real_main (hostArgc, hostArgv));
+}
+
+
+/************************************************************************
+*
+* __wrap_main - start the system
+*
+* This routine keeps the heap in the program break, starts the system
+* clock unless hostClkManual is TRUE, and runs main() in the root task.
+*
+* RETURNS: never
+*
+* ERRNO: N/A
+*
+*/
+
+int __wrap_main
+(
+ int   argc,
+ char *argv[]
+ )
+{
+    pthread_t thread;
+
+    mallopt (M_ARENA_MAX, 1);
+    mallopt (M_MMAP_MAX, 0);
+
+    hostArgc = argc;
+    hostArgv = argv;
+    hostStartNs = hostNowNs ();
+
+    if (!hostClkManual &&
+        (__real_pthread_create (&thread, NULL, hostClkThread, NULL) != 0))
+    {
+        fprintf (stderr, "hostOs: cannot start the system clock\n");
+        return EXIT_FAILURE;
+    }
+
+    if (taskSpawn ("tRoot", 0, 0, HOST_STACK_DEFAULT,
+        (FUNCPTR) hostRootTask, 0,0,0,0,0,0,0,0,0,0) == ERROR)
+    {
+        fprintf (stderr, "hostOs: cannot start the root task\n");
+        return EXIT_FAILURE;
+    }
+
+    for (;;)
+        pause ();
+
+    return EXIT_SUCCESS;
+}
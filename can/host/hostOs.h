@@ -0,0 +1,39 @@
+/* hostOs.h - host build: routines of the kernel shim for host programs */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+This header declares the routines and counters of hostOs.c that have no
+VxWorks counterpart and are used by the host tests.
+*/
+
+#ifndef __INChostOsh
+#define __INChostOsh
+
+#include <vxWorks.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* define as TRUE to run on the virtual clock of hostTickAdvance() */
+extern BOOL hostClkManual;
+
+extern void hostTickAdvance (int ticks);
+
+/* selWakeupAll() calls, pending select() calls woken and the time spent
+   in watchdog routines, at interrupt level, in ns */
+extern ULONG  hostSelWakeupAlls;
+extern ULONG  hostSelWakes;
+extern UINT64 hostWdNs;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INChostOsh */
@@ -0,0 +1,334 @@
+/* busOffTest.c - host test: automatic bus-off recovery */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This program checks the bus-off recovery of WNCAN_BusOffRecoverySet()
+and of the DevIO driver on the simulated board. sys_PR6120_CAN_SimFaultSet()
+makes the transmissions of /can/0 fail until it goes bus off; the fault is
+removed as soon as the recovery task waits, so the restart succeeds.
+
+The checks are:
+
+  - repeated bus offs within the stable time double the back-off delay
+    from minDelay up to maxDelay, and the restart comes no earlier than
+    the delay;
+  - a bus off after the controller was error active for the stable time
+    waits minDelay again;
+  - with WNCAN_BUSOFF_TX_KEEP the frames queued behind the lost one are
+    sent after the recovery;
+  - with WNCAN_BUSOFF_TX_FLUSH they are dropped at the bus off and counted
+    in txDropped, and nothing is sent after the recovery.
+
+The program runs on the virtual clock of hostOs.c, so a tick passes only
+when hostTickAdvance() is called and the delays are counted exactly.
+
+RETURNS: 0 if the test passes, 1 otherwise
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <ioLib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sysLib.h>
+#include <tickLib.h>
+
+#include "CAN/wnCAN.h"
+#include "CAN/wncanDevIO.h"
+#include "testPort.h"
+#include "hostOs.h"
+
+/* defines */
+#define BOFF_RBUF_SIZE  64
+#define BOFF_WBUF_SIZE  16
+#define BOFF_MIN_DELAY  10      /* ms */
+#define BOFF_MAX_DELAY  80      /* ms */
+#define BOFF_STABLE     500     /* ms */
+#define BOFF_QUEUED     5       /* frames written for a bus off */
+#define BOFF_TICKS_MAX  2000    /* bound of a wait, in ticks */
+
+#define BOFF_CHECK(cond, what)                                  \
+    do                                                          \
+    {                                                           \
+        if (!(cond))                                            \
+        {                                                       \
+            printf ("busOffTest: %s (line %d)\n", what, __LINE__); \
+            return ERROR;                                       \
+        }                                                       \
+    } while (0)
+
+/* the clock of hostOs.c runs only in hostTickAdvance() */
+BOOL hostClkManual = TRUE;
+
+extern STATUS sys_PR6120_CAN_SimFaultSet (UINT brdNum, UINT ctrlNum,
+                                          BOOL fault);
+
+LOCAL TEST_PORT tx;
+LOCAL TEST_PORT rx;
+LOCAL int       frameNo;
+
+/************************************************************************
+*
+* boffState - get the recovery state of /can/0
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS boffState
+(
+    WNCAN_BusOffStats *pStats
+)
+{
+    return ioctl (tx.fdCtr, WNCAN_BUSOFF_GET, (int)pStats);
+}
+
+/************************************************************************
+*
+* boffWaitState - advance the clock until /can/0 reaches a recovery state
+*
+* RETURNS: the ticks advanced, or ERROR on a timeout
+*
+* ERRNO: N/A
+*
+*/
+LOCAL int boffWaitState
+(
+    UINT state
+)
+{
+    WNCAN_BusOffStats st;
+    int               ticks;
+
+    for (ticks = 0; ticks < BOFF_TICKS_MAX; ticks++)
+    {
+        if ((boffState (&st) == OK) && (st.state == state))
+            return ticks;
+        hostTickAdvance (1);
+    }
+
+    printf ("busOffTest: state %u not reached\n", state);
+    return ERROR;
+}
+
+/************************************************************************
+*
+* boffRead - read the frames received by /can/1
+*
+* RETURNS: the number of frames read
+*
+* ERRNO: N/A
+*
+*/
+LOCAL int boffRead (void)
+{
+    WNCAN_CHNMSG msg[BOFF_RBUF_SIZE];
+    int          n;
+
+    n = read (rx.fdChn, (char *)msg, sizeof (msg));
+    return (n > 0) ? n / (int)sizeof (WNCAN_CHNMSG) : 0;
+}
+
+/************************************************************************
+*
+* boffCycle - drive /can/0 into bus off and through the recovery
+*
+* This routine turns the fault on, writes <queued> frames, waits for the
+* bus off and turns the fault off. It then waits for the recovery and
+* checks that it took no less than the expected back-off <delay> and
+* that the controller was restarted once.
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS boffCycle
+(
+    UINT delay,
+    int  queued
+)
+{
+    WNCAN_BusOffStats before;
+    WNCAN_BusOffStats st;
+    WNCAN_CHNMSG      msg[BOFF_QUEUED];
+    int               ticks;
+    int               i;
+
+    BOFF_CHECK (boffState (&before) == OK, "WNCAN_BUSOFF_GET failed");
+
+    memset (msg, 0, sizeof (msg));
+    for (i = 0; i < queued; i++, frameNo++)
+    {
+        msg[i].id = 0x200 + (frameNo & 0xff);
+        msg[i].len = 1;
+        msg[i].data[0] = (UCHAR)frameNo;
+    }
+
+    sys_PR6120_CAN_SimFaultSet (0, 0, TRUE);
+    BOFF_CHECK (write (tx.fdChn, (char *)msg, queued * sizeof (WNCAN_CHNMSG))
+                == queued * (int)sizeof (WNCAN_CHNMSG), "write failed");
+    BOFF_CHECK (boffWaitState (WNCAN_BUSOFF_WAIT) != ERROR, "no bus off");
+    sys_PR6120_CAN_SimFaultSet (0, 0, FALSE);
+
+    BOFF_CHECK ((ticks = boffWaitState (WNCAN_BUSOFF_ON_BUS)) != ERROR,
+                "no recovery");
+    BOFF_CHECK (boffState (&st) == OK, "WNCAN_BUSOFF_GET failed");
+
+    if (st.delay != delay)
+    {
+        printf ("busOffTest: back-off delay %u ms, expected %u ms\n",
+                st.delay, delay);
+        return ERROR;
+    }
+    if (ticks < (int)(delay * sysClkRateGet () / 1000))
+    {
+        printf ("busOffTest: recovered after %d ticks, delay %u ms\n",
+                ticks, delay);
+        return ERROR;
+    }
+    BOFF_CHECK (st.busOffs == before.busOffs + 1, "bus off not counted");
+    BOFF_CHECK (st.restarts == before.restarts + 1, "restart not counted");
+    BOFF_CHECK (st.recoveries == before.recoveries + 1,
+                "recovery not counted");
+
+    /* let the frames kept in the output buffer go out */
+    hostTickAdvance (10);
+    return OK;
+}
+
+/************************************************************************
+*
+* boffPolicySet - turn on the recovery with a TX policy
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS boffPolicySet
+(
+    UINT txPolicy
+)
+{
+    WNCAN_BusOffCfg cfg;
+
+    cfg.enable = TRUE;
+    cfg.minDelay = BOFF_MIN_DELAY;
+    cfg.maxDelay = BOFF_MAX_DELAY;
+    cfg.stableTime = BOFF_STABLE;
+    cfg.txPolicy = txPolicy;
+    return ioctl (tx.fdCtr, WNCAN_BUSOFF_SET, (int)&cfg);
+}
+
+/************************************************************************
+*
+* boffTest - run the checks
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS boffTest (void)
+{
+    static const UINT delays[] = {10, 20, 40, 80, 80};
+    WNCAN_STATS       st;
+    WNCAN_CHNMSG      msg;
+    int               i;
+    int               n;
+
+    BOFF_CHECK ((testPortOpen (&tx, "/can/0", FALSE, BOFF_WBUF_SIZE) == OK) &&
+                (testPortOpen (&rx, "/can/1", TRUE, BOFF_RBUF_SIZE) == OK),
+                "opening the ports failed");
+    BOFF_CHECK (boffPolicySet (WNCAN_BUSOFF_TX_KEEP) == OK,
+                "WNCAN_BUSOFF_SET failed");
+
+    /* the back-off doubles up to maxDelay; only the last frame is kept */
+    for (i = 0; i < NELEMENTS (delays); i++)
+    {
+        if (boffCycle (delays[i], 1) != OK)
+            return ERROR;
+    }
+    BOFF_CHECK (boffRead () == 0, "a failed frame was received");
+
+    /* error active for the stable time: minDelay again */
+    hostTickAdvance (BOFF_STABLE * sysClkRateGet () / 1000 + 1);
+    if (boffCycle (BOFF_MIN_DELAY, 1) != OK)
+        return ERROR;
+
+    /* KEEP: the frames behind the lost one are sent after the restart */
+    ioctl (tx.fdChn, WNCAN_STATS_CLEAR, 0);
+    boffRead ();
+    hostTickAdvance (BOFF_STABLE * sysClkRateGet () / 1000 + 1);
+    if (boffCycle (BOFF_MIN_DELAY, BOFF_QUEUED) != OK)
+        return ERROR;
+    n = boffRead ();
+    BOFF_CHECK (ioctl (tx.fdChn, WNCAN_STATS_GET, (int)&st) == OK,
+                "WNCAN_STATS_GET failed");
+    if ((n != BOFF_QUEUED - 1) || (st.txFrames != BOFF_QUEUED - 1) ||
+        (st.txDropped != 1))
+    {
+        printf ("busOffTest: KEEP: %d received, txFrames %lu txDropped %lu\n",
+                n, st.txFrames, st.txDropped);
+        return ERROR;
+    }
+
+    /* FLUSH: they are dropped at the bus off */
+    BOFF_CHECK (boffPolicySet (WNCAN_BUSOFF_TX_FLUSH) == OK,
+                "WNCAN_BUSOFF_SET failed");
+    ioctl (tx.fdChn, WNCAN_STATS_CLEAR, 0);
+    hostTickAdvance (BOFF_STABLE * sysClkRateGet () / 1000 + 1);
+    if (boffCycle (BOFF_MIN_DELAY, BOFF_QUEUED) != OK)
+        return ERROR;
+    n = boffRead ();
+    BOFF_CHECK (ioctl (tx.fdChn, WNCAN_STATS_GET, (int)&st) == OK,
+                "WNCAN_STATS_GET failed");
+    if ((n != 0) || (st.txFrames != 0) || (st.txDropped != BOFF_QUEUED))
+    {
+        printf ("busOffTest: FLUSH: %d received, txFrames %lu "
+                "txDropped %lu\n", n, st.txFrames, st.txDropped);
+        return ERROR;
+    }
+
+    /* the channel sends again after the flush */
+    memset (&msg, 0, sizeof (msg));
+    msg.id = 0x300;
+    BOFF_CHECK (write (tx.fdChn, (char *)&msg, sizeof (msg)) == sizeof (msg),
+                "write failed");
+    hostTickAdvance (10);
+    BOFF_CHECK (boffRead () == 1, "no frame sent after the flush");
+    return OK;
+}
+
+/************************************************************************
+*
+* main - run the bus-off recovery test
+*
+* RETURNS: 0 if the test passes, 1 otherwise
+*
+* ERRNO: N/A
+*
+*/
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if (boffTest () != OK)
+        return 1;
+
+    printf ("busOffTest: passed\n");
+    return 0;
+}
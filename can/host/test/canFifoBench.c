@@ -0,0 +1,525 @@
+/* canFifoBench.c - host benchmark: linked-list and array can_fifo */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This program compares can_fifo.c with the linked-list FIFO it replaced,
+which is reproduced below from the baseline as the listFifoXxx() routines:
+one CAN_MEM_ALLOC node per slot linked in a circle, messages copied field
+by field.
+
+Three figures are measured, each the best of BENCH_RUNS runs:
+
+  - latency: the time of a put followed by a get on an empty FIFO;
+  - throughput: messages per second through a FIFO of BENCH_DEPTH slots,
+    filled and drained one message at a time;
+  - for the array FIFO also the throughput with can_fifo_put_n() and
+    can_fifo_get_n() in batches of BENCH_BATCH messages.
+
+Every message must come out once, in order and unchanged, and both FIFOs
+must hold BENCH_DEPTH - 1 messages when full. The times are printed for
+information only. On a long running target the nodes of the linked list
+are spread over the heap, where the fresh heap of the program would place
+them one after the other; listFifoCreate() therefore links them in a
+shuffled order, so following the list does not walk memory sequentially.
+
+RETURNS: 0 if the FIFOs behave alike, 1 otherwise
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <CAN/icp_can.h>
+#include <CAN/can_fifo.h>
+
+/* defines */
+#define BENCH_DEPTH     4096    /* slots of a FIFO */
+#define BENCH_ROUNDS    200     /* fill and drain cycles per run */
+#define BENCH_PAIRS     10000000
+#define BENCH_BATCH     32
+#define BENCH_RUNS      5
+#define BENCH_SEED      12345   /* of the node order of the list */
+
+/* typedefs */
+
+/* the baseline FIFO: a circle of nodes, head == tail when empty */
+typedef struct list_fifo_item {
+	icp_can_msg_t		msg;
+	struct list_fifo_item	*next;
+} list_fifo_item_t;
+
+typedef struct list_fifo {
+	list_fifo_item_t *head;
+	list_fifo_item_t *tail;
+	unsigned int size;
+} list_fifo_t;
+
+/* the FIFO under test */
+typedef struct
+{
+    const char        *name;
+    icp_can_handle_t (*create) (unsigned int numNodes);
+    void             (*destroy) (icp_can_handle_t handle);
+    int              (*put) (icp_can_handle_t handle, icp_can_msg_t *msg);
+    int              (*get) (icp_can_handle_t handle, icp_can_msg_t *msg);
+} BENCH_FIFO;
+
+/************************************************************************
+*
+* listFifoCreate - create a linked-list FIFO, as the baseline did
+*
+* The nodes are allocated as the baseline did, but linked in an order
+* shuffled with a fixed seed, as they would lie on a fragmented heap.
+*
+* RETURNS: the handle, or 0 if out of memory
+*
+* ERRNO: N/A
+*
+*/
+LOCAL icp_can_handle_t listFifoCreate
+(
+    unsigned int numNodes
+)
+{
+    unsigned int      i;
+    unsigned int      j;
+    unsigned int      seed = BENCH_SEED;
+    list_fifo_item_t **nodes;
+    list_fifo_item_t *curr;
+    list_fifo_t      *f;
+
+    f = (list_fifo_t *) CAN_MEM_ALLOC (sizeof (list_fifo_t));
+    nodes = (list_fifo_item_t **) malloc (numNodes * sizeof (*nodes));
+    if (!f || !nodes)
+        return (icp_can_handle_t) 0;
+
+    for (i = 0; i < numNodes; i++)
+    {
+        nodes[i] = (list_fifo_item_t *)
+                   CAN_MEM_ALLOC (sizeof (list_fifo_item_t));
+        if (!nodes[i])
+            return (icp_can_handle_t) 0;    /* leaks, as the baseline */
+    }
+
+    /* Fisher-Yates with a linear congruential generator */
+    for (i = numNodes - 1; i > 0; i--)
+    {
+        seed = seed * 1103515245 + 12345;
+        j = (seed >> 8) % (i + 1);
+        curr = nodes[i];
+        nodes[i] = nodes[j];
+        nodes[j] = curr;
+    }
+
+    for (i = 0; i < numNodes; i++)
+        nodes[i]->next = nodes[(i + 1) % numNodes];
+
+    f->head = nodes[0];
+    f->tail = f->head;
+    f->size = numNodes;
+    free (nodes);
+    return (icp_can_handle_t) f;
+}
+
+/************************************************************************
+*
+* listFifoDestroy - free a linked-list FIFO
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void listFifoDestroy
+(
+    icp_can_handle_t handle
+)
+{
+    list_fifo_t      *f = (list_fifo_t *) handle;
+    list_fifo_item_t *curr;
+    list_fifo_item_t *next;
+    unsigned int      i;
+
+    curr = f->head;
+    for (i = 0; i < f->size; i++)
+    {
+        next = curr->next;
+        CAN_MEM_FREE (curr);
+        curr = next;
+    }
+    CAN_MEM_FREE (f);
+}
+
+/************************************************************************
+*
+* listFifoGet - get the first message, copied field by field
+*
+* RETURNS: 0, or -1 if the FIFO is empty
+*
+* ERRNO: N/A
+*
+*/
+LOCAL int listFifoGet
+(
+    icp_can_handle_t handle,
+    icp_can_msg_t   *msg
+)
+{
+    int            i;
+    list_fifo_t   *f = (list_fifo_t *) handle;
+    icp_can_msg_t  msg_tmp = f->tail->msg;
+
+    if ((!handle) || (!msg))
+        return -1;
+
+    if (f->head == f->tail)
+        return -1;
+
+    msg->ide = msg_tmp.ide;
+    msg->id  = msg_tmp.id;
+    msg->dlc = msg_tmp.dlc;
+    msg->rtr = msg_tmp.rtr;
+
+    for (i = 0; i < ICP_CAN_MSG_DATA_LEN; i++)
+        msg->data[i] = msg_tmp.data[i];
+
+    f->tail = f->tail->next;
+    return 0;
+}
+
+/************************************************************************
+*
+* listFifoPut - put a message, copied field by field
+*
+* RETURNS: 0, or -1 if the FIFO is full
+*
+* ERRNO: N/A
+*
+*/
+LOCAL int listFifoPut
+(
+    icp_can_handle_t handle,
+    icp_can_msg_t   *msg
+)
+{
+    int            i;
+    list_fifo_t   *f = (list_fifo_t *) handle;
+    icp_can_msg_t *msg_tmp = &(f->head->msg);
+
+    if ((!handle) || (!msg))
+        return -1;
+
+    if (f->head->next == f->tail)
+        return -1;
+
+    msg_tmp->ide = msg->ide;
+    msg_tmp->rtr = msg->rtr;
+    msg_tmp->id  = msg->id;
+    msg_tmp->dlc = msg->dlc;
+
+    for (i = 0; i < ICP_CAN_MSG_DATA_LEN; i++)
+        msg_tmp->data[i] = msg->data[i];
+
+    f->head = f->head->next;
+    return 0;
+}
+
+/************************************************************************
+*
+* benchNs - monotonic time
+*
+* RETURNS: the time in ns
+*
+* ERRNO: N/A
+*
+*/
+LOCAL UINT64 benchNs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (UINT64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/************************************************************************
+*
+* benchMsgFill - build message number "n"
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void benchMsgFill
+(
+    icp_can_msg_t *msg,
+    unsigned int   n
+)
+{
+    int i;
+
+    msg->ide = n & 1;
+    msg->id = n & 0x1fffffff;
+    msg->dlc = n % (ICP_CAN_MSG_DATA_LEN + 1);
+    msg->rtr = 0;
+    for (i = 0; i < ICP_CAN_MSG_DATA_LEN; i++)
+        msg->data[i] = (unsigned char)(n + i);
+}
+
+/************************************************************************
+*
+* benchMsgCheck - check that a message is message number "n"
+*
+* RETURNS: OK, or ERROR if it is not
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS benchMsgCheck
+(
+    const char          *name,
+    const icp_can_msg_t *msg,
+    unsigned int         n
+)
+{
+    icp_can_msg_t expect;
+
+    benchMsgFill (&expect, n);
+    if ((msg->ide != expect.ide) || (msg->id != expect.id) ||
+        (msg->dlc != expect.dlc) || (msg->rtr != expect.rtr) ||
+        (memcmp (msg->data, expect.data, ICP_CAN_MSG_DATA_LEN) != 0))
+    {
+        printf ("canFifoBench: %s: message %u: id 0x%x, expected 0x%x\n",
+                name, n, msg->id, expect.id);
+        return ERROR;
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* benchOne - measure a FIFO one message at a time
+*
+* RETURNS: OK, or ERROR if a message was lost or changed
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS benchOne
+(
+    const BENCH_FIFO *pFifo,
+    double           *pLatency,
+    double           *pRate
+)
+{
+    icp_can_handle_t h;
+    icp_can_msg_t    msg;
+    UINT64           t;
+    UINT64           pairBest = ~0ULL;
+    UINT64           fillBest = ~0ULL;
+    unsigned int     putNo = 0;
+    unsigned int     getNo = 0;
+    int              run;
+    int              round;
+    int              i;
+
+    if ((h = pFifo->create (BENCH_DEPTH)) == 0)
+    {
+        printf ("canFifoBench: %s: create failed\n", pFifo->name);
+        return ERROR;
+    }
+
+    /* a full FIFO holds BENCH_DEPTH - 1 messages */
+    for (i = 0; ; i++, putNo++)
+    {
+        benchMsgFill (&msg, putNo);
+        if (pFifo->put (h, &msg) != 0)
+            break;
+    }
+    if ((i != BENCH_DEPTH - 1) || (pFifo->get (h, &msg) != 0) ||
+        (benchMsgCheck (pFifo->name, &msg, getNo++) != OK))
+    {
+        printf ("canFifoBench: %s: %d messages fit\n", pFifo->name, i);
+        return ERROR;
+    }
+    while (pFifo->get (h, &msg) == 0)
+    {
+        if (benchMsgCheck (pFifo->name, &msg, getNo++) != OK)
+            return ERROR;
+    }
+
+    for (run = 0; run < BENCH_RUNS; run++)
+    {
+        benchMsgFill (&msg, 0);
+        t = benchNs ();
+        for (i = 0; i < BENCH_PAIRS; i++)
+        {
+            msg.id = i;
+            if ((pFifo->put (h, &msg) != 0) || (pFifo->get (h, &msg) != 0) ||
+                (msg.id != (unsigned int)i))
+            {
+                printf ("canFifoBench: %s: put/get failed\n", pFifo->name);
+                return ERROR;
+            }
+        }
+        t = benchNs () - t;
+        if (t < pairBest)
+            pairBest = t;
+
+        t = benchNs ();
+        for (round = 0; round < BENCH_ROUNDS; round++)
+        {
+            for (i = 0; i < BENCH_DEPTH - 1; i++)
+            {
+                benchMsgFill (&msg, putNo++);
+                pFifo->put (h, &msg);
+            }
+            for (i = 0; i < BENCH_DEPTH - 1; i++)
+            {
+                if ((pFifo->get (h, &msg) != 0) || (msg.id != getNo++))
+                {
+                    printf ("canFifoBench: %s: message %u lost\n",
+                            pFifo->name, getNo - 1);
+                    return ERROR;
+                }
+            }
+        }
+        t = benchNs () - t;
+        if (t < fillBest)
+            fillBest = t;
+    }
+
+    pFifo->destroy (h);
+    *pLatency = (double)pairBest / BENCH_PAIRS;
+    *pRate = (double)BENCH_ROUNDS * (BENCH_DEPTH - 1) * 1e9 / fillBest;
+    return OK;
+}
+
+/************************************************************************
+*
+* benchBulk - measure the array FIFO with can_fifo_put_n/get_n()
+*
+* RETURNS: OK, or ERROR if a message was lost or changed
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS benchBulk
+(
+    double *pRate
+)
+{
+    icp_can_msg_t    msgs[BENCH_BATCH];
+    icp_can_handle_t h;
+    UINT64           t;
+    UINT64           best = ~0ULL;
+    unsigned int     putNo = 0;
+    unsigned int     getNo = 0;
+    int              run;
+    int              round;
+    int              left;
+    int              n;
+    int              i;
+
+    if ((h = can_fifo_create (BENCH_DEPTH)) == 0)
+    {
+        printf ("canFifoBench: bulk: create failed\n");
+        return ERROR;
+    }
+
+    for (run = 0; run < BENCH_RUNS; run++)
+    {
+        t = benchNs ();
+        for (round = 0; round < BENCH_ROUNDS; round++)
+        {
+            /* the last batch is short, BENCH_DEPTH - 1 is not a multiple */
+            for (left = BENCH_DEPTH - 1; left > 0; left -= n)
+            {
+                for (i = 0; i < BENCH_BATCH; i++)
+                    benchMsgFill (&msgs[i], putNo + i);
+                n = can_fifo_put_n (h, msgs, BENCH_BATCH);
+                if ((n <= 0) || ((n < BENCH_BATCH) && (n != left)))
+                {
+                    printf ("canFifoBench: bulk: %d of %d queued\n", n, left);
+                    return ERROR;
+                }
+                putNo += n;
+            }
+            while ((n = can_fifo_get_n (h, msgs, BENCH_BATCH)) > 0)
+            {
+                for (i = 0; i < n; i++)
+                {
+                    if (benchMsgCheck ("bulk", &msgs[i], getNo++) != OK)
+                        return ERROR;
+                }
+            }
+            if (getNo != putNo)
+            {
+                printf ("canFifoBench: bulk: %u put, %u got\n", putNo, getNo);
+                return ERROR;
+            }
+        }
+        t = benchNs () - t;
+        if (t < best)
+            best = t;
+    }
+
+    can_fifo_destroy (h);
+    *pRate = (double)BENCH_ROUNDS * (BENCH_DEPTH - 1) * 1e9 / best;
+    return OK;
+}
+
+/************************************************************************
+*
+* main - run the can_fifo benchmark
+*
+* RETURNS: 0 if the FIFOs behave alike, 1 otherwise
+*
+* ERRNO: N/A
+*
+*/
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    static const BENCH_FIFO fifos[] =
+        {
+        {"list", listFifoCreate, listFifoDestroy, listFifoPut, listFifoGet},
+        {"array", can_fifo_create, can_fifo_destroy, can_fifo_put,
+         can_fifo_get},
+        };
+    double latency;
+    double rate;
+    int    i;
+
+    for (i = 0; i < NELEMENTS (fifos); i++)
+    {
+        if (benchOne (&fifos[i], &latency, &rate) != OK)
+            return 1;
+        printf ("canFifoBench: %-5s put + get %5.1f ns, "
+                "%6.1f Mmsg/s one at a time\n",
+                fifos[i].name, latency, rate / 1e6);
+    }
+
+    if (benchBulk (&rate) != OK)
+        return 1;
+    printf ("canFifoBench: array %6.1f Mmsg/s in batches of %d\n",
+            rate / 1e6, BENCH_BATCH);
+
+    printf ("canFifoBench: passed\n");
+    return 0;
+}
@@ -0,0 +1,518 @@
+/* captureTest.c - host test: capture and replay of a DevIO channel */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This program records the frames /can/0 sends to /can/1 with
+wncCaptureStart() and plays the capture back with wncCaptureReplay() on
+the simulated board.
+
+The frames are sent in CAP_BURSTS bursts, CAP_GAP_TICKS apart, of standard
+and extended data frames of every length with a run of remote frames in
+the middle of each. The checks are:
+
+  - the capture, as one more reader of the receive channel, takes no
+    frame from the application reading it;
+  - the capture file holds every frame once and in order, with its ID,
+    flags, length and data, non-decreasing timestamps, the gaps between
+    the bursts and no lost frame records;
+  - the replay as fast as the channel takes the frames, and with their
+    intervals, sends the same frames in the same order; the timed replay
+    lasts as long as the capture;
+  - a capture read from a pipe in pieces that end inside records, with a
+    partial record at the end, is replayed whole: the partial records
+    are carried to the next read and the last one is ignored.
+
+The program runs on the system clock thread of hostOs.c, in real time.
+
+RETURNS: 0 if the test passes, 1 otherwise
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <ioLib.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <taskLib.h>
+#include <tickLib.h>
+#include <sysLib.h>
+
+#include "CAN/wnCAN.h"
+#include "CAN/wncanDevIO.h"
+#include "CAN/wncanCapture.h"
+#include "testPort.h"
+
+/* defines */
+#define CAP_BURST       32
+#define CAP_BURSTS      3
+#define CAP_FRAMES      (CAP_BURST * CAP_BURSTS)
+#define CAP_RTR_FIRST   24      /* the remote frames of a burst */
+#define CAP_RTR_NUM     4
+#define CAP_GAP_TICKS   100     /* between the bursts */
+#define CAP_BUF_SIZE    256
+#define CAP_WAIT_TICKS  2000    /* bound of a wait for frames */
+#define CAP_CHUNK       40      /* bytes per write() to the pipe */
+#define CAP_TAIL        10      /* bytes of the partial last record */
+
+#define CAP_CHECK(cond, what)                                   \
+    do                                                          \
+    {                                                           \
+        if (!(cond))                                            \
+        {                                                       \
+            printf ("captureTest: %s (line %d)\n", what, __LINE__); \
+            return ERROR;                                       \
+        }                                                       \
+    } while (0)
+
+/* locals */
+
+LOCAL TEST_PORT tx;
+LOCAL TEST_PORT rx;
+LOCAL char      capFile[64];
+LOCAL char      capPipe[64];
+
+/************************************************************************
+*
+* capMsgFill - build frame number "n"
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void capMsgFill
+(
+    WNCAN_CHNMSG *pMsg,
+    int           n
+)
+{
+    int i;
+
+    memset (pMsg, 0, sizeof (*pMsg));
+    pMsg->extId = n & 1;
+    pMsg->id = pMsg->extId ? 0x1000000 + n : 0x100 + n;
+    pMsg->rtr = ((n % CAP_BURST) >= CAP_RTR_FIRST) &&
+                ((n % CAP_BURST) < CAP_RTR_FIRST + CAP_RTR_NUM);
+    pMsg->len = n % (WNCAN_MAX_DATA_LEN + 1);
+    if (!pMsg->rtr)
+    {
+        for (i = 0; i < pMsg->len; i++)
+            pMsg->data[i] = (UCHAR)(n + i);
+    }
+}
+
+/************************************************************************
+*
+* capMsgCheck - compare a frame with frame number "n"
+*
+* RETURNS: OK, or ERROR if they differ
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS capMsgCheck
+(
+    const char         *what,
+    const WNCAN_CHNMSG *pMsg,
+    int                 n
+)
+{
+    WNCAN_CHNMSG expect;
+
+    capMsgFill (&expect, n);
+    if ((pMsg->id != expect.id) || (!pMsg->extId != !expect.extId) ||
+        (!pMsg->rtr != !expect.rtr) || (pMsg->len != expect.len) ||
+        (!expect.rtr &&
+         (memcmp (pMsg->data, expect.data, expect.len) != 0)))
+    {
+        printf ("captureTest: %s: frame %d: id 0x%lx ext %d rtr %d len %d, "
+                "expected id 0x%lx ext %d rtr %d len %d\n", what, n,
+                pMsg->id, pMsg->extId, pMsg->rtr, pMsg->len, expect.id,
+                expect.extId, expect.rtr, expect.len);
+        return ERROR;
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* capRtrSet - send data or remote frames once the queued ones are out
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS capRtrSet
+(
+    BOOL rtr
+)
+{
+    WNCAN_CHNCONFIG chncfg;
+    int             numBytes;
+    int             ticks;
+
+    for (ticks = 0; ; ticks++)
+    {
+        CAP_CHECK ((ioctl (tx.fdChn, FIONWRITE, (int)&numBytes) == OK) &&
+                   (ticks < CAP_WAIT_TICKS), "output buffer not drained");
+        if (numBytes == 0)
+            break;
+        taskDelay (1);
+    }
+
+    memset (&chncfg, 0, sizeof (chncfg));
+    chncfg.flags = WNCAN_CHNCFG_RTR;
+    chncfg.rtr = rtr;
+    CAP_CHECK (ioctl (tx.fdChn, WNCAN_CHNCONFIG_SET, (int)&chncfg) == OK,
+               "WNCAN_CHNCONFIG_SET failed");
+    return OK;
+}
+
+/************************************************************************
+*
+* capSend - send the bursts from /can/0
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS capSend (void)
+{
+    WNCAN_CHNMSG msg[CAP_BURST];
+    int          burst;
+    int          first;
+    int          num;
+    int          i;
+
+    for (burst = 0; burst < CAP_BURSTS; burst++)
+    {
+        if (burst != 0)
+            taskDelay (CAP_GAP_TICKS);
+
+        for (i = 0; i < CAP_BURST; i++)
+            capMsgFill (&msg[i], burst * CAP_BURST + i);
+
+        /* data frames, the remote frames, data frames */
+        for (first = 0; first < CAP_BURST; first += num)
+        {
+            num = (first == 0) ? CAP_RTR_FIRST :
+                  (first == CAP_RTR_FIRST) ? CAP_RTR_NUM :
+                  CAP_BURST - first;
+            if (capRtrSet (msg[first].rtr) != OK)
+                return ERROR;
+            CAP_CHECK (write (tx.fdChn, (char *)&msg[first],
+                              num * sizeof (WNCAN_CHNMSG)) ==
+                       num * (int)sizeof (WNCAN_CHNMSG), "write failed");
+        }
+    }
+    return capRtrSet (FALSE);
+}
+
+/************************************************************************
+*
+* capRead - read and check the frames on /can/1
+*
+* RETURNS: OK, or ERROR if a frame is missing, extra or changed
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS capRead
+(
+    const char *what
+)
+{
+    WNCAN_CHNMSG msg[CAP_BURST];
+    int          rcvd = 0;
+    int          ticks;
+    int          n;
+    int          i;
+
+    for (ticks = 0; rcvd < CAP_FRAMES; ticks++)
+    {
+        if (ticks == CAP_WAIT_TICKS)
+        {
+            printf ("captureTest: %s: %d of %d frames received\n", what,
+                    rcvd, CAP_FRAMES);
+            return ERROR;
+        }
+        taskDelay (1);
+
+        while ((n = read (rx.fdChn, (char *)msg, sizeof (msg))) > 0)
+        {
+            for (i = 0; i < n / (int)sizeof (WNCAN_CHNMSG); i++, rcvd++)
+            {
+                if ((rcvd == CAP_FRAMES) ||
+                    (capMsgCheck (what, &msg[i], rcvd) != OK))
+                    return ERROR;
+            }
+        }
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* capRecord - capture the bursts
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS capRecord (void)
+{
+    WNCAN_CAPTURE_ID cap;
+    char             chnName[32];
+    int              ticks;
+
+    sprintf (chnName, "/can/1/%d", rx.chan);
+    CAP_CHECK ((cap = wncCaptureStart (chnName, capFile, 0)) != NULL,
+               "wncCaptureStart failed");
+
+    if ((capSend () != OK) || (capRead ("capture") != OK))
+        return ERROR;
+
+    for (ticks = 0; (cap->frames < CAP_FRAMES) && (ticks < CAP_WAIT_TICKS);
+         ticks++)
+        taskDelay (1);
+
+    CAP_CHECK ((cap->frames == CAP_FRAMES) && (cap->lost == 0) &&
+               (cap->overruns == 0), "frames not captured");
+    CAP_CHECK (wncCaptureStop (cap) == OK, "wncCaptureStop failed");
+    return OK;
+}
+
+/************************************************************************
+*
+* capFileCheck - check the records of the capture file
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS capFileCheck (void)
+{
+    WNCAN_CAPHDR hdr;
+    WNCAN_CAPREC rec;
+    WNCAN_CHNMSG msg;
+    UINT64       lastStamp = 0;
+    int          fd;
+    int          n;
+
+    CAP_CHECK ((fd = open (capFile, O_RDONLY, 0)) != ERROR,
+               "capture file missing");
+    CAP_CHECK ((read (fd, (char *)&hdr, sizeof (hdr)) == sizeof (hdr)) &&
+               (hdr.magic == WNCAN_CAP_MAGIC) &&
+               (hdr.version == WNCAN_CAP_VERSION) &&
+               (hdr.recSize == sizeof (WNCAN_CAPREC)) && (hdr.tsFreq != 0),
+               "bad capture header");
+
+    for (n = 0; read (fd, (char *)&rec, sizeof (rec)) == sizeof (rec); n++)
+    {
+        CAP_CHECK ((n < CAP_FRAMES) && !(rec.flags & WNCAN_CAP_LOST),
+                   "extra or lost frame record");
+
+        memset (&msg, 0, sizeof (msg));
+        msg.id = rec.id;
+        msg.extId = (rec.flags & WNCAN_CAP_EXT) != 0;
+        msg.rtr = (rec.flags & WNCAN_CAP_RTR) != 0;
+        msg.len = rec.len;
+        memcpy (msg.data, rec.data, WNCAN_MAX_DATA_LEN);
+        if (capMsgCheck ("capture file", &msg, n) != OK)
+            return ERROR;
+
+        CAP_CHECK (rec.timeStamp >= lastStamp, "timestamps decrease");
+        if ((n != 0) && (n % CAP_BURST == 0))
+            CAP_CHECK ((rec.timeStamp - lastStamp) * sysClkRateGet () >=
+                       (UINT64)hdr.tsFreq * CAP_GAP_TICKS * 9 / 10,
+                       "no gap between the bursts");
+        lastStamp = rec.timeStamp;
+    }
+    close (fd);
+
+    CAP_CHECK (n == CAP_FRAMES, "frames missing in the capture file");
+    return OK;
+}
+
+/************************************************************************
+*
+* capReplay - replay a capture to /can/0 and check what /can/1 receives
+*
+* The replay opens a free transmit channel of /can/0, which it frees when
+* it closes it.
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS capReplay
+(
+    const char *what,
+    char       *fileName,
+    BOOL        timed,
+    int         minTicks,   /* bound of the replay time */
+    int         maxTicks
+)
+{
+    char  chnName[32];
+    UCHAR chan;
+    ULONG start;
+    int   ticks;
+
+    CAP_CHECK (ioctl (tx.fdCtr, WNCAN_TXCHAN_GET, (int)&chan) == OK,
+               "WNCAN_TXCHAN_GET failed");
+    sprintf (chnName, "/can/0/%d", chan);
+
+    start = tickGet ();
+    CAP_CHECK (wncCaptureReplay (fileName, chnName, timed) == OK,
+               "wncCaptureReplay failed");
+    ticks = (int)(tickGet () - start);
+
+    if (capRead (what) != OK)
+        return ERROR;
+
+    printf ("captureTest: %s: %d frames in %d ticks\n", what, CAP_FRAMES,
+            ticks);
+    if ((ticks < minTicks) || (ticks > maxTicks))
+    {
+        printf ("captureTest: %s: %d ticks, expected %d to %d\n", what,
+                ticks, minTicks, maxTicks);
+        return ERROR;
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* capFeeder - write the capture file to the pipe in pieces
+*
+* The pieces are CAP_CHUNK bytes, one per tick, so most reads of the
+* replay end inside a record. CAP_TAIL bytes of one more record follow.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void capFeeder (void)
+{
+    static char buf[sizeof (WNCAN_CAPHDR) +
+                    (CAP_FRAMES + 1) * sizeof (WNCAN_CAPREC)];
+    int         fdFile;
+    int         fdPipe;
+    int         size = 0;
+    int         off;
+    int         n;
+
+    if ((fdFile = open (capFile, O_RDONLY, 0)) != ERROR)
+    {
+        while ((n = read (fdFile, buf + size, sizeof (buf) - size)) > 0)
+            size += n;
+        close (fdFile);
+    }
+    memset (buf + size, 0xa5, CAP_TAIL);
+    size += CAP_TAIL;
+
+    if ((fdPipe = open (capPipe, O_WRONLY, 0)) == ERROR)
+        return;
+
+    /* the header in one piece, which the replay reads in one */
+    write (fdPipe, buf, sizeof (WNCAN_CAPHDR));
+    for (off = sizeof (WNCAN_CAPHDR); off < size; off += n)
+    {
+        taskDelay (1);
+        n = (size - off < CAP_CHUNK) ? size - off : CAP_CHUNK;
+        if (write (fdPipe, buf + off, n) != n)
+            break;
+    }
+    close (fdPipe);
+}
+
+/************************************************************************
+*
+* capPipeReplay - replay the capture from a pipe
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS capPipeReplay (void)
+{
+    CAP_CHECK (mkfifo (capPipe, 0600) == 0, "mkfifo failed");
+    CAP_CHECK (taskSpawn ("tCapFeed", 100, 0, 16384, (FUNCPTR)capFeeder,
+                          0, 0, 0, 0, 0, 0, 0, 0, 0, 0) != ERROR,
+               "taskSpawn failed");
+
+    /* one piece per tick */
+    return capReplay ("pipe replay", capPipe, FALSE,
+                      CAP_FRAMES * sizeof (WNCAN_CAPREC) / CAP_CHUNK,
+                      CAP_WAIT_TICKS);
+}
+
+/************************************************************************
+*
+* main - run the capture and replay test
+*
+* RETURNS: 0 if the test passes, 1 otherwise
+*
+* ERRNO: N/A
+*
+*/
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    STATUS status;
+
+    sprintf (capFile, "/tmp/captureTest.%d.cap", (int)getpid ());
+    sprintf (capPipe, "/tmp/captureTest.%d.pipe", (int)getpid ());
+
+    if ((testPortOpen (&tx, "/can/0", FALSE, CAP_BUF_SIZE) != OK) ||
+        (testPortOpen (&rx, "/can/1", TRUE, CAP_BUF_SIZE) != OK))
+    {
+        printf ("captureTest: opening the ports failed\n");
+        return 1;
+    }
+
+    status = capRecord ();
+    if (status == OK)
+        status = capFileCheck ();
+
+    /* the replays take the transmit channel in turn */
+    close (tx.fdChn);
+    if (status == OK)
+        status = capReplay ("replay", capFile, FALSE, 0, CAP_GAP_TICKS);
+    if (status == OK)
+        status = capReplay ("timed replay", capFile, TRUE,
+                            (CAP_BURSTS - 1) * CAP_GAP_TICKS * 9 / 10,
+                            CAP_WAIT_TICKS);
+    if (status == OK)
+        status = capPipeReplay ();
+
+    unlink (capFile);
+    unlink (capPipe);
+    if (status != OK)
+        return 1;
+
+    printf ("captureTest: passed\n");
+    return 0;
+}
@@ -0,0 +1,362 @@
+/* frameAccessBench.c - host benchmark: byte and block frame accessors */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This program measures the cost per frame of SJA1000_TxMsg() and of
+SJA1000_ReadID() with SJA1000_ReadData() on a register file in memory, laid
+out as the controller windows of the BAR0 of the PR6120 board: registers 4
+bytes apart, 0x400 bytes per controller.
+
+The frames are accessed through two boards. The byte board has only the
+canInByte/canOutByte accessors, which compute the register address from
+the base address, BAR0 offset and controller number on every access, as
+sys_pr6120_can.c did before the register window; WNCAN_Board_ReadFrame()
+and WNCAN_Board_WriteFrame() then make one call per register. The block
+board has the accessors of sys_pr6120_can.c, which index from the
+precomputed register window and move a frame in one call.
+
+Both boards must write the same transmit buffer image and read the same
+frame. The times, the best of BENCH_RUNS runs of BENCH_FRAMES frames, are
+printed for information only.
+
+RETURNS: 0 if the results of the boards agree, 1 otherwise
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "CAN/wnCAN.h"
+#include "CAN/canController.h"
+#include "CAN/canBoard.h"
+#include "CAN/sja1000.h"
+#include <CAN/sja1000Offsets.h>
+
+/* defines */
+#define BENCH_FRAMES    1000000
+#define BENCH_RUNS      5
+#define BENCH_CTRL      1       /* controller number, window 0x400 */
+#define BENCH_TX_CHN    0
+#define BENCH_RX_CHN    1
+
+extern void SJA1000_establishLinks (struct WNCAN_Device *pDev);
+
+/* the register file, as BAR0 of the board */
+LOCAL UCHAR benchRegs[2 * 0x400] __attribute__((aligned(4)));
+
+/************************************************************************
+*
+* benchByteIn - read a register, address computed per access
+*
+* RETURNS: the register contents
+*
+* ERRNO: N/A
+*
+*/
+LOCAL UCHAR benchByteIn
+(
+    struct WNCAN_Device *pDev,
+    unsigned int         reg
+)
+{
+    UCHAR  net     = pDev->pCtrl->ctrlID;
+    UINT32 offset  = pDev->pBrd->bar0;
+    ULONG  memBase = pDev->pBrd->ioAddress;
+
+    return *((volatile UCHAR *)(memBase) + (offset + reg*4 + net*0x400));
+}
+
+/************************************************************************
+*
+* benchByteOut - write a register, address computed per access
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void benchByteOut
+(
+    struct WNCAN_Device *pDev,
+    unsigned int         reg,
+    UCHAR                value
+)
+{
+    UCHAR  net     = pDev->pCtrl->ctrlID;
+    UINT32 offset  = pDev->pBrd->bar0;
+    ULONG  memBase = pDev->pBrd->ioAddress;
+
+    *((volatile UCHAR *)(memBase) + (offset + reg*4 + net*0x400)) = value;
+}
+
+/************************************************************************
+*
+* benchWinIn - read a register of the register window
+*
+* RETURNS: the register contents
+*
+* ERRNO: N/A
+*
+*/
+LOCAL UCHAR benchWinIn
+(
+    struct WNCAN_Device *pDev,
+    unsigned int         reg
+)
+{
+    return *((volatile UCHAR *)(pDev->pCtrl->regWindow) + reg*4);
+}
+
+/************************************************************************
+*
+* benchWinOut - write a register of the register window
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void benchWinOut
+(
+    struct WNCAN_Device *pDev,
+    unsigned int         reg,
+    UCHAR                value
+)
+{
+    *((volatile UCHAR *)(pDev->pCtrl->regWindow) + reg*4) = value;
+}
+
+/************************************************************************
+*
+* benchReadFrame - read consecutive registers of the register window
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void benchReadFrame
+(
+    struct WNCAN_Device *pDev,
+    unsigned int         reg,
+    UCHAR               *pBuf,
+    UINT                 len
+)
+{
+    volatile UCHAR *addr = (volatile UCHAR *)(pDev->pCtrl->regWindow) + reg*4;
+    UINT            i;
+
+    for (i = 0; i < len; i++)
+        pBuf[i] = addr[i*4];
+}
+
+/************************************************************************
+*
+* benchWriteFrame - write consecutive registers of the register window
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void benchWriteFrame
+(
+    struct WNCAN_Device *pDev,
+    unsigned int         reg,
+    const UCHAR         *pBuf,
+    UINT                 len
+)
+{
+    volatile UCHAR *addr = (volatile UCHAR *)(pDev->pCtrl->regWindow) + reg*4;
+    UINT            i;
+
+    for (i = 0; i < len; i++)
+        addr[i*4] = pBuf[i];
+}
+
+/************************************************************************
+*
+* benchNs - monotonic time
+*
+* RETURNS: the time in ns
+*
+* ERRNO: N/A
+*
+*/
+LOCAL UINT64 benchNs (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (UINT64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/************************************************************************
+*
+* benchRun - time the frame routines on a board
+*
+* This routine stores the transmit buffer image of the last frame sent in
+* "txImage" and the last frame read in "pRxMsg".
+*
+* RETURNS: OK, or ERROR if a routine failed
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS benchRun
+(
+    const char          *name,
+    struct WNCAN_Board  *pBrd,
+    UCHAR               *txImage,
+    struct TxMsg        *pRxMsg
+)
+{
+    static const UCHAR rxImage[SJA1000_FRAME_SIZE] =
+        {0x88, 0x12, 0x34, 0x56, 0x78, 1, 2, 3, 4, 5, 6, 7, 8};
+    UCHAR                   data[8] = {0xde, 0xad, 0xbe, 0xef, 4, 5, 6, 7};
+    UINT                    chnMode[SJA1000_MAX_MSG_OBJ];
+    struct WNCAN_Controller ctrl;
+    struct SJA1000_ChipData chip;
+    struct WNCAN_Device     dev;
+    struct WNCAN_Device    *pDev = &dev;
+    UINT64                  t;
+    UINT64                  txBest = ~0ULL;
+    UINT64                  rxBest = ~0ULL;
+    UCHAR                  *pWin;
+    BOOL                    newData;
+    UCHAR                   len = 0;
+    int                     run;
+    int                     i;
+
+    memset (&ctrl, 0, sizeof (ctrl));
+    memset (&chip, 0, sizeof (chip));
+    memset (&dev, 0, sizeof (dev));
+    chnMode[BENCH_TX_CHN] = WNCAN_CHN_TRANSMIT;
+    chnMode[BENCH_RX_CHN] = WNCAN_CHN_RECEIVE;
+    ctrl.ctrlType = WNCAN_SJA1000;
+    ctrl.ctrlID = BENCH_CTRL;
+    ctrl.chnMode = chnMode;
+    ctrl.numChn = SJA1000_MAX_MSG_OBJ;
+    ctrl.csData = &chip;
+    ctrl.regWindow = pBrd->ioAddress + pBrd->bar0 + BENCH_CTRL * 0x400;
+    dev.pCtrl = &ctrl;
+    dev.pBrd = pBrd;
+    SJA1000_establishLinks (pDev);
+
+    /* transmit buffer free; a received extended frame, ID 0x02468acf */
+    memset (benchRegs, 0, sizeof (benchRegs));
+    pWin = (UCHAR *)ctrl.regWindow;
+    pWin[SJA1000_SR * 4] = SJA1000_SR_TBS;
+
+    for (run = 0; run < BENCH_RUNS; run++)
+    {
+        t = benchNs ();
+        for (i = 0; i < BENCH_FRAMES; i++)
+        {
+            if (CAN_TxMsg (pDev, BENCH_TX_CHN, 0x100 + (i & 0xff), FALSE,
+                           data, 8) != OK)
+                return ERROR;
+        }
+        t = benchNs () - t;
+        if (t < txBest)
+            txBest = t;
+
+        for (i = 0; i < SJA1000_FRAME_SIZE; i++)
+            txImage[i] = pWin[(SJA1000_SFF + i) * 4];
+
+        for (i = 0; i < SJA1000_FRAME_SIZE; i++)
+            pWin[(SJA1000_SFF + i) * 4] = rxImage[i];
+
+        t = benchNs ();
+        for (i = 0; i < BENCH_FRAMES; i++)
+        {
+            pRxMsg->id = CAN_ReadID (pDev, BENCH_RX_CHN, &pRxMsg->ext);
+            len = sizeof (pRxMsg->data);
+            if (CAN_ReadData (pDev, BENCH_RX_CHN, pRxMsg->data, &len,
+                              &newData) != OK)
+                return ERROR;
+        }
+        t = benchNs () - t;
+        if (t < rxBest)
+            rxBest = t;
+        pRxMsg->len = len;
+    }
+
+    printf ("frameAccessBench: %-5s board: TxMsg %6.1f ns, "
+            "ReadID + ReadData %6.1f ns per frame\n", name,
+            (double)txBest / BENCH_FRAMES, (double)rxBest / BENCH_FRAMES);
+    return OK;
+}
+
+/************************************************************************
+*
+* main - run the frame accessor benchmark
+*
+* RETURNS: 0 if the results of the boards agree, 1 otherwise
+*
+* ERRNO: N/A
+*
+*/
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    struct WNCAN_Board byteBrd;
+    struct WNCAN_Board blockBrd;
+    UCHAR              byteTx[SJA1000_FRAME_SIZE];
+    UCHAR              blockTx[SJA1000_FRAME_SIZE];
+    struct TxMsg       byteRx;
+    struct TxMsg       blockRx;
+
+    memset (&byteBrd, 0, sizeof (byteBrd));
+    byteBrd.ioAddress = (ULONG)benchRegs;
+    byteBrd.canInByte = benchByteIn;
+    byteBrd.canOutByte = benchByteOut;
+
+    blockBrd = byteBrd;
+    blockBrd.canInByte = benchWinIn;
+    blockBrd.canOutByte = benchWinOut;
+    blockBrd.canReadFrame = benchReadFrame;
+    blockBrd.canWriteFrame = benchWriteFrame;
+
+    memset (&byteRx, 0, sizeof (byteRx));
+    memset (&blockRx, 0, sizeof (blockRx));
+    if ((benchRun ("byte", &byteBrd, byteTx, &byteRx) != OK) ||
+        (benchRun ("block", &blockBrd, blockTx, &blockRx) != OK))
+    {
+        printf ("frameAccessBench: a frame routine failed\n");
+        return 1;
+    }
+
+    if ((memcmp (byteTx, blockTx, sizeof (byteTx)) != 0) ||
+        (byteTx[0] != 8) || (byteTx[3] != 0xde))
+    {
+        printf ("frameAccessBench: transmit buffer images differ\n");
+        return 1;
+    }
+    if ((byteRx.id != 0x02468acf) || !byteRx.ext || (byteRx.len != 8) ||
+        (blockRx.id != byteRx.id) || (blockRx.ext != byteRx.ext) ||
+        (blockRx.len != byteRx.len) ||
+        (memcmp (byteRx.data, blockRx.data, 8) != 0) ||
+        (byteRx.data[0] != 1) || (byteRx.data[7] != 8))
+    {
+        printf ("frameAccessBench: received frames differ\n");
+        return 1;
+    }
+
+    printf ("frameAccessBench: passed\n");
+    return 0;
+}
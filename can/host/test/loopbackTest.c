@@ -0,0 +1,221 @@
+/* loopbackTest.c - host test: frames from /can/0 to /can/1 */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This program checks the host build end to end. It opens the two
+controllers of the simulated board through DevIO with testPortOpen(),
+writes LOOP_FRAMES frames to the transmit channel of /can/0 and
+reads them from the receive channel of /can/1, waiting in select(). Every
+frame must arrive once, in order and unchanged, and the channel statistics
+must count them.
+
+Meanwhile /can/0 computes its acceptance filter from its readers, and a
+reader of its receive channel sets or clears a rule after every write,
+changing it every LOOP_FILTER_EVERY frames, so the controller passes
+through reset mode with frames in flight, and is asked for updates that
+leave the filter as it is. Neither must lose a frame or count one twice,
+or find the transmit buffer busy.
+
+It runs on the system clock thread of hostOs.c, in real time.
+
+RETURNS: 0 if the test passes, 1 otherwise
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <ioLib.h>
+#include <selectLib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CAN/wnCAN.h"
+#include "CAN/wncanDevIO.h"
+#include "testPort.h"
+
+/* defines */
+#define LOOP_FRAMES    1000
+#define LOOP_BATCH     16
+#define LOOP_RBUF_SIZE 256
+#define LOOP_ID_BASE   0x100
+#define LOOP_FILTER_EVERY 40
+
+/************************************************************************
+*
+* loopMsgFill - build frame number "n"
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void loopMsgFill
+(
+    WNCAN_CHNMSG *pMsg,
+    int           n
+)
+{
+    int i;
+
+    memset (pMsg, 0, sizeof (*pMsg));
+    pMsg->id = LOOP_ID_BASE + (n % 0x400);
+    pMsg->len = n % (WNCAN_MAX_DATA_LEN + 1);
+    for (i = 0; i < pMsg->len; i++)
+        pMsg->data[i] = (UCHAR)(n + i);
+}
+
+/************************************************************************
+*
+* loopAcceptAuto - let /can/0 compute its acceptance filter
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+static STATUS loopAcceptAuto
+(
+    TEST_PORT *pPort
+)
+{
+    WNCAN_CTLRCONFIG cfg;
+
+    memset (&cfg, 0, sizeof (cfg));
+    cfg.ctlrType = WNCAN_SJA1000;
+    if (ioctl (pPort->fdCtr, WNCAN_CTLRCONFIG_GET, (int)&cfg) != OK)
+        return ERROR;
+
+    cfg.ctlrData.sja1000Data.autoAccept = TRUE;
+    return ioctl (pPort->fdCtr, WNCAN_CTLRCONFIG_SET, (int)&cfg);
+}
+
+/************************************************************************
+*
+* main - run the loopback test
+*
+* RETURNS: 0 if the test passes, 1 otherwise
+*
+* ERRNO: N/A
+*
+*/
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    TEST_PORT      tx;
+    TEST_PORT      rx;
+    TEST_PORT      flt;
+    WNCAN_FILTER   rule;
+    WNCAN_CHNMSG   msg[LOOP_BATCH];
+    WNCAN_CHNMSG   expect;
+    WNCAN_STATS    st;
+    struct timeval tv;
+    fd_set         readFds;
+    fd_set         writeFds;
+    int            sent = 0;
+    int            rcvd = 0;
+    int            n;
+    int            i;
+
+    if ((testPortOpen (&tx, "/can/0", FALSE, 0) != OK) ||
+        (testPortOpen (&rx, "/can/1", TRUE, LOOP_RBUF_SIZE) != OK))
+    {
+        printf ("loopbackTest: opening the ports failed\n");
+        return 1;
+    }
+
+    flt = tx;
+    if ((testChanOpen (&flt, "/can/0", TRUE, LOOP_BATCH) != OK) ||
+        (loopAcceptAuto (&tx) != OK))
+    {
+        printf ("loopbackTest: setting up the filter reader failed\n");
+        return 1;
+    }
+    memset (&rule, 0, sizeof (rule));
+    rule.type = WNCAN_FILTER_MASK;
+    rule.frames = WNCAN_FILTER_STD;
+    rule.id = 0x7ff;
+    rule.mask = 0x7ff;
+
+    while (rcvd < LOOP_FRAMES)
+    {
+        FD_ZERO (&readFds);
+        FD_ZERO (&writeFds);
+        FD_SET (rx.fdChn, &readFds);
+        if (sent < LOOP_FRAMES)
+            FD_SET (tx.fdChn, &writeFds);
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+        if (select (FD_SETSIZE, &readFds, &writeFds, NULL, &tv) <= 0)
+        {
+            printf ("loopbackTest: timeout, %d sent, %d received\n",
+                    sent, rcvd);
+            return 1;
+        }
+
+        if (FD_ISSET (tx.fdChn, &writeFds))
+        {
+            n = LOOP_FRAMES - sent;
+            if (n > LOOP_BATCH)
+                n = LOOP_BATCH;
+            for (i = 0; i < n; i++)
+                loopMsgFill (&msg[i], sent + i);
+            n = write (tx.fdChn, (char *)msg, n * sizeof (WNCAN_CHNMSG));
+            if (n > 0)
+                sent += n / sizeof (WNCAN_CHNMSG);
+
+            /* update the filter of /can/0 while it transmits */
+            if ((sent / LOOP_FILTER_EVERY) & 1)
+                ioctl (flt.fdChn, WNCAN_CHNFILTER_ADD, (int)&rule);
+            else
+                ioctl (flt.fdChn, WNCAN_CHNFILTER_CLEAR, 0);
+        }
+
+        if (FD_ISSET (rx.fdChn, &readFds))
+        {
+            n = read (rx.fdChn, (char *)msg, sizeof (msg));
+            for (i = 0; i < n / (int)sizeof (WNCAN_CHNMSG); i++, rcvd++)
+            {
+                loopMsgFill (&expect, rcvd);
+                if ((msg[i].id != expect.id) || (msg[i].len != expect.len) ||
+                    memcmp (msg[i].data, expect.data, expect.len) != 0)
+                {
+                    printf ("loopbackTest: frame %d: id 0x%lx len %d, "
+                            "expected id 0x%lx len %d\n", rcvd, msg[i].id,
+                            msg[i].len, expect.id, expect.len);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    if ((ioctl (tx.fdChn, WNCAN_STATS_GET, (int)&st) != OK) ||
+        (st.txFrames != LOOP_FRAMES) || (st.txRetries != 0) ||
+        (st.txDropped != 0))
+    {
+        printf ("loopbackTest: txFrames %lu txRetries %lu txDropped %lu, "
+                "expected %d, 0, 0\n", st.txFrames, st.txRetries,
+                st.txDropped, LOOP_FRAMES);
+        return 1;
+    }
+    if ((ioctl (rx.fdChn, WNCAN_STATS_GET, (int)&st) != OK) ||
+        (st.rxFrames != LOOP_FRAMES) || (st.rxDropped != 0))
+    {
+        printf ("loopbackTest: rxFrames %lu rxDropped %lu, expected %d\n",
+                st.rxFrames, st.rxDropped, LOOP_FRAMES);
+        return 1;
+    }
+
+    printf ("loopbackTest: %d frames passed\n", LOOP_FRAMES);
+    return 0;
+}
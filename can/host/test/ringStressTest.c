@@ -0,0 +1,514 @@
+/* ringStressTest.c - host test: the message ring under two threads */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This program stresses the single-producer/single-consumer protocol of
+wncanRing.c with a producer and a consumer thread that run in parallel,
+as the ISR and a task do on a multiprocessor, without any lock.
+
+The producer adds the records of a run, in turn with wncRingPut() in
+batches of 1 to RING_BATCH and with wncRingReserve() and wncRingCommit()
+in place.
+The consumer removes them, in turn with wncRingGet() in batches, with
+wncRingPeekRun() and wncRingRemove() of part of the run, and with
+wncRingPeek() and wncRingRemove() of one record. Each record carries its
+sequence number, data derived from it and a checksum of both, so a record
+that is read before it is complete, after it has been overwritten, twice
+or not at all is detected. Neither side may ever see more than numMsgs
+records queued, and a run must lie within the slots.
+
+The records are not a power of two in size, and the rings are one record,
+a capacity below the power-of-two slot count and a larger ring, so the
+copies and runs are split at the wrap in every position. Ten million
+records pass through each of the larger rings and a million through the
+ring of one record, which takes a thread switch per record on a
+uniprocessor.
+
+The two threads only meet in the middle of an operation on a
+multiprocessor. Each ring is therefore also run with one side as
+the interrupt of a uniprocessor: a SCHED_FIFO thread that wakes every
+RING_ISR_NS, fills or empties the ring and sleeps again, for about
+RING_ISR_WAKES periods. The other side does a random amount of other
+work after each operation, so the interrupt preempts it at any point of
+its operations. The producer is the ISR of an input ring, the consumer
+that of an output ring. Without the privilege for SCHED_FIFO these runs
+are skipped.
+
+RETURNS: 0 if the test passes, 1 otherwise
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <pthread.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "CAN/wncanDevIO.h"
+#include "CAN/wncanRing.h"
+
+/* defines */
+#define RING_BATCH      7       /* largest batch of put and get */
+#define RING_ISR_WAKES  20000   /* periods of the ISR side per ring slot */
+#define RING_ISR_NS     20000   /* period of the ISR side */
+#define RING_WORK_MASK  2047    /* largest work of the other side */
+#define RING_DATA       36      /* data bytes, 44 byte records */
+
+/* the side of the ring that runs as an interrupt */
+#define RING_ISR_NONE       0
+#define RING_ISR_PRODUCER   1
+#define RING_ISR_CONSUMER   2
+
+/* typedefs */
+
+typedef struct
+{
+    UINT32 seq;                 /* sequence number */
+    UCHAR  data[RING_DATA];     /* derived from seq */
+    UINT32 sum;                 /* checksum of seq and data */
+} RING_REC;
+
+/* locals */
+
+LOCAL WNCAN_MSGRING_ID ring;
+LOCAL volatile BOOL    ringError;
+LOCAL int              ringMsgs;        /* records of the run */
+LOCAL int              ringIsr;         /* RING_ISR_xxx */
+LOCAL int              ringProduced;
+LOCAL int              ringConsumed;
+
+/************************************************************************
+*
+* ringSum - checksum of a record
+*
+* RETURNS: the checksum of the sequence number and data
+*
+* ERRNO: N/A
+*
+*/
+LOCAL UINT32 ringSum
+(
+    const RING_REC *pRec
+)
+{
+    UINT32 sum = pRec->seq;
+    int    i;
+
+    for (i = 0; i < RING_DATA; i++)
+        sum = sum * 31 + pRec->data[i];
+    return sum;
+}
+
+/************************************************************************
+*
+* ringRecFill - build record number "seq"
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void ringRecFill
+(
+    RING_REC *pRec,
+    UINT32    seq
+)
+{
+    int i;
+
+    pRec->seq = seq;
+    for (i = 0; i < RING_DATA; i++)
+        pRec->data[i] = (UCHAR)((seq * 2654435761U) >> (i % 4 * 8)) + i;
+    pRec->sum = ringSum (pRec);
+}
+
+/************************************************************************
+*
+* ringRecCheck - check that a record is record number "seq"
+*
+* RETURNS: OK, or ERROR after reporting it
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS ringRecCheck
+(
+    const RING_REC *pRec,
+    UINT32          seq
+)
+{
+    RING_REC expect;
+
+    ringRecFill (&expect, seq);
+    if ((pRec->seq != seq) || (pRec->sum != ringSum (pRec)) ||
+        (memcmp (pRec, &expect, sizeof (expect)) != 0))
+    {
+        printf ("ringStressTest: record %u: seq %u sum 0x%x, expected "
+                "sum 0x%x\n", seq, pRec->seq, pRec->sum, expect.sum);
+        ringError = TRUE;
+        return ERROR;
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* ringIdle - wait for the other side
+*
+* The ISR side sleeps until its next period; the other side gives up the
+* processor, which does not let it pass the ISR side.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void ringIdle
+(
+    BOOL isr    /* the caller is the ISR side */
+)
+{
+    struct timespec ts;
+
+    if (!isr)
+    {
+        sched_yield ();
+        return;
+    }
+
+    ts.tv_sec = 0;
+    ts.tv_nsec = RING_ISR_NS;
+    nanosleep (&ts, NULL);
+}
+
+/************************************************************************
+*
+* ringWork - other work of the side that is not the ISR
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void ringWork
+(
+    UINT32 seed
+)
+{
+    volatile UINT32 n;
+
+    for (n = (seed * 2654435761U >> 16) & RING_WORK_MASK; n > 0; n--)
+        ;
+}
+
+/************************************************************************
+*
+* ringCountCheck - check the number of queued records
+*
+* RETURNS: OK, or ERROR after reporting it
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS ringCountCheck
+(
+    const char *side
+)
+{
+    UINT count = wncRingCount (ring);
+
+    if (count > ring->numMsgs)
+    {
+        printf ("ringStressTest: %s: %u records queued in a ring of %u\n",
+                side, count, ring->numMsgs);
+        ringError = TRUE;
+        return ERROR;
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* ringProducer - the producer thread
+*
+* RETURNS: NULL
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void *ringProducer
+(
+    void *arg
+)
+{
+    RING_REC  recs[RING_BATCH];
+    RING_REC *pSlot;
+    BOOL      isr = (ringIsr == RING_ISR_PRODUCER);
+    UINT32    seq = 0;
+    int       turn = 0;
+    int       num;
+    int       i;
+
+    while ((seq < (UINT32)ringMsgs) && !ringError)
+    {
+        if (ringCountCheck ("producer") != OK)
+            break;
+
+        if (turn++ & 1)
+        {
+            if ((pSlot = (RING_REC *)wncRingReserve (ring)) != NULL)
+            {
+                ringRecFill (pSlot, seq++);
+                wncRingCommit (ring, 1);
+            }
+        }
+        else
+        {
+            num = 1 + turn % RING_BATCH;
+            if (num > ringMsgs - (int)seq)
+                num = ringMsgs - seq;
+            for (i = 0; i < num; i++)
+                ringRecFill (&recs[i], seq + i);
+
+            pSlot = (RING_REC *)recs;
+            if ((num = wncRingPut (ring, (char *)recs, num)) == 0)
+                pSlot = NULL;
+            seq += num;
+        }
+
+        if (pSlot == NULL)
+            ringIdle (isr);
+        else if ((ringIsr != RING_ISR_NONE) && !isr)
+            ringWork (seq);
+    }
+
+    ringProduced = seq;
+    return NULL;
+}
+
+/************************************************************************
+*
+* ringConsumer - the consumer thread
+*
+* RETURNS: NULL
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void *ringConsumer
+(
+    void *arg
+)
+{
+    RING_REC  recs[RING_BATCH];
+    RING_REC *pRun;
+    BOOL      isr = (ringIsr == RING_ISR_CONSUMER);
+    UINT32    seq = 0;
+    int       turn = 0;
+    int       num;
+    int       i;
+
+    while ((seq < (UINT32)ringMsgs) && !ringError)
+    {
+        if (ringCountCheck ("consumer") != OK)
+            break;
+
+        switch (turn++ % 3)
+        {
+        case 0:
+            num = wncRingGet (ring, (char *)recs, 1 + turn % RING_BATCH);
+            pRun = recs;
+            break;
+
+        case 1:
+            if ((pRun = (RING_REC *)wncRingPeekRun (ring, &num)) == NULL)
+                break;
+            if (((char *)pRun < ring->slots) ||
+                ((char *)(pRun + num) >
+                 ring->slots + (ring->mask + 1) * ring->msgSize))
+            {
+                printf ("ringStressTest: run of %d records outside the "
+                        "slots\n", num);
+                ringError = TRUE;
+                return NULL;
+            }
+
+            /* leave part of a long run for the next turn */
+            if (num > 1)
+                num -= turn % 2;
+            break;
+
+        default:
+            pRun = (RING_REC *)wncRingPeek (ring);
+            num = (pRun != NULL) ? 1 : 0;
+            break;
+        }
+
+        for (i = 0; i < num; i++)
+        {
+            if (ringRecCheck (&pRun[i], seq) != OK)
+                break;
+            seq++;
+        }
+        if (ringError)
+            break;
+        if ((num != 0) && (pRun != recs))
+            wncRingRemove (ring, num);
+
+        if (num == 0)
+            ringIdle (isr);
+        else if ((ringIsr != RING_ISR_NONE) && !isr)
+            ringWork (seq);
+    }
+
+    ringConsumed = seq;
+    return NULL;
+}
+
+/************************************************************************
+*
+* ringStart - start a side of the ring
+*
+* RETURNS: 0, or the error number of pthread_create()
+*
+* ERRNO: N/A
+*
+*/
+LOCAL int ringStart
+(
+    pthread_t *pThread,
+    void *   (*rtn) (void *),
+    BOOL       isr      /* run it as the ISR side */
+)
+{
+    pthread_attr_t     attr;
+    struct sched_param param;
+    int                rc;
+
+    pthread_attr_init (&attr);
+    if (isr)
+    {
+        pthread_attr_setinheritsched (&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy (&attr, SCHED_FIFO);
+        param.sched_priority = sched_get_priority_min (SCHED_FIFO);
+        pthread_attr_setschedparam (&attr, &param);
+    }
+    rc = pthread_create (pThread, &attr, rtn, NULL);
+    pthread_attr_destroy (&attr);
+    return rc;
+}
+
+/************************************************************************
+*
+* ringRun - pass records through a ring of "numMsgs"
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS ringRun
+(
+    int numMsgs,
+    int msgs,       /* records to pass without an ISR side */
+    int isr         /* RING_ISR_xxx */
+)
+{
+    static const char *isrName[] = {"", ", producer ISR", ", consumer ISR"};
+    pthread_t          producer;
+    pthread_t          consumer;
+    int                rc;
+
+    if ((ring = wncRingCreate (numMsgs, sizeof (RING_REC))) == NULL)
+    {
+        printf ("ringStressTest: wncRingCreate failed\n");
+        return ERROR;
+    }
+
+    ringIsr = isr;
+    ringMsgs = (isr == RING_ISR_NONE) ? msgs : RING_ISR_WAKES * numMsgs;
+    ringProduced = ringConsumed = 0;
+    if ((rc = ringStart (&consumer, ringConsumer,
+                         isr == RING_ISR_CONSUMER)) != 0)
+    {
+        wncRingDelete (ring);
+        if (rc != EPERM)
+        {
+            printf ("ringStressTest: pthread_create failed\n");
+            return ERROR;
+        }
+        printf ("ringStressTest: ring of %d%s: no SCHED_FIFO, skipped\n",
+                numMsgs, isrName[isr]);
+        return OK;
+    }
+    if ((rc = ringStart (&producer, ringProducer,
+                         isr == RING_ISR_PRODUCER)) != 0)
+    {
+        /* the consumer waits for records that never come */
+        printf ("ringStressTest: pthread_create failed\n");
+        return ERROR;
+    }
+    pthread_join (producer, NULL);
+    pthread_join (consumer, NULL);
+    wncRingDelete (ring);
+
+    if (ringError || (ringProduced != ringMsgs) ||
+        (ringConsumed != ringMsgs))
+    {
+        printf ("ringStressTest: ring of %d%s: %d records produced, %d "
+                "consumed\n", numMsgs, isrName[isr], ringProduced,
+                ringConsumed);
+        return ERROR;
+    }
+
+    printf ("ringStressTest: ring of %d%s: %d records\n", numMsgs,
+            isrName[isr], ringMsgs);
+    return OK;
+}
+
+/************************************************************************
+*
+* main - run the ring stress test
+*
+* RETURNS: 0 if the test passes, 1 otherwise
+*
+* ERRNO: N/A
+*
+*/
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    static const struct
+    {
+        int numMsgs;
+        int msgs;
+    } rings[] = {{1, 1000000}, {13, 10000000}, {64, 10000000}};
+    int i;
+    int isr;
+
+    for (i = 0; i < NELEMENTS (rings); i++)
+    {
+        for (isr = RING_ISR_NONE; isr <= RING_ISR_CONSUMER; isr++)
+        {
+            if (ringRun (rings[i].numMsgs, rings[i].msgs, isr) != OK)
+                return 1;
+        }
+    }
+
+    printf ("ringStressTest: passed\n");
+    return 0;
+}
@@ -0,0 +1,238 @@
+/* rxDrainTest.c - host test: SJA1000 RX FIFO draining under a burst */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This program measures the RX interrupts the receiving SJA1000 of the
+simulated board takes for a burst of frames, with and without the RX FIFO
+draining of SJA1000_RxDrainSet().
+
+For each burst the interrupts of /can/1 are held off, as by a long
+interrupt lock, while /can/0 sends DRAIN_BURST frames, so that they are
+queued in the 64 byte receive FIFO of the model. Once the interrupts are
+enabled again, the driver hands them to DevIO in one RX interrupt per
+frame without draining, and in one RX interrupt for the whole burst with
+it. The counts come from WNCAN_CTLRCONFIG_GET; every frame must be read,
+in order, in both modes.
+
+The program runs on the virtual clock of hostOs.c.
+
+RETURNS: 0 if the test passes, 1 otherwise
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <ioLib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CAN/wnCAN.h"
+#include "CAN/canController.h"
+#include "CAN/canBoard.h"
+#include "CAN/sja1000.h"
+#include "CAN/wncanDevIO.h"
+#include "CAN/private/pr6120_can.h"
+#include "hostOs.h"
+#include "testPort.h"
+
+/* defines */
+#define DRAIN_BURST     12      /* frames of 2 bytes, 60 bytes of FIFO */
+#define DRAIN_BURSTS    10
+#define DRAIN_FRAMES    (DRAIN_BURST * DRAIN_BURSTS)
+
+/* the clock of hostOs.c runs only in hostTickAdvance() */
+BOOL hostClkManual = TRUE;
+
+extern struct PR6120_CAN_DeviceEntry *PR6120_CAN_DeviceEntryGet (UINT brdNum);
+
+LOCAL TEST_PORT tx;
+LOCAL TEST_PORT rx;
+
+/************************************************************************
+*
+* drainSet - turn RX FIFO draining of /can/1 on or off
+*
+* The RX statistics are cleared with it.
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS drainSet
+(
+    BOOL rxDrain
+)
+{
+    WNCAN_CTLRCONFIG       cfg;
+    struct SJA1000_RxStats stats;
+
+    memset (&cfg, 0, sizeof (cfg));
+    cfg.ctlrType = WNCAN_SJA1000;
+    if (ioctl (rx.fdCtr, WNCAN_CTLRCONFIG_GET, (int)&cfg) != OK)
+        return ERROR;
+
+    cfg.ctlrData.sja1000Data.rxDrain = rxDrain;
+    if (ioctl (rx.fdCtr, WNCAN_CTLRCONFIG_SET, (int)&cfg) != OK)
+        return ERROR;
+
+    SJA1000_RxStatsGet (&PR6120_CAN_DeviceEntryGet (0)->canDevice[1], &stats,
+                        TRUE);
+    return OK;
+}
+
+/************************************************************************
+*
+* drainRun - send the bursts and count the RX interrupts
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS drainRun
+(
+    BOOL  rxDrain,
+    ULONG *pRxInts,
+    ULONG *pMaxBurst
+)
+{
+    struct WNCAN_Device *pRxDev = &PR6120_CAN_DeviceEntryGet (0)->canDevice[1];
+    WNCAN_CTLRCONFIG     cfg;
+    WNCAN_CHNMSG         msg[DRAIN_BURST];
+    int                  rcvd = 0;
+    int                  burst;
+    int                  got;
+    int                  n;
+    int                  i;
+
+    if (drainSet (rxDrain) != OK)
+    {
+        printf ("rxDrainTest: WNCAN_CTLRCONFIG_SET failed\n");
+        return ERROR;
+    }
+
+    for (burst = 0; burst < DRAIN_BURSTS; burst++)
+    {
+        CAN_DisableInt (pRxDev);
+
+        memset (msg, 0, sizeof (msg));
+        for (i = 0; i < DRAIN_BURST; i++)
+        {
+            msg[i].id = 0x100 + burst * DRAIN_BURST + i;
+            msg[i].len = 2;
+            msg[i].data[0] = (UCHAR)burst;
+            msg[i].data[1] = (UCHAR)i;
+        }
+        for (i = 0; i < DRAIN_BURST; i += got / (int)sizeof (WNCAN_CHNMSG))
+        {
+            got = write (tx.fdChn, (char *)&msg[i],
+                         (DRAIN_BURST - i) * sizeof (WNCAN_CHNMSG));
+            if (got <= 0)
+            {
+                printf ("rxDrainTest: write failed\n");
+                return ERROR;
+            }
+        }
+
+        /* the burst takes less than 1 ms at 1 Mbit/s */
+        hostTickAdvance (2);
+
+        CAN_SetIntMask (pRxDev, WNCAN_INT_ALL);
+        CAN_EnableInt (pRxDev);
+        hostTickAdvance (2);
+
+        for (n = 0; n < DRAIN_BURST; n += got / (int)sizeof (WNCAN_CHNMSG))
+        {
+            got = read (rx.fdChn, (char *)&msg[n],
+                        (DRAIN_BURST - n) * sizeof (WNCAN_CHNMSG));
+            if (got <= 0)
+                break;
+        }
+        for (i = 0; i < n; i++, rcvd++)
+        {
+            if ((msg[i].id != 0x100 + rcvd) || (msg[i].len != 2) ||
+                (msg[i].data[0] != rcvd / DRAIN_BURST) ||
+                (msg[i].data[1] != rcvd % DRAIN_BURST))
+            {
+                printf ("rxDrainTest: frame %d: id 0x%lx\n", rcvd, msg[i].id);
+                return ERROR;
+            }
+        }
+        if (n != DRAIN_BURST)
+        {
+            printf ("rxDrainTest: burst %d: %d of %d frames received\n",
+                    burst, n, DRAIN_BURST);
+            return ERROR;
+        }
+    }
+
+    memset (&cfg, 0, sizeof (cfg));
+    cfg.ctlrType = WNCAN_SJA1000;
+    if ((ioctl (rx.fdCtr, WNCAN_CTLRCONFIG_GET, (int)&cfg) != OK) ||
+        (cfg.ctlrData.sja1000Data.rxFrames != DRAIN_FRAMES))
+    {
+        printf ("rxDrainTest: %lu frames counted, %d sent\n",
+                cfg.ctlrData.sja1000Data.rxFrames, DRAIN_FRAMES);
+        return ERROR;
+    }
+
+    *pRxInts = cfg.ctlrData.sja1000Data.rxInts;
+    *pMaxBurst = cfg.ctlrData.sja1000Data.rxMaxBurst;
+    printf ("rxDrainTest: drain %-3s %4d frames, %4lu RX interrupts, "
+            "%.1f frames per interrupt, largest burst %lu\n",
+            rxDrain ? "on" : "off", DRAIN_FRAMES, *pRxInts,
+            (double)DRAIN_FRAMES / *pRxInts, *pMaxBurst);
+    return OK;
+}
+
+/************************************************************************
+*
+* main - run the RX FIFO draining test
+*
+* RETURNS: 0 if the test passes, 1 otherwise
+*
+* ERRNO: N/A
+*
+*/
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    ULONG intsOff;
+    ULONG intsOn;
+    ULONG maxOff;
+    ULONG maxOn;
+
+    if ((testPortOpen (&tx, "/can/0", FALSE, DRAIN_BURST) != OK) ||
+        (testPortOpen (&rx, "/can/1", TRUE, DRAIN_BURST) != OK))
+    {
+        printf ("rxDrainTest: opening the ports failed\n");
+        return 1;
+    }
+
+    if ((drainRun (FALSE, &intsOff, &maxOff) != OK) ||
+        (drainRun (TRUE, &intsOn, &maxOn) != OK))
+        return 1;
+
+    /* one RX interrupt per frame without draining, one per burst with it */
+    if ((intsOff != DRAIN_FRAMES) || (maxOff != 1) ||
+        (intsOn != DRAIN_BURSTS) || (maxOn != DRAIN_BURST))
+    {
+        printf ("rxDrainTest: failed\n");
+        return 1;
+    }
+
+    printf ("rxDrainTest: passed\n");
+    return 0;
+}
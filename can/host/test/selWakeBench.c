@@ -0,0 +1,268 @@
+/* selWakeBench.c - host benchmark: select() wakeups of the receive ISR */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This program measures what a select() reader costs the receive ISR of
+DevIO under load on the simulated board. /can/0 sends BENCH_BURSTS bursts
+of BENCH_BURST frames to /can/1, where a task waits in select() and reads
+whatever is queued each time it is woken.
+
+The ISR wakes the wakeup list only when a reader is pending and the input
+buffer reaches the read threshold of WNCAN_CHNWAKEUP_SET. Before that it
+called selWakeupAll() for every frame it stored, one call per frame. The
+program counts, through hostOs.c, the selWakeupAll() calls and the select()
+calls they woke per frame, and the time per frame spent at interrupt level,
+where the model of the board runs and calls the ISR. It does this with
+the default read threshold of 1, and with a threshold of 16 and a maximum
+latency.
+
+Every frame must be read once and in order. There may be at most one
+selWakeupAll() call per select() of the reader, and far fewer than one per
+frame, because the model delivers the frames of a clock tick in one run.
+The times are printed for information only.
+
+The program runs on the system clock thread of hostOs.c, in real time.
+
+RETURNS: 0 if the benchmark passes, 1 otherwise
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <ioLib.h>
+#include <selectLib.h>
+#include <stdio.h>
+#include <string.h>
+#include <taskLib.h>
+
+#include "CAN/wnCAN.h"
+#include "CAN/wncanDevIO.h"
+#include "testPort.h"
+#include "hostOs.h"
+
+/* defines */
+#define BENCH_BURST      64
+#define BENCH_BURSTS     32
+#define BENCH_FRAMES     (BENCH_BURST * BENCH_BURSTS)
+#define BENCH_BUF_SIZE   256
+#define BENCH_WAIT_TICKS 1000    /* bound of the wait for a burst */
+
+/* locals */
+
+LOCAL TEST_PORT        tx;
+LOCAL TEST_PORT        rx;
+LOCAL volatile int     benchRcvd;      /* frames read by the reader */
+LOCAL volatile ULONG   benchSelects;   /* select() calls of the reader */
+LOCAL volatile BOOL    benchError;
+LOCAL volatile BOOL    benchStop;
+LOCAL volatile BOOL    benchDone;
+
+/************************************************************************
+*
+* benchMsgFill - build frame number "n"
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void benchMsgFill
+(
+    WNCAN_CHNMSG *pMsg,
+    int           n
+)
+{
+    int i;
+
+    memset (pMsg, 0, sizeof (*pMsg));
+    pMsg->id = 0x100 + (n % 0x400);
+    pMsg->len = WNCAN_MAX_DATA_LEN;
+    for (i = 0; i < WNCAN_MAX_DATA_LEN; i++)
+        pMsg->data[i] = (UCHAR)(n >> (i & 1 ? 8 : 0));
+}
+
+/************************************************************************
+*
+* benchReader - the select() reader task
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void benchReader (void)
+{
+    WNCAN_CHNMSG   msg[BENCH_BUF_SIZE];
+    WNCAN_CHNMSG   expect;
+    struct timeval tv;
+    fd_set         readFds;
+    int            n;
+    int            i;
+
+    while (!benchStop && !benchError)
+    {
+        FD_ZERO (&readFds);
+        FD_SET (rx.fdChn, &readFds);
+        tv.tv_sec = 0;
+        tv.tv_usec = 100000;
+        benchSelects++;
+        if (select (FD_SETSIZE, &readFds, NULL, NULL, &tv) <= 0)
+            continue;
+
+        while ((n = read (rx.fdChn, (char *)msg, sizeof (msg))) > 0)
+        {
+            for (i = 0; i < n / (int)sizeof (WNCAN_CHNMSG); i++)
+            {
+                benchMsgFill (&expect, benchRcvd);
+                if ((msg[i].id != expect.id) || (msg[i].len != expect.len) ||
+                    (memcmp (msg[i].data, expect.data, expect.len) != 0))
+                {
+                    printf ("selWakeBench: frame %d: id 0x%lx, expected "
+                            "0x%lx\n", benchRcvd, msg[i].id, expect.id);
+                    benchError = TRUE;
+                    break;
+                }
+                benchRcvd++;
+            }
+        }
+    }
+    benchDone = TRUE;
+}
+
+/************************************************************************
+*
+* benchRun - send the bursts with a read threshold
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS benchRun
+(
+    UINT rxThreshold,
+    UINT rxMaxLatency,
+    UINT maxWakeups     /* bound of the selWakeupAll() calls */
+)
+{
+    WNCAN_CHNMSG msg[BENCH_BURST];
+    WNCAN_WAKEUP wakeup;
+    ULONG        wakeAlls = hostSelWakeupAlls;
+    ULONG        wakes = hostSelWakes;
+    ULONG        selects;
+    UINT64       intNs = hostWdNs;
+    int          first = benchRcvd;
+    int          burst;
+    int          ticks;
+    int          i;
+
+    wakeup.rxThreshold = rxThreshold;
+    wakeup.txThreshold = 1;
+    wakeup.rxMaxLatency = rxMaxLatency;
+    if (ioctl (rx.fdChn, WNCAN_CHNWAKEUP_SET, (int)&wakeup) != OK)
+    {
+        printf ("selWakeBench: WNCAN_CHNWAKEUP_SET failed\n");
+        return ERROR;
+    }
+
+    selects = benchSelects;
+    for (burst = 0; burst < BENCH_BURSTS; burst++)
+    {
+        for (i = 0; i < BENCH_BURST; i++)
+            benchMsgFill (&msg[i], first + burst * BENCH_BURST + i);
+        if (write (tx.fdChn, (char *)msg, sizeof (msg)) != sizeof (msg))
+        {
+            printf ("selWakeBench: write failed\n");
+            return ERROR;
+        }
+
+        for (ticks = 0; benchRcvd < first + (burst + 1) * BENCH_BURST;
+             ticks++)
+        {
+            if (benchError || (ticks == BENCH_WAIT_TICKS))
+            {
+                printf ("selWakeBench: %d of %d frames received\n",
+                        benchRcvd - first, (burst + 1) * BENCH_BURST);
+                return ERROR;
+            }
+            taskDelay (1);
+        }
+    }
+
+    wakeAlls = hostSelWakeupAlls - wakeAlls;
+    wakes = hostSelWakes - wakes;
+    selects = benchSelects - selects;
+    intNs = hostWdNs - intNs;
+
+    printf ("selWakeBench: threshold %2u: %d frames, %4lu select() calls, "
+            "%4lu selWakeupAll() (%.3f per frame), %4lu woken, "
+            "%.2f us at interrupt level per frame\n", rxThreshold,
+            BENCH_FRAMES, selects, wakeAlls,
+            (double)wakeAlls / BENCH_FRAMES, wakes,
+            (double)intNs / 1000 / BENCH_FRAMES);
+
+    if ((wakeAlls > selects) || (wakeAlls > maxWakeups))
+    {
+        printf ("selWakeBench: %lu selWakeupAll() calls, %lu select() "
+                "calls, at most %u expected\n", wakeAlls, selects,
+                maxWakeups);
+        return ERROR;
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* main - run the select() wakeup benchmark
+*
+* RETURNS: 0 if the benchmark passes, 1 otherwise
+*
+* ERRNO: N/A
+*
+*/
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    STATUS status;
+
+    if ((testPortOpen (&tx, "/can/0", FALSE, BENCH_BUF_SIZE) != OK) ||
+        (testPortOpen (&rx, "/can/1", TRUE, BENCH_BUF_SIZE) != OK))
+    {
+        printf ("selWakeBench: opening the ports failed\n");
+        return 1;
+    }
+
+    if (taskSpawn ("tBenchRd", 100, 0, 16384, (FUNCPTR)benchReader,
+                   0, 0, 0, 0, 0, 0, 0, 0, 0, 0) == ERROR)
+    {
+        printf ("selWakeBench: taskSpawn failed\n");
+        return 1;
+    }
+
+    /* about 9 frames per tick: at most one call per model run; with a
+       threshold of 16 one per 16 frames and one per burst for its tail */
+    status = benchRun (1, 0, BENCH_FRAMES / 4);
+    if (status == OK)
+        status = benchRun (16, 2000, BENCH_FRAMES / 16 + BENCH_BURSTS);
+
+    benchStop = TRUE;
+    while (!benchDone)
+        taskDelay (1);
+
+    if (status != OK)
+        return 1;
+
+    printf ("selWakeBench: passed\n");
+    return 0;
+}
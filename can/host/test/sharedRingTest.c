@@ -0,0 +1,410 @@
+/* sharedRingTest.c - host test: input ring shared with a kernel task */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This program runs the zero-copy receive protocol of WNCAN_CHNRING_GET,
+WNCAN_CHNRING_RELEASE and WNCAN_CHNRING_PUT on the simulated board. The receive ISR of /can/1
+builds the frames sent by /can/0 in the slots of the input ring; the
+program, as the consuming task, reads them in place with wncRingPeekRun()
+and hands the slots back with WNCAN_CHNRING_RELEASE.
+
+The channel reads in the WNCAN_MSGFMT_TS format, so every record carries
+the receive sequence number of the channel. The checks are:
+
+  - once the ring is shared, FIORBUFSET and WNCAN_CHNMSGFMT_SET fail;
+  - SHR_FRAMES frames pass through the ring of SHR_RING_SIZE slots, many
+    times around, consumed SHR_TAKE at a time so that the runs of
+    wncRingPeekRun() end both at the wrap of the slots and in the middle;
+    every record lies in the slots, in order, with consecutive sequence
+    numbers and non-decreasing timestamps, and select() reports the
+    channel readable while records are queued;
+  - frames that find the ring full are counted in rxFrames and rxDropped
+    and dropped; the records in the ring are kept, and the sequence
+    number of the next frame skips the dropped ones;
+  - WNCAN_CHNRING_PUT takes only the ring that was handed out, and only
+    once; read() then returns the record left in it, and FIORBUFSET and
+    WNCAN_CHNMSGFMT_SET work again.
+
+The program runs on the virtual clock of hostOs.c.
+
+RETURNS: 0 if the test passes, 1 otherwise
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <ioLib.h>
+#include <selectLib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CAN/wnCAN.h"
+#include "CAN/wncanDevIO.h"
+#include "CAN/wncanRing.h"
+#include "testPort.h"
+#include "hostOs.h"
+
+/* defines */
+#define SHR_RING_SIZE   64
+#define SHR_WBUF_SIZE   256
+#define SHR_FRAMES      2000
+#define SHR_BATCH       16      /* frames per write() */
+#define SHR_TAKE        5       /* records consumed per release */
+#define SHR_OVERFLOW    10      /* frames sent beyond a full ring */
+#define SHR_TICKS_MAX   5000
+
+#define SHR_CHECK(cond, what)                                   \
+    do                                                          \
+    {                                                           \
+        if (!(cond))                                            \
+        {                                                       \
+            printf ("sharedRingTest: %s (line %d)\n", what, __LINE__); \
+            return ERROR;                                       \
+        }                                                       \
+    } while (0)
+
+/* the clock of hostOs.c runs only in hostTickAdvance() */
+BOOL hostClkManual = TRUE;
+
+LOCAL TEST_PORT        tx;
+LOCAL TEST_PORT        rx;
+LOCAL WNCAN_MSGRING_ID ring;
+LOCAL int              sent;        /* frames written */
+LOCAL int              used;        /* records consumed */
+LOCAL UINT32           nextSeq;     /* sequence number of the next record */
+LOCAL UINT64           lastStamp;
+
+/************************************************************************
+*
+* shrMsgFill - build frame number "n"
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void shrMsgFill
+(
+    WNCAN_CHNMSG *pMsg,
+    int           n
+)
+{
+    memset (pMsg, 0, sizeof (*pMsg));
+    pMsg->id = 0x100 + (n % 0x400);
+    pMsg->len = 1 + n % WNCAN_MAX_DATA_LEN;
+    pMsg->data[0] = (UCHAR)(n >> 8);
+    pMsg->data[pMsg->len - 1] = (UCHAR)n;
+}
+
+/************************************************************************
+*
+* shrSend - write the next "num" frames
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS shrSend
+(
+    int num
+)
+{
+    WNCAN_CHNMSG msg[SHR_RING_SIZE + SHR_OVERFLOW];
+    int          i;
+
+    for (i = 0; i < num; i++)
+        shrMsgFill (&msg[i], sent + i);
+
+    SHR_CHECK (write (tx.fdChn, (char *)msg, num * sizeof (WNCAN_CHNMSG))
+               == num * (int)sizeof (WNCAN_CHNMSG), "write failed");
+    sent += num;
+    return OK;
+}
+
+/************************************************************************
+*
+* shrReadable - poll the receive channel with select()
+*
+* RETURNS: TRUE if select() reports it readable
+*
+* ERRNO: N/A
+*
+*/
+LOCAL BOOL shrReadable (void)
+{
+    struct timeval tv;
+    fd_set         readFds;
+
+    FD_ZERO (&readFds);
+    FD_SET (rx.fdChn, &readFds);
+    tv.tv_sec = 0;
+    tv.tv_usec = 0;
+    return (select (FD_SETSIZE, &readFds, NULL, NULL, &tv) == 1) &&
+           FD_ISSET (rx.fdChn, &readFds);
+}
+
+/************************************************************************
+*
+* shrConsume - consume up to "max" records in place
+*
+* This routine checks each record of the current run of the ring against
+* the frame it must hold, and releases the records it has checked.
+*
+* RETURNS: the number of records consumed, or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL int shrConsume
+(
+    int max
+)
+{
+    WNCAN_CHNMSG_TS *pRec;
+    WNCAN_CHNMSG     expect;
+    char            *pRun;
+    int              num;
+    int              i;
+
+    SHR_CHECK (shrReadable () != wncRingIsEmpty (ring),
+               "select() does not match the ring");
+
+    if ((pRun = wncRingPeekRun (ring, &num)) == NULL)
+        return 0;
+
+    SHR_CHECK ((pRun >= ring->slots) &&
+               (pRun + num * ring->msgSize <=
+                ring->slots + (ring->mask + 1) * ring->msgSize),
+               "run outside the slots");
+
+    if (num > max)
+        num = max;
+
+    for (i = 0; i < num; i++, used++, nextSeq++)
+    {
+        pRec = (WNCAN_CHNMSG_TS *)(pRun + i * ring->msgSize);
+        shrMsgFill (&expect, used);
+        if ((pRec->msg.id != expect.id) || (pRec->msg.len != expect.len) ||
+            (memcmp (pRec->msg.data, expect.data, expect.len) != 0) ||
+            (pRec->seqNum != nextSeq) || (pRec->timeStamp < lastStamp))
+        {
+            printf ("sharedRingTest: record %d: id 0x%lx seq %u, expected "
+                    "id 0x%lx seq %u\n", used, pRec->msg.id, pRec->seqNum,
+                    expect.id, nextSeq);
+            return ERROR;
+        }
+        lastStamp = pRec->timeStamp;
+    }
+
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNRING_RELEASE, num) == OK,
+               "WNCAN_CHNRING_RELEASE failed");
+    return num;
+}
+
+/************************************************************************
+*
+* shrSetup - open the ports and share the input ring
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS shrSetup (void)
+{
+    WNCAN_MSGFMT fmt;
+
+    SHR_CHECK ((testPortOpen (&tx, "/can/0", FALSE, SHR_WBUF_SIZE) == OK) &&
+               (testPortOpen (&rx, "/can/1", TRUE, SHR_RING_SIZE) == OK),
+               "opening the ports failed");
+
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNMSGFMT_GET, (int)&fmt) == OK,
+               "WNCAN_CHNMSGFMT_GET failed");
+    fmt.format = WNCAN_MSGFMT_TS;
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNMSGFMT_SET, (int)&fmt) == OK,
+               "WNCAN_CHNMSGFMT_SET failed");
+
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNRING_GET, 0) == ERROR,
+               "WNCAN_CHNRING_GET took a NULL pointer");
+    SHR_CHECK ((ioctl (rx.fdChn, WNCAN_CHNRING_GET, (int)&ring) == OK) &&
+               (ring != NULL), "WNCAN_CHNRING_GET failed");
+    SHR_CHECK ((ring->msgSize == sizeof (WNCAN_CHNMSG_TS)) &&
+               (ring->numMsgs == SHR_RING_SIZE), "wrong ring geometry");
+    SHR_CHECK (ioctl (tx.fdChn, WNCAN_CHNRING_GET, (int)&ring) == ERROR,
+               "WNCAN_CHNRING_GET on a transmit channel");
+
+    /* the ring cannot be replaced under the task */
+    SHR_CHECK (ioctl (rx.fdChn, FIORBUFSET, 2 * SHR_RING_SIZE) == ERROR,
+               "FIORBUFSET on a shared ring");
+    fmt.format = WNCAN_MSGFMT_STD;
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNMSGFMT_SET, (int)&fmt) == ERROR,
+               "WNCAN_CHNMSGFMT_SET on a shared ring");
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNRING_RELEASE, -1) == ERROR,
+               "WNCAN_CHNRING_RELEASE took a negative count");
+    return OK;
+}
+
+/************************************************************************
+*
+* shrStream - pass SHR_FRAMES frames through the ring
+*
+* The frames are written as long as the ring has room for them, so none
+* is dropped.
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS shrStream (void)
+{
+    int ticks;
+    int n;
+
+    for (ticks = 0; (used < SHR_FRAMES) && (ticks < SHR_TICKS_MAX); ticks++)
+    {
+        while ((sent < SHR_FRAMES) &&
+               (sent - used + SHR_BATCH <= SHR_RING_SIZE))
+        {
+            if (shrSend (SHR_BATCH) != OK)
+                return ERROR;
+        }
+
+        hostTickAdvance (1);
+
+        while ((n = shrConsume (SHR_TAKE)) > 0)
+            ;
+        if (n == ERROR)
+            return ERROR;
+    }
+
+    SHR_CHECK (used == SHR_FRAMES, "frames lost");
+    SHR_CHECK (!shrReadable (), "readable with an empty ring");
+    printf ("sharedRingTest: %d frames through %d slots in %d ticks\n",
+            used, SHR_RING_SIZE, ticks);
+    return OK;
+}
+
+/************************************************************************
+*
+* shrOverflow - overrun the ring and check the drop accounting
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS shrOverflow (void)
+{
+    WNCAN_STATS st;
+    int         n;
+
+    ioctl (rx.fdChn, WNCAN_STATS_CLEAR, 0);
+    if (shrSend (SHR_RING_SIZE + SHR_OVERFLOW) != OK)
+        return ERROR;
+    hostTickAdvance (20);
+
+    SHR_CHECK (wncRingCount (ring) == SHR_RING_SIZE, "ring not full");
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_STATS_GET, (int)&st) == OK,
+               "WNCAN_STATS_GET failed");
+    if ((st.rxFrames != SHR_RING_SIZE + SHR_OVERFLOW) ||
+        (st.rxDropped != SHR_OVERFLOW))
+    {
+        printf ("sharedRingTest: rxFrames %lu rxDropped %lu, expected "
+                "%d and %d\n", st.rxFrames, st.rxDropped,
+                SHR_RING_SIZE + SHR_OVERFLOW, SHR_OVERFLOW);
+        return ERROR;
+    }
+
+    /* the records in the ring are the first ones sent */
+    while ((n = shrConsume (SHR_RING_SIZE)) > 0)
+        ;
+    if (n == ERROR)
+        return ERROR;
+    SHR_CHECK (used == sent - SHR_OVERFLOW, "records lost");
+
+    /* the sequence number of the next frame skips the dropped ones */
+    used += SHR_OVERFLOW;
+    nextSeq += SHR_OVERFLOW;
+    if (shrSend (1) != OK)
+        return ERROR;
+    hostTickAdvance (2);
+    SHR_CHECK (shrConsume (1) == 1, "no frame after the overflow");
+    return OK;
+}
+
+/************************************************************************
+*
+* shrUnshare - hand the ring back and read the channel again
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS shrUnshare (void)
+{
+    WNCAN_CHNMSG_TS rec;
+    WNCAN_CHNMSG    expect;
+    WNCAN_MSGFMT    fmt;
+
+    /* a record is still queued when the ring is handed back */
+    if (shrSend (1) != OK)
+        return ERROR;
+    hostTickAdvance (2);
+    SHR_CHECK (wncRingCount (ring) == 1, "no record queued");
+
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNRING_PUT, 0) == ERROR,
+               "WNCAN_CHNRING_PUT took another ring");
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNRING_PUT, (int)ring) == OK,
+               "WNCAN_CHNRING_PUT failed");
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNRING_PUT, (int)ring) == ERROR,
+               "WNCAN_CHNRING_PUT on a ring not shared");
+
+    SHR_CHECK (read (rx.fdChn, (char *)&rec, sizeof (rec)) == sizeof (rec),
+               "read() after WNCAN_CHNRING_PUT failed");
+    shrMsgFill (&expect, used);
+    SHR_CHECK ((rec.msg.id == expect.id) && (rec.seqNum == nextSeq),
+               "read() returned the wrong record");
+
+    SHR_CHECK (ioctl (rx.fdChn, FIORBUFSET, 2 * SHR_RING_SIZE) == OK,
+               "FIORBUFSET after WNCAN_CHNRING_PUT failed");
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNMSGFMT_GET, (int)&fmt) == OK,
+               "WNCAN_CHNMSGFMT_GET failed");
+    fmt.format = WNCAN_MSGFMT_STD;
+    SHR_CHECK (ioctl (rx.fdChn, WNCAN_CHNMSGFMT_SET, (int)&fmt) == OK,
+               "WNCAN_CHNMSGFMT_SET after WNCAN_CHNRING_PUT failed");
+    return OK;
+}
+
+/************************************************************************
+*
+* main - run the shared ring test
+*
+* RETURNS: 0 if the test passes, 1 otherwise
+*
+* ERRNO: N/A
+*
+*/
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    if ((shrSetup () != OK) || (shrStream () != OK) ||
+        (shrOverflow () != OK) || (shrUnshare () != OK))
+        return 1;
+
+    printf ("sharedRingTest: passed\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+/* testPort.c - host tests: DevIO ports of the simulated board */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This file opens a controller of the simulated board and one of its
+channels through DevIO, the way demo/canbench.c does, for the programs
+of this directory.
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <ioLib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CAN/wnCAN.h"
+#include "CAN/wncanDevIO.h"
+#include "testPort.h"
+
+/************************************************************************
+*
+* testChanOpen - open another channel of an open controller
+*
+* This routine opens the first receive or transmit channel of the
+* controller "name", opened on pPort->fdCtr, sets the size of its input
+* or output buffer to "bufSize" messages unless it is 0 and enables it.
+* A controller can be opened only once; a second channel of it is opened
+* on the descriptor testPortOpen() returned.
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+STATUS testChanOpen
+(
+    TEST_PORT  *pPort,
+    const char *name,
+    BOOL        rx,
+    int         bufSize
+)
+{
+    WNCAN_CHNCONFIG chncfg;
+    UCHAR           chan;
+    char            chnName[32];
+
+    if (ioctl (pPort->fdCtr, rx ? WNCAN_RXCHAN_GET : WNCAN_TXCHAN_GET,
+               (int)&chan) != OK)
+        return ERROR;
+
+    pPort->chan = chan;
+    sprintf (chnName, "%s/%d", name, chan);
+    if ((pPort->fdChn = open (chnName, rx ? O_RDONLY : O_WRONLY, 0)) == ERROR)
+        return ERROR;
+
+    if ((bufSize != 0) &&
+        (ioctl (pPort->fdChn, rx ? FIORBUFSET : FIOWBUFSET, bufSize) != OK))
+        return ERROR;
+
+    memset (&chncfg, 0, sizeof (chncfg));
+    chncfg.flags = rx ? WNCAN_CHNCFG_CHANNEL : WNCAN_CHNCFG_RTR;
+    if (ioctl (pPort->fdChn, WNCAN_CHNCONFIG_SET, (int)&chncfg) != OK)
+        return ERROR;
+
+    ioctl (pPort->fdChn, WNCAN_CHN_ENABLE, TRUE);
+    ioctl (pPort->fdChn, WNCAN_STATS_CLEAR, 0);
+    return OK;
+}
+
+/************************************************************************
+*
+* testPortOpen - open a controller and one of its channels
+*
+* This routine sets TEST_BAUD and the acceptance of all frames on the
+* controller "name", opens its first receive or transmit channel with
+* testChanOpen() and starts the controller.
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+STATUS testPortOpen
+(
+    TEST_PORT  *pPort,
+    const char *name,
+    BOOL        rx,
+    int         bufSize
+)
+{
+    WNCAN_CONFIG    devcfg;
+    ULONG           clk;
+
+    if ((pPort->fdCtr = open (name, O_RDWR, 0)) == ERROR)
+        return ERROR;
+
+    devcfg.flags = WNCAN_CFG_INFO | WNCAN_CFG_GBLFILTER | WNCAN_CFG_BITTIMING;
+    if (ioctl (pPort->fdCtr, WNCAN_CONFIG_GET, (int)&devcfg) != OK)
+        return ERROR;
+
+    devcfg.flags = WNCAN_CFG_GBLFILTER | WNCAN_CFG_BITTIMING;
+    devcfg.filter.mask = 0;
+    devcfg.filter.extended = FALSE;
+    devcfg.bittiming.oversample = FALSE;
+    devcfg.bittiming.sjw = 0;
+    devcfg.bittiming.tseg1 = 4;
+    devcfg.bittiming.tseg2 = 1;
+    clk = devcfg.info.xtalfreq / 2;
+    devcfg.bittiming.brp = clk / ((4 + 1) + (1 + 1) + 1) / TEST_BAUD - 1;
+    if (ioctl (pPort->fdCtr, WNCAN_CONFIG_SET, (int)&devcfg) != OK)
+        return ERROR;
+
+    if (testChanOpen (pPort, name, rx, bufSize) != OK)
+        return ERROR;
+
+    return ioctl (pPort->fdCtr, WNCAN_HALT, FALSE);
+}
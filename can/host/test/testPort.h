@@ -0,0 +1,35 @@
+/* testPort.h - host tests: DevIO ports of the simulated board */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+#ifndef __INCtestPorth
+#define __INCtestPorth
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEST_BAUD      1000000  /* bit rate set by testPortOpen() */
+
+typedef struct
+{
+    int fdCtr;  /* device descriptor */
+    int fdChn;  /* channel descriptor */
+    int chan;   /* channel number */
+} TEST_PORT;
+
+STATUS testPortOpen (TEST_PORT *pPort, const char *name, BOOL rx, 
+                     int bufSize);
+STATUS testChanOpen (TEST_PORT *pPort, const char *name, BOOL rx,
+                     int bufSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INCtestPorth */
@@ -0,0 +1,319 @@
+/* wireRateTest.c - host test: back-to-back transmission at wire rate */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This program checks that the transmit pump of DevIO keeps the SJA1000
+transmitter of the simulated board busy and the frames in order.
+
+A burst of WIRE_FRAMES frames with 8 data bytes is written in one write()
+and the clock is advanced one tick at a time until all of them have been
+read. The model calls the ISR at the simulated end of each frame, so if
+the driver loads the next frame from the transmit interrupt the bus never
+goes idle and the burst takes WIRE_FRAMES frame times, about 100 ms at
+1 Mbit/s. A transmitter reloaded by a task would send one frame per tick,
+nine times slower. The burst must be read within one tick of the wire time,
+every frame once and in order, and the channel statistics must count it
+without drops.
+
+The burst is sent first from /can/0 to /can/1, then split between both
+controllers sending at the same time. The frames of /can/1 have the lower
+identifiers and win arbitration, and the frames of /can/0 that lose it
+must be retried in place.
+
+The program runs on the virtual clock of hostOs.c.
+
+RETURNS: 0 if the test passes, 1 otherwise
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <ioLib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sysLib.h>
+
+#include "CAN/wnCAN.h"
+#include "CAN/wncanDevIO.h"
+#include "testPort.h"
+#include "hostOs.h"
+
+/* defines */
+#define WIRE_FRAMES     900
+#define WIRE_BUF_SIZE   1024
+#define WIRE_FRAME_BITS (47 + 8 * 8)    /* standard frame, 8 data bytes */
+#define WIRE_TICKS_MAX  1000
+
+/* typedefs */
+
+/* one direction of the burst */
+typedef struct
+{
+    const char   *name;
+    TEST_PORT    *pTx;
+    TEST_PORT    *pRx;
+    ULONG         idBase;
+    int           frames;
+    int           rcvd;
+} WIRE_FLOW;
+
+/* the clock of hostOs.c runs only in hostTickAdvance() */
+BOOL hostClkManual = TRUE;
+
+LOCAL TEST_PORT tx0;
+LOCAL TEST_PORT rx0;
+LOCAL TEST_PORT tx1;
+LOCAL TEST_PORT rx1;
+
+/************************************************************************
+*
+* wireMsgFill - build frame number "n" of a flow
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void wireMsgFill
+(
+    const WIRE_FLOW *pFlow,
+    WNCAN_CHNMSG    *pMsg,
+    int              n
+)
+{
+    int i;
+
+    memset (pMsg, 0, sizeof (*pMsg));
+    pMsg->id = pFlow->idBase + (n % 0x80);
+    pMsg->len = WNCAN_MAX_DATA_LEN;
+    pMsg->data[0] = (UCHAR)(n >> 8);
+    pMsg->data[1] = (UCHAR)n;
+    for (i = 2; i < WNCAN_MAX_DATA_LEN; i++)
+        pMsg->data[i] = (UCHAR)(n + i);
+}
+
+/************************************************************************
+*
+* wireSend - write the burst of a flow
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS wireSend
+(
+    WIRE_FLOW *pFlow
+)
+{
+    static WNCAN_CHNMSG msg[WIRE_FRAMES];
+    int                 i;
+
+    for (i = 0; i < pFlow->frames; i++)
+        wireMsgFill (pFlow, &msg[i], i);
+
+    ioctl (pFlow->pTx->fdChn, WNCAN_STATS_CLEAR, 0);
+    ioctl (pFlow->pRx->fdChn, WNCAN_STATS_CLEAR, 0);
+    pFlow->rcvd = 0;
+    if (write (pFlow->pTx->fdChn, (char *)msg,
+               pFlow->frames * sizeof (WNCAN_CHNMSG)) !=
+        pFlow->frames * (int)sizeof (WNCAN_CHNMSG))
+    {
+        printf ("wireRateTest: %s: write failed\n", pFlow->name);
+        return ERROR;
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* wireRead - read and check the frames a flow has received
+*
+* RETURNS: OK, or ERROR if a frame is missing, repeated or changed
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS wireRead
+(
+    WIRE_FLOW *pFlow
+)
+{
+    WNCAN_CHNMSG msg[64];
+    WNCAN_CHNMSG expect;
+    int          n;
+    int          i;
+
+    while ((n = read (pFlow->pRx->fdChn, (char *)msg, sizeof (msg))) > 0)
+    {
+        for (i = 0; i < n / (int)sizeof (WNCAN_CHNMSG); i++, pFlow->rcvd++)
+        {
+            wireMsgFill (pFlow, &expect, pFlow->rcvd);
+            if ((pFlow->rcvd >= pFlow->frames) ||
+                (msg[i].id != expect.id) || (msg[i].len != expect.len) ||
+                (memcmp (msg[i].data, expect.data, expect.len) != 0))
+            {
+                printf ("wireRateTest: %s: frame %d: id 0x%lx data %02x%02x, "
+                        "expected id 0x%lx\n", pFlow->name, pFlow->rcvd,
+                        msg[i].id, msg[i].data[0], msg[i].data[1],
+                        expect.id);
+                return ERROR;
+            }
+        }
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* wireStatsCheck - check the channel statistics of a flow
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS wireStatsCheck
+(
+    const WIRE_FLOW *pFlow
+)
+{
+    WNCAN_STATS tx;
+    WNCAN_STATS rx;
+
+    if ((ioctl (pFlow->pTx->fdChn, WNCAN_STATS_GET, (int)&tx) != OK) ||
+        (ioctl (pFlow->pRx->fdChn, WNCAN_STATS_GET, (int)&rx) != OK) ||
+        (tx.txFrames != (ULONG)pFlow->frames) || (tx.txDropped != 0) ||
+        (rx.rxFrames != (ULONG)pFlow->frames) || (rx.rxDropped != 0))
+    {
+        printf ("wireRateTest: %s: txFrames %lu txDropped %lu rxFrames %lu "
+                "rxDropped %lu, expected %d\n", pFlow->name, tx.txFrames,
+                tx.txDropped, rx.rxFrames, rx.rxDropped, pFlow->frames);
+        return ERROR;
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* wireRun - send the bursts of flows at the same time
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS wireRun
+(
+    WIRE_FLOW *flows,
+    int        numFlows
+)
+{
+    int frames = 0;
+    int rcvd;
+    int ticks;
+    int wireTicks;
+    int i;
+
+    for (i = 0; i < numFlows; i++)
+    {
+        frames += flows[i].frames;
+        if (wireSend (&flows[i]) != OK)
+            return ERROR;
+    }
+
+    /* the bus time of the frames, rounded up to ticks */
+    wireTicks = (int)(((UINT64)frames * WIRE_FRAME_BITS * sysClkRateGet () +
+                       TEST_BAUD - 1) / TEST_BAUD);
+
+    for (ticks = 0; ticks < WIRE_TICKS_MAX; )
+    {
+        hostTickAdvance (1);
+        ticks++;
+
+        rcvd = 0;
+        for (i = 0; i < numFlows; i++)
+        {
+            if (wireRead (&flows[i]) != OK)
+                return ERROR;
+            rcvd += flows[i].rcvd;
+        }
+        if (rcvd == frames)
+            break;
+    }
+
+    printf ("wireRateTest: %d flow%s, %d frames in %d ticks, wire time "
+            "%d ticks\n", numFlows, (numFlows > 1) ? "s" : "", frames,
+            ticks, wireTicks);
+
+    if (ticks > wireTicks + 1)
+    {
+        printf ("wireRateTest: %d of %d frames read after %d ticks\n",
+                rcvd, frames, ticks);
+        return ERROR;
+    }
+
+    for (i = 0; i < numFlows; i++)
+    {
+        if (wireStatsCheck (&flows[i]) != OK)
+            return ERROR;
+    }
+    return OK;
+}
+
+/************************************************************************
+*
+* main - run the wire rate test
+*
+* RETURNS: 0 if the test passes, 1 otherwise
+*
+* ERRNO: N/A
+*
+*/
+int main
+(
+    int   argc,
+    char *argv[]
+)
+{
+    WIRE_FLOW one[] =
+        {
+        {"/can/0 to /can/1", &tx0, &rx1, 0x200, WIRE_FRAMES},
+        };
+    WIRE_FLOW both[] =
+        {
+        {"/can/0 to /can/1", &tx0, &rx1, 0x200, WIRE_FRAMES / 2},
+        {"/can/1 to /can/0", &tx1, &rx0, 0x100, WIRE_FRAMES / 2},
+        };
+
+    if ((testPortOpen (&tx0, "/can/0", FALSE, WIRE_BUF_SIZE) != OK) ||
+        (testPortOpen (&rx1, "/can/1", TRUE, WIRE_BUF_SIZE) != OK))
+    {
+        printf ("wireRateTest: opening the ports failed\n");
+        return 1;
+    }
+
+    rx0.fdCtr = tx0.fdCtr;
+    tx1.fdCtr = rx1.fdCtr;
+    if ((testChanOpen (&rx0, "/can/0", TRUE, WIRE_BUF_SIZE) != OK) ||
+        (testChanOpen (&tx1, "/can/1", FALSE, WIRE_BUF_SIZE) != OK))
+    {
+        printf ("wireRateTest: opening the ports failed\n");
+        return 1;
+    }
+
+    if ((wireRun (one, NELEMENTS (one)) != OK) ||
+        (wireRun (both, NELEMENTS (both)) != OK))
+        return 1;
+
+    printf ("wireRateTest: passed\n");
+    return 0;
+}
@@ -0,0 +1,59 @@
+/* usrCanHost.c - host build: system initialization */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+This file initializes the CAN components of the host build before main()
+runs, as usrRoot() does in a VxWorks image with INCLUDE_CAN_NETWORK_INIT,
+DRV_PR6120_CAN, DRV_PR6120_CAN_SIM and INCLUDE_PR6120_DEVIO: the DevIO
+devices of the simulated board are /can/0 and /can/1.
+*/
+
+/* includes */
+
+#include <vxWorks.h>
+#include <CAN/wnCAN.h>
+#include <CAN/canController.h>
+#include <CAN/canBoard.h>
+#include <CAN/wncanDevIO.h>
+
+/* the configlette, see pr6120_can_cfg.c */
+
+extern void wncan_pr6120_can_init (void);
+extern void wncan_pr6120_can_init2 (void);
+
+/* the DevIO driver, see wncanDevIO.c */
+
+extern STATUS wncDevIODrvInstall (void);
+
+
+/************************************************************************
+*
+* usrRoot - initialize the system
+*
+* This routine runs the init routines of the CAN initialization groups in
+* the order of 02wnCAN.cdf and 40drvPR6120.cdf.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void usrRoot (void)
+{
+    /* usrWindNetCAN_Group0 */
+    wncan_core_init ();
+
+    /* usrWindNetCAN_Group1 */
+    wncan_pr6120_can_init ();
+
+    /* usrWindNetCAN_Group2 */
+    wncDevIODrvInstall ();
+    wncan_pr6120_can_init2 ();
+}
@@ -17,6 +17,7 @@ to the PR6120 CAN card.
 
 /* includes */
 #include <vxWorks.h>
+#include <stddef.h>
 #include <errnoLib.h>
 #include <intLib.h>
 #include <iv.h>
@@ -27,6 +28,7 @@ to the PR6120 CAN card.
 #include "CAN/canBoard.h"
 #include "CAN/i82527.h"
 #include "CAN/sja1000.h"
+#include <CAN/sja1000Offsets.h>
 #include "CAN/private/pr6120_can.h"
 
 /* external reference */
@@ -36,6 +38,10 @@ struct PR6120_CAN_DeviceEntry* PR6120_CAN_DeviceEntryGet(UINT brdNum);
 void sys_PR6120_CAN_canOutByte(struct WNCAN_Device *pDev, unsigned int reg,
                                 UCHAR value);
 UCHAR sys_PR6120_CAN_canInByte(struct WNCAN_Device *pDev, unsigned int reg);
+void sys_PR6120_CAN_canReadFrame(struct WNCAN_Device *pDev, unsigned int reg,
+                                 UCHAR *pBuf, UINT len);
+void sys_PR6120_CAN_canWriteFrame(struct WNCAN_Device *pDev, unsigned int reg,
+                                  const UCHAR *pBuf, UINT len);
 void sys_PR6120_CAN_IntConnect(UINT brdNum);
 
 /*****************************************************************************		
@@ -194,6 +200,9 @@ void pr6120_can_close
         brdNdx = ((pDev->deviceId) & 0xFFFFFF00) >> 8;
         ctrlNdx = (pDev->deviceId) & 0xFF;
 
+        /* no receive poll cycle may run on the closed device */
+        SJA1000_RxPollSet(pDev, 0, 0, 0, 0);
+
         pDE = PR6120_CAN_DeviceEntryGet(brdNdx);
         pDE->allocated[ctrlNdx] = 0;
     }
@@ -262,7 +271,22 @@ void PR6120_CAN_canOutByte
     UCHAR value
 )
 {
+    struct PR6120_CAN_DeviceEntry *pDE;
+    int key;
+
     sys_PR6120_CAN_canOutByte(pDev,reg,value);
+
+    /* the ISR only looks at controllers that can interrupt */
+    if (reg == SJA1000_IER)
+    {
+        pDE = PR6120_CAN_DE_GET(pDev);
+        key = intLock();
+        if (value != 0)
+            pDE->intEnabled |= (1 << pDev->pCtrl->ctrlID);
+        else
+            pDE->intEnabled &= ~(1 << pDev->pCtrl->ctrlID);
+        intUnlock(key);
+    }
     return;
 }
 
@@ -284,10 +308,133 @@ UCHAR PR6120_CAN_canInByte
 {
     UCHAR value;
     value = sys_PR6120_CAN_canInByte(pDev,reg);
+#ifdef PR6120_CAN_REG_STATS
+    PR6120_CAN_DE_GET(pDev)->regReads++;
+#endif
     return(value);
 }
 
 
+/*******************************************************************
+ *  PR6120_CAN_canReadFrame - read <len> consecutive registers
+ *  on the PR6120 CAN board.
+ *
+ * RETURNS: NONE
+ *
+ * ERRNO: N/A
+ */
+void PR6120_CAN_canReadFrame
+(
+    struct WNCAN_Device *pDev,
+    unsigned int reg,
+    UCHAR *pBuf,
+    UINT len
+)
+{
+    sys_PR6120_CAN_canReadFrame(pDev,reg,pBuf,len);
+#ifdef PR6120_CAN_REG_STATS
+    PR6120_CAN_DE_GET(pDev)->regReads += len;
+#endif
+    return;
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_IntService - service the controllers of a PR6120 CAN board
+*
+* This routine is called by the board-level ISR. It services only the
+* controllers that are open and have interrupts enabled and, if the board
+* provides a summary of the controllers requesting an interrupt, only those
+* among them. It makes passes over the controllers until none reports a
+* cause, so events that arrive while one is serviced are handled by the 
+* same interrupt; without a summary a controller that reported nothing is
+* not read again in the same interrupt, as it would assert the line anew. 
+* The interrupts and passes are counted in the device entry, and, in a 
+* build with PR6120_CAN_REG_STATS defined, the register reads; counting 
+* them costs every register access of the board.
+*
+* RETURNS: N/A
+*   
+* ERRNO: N/A
+*
+*/
+void PR6120_CAN_IntService
+(
+    struct PR6120_CAN_DeviceEntry *pDE
+)
+{
+    WNCAN_DEVICE   *pDev;
+    WNCAN_IntType   intStatus;
+    UCHAR           chnNum;
+#ifdef PR6120_CAN_REG_STATS
+    ULONG           regReads = pDE->regReads;
+#endif
+    UINT            pending = pDE->intEnabled;
+    UINT            active;
+    BOOL            serviced = FALSE;
+    UINT            pass;
+    UINT            i;
+
+    pDE->isrCount++;
+
+    for (pass = 0; pass < PR6120_CAN_ISR_PASS_MAX; pass++)
+    {
+        if (pDE->intPending != NULL)
+        {
+            pending = pDE->intEnabled & (*pDE->intPending)(pDE);
+#ifdef PR6120_CAN_REG_STATS
+            pDE->regReads++;
+#endif
+        }
+
+        if (pending == 0)
+            break;
+
+        pDE->isrPasses++;
+        active = 0;
+
+        for (i = 0; i < PR6120_CAN_MAX_CONTROLLERS; i++)
+        {
+            if (!(pending & (1 << i)) || !pDE->allocated[i])
+                continue;
+
+            pDev = &pDE->canDevice[i];
+
+            /* notify board that we're entering isr */
+            if(pDev->pBrd->onEnterISR)
+                pDev->pBrd->onEnterISR(pDev);
+
+            /* Get all pending interrupt causes and service them */
+            intStatus = CAN_GetIntStatus(pDev, &chnNum);
+
+            if (intStatus != WNCAN_INT_NONE)
+            {
+                sja1000IntDispatch(pDev, intStatus);
+                active |= (1 << i);
+            }
+
+            /* notify board that we're leaving isr */
+            if(pDev->pBrd->onLeaveISR)
+                pDev->pBrd->onLeaveISR(pDev);
+        }
+
+        if (active == 0)
+            break;
+
+        serviced = TRUE;
+        pending = active;
+    }
+
+    /* the shared line was raised by another device */
+    if (!serviced)
+        pDE->isrIdle++;
+#ifdef PR6120_CAN_REG_STATS
+    pDE->isrRegReads += pDE->regReads - regReads;
+#endif
+}
+
+
 /************************************************************************
 *
 * pr6120_can_establishLinks - set up function pointers
@@ -312,6 +459,8 @@ STATUS pr6120_can_establishLinks(struct WNCAN_Device *pDev)
 
         pDev->pBrd->canInByte = PR6120_CAN_canInByte;
         pDev->pBrd->canOutByte = PR6120_CAN_canOutByte;
+        pDev->pBrd->canReadFrame = PR6120_CAN_canReadFrame;
+        pDev->pBrd->canWriteFrame = sys_PR6120_CAN_canWriteFrame;
     }
     else
     {
@@ -15,6 +15,10 @@ modification history
 
 /* includes */
 #include <vxWorks.h>
+#include <errnoLib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "CAN/wnCAN.h"
 #include "CAN/canController.h"
@@ -51,6 +55,12 @@ LOCAL void   pr6120_can_show(void);
 
 #if (defined INCLUDE_WNCAN_DEVIO) || (defined INCLUDE_PR6120_DEVIO)
 LOCAL void   pr6120_can_devio_init(void);
+LOCAL STATUS pr6120_can_ctlr_set_config(void *pDrv, void *pCfg);
+LOCAL STATUS pr6120_can_ctlr_get_config(void *pDrv, void *pCfg);
+LOCAL void   pr6120_can_accept_add(void *pAcc, ULONG id, ULONG mask,
+                                   BOOL extId);
+LOCAL STATUS pr6120_can_accept_update(void *pDrv);
+LOCAL void   pr6120_can_event_get(void *pDrv, void *pEvent);
 #endif
 
 /* reserve memory for the requisite data structures */
@@ -222,6 +232,14 @@ LOCAL void pr6120_can_show(void)
             */
             printf("\t\tInterrupt Number: 0x%0x\n",
                 pDE->canBoard.irq);
+            printf("\t\tInterrupts: %lu, %lu with no controller pending\n",
+                pDE->isrCount, pDE->isrIdle);
+            printf("\t\tController passes: %lu\n", pDE->isrPasses);
+
+            /* only counted with PR6120_CAN_REG_STATS */
+            if (pDE->isrRegReads != 0)
+                printf("\t\tRegister reads: %lu (%lu per interrupt)\n",
+                    pDE->isrRegReads, pDE->isrRegReads / pDE->isrCount);
         }
     }
     return;
@@ -277,6 +295,11 @@ LOCAL void pr6120_can_devio_init(void)
                 free(copyConstString);
                 return;
             }
+
+            /* SJA1000 specific settings through WNCAN_CTLRCONFIG_SET/GET */
+            wncDrv->ctrlSetConfig = pr6120_can_ctlr_set_config;
+            wncDrv->ctrlGetConfig = pr6120_can_ctlr_get_config;
+            wncDrv->ctrlEventGet = pr6120_can_event_get;
         }
         
         pCurBrdName = strtok_r(NULL, sep, &pLastBrdName);
@@ -284,5 +307,224 @@ LOCAL void pr6120_can_devio_init(void)
     
     free(copyConstString);
 }
-#endif
 
+
+/************************************************************************
+*
+* pr6120_can_ctlr_set_config - set SJA1000 specific DevIO configuration
+*
+* This routine services WNCAN_CTLRCONFIG_SET. It selects the receive
+* interrupt servicing mode and the hybrid interrupt/polled receive
+* parameters of the SJA1000 controller, and whether its acceptance filter
+* is computed from the software filters of the open channels. While that
+* is enabled, it replaces the filter set with CAN_WriteID() or
+* CAN_SetGlobalRxFilter(); disabling it opens the filter to all frames.
+*
+* RETURNS: OK or ERROR
+*   
+* ERRNO: S_can_illegal_config
+*
+*/
+LOCAL STATUS pr6120_can_ctlr_set_config
+(
+    void *pDrv,
+    void *pCfg
+)
+{
+    WNCAN_DEVIO_DRVINFO *wncDrv = (WNCAN_DEVIO_DRVINFO *)pDrv;
+    WNCAN_CTLRCONFIG    *ctlrCfg = (WNCAN_CTLRCONFIG *)pCfg;
+    struct SJA1000_Accept accept;
+
+    if (ctlrCfg->ctlrType != WNCAN_SJA1000)
+    {
+        errnoSet(S_can_illegal_config);
+        return ERROR;
+    }
+
+    SJA1000_RxDrainSet(wncDrv->wncDevice, ctlrCfg->ctlrData.sja1000Data.rxDrain);
+
+    if (SJA1000_RxPollSet(wncDrv->wncDevice,
+                          ctlrCfg->ctlrData.sja1000Data.rxPollInts,
+                          ctlrCfg->ctlrData.sja1000Data.rxPollWindow,
+                          ctlrCfg->ctlrData.sja1000Data.rxPollBudget,
+                          ctlrCfg->ctlrData.sja1000Data.rxPollIdle) != OK)
+        return ERROR;
+
+    if (ctlrCfg->ctlrData.sja1000Data.autoAccept)
+    {
+        wncDrv->ctrlAcceptUpdate = pr6120_can_accept_update;
+        return pr6120_can_accept_update(wncDrv);
+    }
+
+    if (wncDrv->ctrlAcceptUpdate != NULL)
+    {
+        wncDrv->ctrlAcceptUpdate = NULL;
+        SJA1000_AcceptInit(&accept);
+        return SJA1000_AcceptSet(wncDrv->wncDevice, &accept);
+    }
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* pr6120_can_ctlr_get_config - get SJA1000 specific DevIO configuration
+*
+* This routine services WNCAN_CTLRCONFIG_GET. It returns the receive
+* interrupt servicing mode, the hybrid interrupt/polled receive state, the
+* frames per interrupt and poll statistics and the automatically computed
+* acceptance filter of the SJA1000 controller. The acceptance registers are
+* reported as zero until the filter has been computed.
+*
+* RETURNS: OK or ERROR
+*   
+* ERRNO: S_can_illegal_config
+*
+*/
+LOCAL STATUS pr6120_can_ctlr_get_config
+(
+    void *pDrv,
+    void *pCfg
+)
+{
+    WNCAN_DEVIO_DRVINFO     *wncDrv = (WNCAN_DEVIO_DRVINFO *)pDrv;
+    WNCAN_CTLRCONFIG        *ctlrCfg = (WNCAN_CTLRCONFIG *)pCfg;
+    struct SJA1000_ChipData *pChip;
+    struct SJA1000_RxStats   rxStats;
+    int                      i;
+
+    if (ctlrCfg->ctlrType != WNCAN_SJA1000)
+    {
+        errnoSet(S_can_illegal_config);
+        return ERROR;
+    }
+
+    pChip = (struct SJA1000_ChipData *)wncDrv->wncDevice->pCtrl->csData;
+    SJA1000_RxStatsGet(wncDrv->wncDevice, &rxStats, FALSE);
+
+    ctlrCfg->ctlrData.sja1000Data.rxDrain    = pChip->rxDrain;
+    ctlrCfg->ctlrData.sja1000Data.rxInts     = rxStats.rxInts;
+    ctlrCfg->ctlrData.sja1000Data.rxFrames   = rxStats.rxFrames;
+    ctlrCfg->ctlrData.sja1000Data.rxMaxBurst = rxStats.rxMaxBurst;
+
+    ctlrCfg->ctlrData.sja1000Data.rxPollInts   = pChip->rxPoll.enterInts;
+    ctlrCfg->ctlrData.sja1000Data.rxPollWindow = pChip->rxPoll.window;
+    ctlrCfg->ctlrData.sja1000Data.rxPollBudget = pChip->rxPoll.budget;
+    ctlrCfg->ctlrData.sja1000Data.rxPollIdle   = pChip->rxPoll.idleCycles;
+    ctlrCfg->ctlrData.sja1000Data.rxPolling    = pChip->rxPoll.polling;
+    ctlrCfg->ctlrData.sja1000Data.pollEnters   = rxStats.pollEnters;
+    ctlrCfg->ctlrData.sja1000Data.pollExits    = rxStats.pollExits;
+    ctlrCfg->ctlrData.sja1000Data.pollCycles   = rxStats.pollCycles;
+    ctlrCfg->ctlrData.sja1000Data.pollFrames   = rxStats.pollFrames;
+
+    ctlrCfg->ctlrData.sja1000Data.autoAccept = 
+        (wncDrv->ctrlAcceptUpdate != NULL);
+    ctlrCfg->ctlrData.sja1000Data.accDual = 
+        pChip->accept.valid && pChip->accept.dual;
+    for (i = 0; i < 4; i++)
+    {
+        ctlrCfg->ctlrData.sja1000Data.acr[i] = 
+            pChip->accept.valid ? pChip->accept.acr[i] : 0;
+        ctlrCfg->ctlrData.sja1000Data.amr[i] = 
+            pChip->accept.valid ? pChip->accept.amr[i] : 0;
+    }
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* pr6120_can_accept_add - add a subscribed ID to an SJA1000 filter
+*
+* This routine is the wncDevIOAcceptWalk() callback of
+* pr6120_can_accept_update().
+*
+* RETURNS: N/A
+*   
+* ERRNO: N/A
+*
+*/
+LOCAL void pr6120_can_accept_add
+(
+    void  *pAcc,
+    ULONG  id,
+    ULONG  mask,
+    BOOL   extId
+)
+{
+    SJA1000_AcceptAdd((struct SJA1000_Accept *)pAcc, id, mask, extId);
+}
+
+
+/************************************************************************
+*
+* pr6120_can_accept_update - recompute the SJA1000 acceptance filter
+*
+* This routine is the ctrlAcceptUpdate routine of the DevIO device while
+* the acceptance filter is computed automatically. It collects the IDs the
+* readers of the device subscribe to and programs the tightest filter that
+* passes all of them; if no channel is open for reading the filter passes
+* all frames.
+*
+* RETURNS: OK or ERROR
+*   
+* ERRNO: N/A
+*
+*/
+LOCAL STATUS pr6120_can_accept_update
+(
+    void *pDrv
+)
+{
+    WNCAN_DEVIO_DRVINFO   *wncDrv = (WNCAN_DEVIO_DRVINFO *)pDrv;
+    struct SJA1000_Accept  accept;
+
+    SJA1000_AcceptInit(&accept);
+    wncDevIOAcceptWalk(wncDrv, pr6120_can_accept_add, &accept);
+
+    return SJA1000_AcceptSet(wncDrv->wncDevice, &accept);
+}
+
+
+/************************************************************************
+*
+* pr6120_can_event_get - add the SJA1000 error details to a DevIO event
+*
+* This routine is the ctrlEventGet routine of the DevIO device. It is 
+* called by the ISR handler for each controller event and adds the error 
+* counters, and for a bus error the decoded error code capture register. 
+* The segment code is the one of the SJA1000 ECC register.
+*
+* RETURNS: N/A
+*   
+* ERRNO: N/A
+*
+*/
+LOCAL void pr6120_can_event_get
+(
+    void *pDrv,
+    void *pEvent
+)
+{
+    WNCAN_DEVIO_DRVINFO *wncDrv = (WNCAN_DEVIO_DRVINFO *)pDrv;
+    WNCAN_EVENT         *pEv = (WNCAN_EVENT *)pEvent;
+    WNCAN_BusError       busError;
+    UCHAR                ecc;
+
+    if (pEv->type == WNCAN_EVENT_ERROR)
+    {
+        ecc = SJA1000_ErrorCapture(wncDrv->wncDevice, &busError);
+        pEv->busError = busError;
+        pEv->errCode = ecc;
+        pEv->errDir = (ecc & ECC_DIR) ? WNCAN_ERRDIR_RX : WNCAN_ERRDIR_TX;
+        pEv->errSeg = ecc & (ECC_SEG0 | ECC_SEG1 | ECC_SEG2 | ECC_SEG3 | 
+                             ECC_SEG4);
+        pEv->flags |= WNCAN_EVFLAG_CAPTURE;
+    }
+
+    SJA1000_ErrorCountGet(wncDrv->wncDevice, &pEv->rxErrCnt, &pEv->txErrCnt);
+    pEv->flags |= WNCAN_EVFLAG_COUNTERS;
+}
+#endif
@@ -25,10 +25,14 @@ header file.
 /* includes */
 #include <vxWorks.h>
 #include <errnoLib.h>
+#include <string.h>
 #include <taskLib.h>
 #include <intLib.h>
 #include <iv.h>
 #include <sysLib.h>
+#include <semLib.h>
+#include <tickLib.h>
+#include <wdLib.h>
 
 #include <CAN/wnCAN.h>
 #include <CAN/canController.h>
@@ -40,6 +44,8 @@ header file.
 /* forward declarations */
 const WNCAN_ChannelType g_sja1000chnType[SJA1000_MAX_MSG_OBJ] = { 
 WNCAN_CHN_RECEIVE,WNCAN_CHN_TRANSMIT};
+static void sja1000RxIntEnable(struct WNCAN_Device *pDev, BOOL enable);
+static void sja1000RxPollCycle(struct WNCAN_Device *pDev);
 
 /*
    In Pelican mode, the addresses of the transmit and receive buffers are
@@ -150,6 +156,7 @@ static STATUS SJA1000_Init(struct WNCAN_Device *pDev)
         pDev->pBrd->canOutByte(pDev, SJA1000_AMR1, 0xff);
         pDev->pBrd->canOutByte(pDev, SJA1000_AMR2, 0xff);
         pDev->pBrd->canOutByte(pDev, SJA1000_AMR3, 0xff);
+        ((struct SJA1000_ChipData *)pDev->pCtrl->csData)->accept.valid = FALSE;
         
         /*
         * The controller is not brought out of reset here. CAN_Start must
@@ -434,6 +441,8 @@ static UINT SJA1000_GetBaudRate
 *                   interrupt sources on the CAN controller.
 * WNCAN_INT_BUS_OFF: enables interrupt indicating bus off condition  
 * WNCAN_INT_WAKE_UP: enables interrupt on wake up
+* WNCAN_INT_BUS_STATE: enables interrupts on the error warning limit, 
+*                   error passive and leaving bus off
 * All interrupt masks that need to be enabled must be specified in the list
 * passed to the function, in order to be set, every time the function
 * is called. 
@@ -453,7 +462,8 @@ static STATUS SJA1000_SetIntMask(struct WNCAN_Device *pDev, WNCAN_IntType intMas
         return error if masks other than error, busoff and wakeup
         are passed to the function
         */
-        if((intMask > (WNCAN_INT_ERROR | WNCAN_INT_BUS_OFF | WNCAN_INT_WAKE_UP)) &&
+        if((intMask & ~(WNCAN_INT_ERROR | WNCAN_INT_BUS_OFF | WNCAN_INT_WAKE_UP |
+                        WNCAN_INT_BUS_STATE)) &&
                 (intMask != WNCAN_INT_ALL)) 
         {
                 errnoSet(S_can_invalid_parameter);
@@ -483,11 +493,16 @@ static STATUS SJA1000_SetIntMask(struct WNCAN_Device *pDev, WNCAN_IntType intMas
                         is also raised when the controller goes into error active state from 
                         being bus offf
                 */
-                if(intMask & WNCAN_INT_BUS_OFF)
+                if(intMask & (WNCAN_INT_BUS_OFF | WNCAN_INT_BUS_STATE))
                         value |= IER_EIE;
                 else
                         value &= ~IER_EIE;
                 
+                if(intMask & WNCAN_INT_BUS_STATE)
+                        value |= IER_EPIE;
+                else
+                        value &= ~IER_EPIE;
+                
                 
                 oldLevel = intLock();
                 
@@ -575,6 +590,33 @@ static void SJA1000_DisableInt(struct WNCAN_Device *pDev)
 *
 */
 static WNCAN_BusError SJA1000_GetBusError(struct WNCAN_Device *pDev)
+{
+    WNCAN_BusError error;
+
+    SJA1000_ErrorCapture(pDev, &error);
+    return error;
+}
+
+/************************************************************************
+*
+* SJA1000_ErrorCapture - read and decode the error code capture register
+*
+* This function reads the error code capture register, which also arms it
+* for the next bus error, and stores the decoded error in <pBusError> (see
+* SJA1000_GetBusError()). The raw value holds the error code in bits 7..6, 
+* the direction in bit 5 (ECC_DIR, set for an error during reception) and
+* the frame segment the error was detected in in bits 4..0.
+*
+* RETURNS: the error code capture register
+*
+* ERRNO: N/A
+*
+*/
+UCHAR SJA1000_ErrorCapture
+    (
+    struct WNCAN_Device *pDev,
+    WNCAN_BusError *pBusError
+    )
 {
     UCHAR value;
     WNCAN_BusError error=0;
@@ -614,14 +656,40 @@ static WNCAN_BusError SJA1000_GetBusError(struct WNCAN_Device *pDev)
             }
             break;
     }
-    return error;
+
+    *pBusError = error;
+    return value;
+}
+
+/************************************************************************
+*
+* SJA1000_ErrorCountGet - get the receive and transmit error counters
+*
+* The controller is error passive while either counter is 128 or more, 
+* and goes bus off when the transmit error counter exceeds 255.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+void SJA1000_ErrorCountGet
+    (
+    struct WNCAN_Device *pDev,
+    UCHAR *pRxErr,
+    UCHAR *pTxErr
+    )
+{
+    *pRxErr = pDev->pBrd->canInByte(pDev, SJA1000_RXERR);
+    *pTxErr = pDev->pBrd->canInByte(pDev, SJA1000_TXERR);
 }
 
 /************************************************************************
 *
 * SJA1000_GetIntStatus - get the interrupt status on the controller
 *
-* This function returns the interrupt status on the controller: 
+* This function reads the interrupt register once and returns the OR of
+* every interrupt cause pending on the controller: 
 *
 *    WNCAN_INT_NONE     = no interrupt occurred
 *    WNCAN_INT_ERROR    = bus error
@@ -630,11 +698,15 @@ static WNCAN_BusError SJA1000_GetBusError(struct WNCAN_Device *pDev)
 *    WNCAN_INT_BUS_OFF  = interrupt resulting from bus off condition
 *    WNCAN_INT_WAKE_UP  = interrupt resulting from controller waking up
 *                         after being put in sleep mode
-*    WNCAN_INT_SPURIOUS = unknown interrupt
+*    WNCAN_INT_BUS_STATE = error warning limit crossed without bus off,
+*                         or error passive entered or left
+*
+* The interrupt register is cleared on read, so the caller must service
+* every cause in the returned mask (see sja1000IntDispatch()).
 *
-* NOTE: If the interrupt was caused by the transmission or reception of a 
-* message, the channel number that generated the interrupt is set; otherwise,
-* this value is undefined.
+* NOTE: The channel number is set to the receive channel if a message was
+* received, otherwise to the transmit channel if a message was transmitted;
+* otherwise, this value is undefined.
 *
 * ERRNO: N/A
 *
@@ -652,28 +724,28 @@ static WNCAN_IntType SJA1000_GetIntStatus
     /* read the interrupt register */
     regInt = pDev->pBrd->canInByte(pDev, SJA1000_IR);
 
-        if(regInt & IR_RI) {
-                /*receive interrupt*/
-        intStatus = WNCAN_INT_RX;
-        *channelNum = 0;
-        }
-        
         if( regInt & IR_TI) {
                 /*transmit interrupt*/
-        intStatus = WNCAN_INT_TX;
-        *channelNum = 1;
+        intStatus |= WNCAN_INT_TX;
+        *channelNum = TX_CHN_NUM;
+        }
+
+        if(regInt & IR_RI) {
+                /*receive interrupt*/
+        intStatus |= WNCAN_INT_RX;
+        *channelNum = RX_CHN_NUM;
         }
 
         if(regInt & IR_WUI)
         {
-                intStatus = WNCAN_INT_WAKE_UP;
+                intStatus |= WNCAN_INT_WAKE_UP;
         }
 
         /*flag WNCAN_INT_ERROR, if data overrun error int, or
           bus error int is detected */
         if(regInt & IR_BEI) {
                 /*error interrupt*/
-        intStatus = WNCAN_INT_ERROR;
+        intStatus |= WNCAN_INT_ERROR;
         }
 
         if(regInt & IR_EI) {
@@ -682,12 +754,84 @@ static WNCAN_IntType SJA1000_GetIntStatus
         regStatus = pDev->pBrd->canInByte(pDev, SJA1000_SR);
 
                 if(regStatus & SJA1000_SR_BS)
-                        intStatus = WNCAN_INT_BUS_OFF;
+                        intStatus |= WNCAN_INT_BUS_OFF;
+                else
+                        intStatus |= WNCAN_INT_BUS_STATE;
+        }
+
+        if(regInt & IR_EPI) {
+                /*error passive entered or left*/
+        intStatus |= WNCAN_INT_BUS_STATE;
         }
         
     return intStatus;
 }
 
+/************************************************************************
+*
+* sja1000IntDispatch - service the pending interrupt causes
+*
+* This routine hands every cause in <intStatus>, as returned by
+* SJA1000_GetIntStatus(), to the ISR callback in a single pass. Received
+* frames are serviced first since the RX FIFO is the resource that
+* overruns. On a transmit interrupt WNCAN_INT_TXCLR is delivered before
+* WNCAN_INT_TX, so the callback loads the next queued frame while the bus
+* is still idle and only then wakes the writers. If the transmit buffer was
+* released without the frame being sent, which the cleared SR_TCS bit shows
+* after an abort, WNCAN_INT_TX_ABORTED is delivered first. A transmit
+* interrupt that finds the buffer loaded again is left over from a reset
+* that SJA1000_AcceptSet() has already serviced, and is ignored.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+void sja1000IntDispatch(struct WNCAN_Device *pDev, WNCAN_IntType intStatus)
+{
+    UCHAR regStatus;
+
+    if (WNCAN_INT_PENDING(intStatus, WNCAN_INT_RX))
+    {
+        /* the callback releases the receive buffer through CAN_ReadData();
+           releasing it here as well would discard the next queued frame */
+        sja1000RxService(pDev, RX_CHN_NUM);
+    }
+
+    if (WNCAN_INT_PENDING(intStatus, WNCAN_INT_TX))
+        regStatus = pDev->pBrd->canInByte(pDev, SJA1000_SR);
+
+    if (WNCAN_INT_PENDING(intStatus, WNCAN_INT_TX) &&
+        (regStatus & SJA1000_SR_TBS))
+    {
+        /* SR_TCS is cleared again by the next transmission request */
+        if ((regStatus & SJA1000_SR_TCS) == 0)
+            pDev->pISRCallback(pDev, WNCAN_INT_TX_ABORTED, TX_CHN_NUM);
+
+        /* notify channel available to TX again, refill it first */
+        pDev->pISRCallback(pDev, WNCAN_INT_TXCLR, TX_CHN_NUM);
+
+        pDev->pISRCallback(pDev, WNCAN_INT_TX, TX_CHN_NUM);
+    }
+
+    if (WNCAN_INT_PENDING(intStatus, WNCAN_INT_ERROR))
+    {
+        pDev->pISRCallback(pDev, WNCAN_INT_ERROR, TX_CHN_NUM);
+
+        /* clear bei interrupt flag */
+        pDev->pBrd->canInByte(pDev, SJA1000_ECC);
+    }
+
+    if (WNCAN_INT_PENDING(intStatus, WNCAN_INT_BUS_OFF))
+        pDev->pISRCallback(pDev, WNCAN_INT_BUS_OFF, TX_CHN_NUM);
+
+    if (WNCAN_INT_PENDING(intStatus, WNCAN_INT_WAKE_UP))
+        pDev->pISRCallback(pDev, WNCAN_INT_WAKE_UP, TX_CHN_NUM);
+
+    if (WNCAN_INT_PENDING(intStatus, WNCAN_INT_BUS_STATE))
+        pDev->pISRCallback(pDev, WNCAN_INT_BUS_STATE, TX_CHN_NUM);
+}
+
 /************************************************************************
 *
 * sja1000ISR - interrupt service routine
@@ -710,32 +854,11 @@ void sja1000ISR(ULONG context)
     if(pDev->pBrd->onEnterISR)
         pDev->pBrd->onEnterISR(pDev);
 
-    /* Get the interrupt status */
+    /* Get all pending interrupt causes */
     intStatus = SJA1000_GetIntStatus((void*)context, &chnNum);
 
-         if (intStatus != WNCAN_INT_NONE)
-         {
-                 
-                 pDev->pISRCallback(pDev, intStatus, chnNum);
-                 
-                 if (intStatus == WNCAN_INT_RX)
-                 {
-                         /* release the receive buffer */
-                         /* this will temporarily cleat RI bit */
-                         pDev->pBrd->canOutByte(pDev, SJA1000_CMR, CMR_RRB);
-                 }
-                 else if (intStatus == WNCAN_INT_ERROR)
-                 {
-                         /* clear bei interrupt flag */
-                         pDev->pBrd->canInByte(pDev, SJA1000_ECC);
-                 }
-                 else if (intStatus == WNCAN_INT_TX)
-                 {
-                         /* notify channel available to TX again */
-                         pDev->pISRCallback(pDev, WNCAN_INT_TXCLR, chnNum);
-                 }
-         }
-        
+    if (intStatus != WNCAN_INT_NONE)
+        sja1000IntDispatch(pDev, intStatus);
         
     /* notify board that we're leaving isr */
     if(pDev->pBrd->onLeaveISR)
@@ -745,6 +868,671 @@ void sja1000ISR(ULONG context)
 }
 
 
+/************************************************************************
+*
+* sja1000RxService - hand received frames to the ISR callback
+*
+* This routine services a receive interrupt. By default one frame is handed
+* to the ISR callback per interrupt. When RX FIFO draining is enabled with
+* SJA1000_RxDrainSet(), the callback is invoked again for as long as the
+* receive buffer status bit reports another frame, so a burst of frames
+* queued in the 64 byte RX FIFO is serviced by a single interrupt instead
+* of one interrupt per frame.
+*
+* The callback is expected to release the receive buffer, which
+* CAN_ReadData() does. The loop is bounded by SJA1000_RX_DRAIN_MAX so that
+* a callback which does not read the frame cannot hold the CPU in the ISR.
+*
+* RETURNS: number of frames handed to the callback
+*
+* ERRNO: N/A
+*
+*/
+UINT sja1000RxService(struct WNCAN_Device *pDev, UCHAR chnNum)
+{
+    struct SJA1000_ChipData *pChip = 
+        (struct SJA1000_ChipData *)pDev->pCtrl->csData;
+    UINT nFrames = 0;
+
+    do
+    {
+        pDev->pISRCallback(pDev, WNCAN_INT_RX, chnNum);
+        nFrames++;
+    } while (pChip->rxDrain && (nFrames < SJA1000_RX_DRAIN_MAX) &&
+             (pDev->pBrd->canInByte(pDev, SJA1000_SR) & SJA1000_SR_RBS));
+
+    pChip->rxStats.rxInts++;
+    pChip->rxStats.rxFrames += nFrames;
+    if (nFrames > pChip->rxStats.rxMaxBurst)
+        pChip->rxStats.rxMaxBurst = nFrames;
+
+    /* too many RX interrupts in the window, hand RX to the poll task */
+    if (pChip->rxPoll.enterInts != 0)
+    {
+        ULONG now = tickGet();
+
+        if ((now - pChip->rxPoll.windowStart) >= pChip->rxPoll.window)
+        {
+            pChip->rxPoll.windowStart = now;
+            pChip->rxPoll.windowInts  = 0;
+        }
+
+        if (++pChip->rxPoll.windowInts >= pChip->rxPoll.enterInts)
+        {
+            pChip->rxPoll.windowInts = 0;
+            pChip->rxPoll.idle = 0;
+            pChip->rxPoll.polling = TRUE;
+            sja1000RxIntEnable(pDev, FALSE);
+            pChip->rxStats.pollEnters++;
+            wdStart(pChip->rxPoll.wd, 1, (FUNCPTR)sja1000RxPollCycle,
+                    (int)pDev);
+        }
+    }
+
+    return nFrames;
+}
+
+/************************************************************************
+*
+* sja1000RxIntEnable - enable or disable the receive interrupt
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void sja1000RxIntEnable(struct WNCAN_Device *pDev, BOOL enable)
+{
+    int   oldLevel;
+    UCHAR value;
+
+    oldLevel = intLock();
+    value = pDev->pBrd->canInByte(pDev, SJA1000_IER);
+    if (enable)
+        value |= IER_RIE;
+    else
+        value &= ~IER_RIE;
+    pDev->pBrd->canOutByte(pDev, SJA1000_IER, value);
+    intUnlock(oldLevel);
+}
+
+/************************************************************************
+*
+* sja1000RxPollCycle - run one receive poll cycle
+*
+* This watchdog routine services the RX FIFO while the receive interrupt is
+* masked by sja1000RxService(). Once per tick it hands up to the configured
+* budget of frames to the ISR callback. It runs at interrupt level, which
+* the callback expects, but may be preempted by the CAN interrupt, so each
+* frame is read with interrupts locked. After the configured number of
+* cycles that find the FIFO empty, the receive interrupt is enabled again;
+* otherwise the routine is rearmed for the next tick.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void sja1000RxPollCycle(struct WNCAN_Device *pDev)
+{
+    struct SJA1000_ChipData *pChip = 
+        (struct SJA1000_ChipData *)pDev->pCtrl->csData;
+    struct SJA1000_RxPoll *pPoll = &pChip->rxPoll;
+    UINT nFrames = 0;
+    BOOL ready;
+    int  oldLevel;
+
+    for (;;)
+    {
+        oldLevel = intLock();
+
+        /* polling may have been switched off meanwhile */
+        ready = pPoll->polling && (nFrames < pPoll->budget) &&
+            (pDev->pBrd->canInByte(pDev, SJA1000_SR) & SJA1000_SR_RBS);
+        if (ready)
+            pDev->pISRCallback(pDev, WNCAN_INT_RX, RX_CHN_NUM);
+
+        intUnlock(oldLevel);
+
+        if (!ready)
+            break;
+        nFrames++;
+    }
+
+    oldLevel = intLock();
+
+    if (pPoll->polling)
+    {
+        pChip->rxStats.pollCycles++;
+        pChip->rxStats.pollFrames += nFrames;
+
+        /* the bus has gone quiet, go back to RX interrupts */
+        if (nFrames != 0)
+            pPoll->idle = 0;
+        else if (++pPoll->idle >= pPoll->idleCycles)
+        {
+            pPoll->polling = FALSE;
+            sja1000RxIntEnable(pDev, TRUE);
+            pChip->rxStats.pollExits++;
+        }
+    }
+
+    if (pPoll->polling)
+        wdStart(pPoll->wd, 1, (FUNCPTR)sja1000RxPollCycle, (int)pDev);
+
+    intUnlock(oldLevel);
+}
+
+/************************************************************************
+*
+* SJA1000_RxDrainSet - select the receive interrupt servicing mode
+*
+* When <enable> is TRUE, every receive interrupt drains all frames queued
+* in the RX FIFO (see sja1000RxService()). When FALSE, one frame is
+* serviced per interrupt, which is the default.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+void SJA1000_RxDrainSet(struct WNCAN_Device *pDev, BOOL enable)
+{
+    struct SJA1000_ChipData *pChip = 
+        (struct SJA1000_ChipData *)pDev->pCtrl->csData;
+
+    pChip->rxDrain = enable;
+}
+
+/************************************************************************
+*
+* SJA1000_RxPollSet - configure hybrid interrupt/polled receive
+*
+* When <enterInts> receive interrupts are serviced within <window> ticks,
+* the receive interrupt is masked and a poll task takes over: every tick it
+* hands up to <budget> frames from the RX FIFO to the ISR callback. After
+* <idleCycles> consecutive ticks without a frame the receive interrupt is
+* enabled again. This trades receive latency of up to one tick for one
+* watchdog run per tick instead of one interrupt per frame; the tick rate
+* and budget must keep up with the bus, since the RX FIFO holds only a few
+* frames. An <enterInts> of 0 disables polling, which is the default.
+*
+* The poll cycles are run by a watchdog, which is created when polling is
+* enabled and deleted when it is disabled; the board's close routine
+* disables polling.
+*
+* RETURNS: OK, or ERROR if a parameter is zero or the watchdog cannot be
+* created
+*
+* ERRNO: S_can_invalid_parameter
+*
+*/
+STATUS SJA1000_RxPollSet
+    (
+    struct WNCAN_Device *pDev,
+    UINT enterInts,
+    UINT window,
+    UINT budget,
+    UINT idleCycles
+    )
+{
+    struct SJA1000_ChipData *pChip = 
+        (struct SJA1000_ChipData *)pDev->pCtrl->csData;
+    struct SJA1000_RxPoll *pPoll = &pChip->rxPoll;
+    WDOG_ID wd = NULL;
+    int oldLevel;
+
+    if ((enterInts != 0) &&
+        ((window == 0) || (budget == 0) || (idleCycles == 0)))
+    {
+        errnoSet(S_can_invalid_parameter);
+        return ERROR;
+    }
+
+    if ((enterInts != 0) && (pPoll->wd == NULL))
+    {
+        wd = wdCreate();
+        if (wd == NULL)
+            return ERROR;
+    }
+
+    oldLevel = intLock();
+    pPoll->enterInts  = enterInts;
+    pPoll->window     = window;
+    pPoll->budget     = budget;
+    pPoll->idleCycles = idleCycles;
+    pPoll->windowInts = 0;
+
+    if (enterInts != 0)
+    {
+        if (wd != NULL)
+            pPoll->wd = wd;
+        wd = NULL;
+    }
+    else
+    {
+        /* polling switched off, a pending poll cycle does nothing */
+        if (pPoll->polling)
+        {
+            pPoll->polling = FALSE;
+            sja1000RxIntEnable(pDev, TRUE);
+            pChip->rxStats.pollExits++;
+        }
+        wd = pPoll->wd;
+        pPoll->wd = NULL;
+    }
+    intUnlock(oldLevel);
+
+    /* also cancels the pending poll cycle */
+    if (wd != NULL)
+        wdDelete(wd);
+
+    return OK;
+}
+
+/************************************************************************
+*
+* SJA1000_RxStatsGet - get the receive statistics
+*
+* This routine copies the receive statistics of the controller to <pStats>.
+* The average number of frames serviced per receive interrupt is
+* rxFrames / rxInts. If <clear> is TRUE the statistics are reset.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+void SJA1000_RxStatsGet
+    (
+    struct WNCAN_Device *pDev,
+    struct SJA1000_RxStats *pStats,
+    BOOL clear
+    )
+{
+    struct SJA1000_ChipData *pChip = 
+        (struct SJA1000_ChipData *)pDev->pCtrl->csData;
+    int oldLevel;
+
+    oldLevel = intLock();
+    *pStats = pChip->rxStats;
+    if (clear)
+    {
+        pChip->rxStats.rxInts     = 0;
+        pChip->rxStats.rxFrames   = 0;
+        pChip->rxStats.rxMaxBurst = 0;
+        pChip->rxStats.pollEnters = 0;
+        pChip->rxStats.pollExits  = 0;
+        pChip->rxStats.pollCycles = 0;
+        pChip->rxStats.pollFrames = 0;
+    }
+    intUnlock(oldLevel);
+}
+
+/* ID positions in the single filter image, see struct SJA1000_Accept */
+#define SJA1000_ACC_STD_BITS   0xffe00000
+#define SJA1000_ACC_EXT_BITS   0xfffffff8
+
+/* ID positions in a dual filter, the upper half of the image */
+#define SJA1000_ACC_STD_BITS16 0xffe0
+#define SJA1000_ACC_EXT_BITS16 0xffff
+
+/* bits of ACR3/AMR3 that filter 1 compares with a standard frame's data */
+#define SJA1000_ACC_DATA_NIBBLE 0x000f
+
+/* clock ticks SJA1000_AcceptSet() waits for a pending transmission */
+#define SJA1000_ACC_TX_WAIT    10
+
+/************************************************************************
+*
+* sja1000BitCount - count the bits set in a word
+*
+* RETURNS: number of bits set in <v>
+*
+* ERRNO: N/A
+*
+*/
+static UINT sja1000BitCount(UINT32 v)
+{
+    UINT n = 0;
+
+    for (; v != 0; v &= v - 1)
+        n++;
+
+    return n;
+}
+
+/************************************************************************
+*
+* sja1000AcceptScore - estimate the traffic a filter lets through
+*
+* This routine returns the fraction of frames of one format that pass
+* filters comparing <care1> and <care2> of its ID bits <idBits>, scaled to
+* 1 << 32 and assuming evenly distributed IDs. A <care2> of ~0 stands for
+* no second filter.
+*
+* RETURNS: the estimate
+*
+* ERRNO: N/A
+*
+*/
+static UINT64 sja1000AcceptScore(UINT32 care1, UINT32 care2, UINT32 idBits)
+{
+    UINT64 score;
+
+    score = (UINT64)1 << (32 - sja1000BitCount(care1 & idBits));
+    if (care2 != (UINT32)~0)
+        score += (UINT64)1 << (32 - sja1000BitCount(care2 & idBits));
+
+    return (score > ((UINT64)1 << 32)) ? ((UINT64)1 << 32) : score;
+}
+
+/************************************************************************
+*
+* sja1000AcceptMerge - merge the two closest dual filter candidates
+*
+* This routine replaces the two candidates that have the most compared
+* bits in common by a single candidate covering both.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void sja1000AcceptMerge(struct SJA1000_Accept *pAcc)
+{
+    struct SJA1000_AcceptGroup *pGrp = pAcc->group;
+    USHORT care;
+    UINT   i, j;
+    UINT   bi = 0, bj = 1;
+    int    best = -1;
+
+    for (i = 0; i < pAcc->numGroups; i++)
+    {
+        for (j = i + 1; j < pAcc->numGroups; j++)
+        {
+            care = pGrp[i].care & pGrp[j].care & ~(pGrp[i].code ^ pGrp[j].code);
+            if ((int)sja1000BitCount(care) > best)
+            {
+                best = sja1000BitCount(care);
+                bi = i;
+                bj = j;
+            }
+        }
+    }
+
+    pGrp[bi].care &= pGrp[bj].care & ~(pGrp[bi].code ^ pGrp[bj].code);
+    pGrp[bi].code &= pGrp[bi].care;
+    pGrp[bi].hasStd |= pGrp[bj].hasStd;
+    pGrp[bj] = pGrp[--pAcc->numGroups];
+}
+
+/************************************************************************
+*
+* SJA1000_AcceptInit - start computing an acceptance filter
+*
+* This routine empties <pAcc>. The rules of the filter are then added with
+* SJA1000_AcceptAdd() and the result is programmed with SJA1000_AcceptSet().
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+void SJA1000_AcceptInit(struct SJA1000_Accept *pAcc)
+{
+    memset(pAcc, 0, sizeof(struct SJA1000_Accept));
+}
+
+/************************************************************************
+*
+* SJA1000_AcceptAdd - add a rule to an acceptance filter
+*
+* This routine adds the frames whose <id> matches in the bits set in
+* <mask> to the filter under construction; <ext> selects the frame format.
+* A zero <mask> adds all frames of the format. The single filter is kept
+* as the bits all rules agree on. For the dual filter up to
+* SJA1000_ACCEPT_GROUPS candidates are kept, the closest two being merged
+* when one more is needed.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+void SJA1000_AcceptAdd
+    (
+    struct SJA1000_Accept *pAcc,
+    ULONG id,
+    ULONG mask,
+    BOOL ext
+    )
+{
+    struct SJA1000_AcceptGroup *pGrp;
+    UINT32 code;
+    UINT32 care;
+    UINT   i;
+
+    if (ext)
+    {
+        care = (mask & 0x1fffffff) << 3;
+        code = (id << 3) & care;
+    }
+    else
+    {
+        care = (mask & 0x7ff) << 21;
+        code = (id << 21) & care;
+    }
+
+    if (pAcc->numRules++ == 0)
+    {
+        pAcc->code = code;
+        pAcc->care = care;
+    }
+    else
+    {
+        pAcc->care &= care & ~(pAcc->code ^ code);
+        pAcc->code &= pAcc->care;
+    }
+
+    /* nothing to do if a candidate already covers the rule */
+    for (i = 0; i < pAcc->numGroups; i++)
+    {
+        pGrp = &pAcc->group[i];
+        if (((pGrp->care & ~(care >> 16)) == 0) &&
+            (((pGrp->code ^ (code >> 16)) & pGrp->care) == 0))
+        {
+            pGrp->hasStd |= !ext;
+            return;
+        }
+    }
+
+    pGrp = &pAcc->group[pAcc->numGroups++];
+    pGrp->code = (USHORT)(code >> 16);
+    pGrp->care = (USHORT)(care >> 16);
+    pGrp->hasStd = !ext;
+
+    if (pAcc->numGroups > SJA1000_ACCEPT_GROUPS)
+        sja1000AcceptMerge(pAcc);
+}
+
+/************************************************************************
+*
+* SJA1000_AcceptSet - program an acceptance filter
+*
+* This routine programs the acceptance code and mask registers with the
+* filter computed in <pAcc>, in single filter mode or, if it lets less
+* traffic through, dual filter mode. A filter without rules accepts all
+* frames. The controller is put into reset mode for the update, which
+* discards the frames in the RX FIFO, so the registers are only written
+* when the filter has changed.
+*
+* Reset mode also aborts a frame in the transmit buffer, without a transmit
+* interrupt, so the update waits until the buffer has been released, for at
+* most SJA1000_ACC_TX_WAIT clock ticks. A frame still pending then, e.g.
+* because no other node acknowledges it, is aborted. As the reset may also
+* clear a transmit interrupt not yet serviced, the routine services it once
+* the controller is back in operating mode, as sja1000IntDispatch() would:
+* the frame counts as sent only if SR_TBS and SR_TCS were both set before
+* the reset. Nothing is delivered when the filter is unchanged or the
+* controller was already in reset mode. This routine must be called from
+* task level.
+*
+* In dual filter mode filter 1 compares the low nibble of ACR3 with the
+* first data byte of standard frames, where filter 2 compares it with the
+* ID of extended frames; when filter 1 covers standard frames the nibble is
+* therefore left as don't care.
+*
+* RETURNS: OK
+*
+* ERRNO: N/A
+*
+*/
+STATUS SJA1000_AcceptSet
+    (
+    struct WNCAN_Device *pDev,
+    struct SJA1000_Accept *pAcc
+    )
+{
+    struct SJA1000_ChipData *pChip = 
+        (struct SJA1000_ChipData *)pDev->pCtrl->csData;
+    struct SJA1000_AcceptRegs regs;
+    struct SJA1000_AcceptGroup grp;
+    UINT32 care1;
+    UINT32 care2;
+    UINT64 single;
+    UINT64 dual;
+    UCHAR  regMod;
+    UCHAR  regSr = 0;
+    UCHAR  mode;
+    int    oldLevel;
+    int    wait;
+    int    i;
+
+    memset(&regs, 0, sizeof(regs));
+    regs.valid = TRUE;
+
+    if (pAcc->numRules == 0)
+    {
+        /* accept all frames */
+        for (i = 0; i < 4; i++)
+        {
+            regs.acr[i] = 0xff;
+            regs.amr[i] = 0xff;
+        }
+    }
+    else
+    {
+        while (pAcc->numGroups > 2)
+            sja1000AcceptMerge(pAcc);
+        if (pAcc->numGroups == 1)
+            pAcc->group[pAcc->numGroups++] = pAcc->group[0];
+
+        /* filter 1 should be the one that does not need the data nibble */
+        if (pAcc->group[0].hasStd && !pAcc->group[1].hasStd)
+        {
+            grp = pAcc->group[0];
+            pAcc->group[0] = pAcc->group[1];
+            pAcc->group[1] = grp;
+        }
+        if (pAcc->group[0].hasStd)
+        {
+            pAcc->group[1].care &= ~SJA1000_ACC_DATA_NIBBLE;
+            pAcc->group[1].code &= pAcc->group[1].care;
+        }
+
+        care1 = pAcc->group[0].care;
+        care2 = pAcc->group[1].care;
+        single = sja1000AcceptScore(pAcc->care, ~0, SJA1000_ACC_STD_BITS) +
+                 sja1000AcceptScore(pAcc->care, ~0, SJA1000_ACC_EXT_BITS);
+        dual = sja1000AcceptScore(care1, care2, SJA1000_ACC_STD_BITS16) +
+               sja1000AcceptScore(care1, care2, SJA1000_ACC_EXT_BITS16);
+
+        if (dual < single)
+        {
+            regs.dual = TRUE;
+            regs.acr[0] = (UCHAR)(pAcc->group[0].code >> 8);
+            regs.acr[1] = (UCHAR)pAcc->group[0].code;
+            regs.acr[2] = (UCHAR)(pAcc->group[1].code >> 8);
+            regs.acr[3] = (UCHAR)pAcc->group[1].code;
+            regs.amr[0] = (UCHAR)~(care1 >> 8);
+            regs.amr[1] = (UCHAR)~care1;
+            regs.amr[2] = (UCHAR)~(care2 >> 8);
+            regs.amr[3] = (UCHAR)~care2;
+        }
+        else
+        {
+            for (i = 0; i < 4; i++)
+            {
+                regs.acr[i] = (UCHAR)(pAcc->code >> (24 - 8 * i));
+                regs.amr[i] = (UCHAR)~(pAcc->care >> (24 - 8 * i));
+            }
+        }
+    }
+
+    if (pChip->accept.valid && (pChip->accept.dual == regs.dual) &&
+        (memcmp(pChip->accept.acr, regs.acr, 4) == 0) &&
+        (memcmp(pChip->accept.amr, regs.amr, 4) == 0))
+        return OK;
+
+    /*
+    The ISR must not access the controller while it is in reset mode, and
+    must not load the transmit buffer between the test and the reset
+    */
+    for (wait = 0; ; wait++)
+    {
+        oldLevel = intLock();
+
+        regMod = pDev->pBrd->canInByte(pDev, SJA1000_MOD);
+        if (regMod & MOD_RM)
+            break;
+
+        regSr = pDev->pBrd->canInByte(pDev, SJA1000_SR);
+        if (regSr & SJA1000_SR_TBS)
+            break;
+
+        if (wait >= SJA1000_ACC_TX_WAIT)
+            break;
+
+        intUnlock(oldLevel);
+        taskDelay(1);
+    }
+
+    pDev->pBrd->canOutByte(pDev, SJA1000_MOD, regMod | MOD_RM);
+
+    pDev->pBrd->canOutByte(pDev, SJA1000_ACR0, regs.acr[0]);
+    pDev->pBrd->canOutByte(pDev, SJA1000_ACR1, regs.acr[1]);
+    pDev->pBrd->canOutByte(pDev, SJA1000_ACR2, regs.acr[2]);
+    pDev->pBrd->canOutByte(pDev, SJA1000_ACR3, regs.acr[3]);
+    pDev->pBrd->canOutByte(pDev, SJA1000_AMR0, regs.amr[0]);
+    pDev->pBrd->canOutByte(pDev, SJA1000_AMR1, regs.amr[1]);
+    pDev->pBrd->canOutByte(pDev, SJA1000_AMR2, regs.amr[2]);
+    pDev->pBrd->canOutByte(pDev, SJA1000_AMR3, regs.amr[3]);
+
+    /* the filter mode can only be changed in reset mode */
+    mode = regs.dual ? (regMod & ~MOD_AFM) : (regMod | MOD_AFM);
+    pDev->pBrd->canOutByte(pDev, SJA1000_MOD, mode | MOD_RM);
+
+    /* put controller back into normal mode, if it was */
+    if ((regMod & MOD_RM) == 0)
+    {
+        pDev->pBrd->canOutByte(pDev, SJA1000_MOD, mode);
+
+        /* the transmit interrupt the reset may have taken */
+        if ((regSr & (SJA1000_SR_TBS | SJA1000_SR_TCS)) !=
+            (SJA1000_SR_TBS | SJA1000_SR_TCS))
+            pDev->pISRCallback(pDev, WNCAN_INT_TX_ABORTED, TX_CHN_NUM);
+        pDev->pISRCallback(pDev, WNCAN_INT_TXCLR, TX_CHN_NUM);
+        pDev->pISRCallback(pDev, WNCAN_INT_TX, TX_CHN_NUM);
+    }
+
+    pChip->accept = regs;
+
+    intUnlock(oldLevel);
+
+    return OK;
+}
+
 /************************************************************************
 *
 * SJA1000_ReadID - read the CAN Id
@@ -762,7 +1550,7 @@ void sja1000ISR(ULONG context)
 static long SJA1000_ReadID(struct WNCAN_Device *pDev, UCHAR channelNum, 
                            BOOL* ext)
 {
-    UCHAR           value;
+    UCHAR           frame[5];
     struct TxMsg    *pTxMsg;
     ULONG           msgID=0xffffffff;
 
@@ -780,32 +1568,20 @@ static long SJA1000_ReadID(struct WNCAN_Device *pDev, UCHAR channelNum,
         /* Set up frame and ID registers based on channel mode */
         if(pDev->pCtrl->chnMode[channelNum] == WNCAN_CHN_RECEIVE)
         {
-            /* get the frame format */
-            value = pDev->pBrd->canInByte(pDev, SJA1000_SFF);
+            /* get the frame format and identifier in one transfer */
+            WNCAN_Board_ReadFrame(pDev, SJA1000_SFF, frame, 5);
 
             /* test if message ID is extended or standard */
-            if (value & 0x80)
+            if (frame[0] & 0x80)
             {
                 *ext = 1;
-                value = pDev->pBrd->canInByte(pDev,SJA1000_RXID);
-                msgID = (value << (24-3));
-
-                value = pDev->pBrd->canInByte(pDev,SJA1000_RXID+1);
-                msgID |= (value << (16-3));
-
-                value = pDev->pBrd->canInByte(pDev,SJA1000_RXID+2);
-                msgID |= (value << (8-3));
-
-                value = pDev->pBrd->canInByte(pDev,SJA1000_RXID+3);
-                msgID |= (value >> 3);
+                msgID = (frame[1] << (24-3)) | (frame[2] << (16-3)) |
+                        (frame[3] << (8-3))  | (frame[4] >> 3);
             }
             else
             {
                 *ext = 0;
-                value = pDev->pBrd->canInByte(pDev,SJA1000_RXID);
-                msgID = (value << (8-5));
-                value = pDev->pBrd->canInByte(pDev,SJA1000_RXID+1);
-                msgID |= (value >> 5);
+                msgID = (frame[1] << (8-5)) | (frame[2] >> 5);
             }
         }
         else
@@ -899,6 +1675,10 @@ static STATUS SJA1000_WriteID(struct WNCAN_Device *pDev, UCHAR channelNum,
                 pDev->pBrd->canOutByte(pDev, SJA1000_ACR1, value);
                                 
                         }
+
+            /* SJA1000_AcceptSet() must rewrite the filter */
+            ((struct SJA1000_ChipData *)pDev->pCtrl->csData)->accept.valid = 
+                FALSE;
             /* put controller back into normal mode */
             if((regMod&MOD_RM)==0)
             	pDev->pBrd->canOutByte(pDev,  SJA1000_MOD, regMod);
@@ -951,6 +1731,7 @@ static STATUS SJA1000_ReadData(struct WNCAN_Device *pDev, UCHAR channelNum,
                        UCHAR *data, UCHAR *len, BOOL *newData)
 {
     UCHAR           value;
+    UCHAR           frame[SJA1000_FRAME_SIZE];
     UCHAR           hwLength=0;
     UINT            i;
     UINT            offset;
@@ -977,10 +1758,14 @@ static STATUS SJA1000_ReadData(struct WNCAN_Device *pDev, UCHAR channelNum,
 
         if(pDev->pCtrl->chnMode[channelNum] == WNCAN_CHN_RECEIVE)
         {
-            /* get the frame info and read the data */
-            value = pDev->pBrd->canInByte(pDev, SJA1000_SFF);
-            offset = (value & 0x80)? 2 : 0;
-            hwLength = value & 0xF;
+            /* get the frame info, identifier and data in one transfer */
+            WNCAN_Board_ReadFrame(pDev, SJA1000_SFF, frame, SJA1000_FRAME_SIZE);
+            offset = (frame[0] & 0x80)? 5 : 3;
+            hwLength = frame[0] & 0xF;
+
+            /* DLC values above 8 still carry 8 data bytes */
+            if (hwLength > 8)
+                hwLength = 8;
 
             if (hwLength > *len)
             {
@@ -1001,7 +1786,7 @@ static STATUS SJA1000_ReadData(struct WNCAN_Device *pDev, UCHAR channelNum,
             }
 
             for (i = 0; i < *len; i++)
-                data[i] = pDev->pBrd->canInByte(pDev, (SJA1000_SFDATA + i + offset));
+                data[i] = frame[offset + i];
 
             /* check the status register to see if the message was new */
             value = pDev->pBrd->canInByte(pDev, SJA1000_SR);
@@ -1151,6 +1936,60 @@ SJA1000_WriteData(struct WNCAN_Device *pDev, UCHAR channelNum,
     return retCode;
 }
 
+/************************************************************************
+*
+* sja1000FrameEncode - build the transmit buffer image of a CAN message
+*
+* This routine fills <pFrame> with the frame info, identifier and data
+* bytes of a message, laid out as the transmit buffer registers starting
+* at SJA1000_SFF, so that the frame can be loaded with a single
+* WNCAN_Board_WriteFrame() call.
+*
+* RETURNS: number of bytes placed in <pFrame>
+*
+* ERRNO: N/A
+*
+*/
+static UINT sja1000FrameEncode
+      (
+          UCHAR *pFrame,
+          ULONG canId,
+          BOOL ext,
+          BOOL rtr,
+          const UCHAR *data,
+          UCHAR len
+       )
+{
+    UINT ndx = 0;
+    UINT i;
+
+    /* set up the frame info reg. */
+    pFrame[ndx] = (ext)? 0x80 : 0;
+    if(rtr)
+        pFrame[ndx] |= 0x40;
+    pFrame[ndx++] |= len;
+
+    /* the ID */
+    if (ext == TRUE)
+    {
+        pFrame[ndx++] = canId >> (24 - 3);
+        pFrame[ndx++] = canId >> (16 - 3);
+        pFrame[ndx++] = canId >> (8 - 3);
+        pFrame[ndx++] = canId << 3;
+    }
+    else
+    {
+        pFrame[ndx++] = canId >> (8 - 5);
+        pFrame[ndx++] = canId << 5;
+    }
+
+    /* data */
+    for(i = 0 ; i < len ; i++)
+        pFrame[ndx++] = data[i];
+
+    return ndx;
+}
+
 /************************************************************************
 *
 * SJA1000_TxMsg - transmits a CAN message
@@ -1185,8 +2024,9 @@ static STATUS SJA1000_TxMsg
 {
 
     UCHAR  value;
+    UCHAR  frame[SJA1000_FRAME_SIZE];
     UINT   i;
-    UINT   ndx;
+    UINT   nBytes;
     struct TxMsg *pTxMsg;
 
     STATUS retCode = ERROR; /* pessimistic */
@@ -1238,46 +2078,9 @@ static STATUS SJA1000_TxMsg
                 pTxMsg->data[i] = data[i];
         
 
-        /* set up the frame info reg. */
-        value = (ext)? 0x80 : 0;
-
-        if(pTxMsg->rtr)
-                value |= 0x40;
-
-        value |= len;
-
-        pDev->pBrd->canOutByte(pDev, SJA1000_SFF, value);
-
-
-        /* write the ID */
-        ndx = SJA1000_TXID;
-        if (ext == TRUE)
-        {
-                value = canId >> (24 - 3);
-                pDev->pBrd->canOutByte(pDev, ndx++, value);
-
-                value = canId >> (16 - 3);
-                pDev->pBrd->canOutByte(pDev, ndx++, value);
-
-                value = canId >> (8 - 3);
-                pDev->pBrd->canOutByte(pDev, ndx++, value);
-
-                value = canId << 3;
-                pDev->pBrd->canOutByte(pDev, ndx++, value);
-        }
-        else
-        {
-                value = canId >> ( 8 - 5);
-                pDev->pBrd->canOutByte(pDev, ndx++, value);
-
-                value = canId << 5;
-                pDev->pBrd->canOutByte(pDev, ndx++, value);
-        }
-
-
-        /* write data */
-        for(i = 0 ; i < len ; i++)
-                pDev->pBrd->canOutByte(pDev, ndx++, data[i]);
+        /* load frame info, identifier and data in one transfer */
+        nBytes = sja1000FrameEncode(frame, canId, ext, pTxMsg->rtr, data, len);
+        WNCAN_Board_WriteFrame(pDev, SJA1000_SFF, frame, nBytes);
 
         /* Request a transmission */
         pDev->pBrd->canOutByte(pDev, SJA1000_CMR, CMR_TR);
@@ -1307,8 +2110,8 @@ static STATUS SJA1000_Tx
           )
 {
     UCHAR        value;
-    UINT         ndx;
-    UINT         i;
+    UCHAR        frame[SJA1000_FRAME_SIZE];
+    UINT         nBytes;
     struct TxMsg *pTxMsg;
     STATUS retCode = ERROR; /* pessimistic */
 
@@ -1334,31 +2137,10 @@ static STATUS SJA1000_Tx
 
         pTxMsg = (struct TxMsg *)pDev->pCtrl->csData;
 
-        value = (pTxMsg->ext)? 0x80 : 0;
-        if(pTxMsg->rtr)
-                value |= 0x40;
-        value |= pTxMsg->len;
-        pDev->pBrd->canOutByte(pDev, SJA1000_SFF, value);
-
-        ndx = SJA1000_TXID;
-
-        /* write the identifier */
-        if(pTxMsg->ext)
-        {
-                pDev->pBrd->canOutByte(pDev, ndx++, pTxMsg->id >> (24 - 3));
-                pDev->pBrd->canOutByte(pDev, ndx++, pTxMsg->id >> (16 - 3));
-                pDev->pBrd->canOutByte(pDev, ndx++, pTxMsg->id >> (8 - 3));
-                pDev->pBrd->canOutByte(pDev, ndx++, pTxMsg->id << 3);
-        }
-        else
-        {
-                pDev->pBrd->canOutByte(pDev, ndx++, pTxMsg->id >> (8 - 5));
-                pDev->pBrd->canOutByte(pDev, ndx++, pTxMsg->id << 5);
-        }
-
-        /* write data */
-        for (i = 0; i < pTxMsg->len ; i++)
-                pDev->pBrd->canOutByte(pDev, ndx++, pTxMsg->data[i]);
+        /* load frame info, identifier and data in one transfer */
+        nBytes = sja1000FrameEncode(frame, pTxMsg->id, pTxMsg->ext, 
+                                    pTxMsg->rtr, pTxMsg->data, pTxMsg->len);
+        WNCAN_Board_WriteFrame(pDev, SJA1000_SFF, frame, nBytes);
 
         /* Request a transmission */
         pDev->pBrd->canOutByte(pDev, SJA1000_CMR, CMR_TR);
@@ -1439,6 +2221,7 @@ static STATUS SJA1000_SetGlobalRxFilter
         value = (mask  << 3) | 0x07;    
         pDev->pBrd->canOutByte(pDev, SJA1000_AMR3, value);
     }
+    ((struct SJA1000_ChipData *)pDev->pCtrl->csData)->accept.valid = FALSE;
 
     /* put controller back into normal mode */
     pDev->pBrd->canOutByte(pDev,  SJA1000_MOD, regMod);
@@ -1719,10 +2502,12 @@ static int SJA1000_IsRTR
                 }
                 else
                 {
-                        /* Read RTR field in the received channel hardware */
-                        value = pDev->pBrd->canInByte(pDev,SJA1000_RXID+2);
+                        /* Read RTR bit of the frame information, which
+                        ** is in the same place for both frame formats
+                        */
+                        value = pDev->pBrd->canInByte(pDev,SJA1000_SFF);
 
-                        if(value & 0x10)
+                        if(value & 0x40)
                                 retCode = 1;
                         else
                                 retCode = 0;
@@ -1791,10 +2576,9 @@ static void SJA1000_TxAbort
           struct WNCAN_Device *pDev
           )
 {
-    UCHAR value;
-
-    value = pDev->pBrd->canInByte(pDev, SJA1000_CMR);
-    pDev->pBrd->canOutByte(pDev, SJA1000_CMR, value | CMR_AT);
+    /* CMR is write-only and reads back as 0xFF; writing that back would
+       also request a transmission and release the receive buffer */
+    pDev->pBrd->canOutByte(pDev, SJA1000_CMR, CMR_AT);
     return;
 }
 
@@ -4,6 +4,7 @@
 modification history 
 --------------------
 2016/05/27 Jonah Liu Created on base of sys_pr6120_can.c
+           Precompute per-controller register window, add block accessors
 
 */
 
@@ -38,6 +39,9 @@ the PR6120 CAN card.
 #include <CAN/sja1000Offsets.h>
 #include "CAN/private/pr6120_can.h"
 
+/* sys_pr6120_can_sim.c provides these routines for the simulated board */
+#ifndef DRV_PR6120_CAN_SIM
+
 #define DEVICE_ID_PR6120_CAN       0xC204L /* device ID */
 #define VENDOR_ID_PR6120_CAN       0x13FEL /* subsystem ID */
 
@@ -82,81 +86,13 @@ extern void PR6120_CAN_DisableIRQ(struct WNCAN_Device *pDev);
 extern STATUS CAN_DEVICE_establishLinks(WNCAN_DEVICE *pDev, WNCAN_BoardType brdType, WNCAN_ControllerType ctrlType);
 
 
-/************************************************************************
-*
-* SJA1000_GetIntStatus - get the interrupt status on the controller
-*
-* This function returns the interrupt status on the controller: 
-*
-*    WNCAN_INT_NONE     = no interrupt occurred
-*    WNCAN_INT_ERROR    = bus error
-*    WNCAN_INT_TX       = interrupt resuting from a CAN transmission
-*    WNCAN_INT_RX       = interrupt resulting form message reception
-*    WNCAN_INT_BUS_OFF  = interrupt resulting from bus off condition
-*    WNCAN_INT_WAKE_UP  = interrupt resulting from controller waking up
-*                         after being put in sleep mode
-*    WNCAN_INT_SPURIOUS = unknown interrupt
-*
-* NOTE: If the interrupt was caused by the transmission or reception of a 
-* message, the channel number that generated the interrupt is set; otherwise,
-* this value is undefined.
-*
-* ERRNO: N/A
-*
-*/
-static WNCAN_IntType SJA1000_GetIntStatus
-      (
-          struct WNCAN_Device *pDev,
-          UCHAR *channelNum
-          )
-{
-    UCHAR       regInt;
-    WNCAN_IntType   intStatus=WNCAN_INT_NONE;
-        UCHAR regStatus;
-
-    /* read the interrupt register */
-    regInt = pDev->pBrd->canInByte(pDev, SJA1000_IR);
-
-        if(regInt & IR_RI) {
-                /*receive interrupt*/
-        intStatus = WNCAN_INT_RX;
-        *channelNum = 0;
-        }
-        
-        if( regInt & IR_TI) {
-                /*transmit interrupt*/
-        intStatus = WNCAN_INT_TX;
-        *channelNum = 1;
-        }
-
-        if(regInt & IR_WUI)
-        {
-                intStatus = WNCAN_INT_WAKE_UP;
-        }
-
-        /*flag WNCAN_INT_ERROR, if data overrun error int, or
-          bus error int is detected */
-        if(regInt & IR_BEI) {
-                /*error interrupt*/
-        intStatus = WNCAN_INT_ERROR;
-        }
-
-        if(regInt & IR_EI) {
-                /*bus off interrupt*/
-                /* read the status register */
-        regStatus = pDev->pBrd->canInByte(pDev, SJA1000_SR);
-
-                if(regStatus & SJA1000_SR_BS)
-                        intStatus = WNCAN_INT_BUS_OFF;
-        }
-        
-    return intStatus;
-}
-
 /************************************************************************
 *
 * PR6120_CAN_ISR - board-level isr for PR6120 CAN board
 *
+* The board has no register summarizing which controller interrupts, so
+* PR6120_CAN_IntService() reads the controllers that have interrupts
+* enabled.
 *
 * RETURNS: N/A
 *   
@@ -168,53 +104,7 @@ static void PR6120_CAN_ISR
     ULONG param
 )
 {
-    struct PR6120_CAN_DeviceEntry *pDE = 
-        (struct PR6120_CAN_DeviceEntry *)param;
-    UINT i;
-
-    /* disable the interrupt. */
-    //PR6120_CAN_DisableIRQ(&pDE->canDevice[0]);
-
-    for (i = 0; i < PR6120_CAN_MAX_CONTROLLERS; i++)
-    {
-        if(pDE->allocated[i])
-        {
-        	WNCAN_DEVICE     *pDev = &pDE->canDevice[i];
-        	WNCAN_IntType   intStatus=WNCAN_INT_NONE;
-        	UCHAR chnNum;
-        	
-        	/* notify board that we're entering isr */
-        	if(pDev->pBrd->onEnterISR)
-        	    pDev->pBrd->onEnterISR(pDev);
-        	
-        	/* Get the interrupt status */
-        	intStatus = SJA1000_GetIntStatus((void*)pDev, &chnNum);
-
-        	if (intStatus != WNCAN_INT_NONE)
-        	{
-        	                 
-        	    pDev->pISRCallback(pDev, intStatus, chnNum);
-
-				if (intStatus == WNCAN_INT_RX) {
-					/* release the receive buffer */
-					/* this will temporarily cleat RI bit */
-					//pDev->pBrd->canOutByte(pDev, SJA1000_CMR, CMR_RRB);
-				} else if (intStatus == WNCAN_INT_ERROR) {
-					/* clear bei interrupt flag */
-					pDev->pBrd->canInByte(pDev, SJA1000_ECC);
-				} else if (intStatus == WNCAN_INT_TX) {
-					/* notify channel available to TX again */
-					pDev->pISRCallback(pDev, WNCAN_INT_TXCLR, chnNum);
-				}
-			}
-        	
-        	/* notify board that we're leaving isr */
-        	if(pDev->pBrd->onLeaveISR)
-        	    pDev->pBrd->onLeaveISR(pDev);
-        }
-    }
-    /* Enable the interrupt. */
-    //PR6120_CAN_EnableIRQ(&pDE->canDevice[0]);
+    PR6120_CAN_IntService((struct PR6120_CAN_DeviceEntry *)param);
 }
 
 
@@ -461,6 +351,10 @@ STATUS sys_PR6120_CAN_Init
 
         pDev[ctrlNum]->pBrd = pBrd;
 
+        /* Each controller occupies a 0x400 byte window of BAR0 */
+        pDev[ctrlNum]->pCtrl->regWindow = 
+            pBrd->ioAddress + pBrd->bar0 + ctrlNum * 0x400;
+
         /* Initialize the controller data structure: Note, ctrlType is set 
            inside pr6120_can_establishLinks() */
         pDev[ctrlNum]->pCtrl->ctrlID     = (UCHAR)ctrlNum;
@@ -472,7 +366,7 @@ STATUS sys_PR6120_CAN_Init
             &(pDeviceEntry->chData[ctrlNum].sja1000chnMode[0]);
 
         pDev[ctrlNum]->pCtrl->csData     = 
-            &(pDeviceEntry->txMsg[ctrlNum]);
+            &(pDeviceEntry->chipData[ctrlNum]);
 
         /* set default baud rate to 125 Kbits/sec */
         pDev[ctrlNum]->pCtrl->brp = 3;       
@@ -524,10 +418,6 @@ void sys_PR6120_CAN_canOutByte
     UCHAR value
 )
 {
-    UCHAR    net     = pDev->pCtrl->ctrlID;
-    UINT32   offset  = pDev->pBrd->bar0;
-    ULONG    memBase = pDev->pBrd->ioAddress;
-
     UCHAR*   addr;
 
     #ifdef DEBUG
@@ -545,7 +435,7 @@ void sys_PR6120_CAN_canOutByte
     #endif
     #endif
 
-    addr = (UCHAR*)(memBase) + (offset + reg*4 + net*0x400);
+    addr = (UCHAR*)(pDev->pCtrl->regWindow) + reg*4;
 
     #ifdef DEBUG
     /* Read the data first */
@@ -577,9 +467,6 @@ UCHAR sys_PR6120_CAN_canInByte
     unsigned int reg
 )
 {
-    UCHAR    net     = pDev->pCtrl->ctrlID;
-    UINT32   offset  = pDev->pBrd->bar0;
-    ULONG    memBase = pDev->pBrd->ioAddress;
     UCHAR    data;
     UCHAR*   addr;
     
@@ -594,8 +481,66 @@ UCHAR sys_PR6120_CAN_canInByte
     #endif
     #endif
     
-    addr = (UCHAR*)(memBase) + (offset + reg*4 + net*0x400);
+    addr = (UCHAR*)(pDev->pCtrl->regWindow) + reg*4;
     data = *(addr);
     
     return(data);
 }
+
+/*******************************************************************
+ *  sys_PR6120_CAN_canReadFrame - read <len> consecutive SJA1000 
+ *  registers starting at <reg> on the PR6120 CAN board.
+ *
+ * RETURNS: NONE
+ *
+ * ERRNO: N/A
+ */
+void sys_PR6120_CAN_canReadFrame
+(
+    struct WNCAN_Device *pDev,
+    unsigned int reg,
+    UCHAR *pBuf,
+    UINT len
+)
+{
+    volatile UCHAR* addr;
+    UINT     i;
+
+    /* registers are spaced 4 bytes apart in the controller window */
+    addr = (volatile UCHAR*)(pDev->pCtrl->regWindow) + reg*4;
+
+    for (i = 0; i < len; i++)
+        pBuf[i] = addr[i*4];
+
+    return;
+}
+
+/*******************************************************************
+ *  sys_PR6120_CAN_canWriteFrame - write <len> consecutive SJA1000 
+ *  registers starting at <reg> on the PR6120 CAN board.
+ *
+ * RETURNS: NONE
+ *
+ * ERRNO: N/A
+ */
+void sys_PR6120_CAN_canWriteFrame
+(
+    struct WNCAN_Device *pDev,
+    unsigned int reg,
+    const UCHAR *pBuf,
+    UINT len
+)
+{
+    volatile UCHAR* addr;
+    UINT     i;
+
+    /* registers are spaced 4 bytes apart in the controller window */
+    addr = (volatile UCHAR*)(pDev->pCtrl->regWindow) + reg*4;
+
+    for (i = 0; i < len; i++)
+        addr[i*4] = pBuf[i];
+
+    return;
+}
+
+#endif /* DRV_PR6120_CAN_SIM */
@@ -0,0 +1,1481 @@
+/* sys_pr6120_can_sim.c - simulated PR6120 CAN board */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+
+*/
+
+/*
+
+DESCRIPTION
+This file replaces the BSP dependent part of the PR6120 CAN driver,
+sys_pr6120_can.c, when DRV_PR6120_CAN_SIM is included. It provides the same
+sys_PR6120_CAN_xxx routines, but instead of accessing the SJA1000
+controllers of a PCI card they access a software model of the controllers,
+so the CAN stack, the DevIO interface and applications can be run on a
+target or a simulator without the card.
+
+Each simulated board has two SJA1000 controllers in PeliCAN mode connected
+to one virtual bus. The model implements the registers used by sja1000.c:
+the reset and operating modes, the transmit buffer, the 64 byte receive
+FIFO with data overrun, the acceptance filter in single and dual filter
+mode, the interrupt and interrupt enable registers, the error counters with
+the warning, passive and bus-off states and bus-off recovery, self test and
+listen only modes, self reception, abort and single shot transmission,
+arbitration between the two controllers and the arbitration lost and error
+code capture registers. A frame is acknowledged if the other controller is
+in operating mode and not listening only, or the transmitter is in self
+test mode; otherwise the transmitter counts an acknowledge error and
+retries.
+
+The bus is cycle-approximate: a frame occupies the bus for its nominal
+length in bits, including the interframe space but without stuff bits, at
+the bit rate programmed into the bus timing registers of the transmitter.
+The model runs from a watchdog at interrupt level every system clock tick
+while there is bus activity; it sends the frames that fit into the time
+that has passed and calls the board ISR after each frame, so the driver
+reloads the transmitter at the simulated end of the frame. Bus throughput
+therefore matches the bit rate, while interrupt latency is bounded by the
+system clock period; a system clock rate of 1000 Hz or more is recommended.
+
+sys_PR6120_CAN_SimFaultSet() makes the transmissions of a controller fail
+with bit errors, which drives it through the error warning and error
+passive states into bus-off, and sys_PR6120_CAN_SimShow() displays the bus
+counters.
+
+*/
+
+/* includes */
+#include <vxWorks.h>
+#include <errnoLib.h>
+#include <intLib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysLib.h>
+#include <tickLib.h>
+#include <wdLib.h>
+
+#include "CAN/wnCAN.h"
+#include "CAN/canController.h"
+#include "CAN/canBoard.h"
+#include "CAN/i82527.h"
+#include "CAN/sja1000.h"
+#include <CAN/sja1000Offsets.h>
+#include "CAN/private/pr6120_can.h"
+
+/* size of the receive FIFO in bytes and frames */
+#define PR6120_CAN_SIM_RXFIFO_SIZE  64
+#define PR6120_CAN_SIM_RXFIFO_MSGS  64
+
+/* bound of the frames sent per run of the model */
+#define PR6120_CAN_SIM_RUN_MAX      1000
+
+/* bits of a data frame without data: SOF to EOF and the interframe space */
+#define PR6120_CAN_SIM_STD_BITS     47
+#define PR6120_CAN_SIM_EXT_BITS     67
+
+/* bus idle time before a controller recovers from bus-off, in bits */
+#define PR6120_CAN_SIM_RECOVER_BITS (128 * 11)
+
+/* error code capture values: ack error and bit error in the identifier */
+#define PR6120_CAN_SIM_ECC_ACK      (ECC_ERRC0 | ECC_ERCC1 | 0x19)
+#define PR6120_CAN_SIM_ECC_BIT      0x02
+
+/* register model of one SJA1000 controller */
+struct PR6120_CAN_SimCtrl
+{
+    struct PR6120_CAN_SimBus *pBus;
+    UINT   ndx;               /* controller number on the board */
+
+    UCHAR  mod;               /* mode */
+    UCHAR  ier;               /* interrupt enable */
+    UCHAR  ir;                /* latched interrupts, RI is derived */
+    UCHAR  btr0;
+    UCHAR  btr1;
+    UCHAR  ocr;
+    UCHAR  cdr;
+    UCHAR  ewlr;
+    UCHAR  alc;
+    UCHAR  ecc;
+    BOOL   alcLocked;         /* alc holds a capture not read yet */
+    BOOL   eccLocked;         /* ecc holds a capture not read yet */
+    UINT   rxErr;
+    UINT   txErr;
+    UCHAR  rbsa;
+    UCHAR  acr[4];
+    UCHAR  amr[4];
+
+    UCHAR  txBuf[SJA1000_FRAME_SIZE];    /* written in operating mode */
+    BOOL   txPending;         /* transmission requested, TBS clear */
+    BOOL   txSelf;            /* self reception request */
+    BOOL   txSingle;          /* single shot, no retransmission */
+    BOOL   txAbort;           /* abort requested while on the bus */
+    BOOL   txComplete;        /* TCS */
+    UINT64 txReq;             /* bus time of the request */
+
+    UCHAR  rxFifo[PR6120_CAN_SIM_RXFIFO_SIZE];
+    UINT   rxHead;            /* first byte of the oldest frame */
+    UINT   rxBytes;
+    UINT   rxFrames;
+    BOOL   overrun;           /* DOS */
+
+    BOOL   errWarn;           /* ES */
+    BOOL   errPassive;
+    BOOL   busOff;            /* BS */
+    UINT64 recoverAt;         /* bus time bus-off recovery ends, 0 = none */
+    BOOL   fault;             /* see sys_PR6120_CAN_SimFaultSet() */
+
+    /* counters, see sys_PR6120_CAN_SimShow() */
+    ULONG  txFrames;
+    ULONG  rxFramesTotal;
+    ULONG  rxOverruns;
+    ULONG  ackErrors;
+    ULONG  bitErrors;
+    ULONG  arbLost;
+    ULONG  busOffs;
+};
+
+/* virtual bus of one simulated board */
+struct PR6120_CAN_SimBus
+{
+    struct PR6120_CAN_SimCtrl      ctrl[PR6120_CAN_MAX_CONTROLLERS];
+    struct PR6120_CAN_DeviceEntry *pDE;
+    WDOG_ID wd;
+    BOOL    wdArmed;
+    BOOL    running;          /* the model is running, use clock below */
+    UINT64  clock;            /* bus time the model has reached, ns */
+    UINT64  idleAt;           /* bus time the bus becomes idle */
+    int     txOwner;          /* controller on the bus, -1 = idle */
+    UINT64  txEnd;            /* bus time the frame on the bus ends */
+    UINT64  busyTime;         /* time the bus was busy, ns */
+    ULONG   frames;           /* frames sent */
+    ULONG   lagRuns;          /* runs stopped by PR6120_CAN_SIM_RUN_MAX */
+};
+
+static const char PR6120_CAN_deviceName[] ="PR6120 CAN (simulated)";
+
+extern UINT PR6120_CAN_MaxBrdNumGet(void);
+extern struct PR6120_CAN_DeviceEntry* PR6120_CAN_DeviceEntryGet(UINT brdNum);
+extern STATUS CAN_DEVICE_establishLinks(WNCAN_DEVICE *pDev, WNCAN_BoardType brdType, WNCAN_ControllerType ctrlType);
+
+static void PR6120_CAN_SimRun(struct PR6120_CAN_SimBus *pBus);
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimNow - current bus time
+*
+* Register accesses made by the model itself, from the ISR, happen at the
+* bus time the model has reached; all others happen at the system time.
+*
+* RETURNS: bus time in ns
+*
+* ERRNO: N/A
+*
+*/
+static UINT64 PR6120_CAN_SimNow
+(
+    struct PR6120_CAN_SimBus *pBus
+)
+{
+    if (pBus->running)
+        return pBus->clock;
+
+    return tick64Get() * 1000000000ULL / sysClkRateGet();
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimBitTime - bit time programmed into a controller
+*
+* RETURNS: bit time in ns
+*
+* ERRNO: N/A
+*
+*/
+static UINT64 PR6120_CAN_SimBitTime
+(
+    struct PR6120_CAN_SimCtrl *pCtrl
+)
+{
+    UINT tq;
+    UINT nq;
+
+    /* tq = 2 * (brp + 1) / xtal, bit = 1 + (tseg1 + 1) + (tseg2 + 1) tq */
+    tq = 2 * ((pCtrl->btr0 & 0x3f) + 1);
+    nq = 3 + (pCtrl->btr1 & 0x0f) + ((pCtrl->btr1 >> 4) & 0x07);
+
+    return (UINT64) tq * nq * 1000000000ULL /
+        pCtrl->pBus->pDE->canBoard.xtalFreq;
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimFrameSize - bytes of a frame in the frame window
+*
+* RETURNS: frame info, identifier and data bytes of the frame
+*
+* ERRNO: N/A
+*
+*/
+static UINT PR6120_CAN_SimFrameSize
+(
+    const UCHAR *pFrame
+)
+{
+    UINT len = pFrame[0] & 0x0f;
+
+    /* a remote frame carries no data, DLC values above 8 carry 8 */
+    if (pFrame[0] & 0x40)
+        len = 0;
+    else if (len > 8)
+        len = 8;
+
+    return ((pFrame[0] & 0x80) ? 5 : 3) + len;
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimArbKey - arbitration field of a frame
+*
+* The fields are placed in the order they are sent, starting at bit 31,
+* so the frame with the lower key wins arbitration and 31 minus the first
+* differing bit is the bit number reported in the ALC register.
+*
+* RETURNS: arbitration key
+*
+* ERRNO: N/A
+*
+*/
+static UINT32 PR6120_CAN_SimArbKey
+(
+    const UCHAR *pFrame
+)
+{
+    UINT32 id;
+    UINT32 rtr = (pFrame[0] & 0x40) ? 1 : 0;
+
+    if (pFrame[0] & 0x80)
+    {
+        id = ((UINT32) pFrame[1] << 21) | ((UINT32) pFrame[2] << 13) |
+             ((UINT32) pFrame[3] << 5) | (pFrame[4] >> 3);
+        return ((id >> 18) << 21) | (3 << 19) | ((id & 0x3ffff) << 1) | rtr;
+    }
+
+    id = ((UINT32) pFrame[1] << 3) | (pFrame[2] >> 5);
+    return (id << 21) | (rtr << 20);
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimAccept - apply the acceptance filter of a controller
+*
+* Data bytes compared by the filter that the frame does not carry are
+* treated as matching.
+*
+* RETURNS: TRUE if the controller accepts the frame
+*
+* ERRNO: N/A
+*
+*/
+static BOOL PR6120_CAN_SimAccept
+(
+    struct PR6120_CAN_SimCtrl *pCtrl,
+    const UCHAR *pFrame
+)
+{
+    UINT32 code = ((UINT32) pCtrl->acr[0] << 24) | (pCtrl->acr[1] << 16) |
+                  (pCtrl->acr[2] << 8) | pCtrl->acr[3];
+    UINT32 care = ~(((UINT32) pCtrl->amr[0] << 24) | (pCtrl->amr[1] << 16) |
+                    (pCtrl->amr[2] << 8) | pCtrl->amr[3]);
+    UINT32 image;
+    UINT32 id;
+    UINT   nData;
+    UCHAR  data1;
+    BOOL   ext = (pFrame[0] & 0x80) ? TRUE : FALSE;
+    BOOL   rtr = (pFrame[0] & 0x40) ? TRUE : FALSE;
+
+    nData = PR6120_CAN_SimFrameSize(pFrame) - (ext ? 5 : 3);
+    data1 = pFrame[3];
+
+    if (ext)
+        id = ((UINT32) pFrame[1] << 21) | ((UINT32) pFrame[2] << 13) |
+             ((UINT32) pFrame[3] << 5) | (pFrame[4] >> 3);
+    else
+        id = ((UINT32) pFrame[1] << 3) | (pFrame[2] >> 5);
+
+    if (pCtrl->mod & MOD_AFM)
+    {
+        /* single filter */
+        if (ext)
+        {
+            image = (id << 3) | (rtr ? 0x04 : 0);
+            care &= 0xfffffffc;
+        }
+        else
+        {
+            image = (id << 21) | (rtr ? 0x00100000 : 0) |
+                    ((UINT32) data1 << 8) | pFrame[4];
+            care &= 0xfff0ffff;
+            if (nData < 2)
+                care &= 0xffffff00;
+            if (nData < 1)
+                care &= 0xffff00ff;
+        }
+
+        return ((image ^ code) & care) == 0;
+    }
+
+    /* dual filter, filter 1 in ACR0/ACR1, filter 2 in ACR2/ACR3 */
+    if (ext)
+    {
+        image = (id >> 13) & 0xffff;
+        return (((image ^ (code >> 16)) & (care >> 16)) == 0) ||
+               (((image ^ code) & care & 0xffff) == 0);
+    }
+
+    image = (id << 5) | (rtr ? 0x10 : 0);
+
+    /* filter 1 also compares data byte 1, split over ACR1 and ACR3 */
+    if (((((image | (data1 >> 4)) ^ (code >> 16)) &
+          (care >> 16) & (nData ? 0xffff : 0xfff0)) == 0) &&
+        (((data1 ^ code) & care & (nData ? 0x0f : 0)) == 0))
+        return TRUE;
+
+    return ((image ^ code) & care & 0xfff0) == 0;
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimErrState - update the error state of a controller
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void PR6120_CAN_SimErrState
+(
+    struct PR6120_CAN_SimCtrl *pCtrl
+)
+{
+    BOOL warn;
+    BOOL passive;
+
+    warn = (pCtrl->txErr >= pCtrl->ewlr) || (pCtrl->rxErr >= pCtrl->ewlr);
+    passive = (pCtrl->txErr >= 128) || (pCtrl->rxErr >= 128);
+
+    if (warn != pCtrl->errWarn)
+    {
+        pCtrl->errWarn = warn;
+        pCtrl->ir |= pCtrl->ier & IR_EI;
+    }
+
+    if (passive != pCtrl->errPassive)
+    {
+        pCtrl->errPassive = passive;
+        pCtrl->ir |= pCtrl->ier & IR_EPI;
+    }
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimTxError - count a transmit error of a controller
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void PR6120_CAN_SimTxError
+(
+    struct PR6120_CAN_SimCtrl *pCtrl,
+    UCHAR ecc,
+    UINT  increment
+)
+{
+    if (!pCtrl->eccLocked)
+    {
+        pCtrl->ecc = ecc;
+        pCtrl->eccLocked = TRUE;
+    }
+    pCtrl->ir |= pCtrl->ier & IR_BEI;
+
+    pCtrl->txErr += increment;
+    if (pCtrl->txErr > 255)
+    {
+        /* bus-off: the controller enters reset mode and stops sending */
+        pCtrl->busOff = TRUE;
+        pCtrl->busOffs++;
+        pCtrl->txErr = 127;
+        pCtrl->rxErr = 0;
+        pCtrl->mod |= MOD_RM;
+        pCtrl->txPending = FALSE;
+        pCtrl->ir |= pCtrl->ier & IR_EI;
+    }
+
+    PR6120_CAN_SimErrState(pCtrl);
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimRxPut - receive a frame into the receive FIFO
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void PR6120_CAN_SimRxPut
+(
+    struct PR6120_CAN_SimCtrl *pCtrl,
+    const UCHAR *pFrame
+)
+{
+    UINT len = PR6120_CAN_SimFrameSize(pFrame);
+    UINT ndx;
+    UINT i;
+
+    if (!PR6120_CAN_SimAccept(pCtrl, pFrame))
+        return;
+
+    if ((pCtrl->rxBytes + len > PR6120_CAN_SIM_RXFIFO_SIZE) ||
+        (pCtrl->rxFrames >= PR6120_CAN_SIM_RXFIFO_MSGS))
+    {
+        pCtrl->overrun = TRUE;
+        pCtrl->rxOverruns++;
+        pCtrl->ir |= pCtrl->ier & IR_DOI;
+        return;
+    }
+
+    ndx = pCtrl->rxHead + pCtrl->rxBytes;
+    for (i = 0; i < len; i++)
+        pCtrl->rxFifo[(ndx + i) % PR6120_CAN_SIM_RXFIFO_SIZE] = pFrame[i];
+
+    pCtrl->rxBytes += len;
+    pCtrl->rxFrames++;
+    pCtrl->rxFramesTotal++;
+
+    if (pCtrl->rxErr > 127)
+        pCtrl->rxErr = 119;
+    else if (pCtrl->rxErr > 0)
+        pCtrl->rxErr--;
+    PR6120_CAN_SimErrState(pCtrl);
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimRxRelease - release the oldest frame of the receive FIFO
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void PR6120_CAN_SimRxRelease
+(
+    struct PR6120_CAN_SimCtrl *pCtrl
+)
+{
+    UCHAR frame[SJA1000_FRAME_SIZE];
+    UINT  len;
+
+    if (pCtrl->rxFrames == 0)
+        return;
+
+    frame[0] = pCtrl->rxFifo[pCtrl->rxHead];
+    len = PR6120_CAN_SimFrameSize(frame);
+
+    pCtrl->rxHead = (pCtrl->rxHead + len) % PR6120_CAN_SIM_RXFIFO_SIZE;
+    pCtrl->rxBytes -= len;
+    pCtrl->rxFrames--;
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimIntLine - interrupt output of a controller
+*
+* RETURNS: TRUE if the controller requests an interrupt
+*
+* ERRNO: N/A
+*
+*/
+static BOOL PR6120_CAN_SimIntLine
+(
+    struct PR6120_CAN_SimCtrl *pCtrl
+)
+{
+    return (pCtrl->ir != 0) ||
+           ((pCtrl->rxFrames != 0) && (pCtrl->ier & IER_RIE));
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimKick - make sure the model runs on the next tick
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void PR6120_CAN_SimKick
+(
+    struct PR6120_CAN_SimBus *pBus
+)
+{
+    /* a running model checks for work again before it returns */
+    if (pBus->running || pBus->wdArmed || !pBus->pDE->intConnect)
+        return;
+
+    pBus->wdArmed = TRUE;
+    wdStart (pBus->wd, 1, (FUNCPTR) PR6120_CAN_SimRun, (int) pBus);
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimReset - enter reset mode
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void PR6120_CAN_SimReset
+(
+    struct PR6120_CAN_SimCtrl *pCtrl
+)
+{
+    struct PR6120_CAN_SimBus *pBus = pCtrl->pBus;
+
+    /* a frame on the bus is cut off */
+    if (pBus->txOwner == (int) pCtrl->ndx)
+    {
+        pBus->txOwner = -1;
+        pBus->idleAt = PR6120_CAN_SimNow(pBus);
+    }
+
+    pCtrl->txPending = FALSE;
+    pCtrl->txComplete = TRUE;
+    pCtrl->rxHead = 0;
+    pCtrl->rxBytes = 0;
+    pCtrl->rxFrames = 0;
+    pCtrl->overrun = FALSE;
+    pCtrl->recoverAt = 0;
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimWrite - write a register of the model
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void PR6120_CAN_SimWrite
+(
+    struct PR6120_CAN_SimCtrl *pCtrl,
+    unsigned int reg,
+    UCHAR value
+)
+{
+    struct PR6120_CAN_SimBus *pBus = pCtrl->pBus;
+    BOOL reset = (pCtrl->mod & MOD_RM) ? TRUE : FALSE;
+
+    switch (reg)
+    {
+    case SJA1000_MOD:
+        value &= MOD_RM | MOD_LOM | MOD_STM | MOD_AFM | MOD_SM;
+
+        /* the other mode bits can only be changed in reset mode */
+        if (!reset)
+            value = (value & (MOD_RM | MOD_SM)) |
+                    (pCtrl->mod & (MOD_LOM | MOD_STM | MOD_AFM));
+
+        if ((value & MOD_RM) && !reset)
+            PR6120_CAN_SimReset(pCtrl);
+        else if (!(value & MOD_RM) && reset && pCtrl->busOff)
+            pCtrl->recoverAt = PR6120_CAN_SimNow(pBus) +
+                PR6120_CAN_SIM_RECOVER_BITS * PR6120_CAN_SimBitTime(pCtrl);
+
+        pCtrl->mod = value;
+        break;
+
+    case SJA1000_CMR:
+        if (value & CMR_RRB)
+            PR6120_CAN_SimRxRelease(pCtrl);
+        if (value & CMR_CDO)
+            pCtrl->overrun = FALSE;
+
+        if ((value & CMR_AT) && pCtrl->txPending)
+        {
+            if (pBus->txOwner == (int) pCtrl->ndx)
+            {
+                /* the frame on the bus finishes, but is not retried */
+                pCtrl->txAbort = TRUE;
+            }
+            else
+            {
+                pCtrl->txPending = FALSE;
+                pCtrl->txComplete = FALSE;
+                pCtrl->ir |= pCtrl->ier & IR_TI;
+            }
+        }
+
+        if ((value & (CMR_TR | CMR_SRR)) && !reset && !pCtrl->txPending &&
+            !pCtrl->busOff)
+        {
+            pCtrl->txPending = TRUE;
+            pCtrl->txSelf = (value & CMR_SRR) ? TRUE : FALSE;
+            pCtrl->txSingle = (value & CMR_AT) ? TRUE : FALSE;
+            pCtrl->txAbort = FALSE;
+            pCtrl->txComplete = FALSE;
+            pCtrl->txReq = PR6120_CAN_SimNow(pBus);
+        }
+        break;
+
+    case SJA1000_IER:
+        pCtrl->ier = value;
+        break;
+
+    case SJA1000_BTR0:
+        if (reset)
+            pCtrl->btr0 = value;
+        break;
+
+    case SJA1000_BTR1:
+        if (reset)
+            pCtrl->btr1 = value;
+        break;
+
+    case SJA1000_OCR:
+        if (reset)
+            pCtrl->ocr = value;
+        break;
+
+    case SJA1000_EWLR:
+        if (reset)
+            pCtrl->ewlr = value;
+        break;
+
+    case SJA1000_RXERR:
+        if (reset)
+            pCtrl->rxErr = value;
+        break;
+
+    case SJA1000_TXERR:
+        if (reset)
+            pCtrl->txErr = value;
+        break;
+
+    case SJA1000_RXBSA:
+        if (reset)
+            pCtrl->rbsa = value;
+        break;
+
+    case SJA1000_CDR:
+        pCtrl->cdr = value;
+        break;
+
+    default:
+        /* frame window: acceptance filter in reset mode, else TX buffer */
+        if ((reg >= SJA1000_SFF) && (reg < SJA1000_SFF + SJA1000_FRAME_SIZE))
+        {
+            if (!reset)
+                pCtrl->txBuf[reg - SJA1000_SFF] = value;
+            else if (reg <= SJA1000_ACR3)
+                pCtrl->acr[reg - SJA1000_ACR0] = value;
+            else if (reg <= SJA1000_AMR3)
+                pCtrl->amr[reg - SJA1000_AMR0] = value;
+        }
+        break;
+    }
+
+    if (pCtrl->txPending || PR6120_CAN_SimIntLine(pCtrl) ||
+        pCtrl->recoverAt)
+        PR6120_CAN_SimKick(pBus);
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimRead - read a register of the model
+*
+* RETURNS: the register contents
+*
+* ERRNO: N/A
+*
+*/
+static UCHAR PR6120_CAN_SimRead
+(
+    struct PR6120_CAN_SimCtrl *pCtrl,
+    unsigned int reg
+)
+{
+    struct PR6120_CAN_SimBus *pBus = pCtrl->pBus;
+    BOOL  reset = (pCtrl->mod & MOD_RM) ? TRUE : FALSE;
+    UCHAR value;
+
+    switch (reg)
+    {
+    case SJA1000_MOD:
+        return pCtrl->mod;
+
+    case SJA1000_CMR:
+        /* write-only */
+        return 0xff;
+
+    case SJA1000_SR:
+        value = 0;
+        if (pCtrl->rxFrames)
+            value |= SJA1000_SR_RBS;
+        if (pCtrl->overrun)
+            value |= SJA1000_SR_DOS;
+        if (!pCtrl->txPending)
+            value |= SJA1000_SR_TBS;
+        if (pCtrl->txComplete)
+            value |= SJA1000_SR_TCS;
+        if (pBus->txOwner == (int) pCtrl->ndx)
+            value |= SJA1000_SR_TS;
+        else if ((pBus->txOwner >= 0) && !reset)
+            value |= SJA1000_SR_RS;
+        if (pCtrl->errWarn)
+            value |= SJA1000_SR_ES;
+        if (pCtrl->busOff)
+            value |= SJA1000_SR_BS;
+        return value;
+
+    case SJA1000_IR:
+        /* cleared on read, except RI which follows the receive FIFO */
+        value = pCtrl->ir;
+        if ((pCtrl->rxFrames != 0) && (pCtrl->ier & IER_RIE))
+            value |= IR_RI;
+        pCtrl->ir = 0;
+        return value;
+
+    case SJA1000_IER:
+        return pCtrl->ier;
+
+    case SJA1000_BTR0:
+        return pCtrl->btr0;
+
+    case SJA1000_BTR1:
+        return pCtrl->btr1;
+
+    case SJA1000_OCR:
+        return pCtrl->ocr;
+
+    case SJA1000_ALC:
+        pCtrl->alcLocked = FALSE;
+        return pCtrl->alc;
+
+    case SJA1000_ECC:
+        pCtrl->eccLocked = FALSE;
+        return pCtrl->ecc;
+
+    case SJA1000_EWLR:
+        return pCtrl->ewlr;
+
+    case SJA1000_RXERR:
+        return (UCHAR) pCtrl->rxErr;
+
+    case SJA1000_TXERR:
+        return (UCHAR) pCtrl->txErr;
+
+    case SJA1000_RMC:
+        return (UCHAR) pCtrl->rxFrames;
+
+    case SJA1000_RXBSA:
+        return pCtrl->rbsa;
+
+    case SJA1000_CDR:
+        return pCtrl->cdr;
+
+    default:
+        /* frame window: acceptance filter in reset mode, else RX FIFO */
+        if ((reg >= SJA1000_SFF) && (reg < SJA1000_SFF + SJA1000_FRAME_SIZE))
+        {
+            if (!reset)
+                return pCtrl->rxFifo[(pCtrl->rxHead + reg - SJA1000_SFF) %
+                                     PR6120_CAN_SIM_RXFIFO_SIZE];
+            if (reg <= SJA1000_ACR3)
+                return pCtrl->acr[reg - SJA1000_ACR0];
+            if (reg <= SJA1000_AMR3)
+                return pCtrl->amr[reg - SJA1000_AMR0];
+        }
+        return 0;
+    }
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimArbitrate - put the next frame on the bus
+*
+* The controllers that requested a transmission before the bus became
+* idle take part in arbitration; the losers report it and retry.
+*
+* RETURNS: TRUE if a frame was put on the bus
+*
+* ERRNO: N/A
+*
+*/
+static BOOL PR6120_CAN_SimArbitrate
+(
+    struct PR6120_CAN_SimBus *pBus
+)
+{
+    struct PR6120_CAN_SimCtrl *pCtrl;
+    UINT64 start = 0;
+    UINT32 key[PR6120_CAN_MAX_CONTROLLERS];
+    UINT32 diff;
+    int    winner = -1;
+    UINT   bit;
+    UINT   i;
+
+    /* the bus starts when the first request meets an idle bus */
+    for (i = 0; i < PR6120_CAN_MAX_CONTROLLERS; i++)
+    {
+        pCtrl = &pBus->ctrl[i];
+        if (!pCtrl->txPending || (pCtrl->mod & (MOD_RM | MOD_LOM)))
+            continue;
+        if ((winner < 0) || (pCtrl->txReq < start))
+            start = pCtrl->txReq;
+        winner = i;
+    }
+
+    if (winner < 0)
+        return FALSE;
+
+    if (start < pBus->idleAt)
+        start = pBus->idleAt;
+
+    winner = -1;
+    for (i = 0; i < PR6120_CAN_MAX_CONTROLLERS; i++)
+    {
+        pCtrl = &pBus->ctrl[i];
+        if (!pCtrl->txPending || (pCtrl->mod & (MOD_RM | MOD_LOM)) ||
+            (pCtrl->txReq > start))
+            continue;
+        key[i] = PR6120_CAN_SimArbKey(pCtrl->txBuf);
+        if ((winner < 0) || (key[i] < key[winner]))
+            winner = i;
+    }
+
+    for (i = 0; i < PR6120_CAN_MAX_CONTROLLERS; i++)
+    {
+        pCtrl = &pBus->ctrl[i];
+        if ((i == (UINT) winner) || !pCtrl->txPending ||
+            (pCtrl->mod & (MOD_RM | MOD_LOM)) || (pCtrl->txReq > start))
+            continue;
+
+        /* ALC holds the number of the bit that was lost */
+        diff = key[i] ^ key[winner];
+        for (bit = 0; (bit < 31) && !(diff & (0x80000000 >> bit)); bit++)
+            ;
+        if (!pCtrl->alcLocked)
+        {
+            pCtrl->alc = (UCHAR) bit;
+            pCtrl->alcLocked = TRUE;
+        }
+        pCtrl->ir |= pCtrl->ier & IR_ALI;
+        pCtrl->arbLost++;
+    }
+
+    pCtrl = &pBus->ctrl[winner];
+    if (pCtrl->txBuf[0] & 0x80)
+        bit = PR6120_CAN_SIM_EXT_BITS +
+              8 * (PR6120_CAN_SimFrameSize(pCtrl->txBuf) - 5);
+    else
+        bit = PR6120_CAN_SIM_STD_BITS +
+              8 * (PR6120_CAN_SimFrameSize(pCtrl->txBuf) - 3);
+
+    pBus->txOwner = winner;
+    pBus->txEnd = start + PR6120_CAN_SimBitTime(pCtrl) * bit;
+    pBus->busyTime += pBus->txEnd - start;
+
+    return TRUE;
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimFrameDone - finish the frame on the bus
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void PR6120_CAN_SimFrameDone
+(
+    struct PR6120_CAN_SimBus *pBus
+)
+{
+    struct PR6120_CAN_SimCtrl *pTx = &pBus->ctrl[pBus->txOwner];
+    struct PR6120_CAN_SimCtrl *pRx;
+    BOOL   acked = (pTx->mod & MOD_STM) ? TRUE : FALSE;
+    UINT   i;
+
+    pBus->txOwner = -1;
+    pBus->idleAt = pBus->txEnd;
+
+    if (pTx->fault)
+    {
+        /* every node sees the error frame, the transmitter counts it */
+        pTx->bitErrors++;
+        PR6120_CAN_SimTxError(pTx, PR6120_CAN_SIM_ECC_BIT, 8);
+    }
+    else
+    {
+        for (i = 0; i < PR6120_CAN_MAX_CONTROLLERS; i++)
+        {
+            pRx = &pBus->ctrl[i];
+            if ((pRx == pTx) || (pRx->mod & MOD_RM))
+                continue;
+            if (!(pRx->mod & MOD_LOM))
+                acked = TRUE;
+            PR6120_CAN_SimRxPut(pRx, pTx->txBuf);
+        }
+
+        if (acked)
+        {
+            if (pTx->txSelf)
+                PR6120_CAN_SimRxPut(pTx, pTx->txBuf);
+
+            pBus->frames++;
+            pTx->txFrames++;
+            pTx->txPending = FALSE;
+            pTx->txComplete = TRUE;
+            pTx->ir |= pTx->ier & IR_TI;
+            if (pTx->txErr > 0)
+                pTx->txErr--;
+            PR6120_CAN_SimErrState(pTx);
+            return;
+        }
+
+        /* an error passive transmitter does not count ack errors */
+        pTx->ackErrors++;
+        PR6120_CAN_SimTxError(pTx, PR6120_CAN_SIM_ECC_ACK,
+                              pTx->errPassive ? 0 : 8);
+    }
+
+    if (pTx->txPending && (pTx->txSingle || pTx->txAbort))
+    {
+        pTx->txPending = FALSE;
+        pTx->txComplete = FALSE;
+        pTx->ir |= pTx->ier & IR_TI;
+    }
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimIntPending - controllers requesting an interrupt
+*
+* The model offers the interrupt outputs of its controllers as a board
+* level summary, which PR6120_CAN_IntService() reads instead of the
+* interrupt register of each controller.
+*
+* RETURNS: bit mask of the controllers requesting an interrupt
+*
+* ERRNO: N/A
+*
+*/
+static UINT PR6120_CAN_SimIntPending
+(
+    struct PR6120_CAN_DeviceEntry *pDE
+)
+{
+    struct PR6120_CAN_SimBus *pBus = ((struct PR6120_CAN_SimCtrl *)
+        pDE->canDevice[0].pCtrl->regWindow)->pBus;
+    UINT pending = 0;
+    UINT i;
+
+    for (i = 0; i < PR6120_CAN_MAX_CONTROLLERS; i++)
+    {
+        if (PR6120_CAN_SimIntLine(&pBus->ctrl[i]))
+            pending |= (1 << i);
+    }
+
+    return pending;
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimIsr - board-level isr for the simulated board
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void PR6120_CAN_SimIsr
+(
+    struct PR6120_CAN_SimBus *pBus
+)
+{
+    /* the interrupt line is level triggered */
+    if (PR6120_CAN_SimIntPending(pBus->pDE) != 0)
+        PR6120_CAN_IntService(pBus->pDE);
+}
+
+
+/************************************************************************
+*
+* PR6120_CAN_SimRun - advance the model to the current time
+*
+* This routine runs from the watchdog of the board at interrupt level. It
+* sends the frames that fit into the time passed since the last run and
+* calls the ISR after each of them.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void PR6120_CAN_SimRun
+(
+    struct PR6120_CAN_SimBus *pBus
+)
+{
+    struct PR6120_CAN_SimCtrl *pCtrl;
+    UINT64 now;
+    BOOL   busy;
+    UINT   n;
+    UINT   i;
+
+    pBus->wdArmed = FALSE;
+    now = PR6120_CAN_SimNow(pBus);
+    pBus->running = TRUE;
+    if (pBus->clock < pBus->idleAt)
+        pBus->clock = pBus->idleAt;
+
+    PR6120_CAN_SimIsr(pBus);
+
+    for (n = 0; n < PR6120_CAN_SIM_RUN_MAX; n++)
+    {
+        if ((pBus->txOwner < 0) && !PR6120_CAN_SimArbitrate(pBus))
+            break;
+        if (pBus->txEnd > now)
+            break;
+
+        pBus->clock = pBus->txEnd;
+        PR6120_CAN_SimFrameDone(pBus);
+        PR6120_CAN_SimIsr(pBus);
+    }
+    if (n == PR6120_CAN_SIM_RUN_MAX)
+        pBus->lagRuns++;
+
+    /* bus-off recovery */
+    for (i = 0; i < PR6120_CAN_MAX_CONTROLLERS; i++)
+    {
+        pCtrl = &pBus->ctrl[i];
+        if (pCtrl->recoverAt && (pCtrl->recoverAt <= now))
+        {
+            pCtrl->recoverAt = 0;
+            pCtrl->busOff = FALSE;
+            pCtrl->txErr = 0;
+            pCtrl->rxErr = 0;
+            pCtrl->ir |= pCtrl->ier & IR_EI;
+            PR6120_CAN_SimErrState(pCtrl);
+        }
+    }
+    PR6120_CAN_SimIsr(pBus);
+
+    pBus->running = FALSE;
+    if (pBus->clock < now)
+        pBus->clock = now;
+
+    busy = (pBus->txOwner >= 0);
+    for (i = 0; i < PR6120_CAN_MAX_CONTROLLERS; i++)
+    {
+        pCtrl = &pBus->ctrl[i];
+        if (pCtrl->txPending || pCtrl->recoverAt ||
+            (pBus->pDE->allocated[i] && PR6120_CAN_SimIntLine(pCtrl)))
+            busy = TRUE;
+    }
+
+    if (busy)
+        PR6120_CAN_SimKick(pBus);
+}
+
+
+/************************************************************************
+*
+* sys_PR6120_CAN_IntConnect - connect board-level interrupts
+*
+* This routine starts the model of the specified simulated board.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+void sys_PR6120_CAN_IntConnect
+(
+    UINT brdNum
+)
+{
+    struct PR6120_CAN_DeviceEntry  *pDeviceEntry = 0;
+    struct PR6120_CAN_SimCtrl      *pCtrl;
+    int                             oldLevel;
+
+    /* Get the device entry */
+    pDeviceEntry = PR6120_CAN_DeviceEntryGet(brdNum);
+
+    if ((pDeviceEntry == NULL) || (pDeviceEntry->inUse == FALSE))
+        return;
+
+    pCtrl = (struct PR6120_CAN_SimCtrl *)
+        pDeviceEntry->canDevice[0].pCtrl->regWindow;
+
+    oldLevel = intLock();
+    pDeviceEntry->intConnect = TRUE;
+    PR6120_CAN_SimKick(pCtrl->pBus);
+    intUnlock(oldLevel);
+}
+
+
+/************************************************************************
+*
+* sys_PR6120_CAN_Init - init the specified simulated PR6120 CAN board
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+STATUS sys_PR6120_CAN_Init
+(
+    UINT brdNum
+)
+{
+    UINT          ctrlNum;
+    STATUS        retCode;
+
+    struct PR6120_CAN_DeviceEntry  *pDeviceEntry = 0;
+    struct WNCAN_Device             *pDev[2]      = {0,0};
+    struct WNCAN_Board              *pBrd         = 0;
+    struct PR6120_CAN_SimBus        *pBus;
+
+    retCode = ERROR;      /* pessimistic */
+
+    /* check that the board number is within range */
+    if (brdNum >= PR6120_CAN_MaxBrdNumGet())
+        goto exit;
+
+    /* Get the device entry */
+    pDeviceEntry = PR6120_CAN_DeviceEntryGet(brdNum);
+
+    if (pDeviceEntry == NULL)
+        goto exit;
+
+    /* Check if the device entry has already been initialized.
+       If so, return now */
+    if (pDeviceEntry->inUse == TRUE)
+    {
+        retCode = OK;
+        goto exit;
+    }
+
+    pBus = (struct PR6120_CAN_SimBus *) calloc(1, sizeof(*pBus));
+    if (pBus == NULL)
+        goto exit;
+
+    pBus->wd = wdCreate();
+    if (pBus->wd == NULL)
+    {
+        free(pBus);
+        goto exit;
+    }
+
+    pBus->pDE = pDeviceEntry;
+    pBus->txOwner = -1;
+    pDeviceEntry->intPending = PR6120_CAN_SimIntPending;
+
+    /* Point to the can board */
+    pBrd = &pDeviceEntry->canBoard;
+    pBrd->irq = 0;
+    pBrd->bar0 = 0;
+    pBrd->ioAddress = 0;
+    pBrd->xtalFreq = _16MHZ;
+
+    /* Initialize each controller contained in the board */
+    for (ctrlNum = 0; ctrlNum < PR6120_CAN_MAX_CONTROLLERS; ctrlNum++)
+    {
+        /* hardware reset state */
+        pBus->ctrl[ctrlNum].pBus = pBus;
+        pBus->ctrl[ctrlNum].ndx = ctrlNum;
+        pBus->ctrl[ctrlNum].mod = MOD_RM;
+        pBus->ctrl[ctrlNum].ewlr = 96;
+        pBus->ctrl[ctrlNum].txComplete = TRUE;
+
+        pDev[ctrlNum] = &(pDeviceEntry->canDevice[ctrlNum]);
+
+        /* Point to the statically allocated memory for the WNCAN_Controller
+           and WNCAN_Board data structures */
+        pDev[ctrlNum]->pCtrl =
+            &(pDeviceEntry->canControllerArray[ctrlNum]);
+
+        pDev[ctrlNum]->pBrd = pBrd;
+
+        /* The register window of a controller is its model */
+        pDev[ctrlNum]->pCtrl->regWindow = (ULONG) &pBus->ctrl[ctrlNum];
+
+        /* Initialize the controller data structure: Note, ctrlType is set
+           inside pr6120_can_establishLinks() */
+        pDev[ctrlNum]->pCtrl->ctrlID     = (UCHAR)ctrlNum;
+        pDev[ctrlNum]->pCtrl->pDev       = pDev[ctrlNum];
+        pDev[ctrlNum]->pCtrl->chnType    = g_sja1000chnType;
+        pDev[ctrlNum]->pCtrl->numChn     = SJA1000_MAX_MSG_OBJ;
+
+        pDev[ctrlNum]->pCtrl->chnMode    =
+            &(pDeviceEntry->chData[ctrlNum].sja1000chnMode[0]);
+
+        pDev[ctrlNum]->pCtrl->csData     =
+            &(pDeviceEntry->chipData[ctrlNum]);
+
+        /* set default baud rate to 125 Kbits/sec */
+        pDev[ctrlNum]->pCtrl->brp = 3;
+        pDev[ctrlNum]->pCtrl->sjw = 0;
+        pDev[ctrlNum]->pCtrl->tseg1 = 0xc;
+        pDev[ctrlNum]->pCtrl->tseg2 = 0x1;
+        pDev[ctrlNum]->pCtrl->samples = 0;
+
+
+        /* This will call pr6120_can_establishLinks() */
+        if(CAN_DEVICE_establishLinks(pDev[ctrlNum], WNCAN_PR6120_CAN,
+            WNCAN_SJA1000) == ERROR)
+        {
+            pDev[ctrlNum] = 0;
+            goto exit;
+        }
+
+        /* Assign the device name and Id */
+        pDev[ctrlNum]->deviceName = PR6120_CAN_deviceName;
+        pDev[ctrlNum]->deviceId = (brdNum<<8) | ctrlNum;
+    }
+
+    /* mark as inUse */
+    pDeviceEntry->bus   = 0;
+    pDeviceEntry->dev   = 0;
+    pDeviceEntry->func  = 0;
+    pDeviceEntry->inUse = 1;
+    pDeviceEntry->intConnect = FALSE;
+
+    retCode = OK;
+
+exit:
+    return retCode;
+}
+
+
+/*******************************************************************
+ *  sys_PR6120_CAN_canOutByte - write a register of a simulated
+ *  controller
+ *
+ * RETURNS: NONE
+ *
+ * ERRNO: N/A
+ */
+void sys_PR6120_CAN_canOutByte
+(
+    struct WNCAN_Device *pDev,
+    unsigned int reg,
+    UCHAR value
+)
+{
+    int oldLevel;
+
+    oldLevel = intLock();
+    PR6120_CAN_SimWrite((struct PR6120_CAN_SimCtrl *) pDev->pCtrl->regWindow,
+                        reg, value);
+    intUnlock(oldLevel);
+}
+
+/*******************************************************************
+ *  sys_PR6120_CAN_canInByte - read a register of a simulated
+ *  controller
+ *
+ * RETURNS: UCHAR - The register contents
+ *
+ * ERRNO: N/A
+ */
+UCHAR sys_PR6120_CAN_canInByte
+(
+    struct WNCAN_Device *pDev,
+    unsigned int reg
+)
+{
+    UCHAR data;
+    int   oldLevel;
+
+    oldLevel = intLock();
+    data = PR6120_CAN_SimRead(
+        (struct PR6120_CAN_SimCtrl *) pDev->pCtrl->regWindow, reg);
+    intUnlock(oldLevel);
+
+    return(data);
+}
+
+/*******************************************************************
+ *  sys_PR6120_CAN_canReadFrame - read <len> consecutive registers
+ *  starting at <reg> of a simulated controller
+ *
+ * RETURNS: NONE
+ *
+ * ERRNO: N/A
+ */
+void sys_PR6120_CAN_canReadFrame
+(
+    struct WNCAN_Device *pDev,
+    unsigned int reg,
+    UCHAR *pBuf,
+    UINT len
+)
+{
+    struct PR6120_CAN_SimCtrl *pCtrl =
+        (struct PR6120_CAN_SimCtrl *) pDev->pCtrl->regWindow;
+    int   oldLevel;
+    UINT  i;
+
+    oldLevel = intLock();
+    for (i = 0; i < len; i++)
+        pBuf[i] = PR6120_CAN_SimRead(pCtrl, reg + i);
+    intUnlock(oldLevel);
+}
+
+/*******************************************************************
+ *  sys_PR6120_CAN_canWriteFrame - write <len> consecutive registers
+ *  starting at <reg> of a simulated controller
+ *
+ * RETURNS: NONE
+ *
+ * ERRNO: N/A
+ */
+void sys_PR6120_CAN_canWriteFrame
+(
+    struct WNCAN_Device *pDev,
+    unsigned int reg,
+    const UCHAR *pBuf,
+    UINT len
+)
+{
+    struct PR6120_CAN_SimCtrl *pCtrl =
+        (struct PR6120_CAN_SimCtrl *) pDev->pCtrl->regWindow;
+    int   oldLevel;
+    UINT  i;
+
+    oldLevel = intLock();
+    for (i = 0; i < len; i++)
+        PR6120_CAN_SimWrite(pCtrl, reg + i, pBuf[i]);
+    intUnlock(oldLevel);
+}
+
+/************************************************************************
+*
+* sys_PR6120_CAN_SimFaultSet - inject transmit errors
+*
+* While <fault> is TRUE every frame sent by the specified controller fails
+* with a bit error and is retried, which raises its transmit error counter
+* until the controller goes bus-off.
+*
+* RETURNS: OK, or ERROR if the board or controller does not exist
+*
+* ERRNO: S_can_illegal_board_no, S_can_illegal_ctrl_no
+*
+*/
+STATUS sys_PR6120_CAN_SimFaultSet
+(
+    UINT brdNum,
+    UINT ctrlNum,
+    BOOL fault
+)
+{
+    struct PR6120_CAN_DeviceEntry *pDE;
+    struct PR6120_CAN_SimCtrl     *pCtrl;
+
+    pDE = PR6120_CAN_DeviceEntryGet(brdNum);
+    if ((pDE == NULL) || (pDE->inUse == FALSE))
+    {
+        errnoSet(S_can_illegal_board_no);
+        return ERROR;
+    }
+
+    if (ctrlNum >= PR6120_CAN_MAX_CONTROLLERS)
+    {
+        errnoSet(S_can_illegal_ctrl_no);
+        return ERROR;
+    }
+
+    pCtrl = (struct PR6120_CAN_SimCtrl *)
+        pDE->canDevice[ctrlNum].pCtrl->regWindow;
+    pCtrl->fault = fault;
+
+    return OK;
+}
+
+/************************************************************************
+*
+* sys_PR6120_CAN_SimShow - display the counters of a simulated board
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+void sys_PR6120_CAN_SimShow
+(
+    UINT brdNum
+)
+{
+    struct PR6120_CAN_DeviceEntry *pDE;
+    struct PR6120_CAN_SimBus      *pBus;
+    struct PR6120_CAN_SimCtrl     *pCtrl;
+    UINT                           i;
+
+    pDE = PR6120_CAN_DeviceEntryGet(brdNum);
+    if ((pDE == NULL) || (pDE->inUse == FALSE))
+    {
+        printf("board %u not initialized\n", brdNum);
+        return;
+    }
+
+    pBus = ((struct PR6120_CAN_SimCtrl *)
+            pDE->canDevice[0].pCtrl->regWindow)->pBus;
+
+    printf("board %u: %lu frames, bus busy %llu us, %lu lagging runs\n",
+           brdNum, pBus->frames, pBus->busyTime / 1000, pBus->lagRuns);
+
+    for (i = 0; i < PR6120_CAN_MAX_CONTROLLERS; i++)
+    {
+        pCtrl = &pBus->ctrl[i];
+        printf("  ctrl %u: %s%s%s bit time %llu ns, txerr %u rxerr %u\n",
+               i, (pCtrl->mod & MOD_RM) ? "reset" : "operating",
+               pCtrl->busOff ? ", bus-off" : "",
+               pCtrl->fault ? ", fault" : "",
+               PR6120_CAN_SimBitTime(pCtrl), pCtrl->txErr, pCtrl->rxErr);
+        printf("          tx %lu rx %lu overruns %lu ack errors %lu "
+               "bit errors %lu arbitration lost %lu bus-off %lu\n",
+               pCtrl->txFrames, pCtrl->rxFramesTotal, pCtrl->rxOverruns,
+               pCtrl->ackErrors, pCtrl->bitErrors, pCtrl->arbLost,
+               pCtrl->busOffs);
+    }
+}
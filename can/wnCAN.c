@@ -22,12 +22,34 @@ wnCAN.h header file.
 /* includes */
 #include <vxWorks.h>
 #include <errnoLib.h>
+#include <stdlib.h>
+#include <intLib.h>
+#include <semLib.h>
+#include <sysLib.h>
+#include <taskLib.h>
+#include <tickLib.h>
 #include <CAN/wnCAN.h>
 
 #include <CAN/canBoard.h>
 #include <CAN/canController.h>
 #include <CAN/canFixedLL.h>
 
+/* bus-off recovery state of a device, see WNCAN_BusOffRecoverySet */
+struct WNCAN_BusOffRecovery
+{
+    struct WNCAN_Device *pDev;
+    WNCAN_BusOffCfg      cfg;
+    WNCAN_BusOffStats    stats;
+    void               (*pUserISR)(struct WNCAN_Device *pDev,
+                                   WNCAN_IntType intStatus, UCHAR chnNum);
+    SEM_ID               sem;       /* bus off seen, given by the ISR */
+    SEM_ID               exitSem;   /* the recovery task has exited */
+    int                  taskId;
+    volatile BOOL        stop;      /* recovery task to exit */
+    ULONG                offTick;   /* tick of the last bus off */
+    ULONG                onTick;    /* tick of the last recovery */
+};
+
 /* global variables */
 const static WNCAN_VersionInfo info = {1,3};
 
@@ -109,6 +131,7 @@ STATUS CAN_DEVICE_establishLinks
 
         /* set default isr callback */
         pDev->pISRCallback = defaultISRCallback;
+        pDev->pBusOff = NULL;
     }
     return retCode;
 }
@@ -135,6 +158,9 @@ STATUS CAN_InstallISRCallback
         errnoSet(S_can_invalid_parameter);
         return ERROR;
     }
+    else if(pDev->pBusOff != NULL)
+        /* the recovery engine sees the interrupts first */
+        pDev->pBusOff->pUserISR = pFun;
     else
         pDev->pISRCallback = pFun;
 
@@ -166,6 +192,8 @@ struct WNCAN_Device *WNCAN_Open
 *
 * WNCAN_Close - close the handle to the requested WNCAN_DEVICE
 *
+* Automatic bus-off recovery of the device is turned off.
+*
 * RETURNS: N/A
 *
 * ERRNO: N/A
@@ -177,8 +205,14 @@ void WNCAN_Close
 struct WNCAN_Device *pDev
 )
 {
+        WNCAN_BusOffCfg cfg = {FALSE};
+
         if(pDev != NULL)
+        {
+                if(pDev->pBusOff != NULL)
+                        WNCAN_BusOffRecoverySet(pDev, &cfg);
                 WNCAN_Board_Close(pDev);
+        }
 
     return;
 }
@@ -580,6 +614,346 @@ STATUS WNCAN_FreeChannel(struct WNCAN_Device *pDev, UCHAR channelNum)
 }
 
 
+/************************************************************************
+*
+* wncanMsToTicks - convert milliseconds to system clock ticks
+*
+* RETURNS: the number of ticks, rounded up
+*
+* ERRNO: N/A
+*
+*/
+static int wncanMsToTicks
+(
+    UINT ms
+)
+{
+    int rate = sysClkRateGet();
+
+    return (int)((ms / 1000) * rate + ((ms % 1000) * rate + 999) / 1000);
+}
+
+/************************************************************************
+*
+* wncanBusOffISR - interrupt callback of a device with bus-off recovery
+*
+* This routine is installed as the ISR callback while automatic bus-off
+* recovery is on. It hands a bus off to the recovery task, notes the
+* return to error active after a restart, and passes every interrupt on
+* to the callback installed by the application.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void wncanBusOffISR
+(
+    struct WNCAN_Device *pDev,
+    WNCAN_IntType        intStatus,
+    UCHAR                chnNum
+)
+{
+    struct WNCAN_BusOffRecovery *pRec = pDev->pBusOff;
+
+    switch(intStatus)
+    {
+    case WNCAN_INT_BUS_OFF:
+        if(pRec->stats.state == WNCAN_BUSOFF_ON_BUS)
+        {
+            pRec->stats.busOffs++;
+            pRec->stats.state = WNCAN_BUSOFF_WAIT;
+            pRec->offTick = tickGet();
+            semGive(pRec->sem);
+        }
+        break;
+
+    case WNCAN_INT_BUS_STATE:
+        /* the controller has seen the bus idle and is error active again,
+           also when it was restarted by the application */
+        if((pRec->stats.state != WNCAN_BUSOFF_ON_BUS) &&
+           (CAN_GetBusStatus(pDev) != WNCAN_BUS_OFF))
+        {
+            if(pRec->stats.state == WNCAN_BUSOFF_RECOVER)
+                pRec->stats.recoveries++;
+            pRec->stats.state = WNCAN_BUSOFF_ON_BUS;
+            pRec->onTick = tickGet();
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    (*pRec->pUserISR)(pDev, intStatus, chnNum);
+}
+
+/************************************************************************
+*
+* wncanBusOffTask - restart a controller that went bus off
+*
+* For each bus off this task waits the back-off delay, then restarts the
+* controller. The delay starts at minDelay and is doubled for each bus off
+* within stableTime of the last recovery, up to maxDelay. It is never
+* shorter than WNCAN_BUSOFF_RECESSIVE bit times, so controllers that do
+* not count the recessive bits themselves still leave the bus idle for
+* that long; the SJA1000 counts them again after the restart and only
+* then signals the return to error active.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void wncanBusOffTask
+(
+    struct WNCAN_BusOffRecovery *pRec
+)
+{
+    struct WNCAN_Device *pDev = pRec->pDev;
+    int                  timeout = WAIT_FOREVER;
+    STATUS               given;
+    UINT                 delay;
+    UINT                 baud;
+    UINT                 samplePoint;
+    int                  idle;
+    UINT                 i;
+    int                  key;
+
+    for(;;)
+    {
+        given = semTake(pRec->sem, timeout);
+        if(pRec->stop)
+            break;
+
+        if(given == OK)
+        {
+            /* a bus off, a new one if the delay of the last was running */
+            if((pRec->offTick - pRec->onTick) >= 
+               (ULONG)wncanMsToTicks(pRec->cfg.stableTime))
+                pRec->stats.backoff = 0;
+
+            delay = pRec->cfg.minDelay;
+            for(i = 0; i < pRec->stats.backoff; i++)
+                delay = (delay > pRec->cfg.maxDelay / 2) ? 
+                        pRec->cfg.maxDelay : delay * 2;
+            if(delay < pRec->cfg.maxDelay)
+                pRec->stats.backoff++;
+            pRec->stats.delay = delay;
+
+            timeout = wncanMsToTicks(delay);
+            baud = CAN_GetBaudRate(pDev, &samplePoint);
+            if(baud != 0)
+            {
+                idle = (int)((WNCAN_BUSOFF_RECESSIVE * sysClkRateGet() + 
+                              baud - 1) / baud);
+                if(timeout < idle)
+                    timeout = idle;
+            }
+            if(timeout == 0)
+                timeout = 1;
+            continue;
+        }
+
+        /* the delay has passed */
+        timeout = WAIT_FOREVER;
+
+        key = intLock();
+        if(pRec->stats.state != WNCAN_BUSOFF_WAIT)
+        {
+            intUnlock(key);
+            continue;
+        }
+        pRec->stats.state = WNCAN_BUSOFF_RECOVER;
+        pRec->stats.restarts++;
+        intUnlock(key);
+
+        if(pRec->cfg.txPolicy == WNCAN_BUSOFF_TX_FLUSH)
+            CAN_TxAbort(pDev);
+        CAN_Start(pDev);
+    }
+
+    semGive(pRec->exitSem);
+}
+
+/************************************************************************
+*
+* wncanBusOffFree - release the bus-off recovery state of a device
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+static void wncanBusOffFree
+(
+    struct WNCAN_BusOffRecovery *pRec
+)
+{
+    if(pRec->sem != NULL)
+        semDelete(pRec->sem);
+    if(pRec->exitSem != NULL)
+        semDelete(pRec->exitSem);
+    free(pRec);
+}
+
+/************************************************************************
+*
+* WNCAN_BusOffRecoverySet - configure automatic bus-off recovery
+*
+* With pCfg->enable TRUE this routine starts a task of priority
+* WNCAN_BUSOFF_PRIORITY that restarts the controller after each bus off,
+* see wncanBusOffTask(), and installs an ISR callback in front of the one
+* of the application to report bus offs to it. Called again while the
+* recovery is on, it only changes the configuration, which is used from the
+* next bus off on. A controller that is already bus off is recovered at
+* once. With pCfg->enable FALSE the task is stopped and the callback of
+* the application is reinstalled.
+*
+* The TX policy is applied to the frame pending in the controller, which
+* is aborted before the restart with WNCAN_BUSOFF_TX_FLUSH; the DevIO
+* driver applies it to its output buffers.
+*
+* RETURNS: OK, or ERROR
+*
+* ERRNO: S_can_invalid_parameter, S_can_out_of_memory
+*
+*/
+STATUS WNCAN_BusOffRecoverySet
+(
+    struct WNCAN_Device *pDev,
+    WNCAN_BusOffCfg     *pCfg
+)
+{
+    struct WNCAN_BusOffRecovery *pRec;
+    int                          key;
+
+    if((pDev == NULL) || (pCfg == NULL) ||
+       (pCfg->enable && ((pCfg->minDelay == 0) ||
+                         (pCfg->maxDelay < pCfg->minDelay) ||
+                         ((pCfg->txPolicy != WNCAN_BUSOFF_TX_KEEP) &&
+                          (pCfg->txPolicy != WNCAN_BUSOFF_TX_FLUSH)))))
+    {
+        errnoSet(S_can_invalid_parameter);
+        return ERROR;
+    }
+
+    pRec = pDev->pBusOff;
+
+    if(!pCfg->enable)
+    {
+        if(pRec == NULL)
+            return OK;
+
+        key = intLock();
+        pDev->pISRCallback = pRec->pUserISR;
+        pDev->pBusOff = NULL;
+        intUnlock(key);
+
+        pRec->stop = TRUE;
+        semGive(pRec->sem);
+        semTake(pRec->exitSem, WAIT_FOREVER);
+        wncanBusOffFree(pRec);
+        return OK;
+    }
+
+    if(pRec != NULL)
+    {
+        key = intLock();
+        pRec->cfg = *pCfg;
+        intUnlock(key);
+        return OK;
+    }
+
+    pRec = (struct WNCAN_BusOffRecovery *)calloc(1, sizeof(*pRec));
+    if(pRec == NULL)
+    {
+        errnoSet(S_can_out_of_memory);
+        return ERROR;
+    }
+
+    pRec->pDev = pDev;
+    pRec->cfg = *pCfg;
+    pRec->stats.state = WNCAN_BUSOFF_ON_BUS;
+    pRec->onTick = tickGet();
+    pRec->sem = semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+    pRec->exitSem = semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+    if((pRec->sem == NULL) || (pRec->exitSem == NULL))
+    {
+        wncanBusOffFree(pRec);
+        errnoSet(S_can_out_of_memory);
+        return ERROR;
+    }
+
+    pRec->taskId = taskSpawn("tCanBusOff", WNCAN_BUSOFF_PRIORITY, 0,
+                             WNCAN_BUSOFF_STACK,
+                             (FUNCPTR)wncanBusOffTask, (int)pRec,
+                             0, 0, 0, 0, 0, 0, 0, 0, 0);
+    if(pRec->taskId == ERROR)
+    {
+        wncanBusOffFree(pRec);
+        return ERROR;
+    }
+
+    key = intLock();
+    pRec->pUserISR = pDev->pISRCallback;
+    pDev->pBusOff = pRec;
+    pDev->pISRCallback = wncanBusOffISR;
+    if(CAN_GetBusStatus(pDev) == WNCAN_BUS_OFF)
+    {
+        pRec->stats.busOffs++;
+        pRec->stats.state = WNCAN_BUSOFF_WAIT;
+        pRec->offTick = pRec->onTick;
+        semGive(pRec->sem);
+    }
+    intUnlock(key);
+
+    return OK;
+}
+
+/************************************************************************
+*
+* WNCAN_BusOffRecoveryGet - get the bus-off recovery configuration and counts
+*
+* This routine copies the configuration to pCfg and the state and counters
+* to pStats; either may be NULL.
+*
+* RETURNS: OK, or ERROR if automatic recovery is off
+*
+* ERRNO: S_can_invalid_parameter, S_can_no_op
+*
+*/
+STATUS WNCAN_BusOffRecoveryGet
+(
+    struct WNCAN_Device *pDev,
+    WNCAN_BusOffCfg     *pCfg,
+    WNCAN_BusOffStats   *pStats
+)
+{
+    int key;
+
+    if(pDev == NULL)
+    {
+        errnoSet(S_can_invalid_parameter);
+        return ERROR;
+    }
+
+    key = intLock();
+    if(pDev->pBusOff == NULL)
+    {
+        intUnlock(key);
+        errnoSet(S_can_no_op);
+        return ERROR;
+    }
+    if(pCfg != NULL)
+        *pCfg = pDev->pBusOff->cfg;
+    if(pStats != NULL)
+        *pStats = pDev->pBusOff->stats;
+    intUnlock(key);
+
+    return OK;
+}
+
 
 /************************************************************************
 *
@@ -24,6 +24,9 @@ CAN drivers
 #include <CAN/canBoard.h>
 #include <CAN/canController.h>
 #include <CAN/canFixedLL.h>
+#ifdef INCLUDE_WNCAN_DEVIO
+#include <CAN/wncanDevIO.h>
+#endif
 
 
 /************************************************************************
@@ -49,5 +52,10 @@ void WNCAN_Show(void)
 	    (*pBoardNode->nodedata.boarddata.show_fn)();
     }
 
+#ifdef INCLUDE_WNCAN_DEVIO
+    /* per-device and per-channel DevIO counters */
+    wncDevIOShow();
+#endif
+
     return;
 }
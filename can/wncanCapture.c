@@ -0,0 +1,753 @@
+/* wncanCapture.c - CAN bus capture and replay */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+This file records the frames received on a DevIO channel to a binary file,
+in the format defined in wncanCapture.h, and plays such a file back to a
+DevIO channel.
+
+wncCaptureStart() opens the channel as one more reader, so the capture
+neither takes frames from nor changes the filters of the applications
+reading it; it should have no software filter of its own, so the
+hardware acceptance filter passes every frame. The frames are read with
+their receive timestamps by a reader task into one of two buffers, and a
+writer task of lower priority writes full buffers to the file. The reader
+never waits for the file: when both buffers are full the frames are
+counted and recorded as lost, and the receive interrupt only ever sees
+the reader's DevIO input buffer. A buffer that is not full is written
+after the channel has been idle for WNCAN_CAP_IDLE_MS, or at least once a
+second.
+
+Frames the local controller transmits are not received by it and are
+therefore not in the capture.
+
+wncCaptureReplay() writes the frames of a capture to a channel through
+write(), either as fast as the channel takes them or with the intervals
+they were received with, to the resolution of the system clock. Remote
+frames are selected per channel with WNCAN_CHNCONFIG_SET, so the replay
+waits for the output buffer to drain whenever a remote frame follows a
+data frame, or the reverse.
+
+INCLUDE FILES
+
+  CAN/wncanCapture.h
+*/
+
+/* includes */
+
+#include <vxWorks.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errnoLib.h>
+#include <ioLib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <taskLib.h>
+#include <tickLib.h>
+#include <sysLib.h>
+#include <selectLib.h>
+#include <semLib.h>
+#include <CAN/wnCAN.h>
+#include <CAN/wncanDevIO.h>
+#include <CAN/wncanCapture.h>
+
+/* frames moved per read() and write() */
+#define WNCAN_CAP_IO_MAX     64
+
+/* DevIO input buffer of the capture, #msgs */
+#define WNCAN_CAP_RBUF_MSGS  512
+
+/* a partly filled buffer is written after this much idle time */
+#define WNCAN_CAP_IDLE_MS    200
+
+/* locals */
+
+LOCAL void   wncUtilCapReader (WNCAN_CAPTURE_ID cap);
+LOCAL void   wncUtilCapWriter (WNCAN_CAPTURE_ID cap);
+LOCAL BOOL   wncUtilCapHandover (WNCAN_CAPTURE_ID cap);
+LOCAL WNCAN_CAPREC *wncUtilCapNext (WNCAN_CAPTURE_ID cap);
+LOCAL void   wncUtilCapFrame (WNCAN_CAPTURE_ID cap, WNCAN_CHNMSG_TS *pMsg);
+LOCAL void   wncUtilCapFree (WNCAN_CAPTURE_ID cap);
+LOCAL STATUS wncUtilCapSend (int fd, WNCAN_CHNMSG *pMsgs, int numMsgs);
+LOCAL STATUS wncUtilCapDrain (int fd);
+LOCAL STATUS wncUtilCapRtrSet (int fd, BOOL rtr);
+
+
+/************************************************************************
+*
+* wncCaptureStart - start recording a DevIO channel to a file
+*
+* This routine opens the DevIO channel "chnName", e.g. "/can/0/1", for
+* reading, creates the capture file "fileName" and starts the reader and
+* writer tasks. "bufRecs" is the number of records of each of the two
+* buffers, 0 for WNCAN_CAP_DEF_RECS; one buffer should hold the frames of
+* the longest stall of the file system. The device must be started, as
+* the capture does not change its configuration.
+*
+* RETURNS: ID of the capture, or NULL on error
+*
+* ERRNO: S_can_out_of_memory
+*
+*/
+
+WNCAN_CAPTURE_ID wncCaptureStart
+(
+ char  *chnName,    /* DevIO channel to record */
+ char  *fileName,   /* capture file to create */
+ UINT   bufRecs     /* records per buffer, 0 for the default */
+ )
+{
+    WNCAN_CAPTURE_ID  cap;
+    WNCAN_MSGFMT      msgFmt;
+    WNCAN_CAPHDR      hdr;
+
+    if ((chnName == NULL) || (fileName == NULL))
+    {
+        errnoSet (S_can_invalid_parameter);
+        return NULL;
+    }
+
+    if (bufRecs == 0)
+        bufRecs = WNCAN_CAP_DEF_RECS;
+
+    cap = (WNCAN_CAPTURE_ID) calloc (1, sizeof(WNCAN_CAPTURE));
+    if (cap == NULL)
+    {
+        errnoSet (S_can_out_of_memory);
+        return NULL;
+    }
+
+    cap->fdChn = ERROR;
+    cap->fdFile = ERROR;
+    cap->bufRecs = bufRecs;
+    cap->buf[0] = (WNCAN_CAPREC *) malloc (bufRecs * sizeof(WNCAN_CAPREC));
+    cap->buf[1] = (WNCAN_CAPREC *) malloc (bufRecs * sizeof(WNCAN_CAPREC));
+    cap->fullSem = semBCreate (SEM_Q_PRIORITY, SEM_EMPTY);
+    cap->doneSem = semCCreate (SEM_Q_PRIORITY, 0);
+    if ((cap->buf[0] == NULL) || (cap->buf[1] == NULL) ||
+        (cap->fullSem == NULL) || (cap->doneSem == NULL))
+    {
+        errnoSet (S_can_out_of_memory);
+        wncUtilCapFree (cap);
+        return NULL;
+    }
+
+    /* the timestamped read format gives the receive time and the sequence
+    ** numbers that show frames lost in the input buffer
+    */
+    cap->fdChn = open (chnName, O_RDONLY, 0);
+    if (cap->fdChn == ERROR)
+    {
+        wncUtilCapFree (cap);
+        return NULL;
+    }
+
+    msgFmt.format = WNCAN_MSGFMT_TS;
+    msgFmt.txFormat = WNCAN_MSGFMT_STD;
+    if ((ioctl (cap->fdChn, WNCAN_CHNMSGFMT_SET, (int) &msgFmt) != OK) ||
+        (ioctl (cap->fdChn, WNCAN_CHNMSGFMT_GET, (int) &msgFmt) != OK))
+    {
+        wncUtilCapFree (cap);
+        return NULL;
+    }
+    ioctl (cap->fdChn, FIORBUFSET, WNCAN_CAP_RBUF_MSGS);
+    ioctl (cap->fdChn, WNCAN_CHN_ENABLE, TRUE);
+
+    cap->fdFile = open (fileName, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    if (cap->fdFile == ERROR)
+    {
+        wncUtilCapFree (cap);
+        return NULL;
+    }
+
+    memset (&hdr, 0, sizeof(hdr));
+    hdr.magic = WNCAN_CAP_MAGIC;
+    hdr.version = WNCAN_CAP_VERSION;
+    hdr.recSize = sizeof(WNCAN_CAPREC);
+    hdr.tsFreq = msgFmt.tsFreq;
+    if (write (cap->fdFile, (char *) &hdr, sizeof(hdr)) != sizeof(hdr))
+    {
+        wncUtilCapFree (cap);
+        return NULL;
+    }
+
+    cap->wrTask = taskSpawn ("tWncCapWr", WNCAN_CAP_WR_PRIORITY, 0,
+        WNCAN_CAP_STACK_SIZE, (FUNCPTR) wncUtilCapWriter, (int) cap,
+        0,0,0,0,0,0,0,0,0);
+    if (cap->wrTask == ERROR)
+    {
+        wncUtilCapFree (cap);
+        return NULL;
+    }
+
+    cap->rxTask = taskSpawn ("tWncCapRx", WNCAN_CAP_RX_PRIORITY, 0,
+        WNCAN_CAP_STACK_SIZE, (FUNCPTR) wncUtilCapReader, (int) cap,
+        0,0,0,0,0,0,0,0,0);
+    if (cap->rxTask == ERROR)
+    {
+        cap->wrStop = TRUE;
+        semGive (cap->fullSem);
+        semTake (cap->doneSem, WAIT_FOREVER);
+        wncUtilCapFree (cap);
+        return NULL;
+    }
+
+    return cap;
+}
+
+
+/************************************************************************
+*
+* wncCaptureStop - stop a capture and close its file
+*
+* This routine stops the reader task, waits until the writer task has
+* written the frames read so far and releases the capture. "cap" must not
+* be used afterwards.
+*
+* RETURNS: OK, or ERROR if a buffer could not be written to the file
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS wncCaptureStop
+(
+ WNCAN_CAPTURE_ID  cap   /* capture to stop */
+ )
+{
+    STATUS  status;
+
+    if (cap == NULL)
+        return ERROR;
+
+    cap->rxStop = TRUE;
+    semTake (cap->doneSem, WAIT_FOREVER);
+
+    cap->wrStop = TRUE;
+    semGive (cap->fullSem);
+    semTake (cap->doneSem, WAIT_FOREVER);
+
+    status = (cap->writeErrors == 0) ? OK : ERROR;
+    wncUtilCapFree (cap);
+    return status;
+}
+
+
+/************************************************************************
+*
+* wncCaptureShow - display the counters of a capture
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncCaptureShow
+(
+ WNCAN_CAPTURE_ID  cap   /* capture to show */
+ )
+{
+    if (cap == NULL)
+        return;
+
+    printf("\tFrames recorded: %lu\n", cap->frames);
+    printf("\tFrames lost: %lu in the input buffer, %lu buffers full\n",
+        cap->lost, cap->overruns);
+    printf("\tBuffers written: %lu, write errors: %lu\n", cap->flushes,
+        cap->writeErrors);
+}
+
+
+/************************************************************************
+*
+* wncCaptureReplay - play a capture file back to a DevIO channel
+*
+* This routine writes the frames of the capture file "fileName" to the
+* DevIO channel "chnName", which it opens for writing. With "timed" TRUE
+* each frame is written when as much time has passed since the first one
+* as passed between them when they were received, to one system clock
+* tick; otherwise the frames are written as fast as the channel takes
+* them. The routine returns when the last frame has been passed to the
+* controller, as closing the channel drops the frames still in its output
+* buffer. A partial record at the end of a capture that was cut short is
+* ignored.
+*
+* RETURNS: OK, or ERROR if the file is not a capture or cannot be played
+*
+* ERRNO: S_can_invalid_parameter
+*
+*/
+
+STATUS wncCaptureReplay
+(
+ char  *fileName,   /* capture file to play */
+ char  *chnName,    /* DevIO channel to write */
+ BOOL   timed       /* keep the intervals between frames */
+ )
+{
+    WNCAN_CAPHDR   hdr;
+    WNCAN_CAPREC   recs[WNCAN_CAP_IO_MAX];
+    WNCAN_CHNMSG   msgs[WNCAN_CAP_IO_MAX];
+    WNCAN_CAPREC  *pRec;
+    BOOL           rtr = FALSE;
+    BOOL           first = TRUE;
+    UINT64         firstStamp = 0;
+    ULONG          startTick = 0;
+    ULONG          due;
+    int            clkRate = sysClkRateGet();
+    int            fdFile;
+    int            fdChn = ERROR;
+    int            numBytes;
+    int            numRecs;
+    int            partial = 0;
+    int            numMsgs = 0;
+    int            i;
+    STATUS         status = ERROR;
+
+    fdFile = open (fileName, O_RDONLY, 0);
+    if (fdFile == ERROR)
+        return ERROR;
+
+    if ((read (fdFile, (char *) &hdr, sizeof(hdr)) != sizeof(hdr)) ||
+        (hdr.magic != WNCAN_CAP_MAGIC) ||
+        (hdr.version != WNCAN_CAP_VERSION) ||
+        (hdr.recSize != sizeof(WNCAN_CAPREC)) || (hdr.tsFreq == 0))
+    {
+        errnoSet (S_can_invalid_parameter);
+        goto done;
+    }
+
+    fdChn = open (chnName, O_WRONLY, 0);
+    if ((fdChn == ERROR) || (wncUtilCapRtrSet (fdChn, FALSE) != OK))
+        goto done;
+    ioctl (fdChn, WNCAN_CHN_ENABLE, TRUE);
+
+    /* a read may end inside a record, whose start is kept for the next */
+    while ((numBytes = read (fdFile, (char *) recs + partial,
+                             sizeof(recs) - partial)) > 0)
+    {
+        numBytes += partial;
+        numRecs = numBytes / sizeof(WNCAN_CAPREC);
+        partial = numBytes - numRecs * sizeof(WNCAN_CAPREC);
+        for (i = 0, pRec = recs; i < numRecs; i++, pRec++)
+        {
+            if (pRec->flags & WNCAN_CAP_LOST)
+                continue;
+
+            if (timed)
+            {
+                if (first)
+                {
+                    first = FALSE;
+                    firstStamp = pRec->timeStamp;
+                    startTick = tickGet();
+                }
+
+                /* send what is due before waiting for the next frame */
+                due = startTick + (ULONG) ((pRec->timeStamp - firstStamp) *
+                    clkRate / hdr.tsFreq);
+                if ((long) (due - tickGet()) > 0)
+                {
+                    if (wncUtilCapSend (fdChn, msgs, numMsgs) != OK)
+                        goto done;
+                    numMsgs = 0;
+                    taskDelay ((int) (due - tickGet()));
+                }
+            }
+
+            if (((pRec->flags & WNCAN_CAP_RTR) != 0) != rtr)
+            {
+                /* the frames queued so far go out with the old setting */
+                if (wncUtilCapSend (fdChn, msgs, numMsgs) != OK)
+                    goto done;
+                numMsgs = 0;
+
+                rtr = !rtr;
+                if (wncUtilCapRtrSet (fdChn, rtr) != OK)
+                    goto done;
+            }
+
+            msgs[numMsgs].id = pRec->id;
+            msgs[numMsgs].extId = (pRec->flags & WNCAN_CAP_EXT) ? TRUE : FALSE;
+            msgs[numMsgs].rtr = rtr;
+            msgs[numMsgs].len = pRec->len;
+            memcpy (msgs[numMsgs].data, pRec->data, WNCAN_MAX_DATA_LEN);
+            numMsgs++;
+        }
+
+        if (wncUtilCapSend (fdChn, msgs, numMsgs) != OK)
+            goto done;
+        numMsgs = 0;
+
+        if (partial != 0)
+            memmove ((char *) recs, (char *) &recs[numRecs], partial);
+    }
+
+    /* a partial record at the end of a truncated capture is ignored */
+    if (numBytes == 0)
+        status = wncUtilCapDrain (fdChn);
+
+done:
+    if (fdChn != ERROR)
+        close (fdChn);
+    close (fdFile);
+    return status;
+}
+
+
+/************************************************************************
+*
+* wncUtilCapReader - reader task of a capture
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilCapReader
+(
+ WNCAN_CAPTURE_ID  cap
+ )
+{
+    WNCAN_CHNMSG_TS  msgs[WNCAN_CAP_IO_MAX];
+    fd_set           readFds;
+    struct timeval   timeout;
+    ULONG            lastFlush = tickGet();
+    int              numMsgs;
+    int              i;
+
+    while (!cap->rxStop)
+    {
+        FD_ZERO (&readFds);
+        FD_SET (cap->fdChn, &readFds);
+        timeout.tv_sec = 0;
+        timeout.tv_usec = WNCAN_CAP_IDLE_MS * 1000;
+
+        /* an idle bus is a good time to write what has been read */
+        if (select (cap->fdChn + 1, &readFds, NULL, NULL, &timeout) <= 0)
+        {
+            if (wncUtilCapHandover (cap))
+                lastFlush = tickGet();
+            continue;
+        }
+
+        numMsgs = read (cap->fdChn, (char *) msgs, sizeof(msgs));
+        if (numMsgs <= 0)
+            continue;
+
+        numMsgs /= sizeof(WNCAN_CHNMSG_TS);
+        for (i = 0; i < numMsgs; i++)
+            wncUtilCapFrame (cap, &msgs[i]);
+
+        if ((tickGet() - lastFlush) >= (ULONG) sysClkRateGet())
+        {
+            if (wncUtilCapHandover (cap))
+                lastFlush = tickGet();
+        }
+    }
+
+    /* hand the rest to the writer once it has a buffer free */
+    while (!wncUtilCapHandover (cap))
+        taskDelay (1);
+
+    semGive (cap->doneSem);
+}
+
+
+/************************************************************************
+*
+* wncUtilCapWriter - file writer task of a capture
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilCapWriter
+(
+ WNCAN_CAPTURE_ID  cap
+ )
+{
+    int  numBytes;
+
+    for (;;)
+    {
+        semTake (cap->fullSem, WAIT_FOREVER);
+
+        /* the buffers are handed over, and written, in turn */
+        while (cap->busy[cap->drain])
+        {
+            numBytes = cap->count[cap->drain] * sizeof(WNCAN_CAPREC);
+            if (write (cap->fdFile, (char *) cap->buf[cap->drain], numBytes) !=
+                numBytes)
+                cap->writeErrors++;
+            cap->flushes++;
+
+            cap->count[cap->drain] = 0;
+            cap->busy[cap->drain] = FALSE;
+            cap->drain ^= 1;
+        }
+
+        if (cap->wrStop)
+            break;
+    }
+
+    semGive (cap->doneSem);
+}
+
+
+/************************************************************************
+*
+* wncUtilCapHandover - pass the buffer being filled to the writer
+*
+* This routine hands the buffer the reader fills to the writer task, if
+* it holds any records, and continues with the other buffer. It fails if
+* the writer still has the other buffer.
+*
+* RETURNS: TRUE if the buffer was handed over or is empty, else FALSE
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL BOOL wncUtilCapHandover
+(
+ WNCAN_CAPTURE_ID  cap
+ )
+{
+    if (cap->count[cap->fill] == 0)
+        return TRUE;
+
+    if (cap->busy[cap->fill ^ 1])
+        return FALSE;
+
+    cap->busy[cap->fill] = TRUE;
+    cap->fill ^= 1;
+    semGive (cap->fullSem);
+    return TRUE;
+}
+
+
+/************************************************************************
+*
+* wncUtilCapNext - get the next free record
+*
+* RETURNS: pointer to the record, or NULL if both buffers are full
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL WNCAN_CAPREC *wncUtilCapNext
+(
+ WNCAN_CAPTURE_ID  cap
+ )
+{
+    if ((cap->count[cap->fill] == cap->bufRecs) && !wncUtilCapHandover (cap))
+        return NULL;
+
+    return &cap->buf[cap->fill][cap->count[cap->fill]++];
+}
+
+
+/************************************************************************
+*
+* wncUtilCapFrame - record a received frame
+*
+* This routine records the frames lost since the previous one, as counted
+* by the DevIO sequence numbers or by the capture itself, and then the
+* frame. A frame that finds both buffers full is counted as lost.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilCapFrame
+(
+ WNCAN_CAPTURE_ID  cap,
+ WNCAN_CHNMSG_TS  *pMsg
+ )
+{
+    WNCAN_CAPREC  *pRec;
+
+    if (cap->seqValid && (pMsg->seqNum != cap->nextSeq))
+    {
+        cap->lost += pMsg->seqNum - cap->nextSeq;
+        cap->lostPending += pMsg->seqNum - cap->nextSeq;
+    }
+    cap->nextSeq = pMsg->seqNum + 1;
+    cap->seqValid = TRUE;
+
+    if (cap->lostPending != 0)
+    {
+        pRec = wncUtilCapNext (cap);
+        if (pRec != NULL)
+        {
+            memset (pRec, 0, sizeof(*pRec));
+            pRec->timeStamp = pMsg->timeStamp;
+            pRec->id = cap->lostPending;
+            pRec->flags = WNCAN_CAP_LOST;
+            cap->lostPending = 0;
+        }
+    }
+
+    pRec = wncUtilCapNext (cap);
+    if (pRec == NULL)
+    {
+        cap->overruns++;
+        cap->lostPending++;
+        return;
+    }
+
+    pRec->timeStamp = pMsg->timeStamp;
+    pRec->id = pMsg->msg.id;
+    pRec->flags = (pMsg->msg.extId ? WNCAN_CAP_EXT : 0) |
+        (pMsg->msg.rtr ? WNCAN_CAP_RTR : 0);
+    pRec->len = pMsg->msg.len;
+    memcpy (pRec->data, pMsg->msg.data, WNCAN_MAX_DATA_LEN);
+    pRec->pad[0] = pRec->pad[1] = 0;
+    cap->frames++;
+}
+
+
+/************************************************************************
+*
+* wncUtilCapFree - release a capture
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilCapFree
+(
+ WNCAN_CAPTURE_ID  cap
+ )
+{
+    if (cap->fdChn != ERROR)
+        close (cap->fdChn);
+    if (cap->fdFile != ERROR)
+        close (cap->fdFile);
+    if (cap->fullSem != NULL)
+        semDelete (cap->fullSem);
+    if (cap->doneSem != NULL)
+        semDelete (cap->doneSem);
+    free (cap->buf[0]);
+    free (cap->buf[1]);
+    free (cap);
+}
+
+
+/************************************************************************
+*
+* wncUtilCapSend - write frames to a channel, waiting for room
+*
+* RETURNS: OK, or ERROR if the channel fails
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL STATUS wncUtilCapSend
+(
+ int            fd,
+ WNCAN_CHNMSG  *pMsgs,
+ int            numMsgs
+ )
+{
+    fd_set         writeFds;
+    int            numBytes;
+
+    while (numMsgs > 0)
+    {
+        numBytes = write (fd, (char *) pMsgs, numMsgs * sizeof(WNCAN_CHNMSG));
+        if (numBytes == ERROR)
+        {
+            if (errnoGet() != S_can_buffer_overflow)
+                return ERROR;
+
+            FD_ZERO (&writeFds);
+            FD_SET (fd, &writeFds);
+            if (select (fd + 1, NULL, &writeFds, NULL, NULL) == ERROR)
+                return ERROR;
+            continue;
+        }
+
+        pMsgs += numBytes / sizeof(WNCAN_CHNMSG);
+        numMsgs -= numBytes / sizeof(WNCAN_CHNMSG);
+    }
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* wncUtilCapDrain - wait until the output buffer of a channel is empty
+*
+* RETURNS: OK, or ERROR if the channel fails
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL STATUS wncUtilCapDrain
+(
+ int   fd
+ )
+{
+    int  numBytes;
+
+    for (;;)
+    {
+        if (ioctl (fd, FIONWRITE, (int) &numBytes) != OK)
+            return ERROR;
+        if (numBytes == 0)
+            return OK;
+        taskDelay (1);
+    }
+}
+
+
+/************************************************************************
+*
+* wncUtilCapRtrSet - select data or remote frames on a channel
+*
+* This routine waits until the frames written to the channel have been
+* passed to the controller, which sends them with the current setting,
+* and then changes the setting.
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL STATUS wncUtilCapRtrSet
+(
+ int   fd,
+ BOOL  rtr
+ )
+{
+    WNCAN_CHNCONFIG  chnCfg;
+
+    if (wncUtilCapDrain (fd) != OK)
+        return ERROR;
+
+    chnCfg.flags = WNCAN_CHNCFG_RTR;
+    chnCfg.rtr = rtr;
+    return ioctl (fd, WNCAN_CHNCONFIG_SET, (int) &chnCfg);
+}
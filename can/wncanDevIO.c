@@ -31,7 +31,15 @@ in the wncanDevIO.h header file.
 #include <stdio.h>
 #include <CAN/wnCAN.h>
 #include <CAN/wncanDevIO.h>
+#include <CAN/wncanRing.h>
+#include <CAN/wncanFilter.h>
+#include <CAN/wncanTxQueue.h>
 #include <intLib.h>
+#include <tickLib.h>
+#include <sysLib.h>
+#include <wdLib.h>
+#include <taskLib.h>
+#include <drv/timer/timestampDev.h>
 
 #ifndef _WRS_VXWORKS_5_X
 #include <memLib.h>
@@ -49,15 +57,41 @@ in the wncanDevIO.h header file.
 
 LOCAL int wncDevIODrvNum = 0;     /* driver number assigned to this driver */
 LOCAL int wncDevDrvInstance = 0;  /* # times wncDevIODevCreate() called */
+LOCAL WNCAN_DEVIO_DRVINFO *wncDevIODevList = NULL;  /* created devices */
 
 /* local prototypes */
-LOCAL int wncUtilCalcRingBufSize(int numCanMsgs);
 LOCAL STATUS wncUtilIoctlFioCmds(WNCAN_DEVIO_FDINFO*,int,int);
 LOCAL STATUS wncUtilIoctlDeviceFioCmds(WNCAN_DEVIO_FDINFO*,int,int);
 LOCAL STATUS wncUtilIoctlChannelCmds(WNCAN_DEVIO_FDINFO*,int,int);
 LOCAL STATUS wncUtilIoctlCtlrCmds(WNCAN_DEVIO_FDINFO*,int,int);
 LOCAL STATUS wncUtilIoctlDeviceCmds(WNCAN_DEVIO_FDINFO*,int,int);
+LOCAL STATUS wncUtilIoctlStatsCmds(WNCAN_DEVIO_FDINFO*,int,int);
 LOCAL void wncDevIOIsrHandler(struct WNCAN_Device*,WNCAN_IntType,UCHAR);
+LOCAL UINT64 wncUtilTimestamp(void);
+LOCAL char *wncUtilRxReserve(WNCAN_DEVIO_FDINFO*,ULONG,BOOL);
+LOCAL void wncUtilRxPublish(WNCAN_DEVIO_FDINFO*,char*,UINT64);
+LOCAL void wncUtilRxWakeup(WNCAN_DEVIO_FDINFO*);
+LOCAL void wncUtilRxLatencyExpired(WNCAN_DEVIO_FDINFO*);
+LOCAL void wncUtilAcceptUpdate(WNCAN_DEVIO_DRVINFO*);
+LOCAL void wncUtilTxPump(struct WNCAN_Device*,WNCAN_DEVIO_FDINFO*,UCHAR,BOOL);
+LOCAL WNCAN_CHNMSG *wncUtilTxNext(WNCAN_DEVIO_FDINFO*,UINT64*);
+LOCAL void wncUtilTxRemove(WNCAN_DEVIO_FDINFO*);
+LOCAL void wncUtilTxDeadlineStart(WNCAN_DEVIO_FDINFO*,UINT64);
+LOCAL void wncUtilTxDeadlineExpired(WNCAN_DEVIO_FDINFO*);
+LOCAL void wncUtilTxRestart(struct WNCAN_Device*,WNCAN_DEVIO_FDINFO*);
+LOCAL void wncUtilTxLost(WNCAN_DEVIO_FDINFO*);
+LOCAL void wncUtilRxStage(struct WNCAN_Device*,WNCAN_DEVIO_FDINFO*,UCHAR,UINT64);
+LOCAL void wncUtilRxDeferDrain(WNCAN_DEVIO_FDINFO*);
+LOCAL void wncUtilRxDeferTask(WNCAN_DEVIO_FDINFO*);
+LOCAL void wncUtilRxDeferStop(WNCAN_DEVIO_FDINFO*);
+LOCAL STATUS wncUtilRxDeferSet(WNCAN_DEVIO_FDINFO*,WNCAN_RXDEFER*);
+LOCAL void wncUtilIsrHistAdd(WNCAN_DEVIO_FDINFO*,UINT64);
+LOCAL WNCAN_BusError wncUtilEventPost(struct WNCAN_Device*,WNCAN_DEVIO_FDINFO*,UINT);
+LOCAL void wncUtilBusOffTx(struct WNCAN_Device*,WNCAN_DEVIO_FDINFO*,WNCAN_IntType);
+
+/* receive timestamp source and its frequency, see wncDevIOTimestampSet() */
+LOCAL WNCAN_TSFUNC wncDevIOTsFunc = wncUtilTimestamp;
+LOCAL UINT32 wncDevIOTsFreq = 0;  /* 0: sysTimestampFreq() */
 
 /* memory allocation for 5.5 and AE are different */
 #ifdef _WRS_KERNEL 
@@ -89,6 +123,14 @@ WNCDEV_PUT_DEVICEINFO(pDrv->wncDevice, pInfo)
 #define WNCDRV_GET_DEVICEINFO(pDrv) \
 WNCDEV_GET_DEVICEINFO(pDrv->wncDevice)
 
+/* size of a message passed to write(), and of its output buffer record */
+#define WNCDEV_TXMSG_SIZE(pInfo) \
+(((pInfo)->fdtype.channel.txFormat == WNCAN_MSGFMT_DL) ? \
+ sizeof(WNCAN_CHNMSG_DL) : sizeof(WNCAN_CHNMSG))
+#define WNCDEV_TXREC_SIZE(pInfo) \
+(((pInfo)->fdtype.channel.txFormat == WNCAN_MSGFMT_DL) ? \
+ sizeof(WNCAN_TXMSG) : sizeof(WNCAN_CHNMSG))
+
 
 /************************************************************************
 *
@@ -285,6 +327,8 @@ STATUS wncDevIODevCreate
             wncDrv->wncDevice    = NULL;
             wncDrv->ctrlSetConfig = NULL;
             wncDrv->ctrlGetConfig = NULL;
+            wncDrv->ctrlAcceptUpdate = NULL;
+            wncDrv->ctrlEventGet = NULL;
             
             /* create device mutex */
             wncDrv->mutex        = semBCreate(SEM_Q_PRIORITY, SEM_FULL);
@@ -305,6 +349,10 @@ STATUS wncDevIODevCreate
             
             if (status == OK)
             {
+                /* remember the device for wncDevIOShow() */
+                wncDrv->next = wncDevIODevList;
+                wncDevIODevList = wncDrv;
+                
                 wncDevDrvInstance++;
                 if (pwncDrv)           /* pass back to use the dev pointer */
                     *pwncDrv = wncDrv;
@@ -394,6 +442,17 @@ STATUS wncDevIODevDestroy
     
     iosDevDelete (&wncDrv->devHdr);
     
+    /* Remove it from the list of created devices */
+    
+    {
+        WNCAN_DEVIO_DRVINFO **ppDrv = &wncDevIODevList;
+        
+        while ((*ppDrv != NULL) && (*ppDrv != wncDrv))
+            ppDrv = &(*ppDrv)->next;
+        if (*ppDrv != NULL)
+            *ppDrv = wncDrv->next;
+    }
+    
     /* Free DevIO driver struct resources */
     
     wncDrv->boardType = 0;
@@ -554,6 +613,13 @@ int wncDevIOOpen
         
         fdInfo->wnDevIODrv = wncDrv;
         fdInfo->devType = FD_WNCAN_DEVICE;
+        bzero((char*)&fdInfo->stats, sizeof(WNCAN_STATS));
+        
+        /* read() of the events is the only consumer of their queue */
+        fdInfo->wrMutex = NULL;
+        fdInfo->rdMutex = semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE);
+        if (fdInfo->rdMutex == NULL)
+            goto ErrorExit;
         
         /* initialize select's wakeup list */            
         selWakeupListInit(&fdInfo->selWakeupList);
@@ -570,6 +636,40 @@ int wncDevIOOpen
             
             goto ErrorExit;
         }
+        bzero((char*)fdInfo->fdtype.device.chnInfo, bufSize);
+        
+        /* frames are queued by the ISR until WNCAN_RXDEFER_SET */
+        fdInfo->fdtype.device.rxStage = NULL;
+        fdInfo->fdtype.device.deferSem = NULL;
+        fdInfo->fdtype.device.deferExit = NULL;
+        fdInfo->fdtype.device.deferTask = 0;
+        fdInfo->fdtype.device.deferPosted = FALSE;
+        fdInfo->fdtype.device.deferStop = FALSE;
+        fdInfo->fdtype.device.staged = 0;
+        fdInfo->fdtype.device.stageDropped = 0;
+        fdInfo->fdtype.device.deferRuns = 0;
+        fdInfo->fdtype.device.isrHist = FALSE;
+        fdInfo->fdtype.device.txStalled = FALSE;
+        fdInfo->fdtype.device.isrBinTicks = 1;
+        fdInfo->fdtype.device.isrMaxTicks = 0;
+        bzero((char*)fdInfo->fdtype.device.isrCount, 
+            sizeof(fdInfo->fdtype.device.isrCount));
+        
+        /* queue of controller events, read from this descriptor */
+        fdInfo->fdtype.device.eventBuf = wncRingCreate(WNCAN_EVENT_BUF_SIZE, 
+            sizeof(WNCAN_EVENT));
+        if (fdInfo->fdtype.device.eventBuf == NULL)
+        {
+#if DEVIO_DEBUG
+            logMsg("wncDevIOOpen() ERROR: event buffer create failed\n", 
+                0,0,0,0,0,0);
+#endif
+            
+            WNCDEV_FREE((char*)fdInfo->fdtype.device.chnInfo);
+            goto ErrorExit;
+        }
+        fdInfo->fdtype.device.eventSeq = 0;
+        fdInfo->fdtype.device.eventsLost = 0;
         
         /* store into can dev pointer */
         WNCDRV_PUT_DEVICEINFO(wncDrv, fdInfo);
@@ -580,7 +680,9 @@ int wncDevIOOpen
     else
     {
         WNCAN_DEVIO_FDINFO  *pDevInfo = NULL;
-        int                  ringBufSize = 0;
+        WNCAN_DEVIO_FDINFO  *pHead;
+        ULONG                chn;
+        int                  key;
         
         /* Check flags argument */
         
@@ -605,6 +707,35 @@ int wncDevIOOpen
             goto ErrorExit;
         }
         
+        /* skip leading slash */
+        chn = stringToUlong(&name[1]);
+        if (chn >= (ULONG) CAN_GetNumChannels(wncDrv->wncDevice))
+        {
+#if DEVIO_DEBUG
+            logMsg("wncDevIOOpen() ERROR: Invalid channel number\n", 
+                0,0,0,0,0,0);
+#endif
+            
+            goto ErrorExit;
+        }
+        
+        /* 
+        Any number of descriptors may read a channel, each receiving the 
+        frames that pass its own filter, but only one may write it 
+        */
+        pDevInfo = WNCDRV_GET_DEVICEINFO(wncDrv);
+        pHead = pDevInfo->fdtype.device.chnInfo[chn];
+        if ((flags != O_RDONLY) && (pHead != NULL) && 
+            (pHead->fdtype.channel.outputBuf != NULL))
+        {
+#if DEVIO_DEBUG
+            logMsg("wncDevIOOpen() ERROR: CAN channel already open for "
+                "writing\n", 0,0,0,0,0,0);
+#endif
+            
+            goto ErrorExit;
+        }
+        
         /* Allocate and initialize DevIO file descriptor structure */
         
         fdInfo = (WNCAN_DEVIO_FDINFO *) WNCDEV_MALLOC(sizeof(WNCAN_DEVIO_FDINFO));
@@ -620,6 +751,27 @@ int wncDevIOOpen
         
         fdInfo->wnDevIODrv = wncDrv;
         fdInfo->devType = FD_WNCAN_CHANNEL;
+        bzero((char*)&fdInfo->stats, sizeof(WNCAN_STATS));
+        
+        /* 
+        The ISR and read() or write() share each ring without a lock, which 
+        holds for one reading and one writing task only; tasks sharing the 
+        descriptor take turns 
+        */
+        fdInfo->rdMutex = NULL;
+        fdInfo->wrMutex = NULL;
+        if ( (flags == O_RDWR) || (flags == O_RDONLY) )
+        {
+            fdInfo->rdMutex = semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE);
+            if (fdInfo->rdMutex == NULL)
+                goto ErrorExit;
+        }
+        if ( (flags == O_RDWR) || (flags == O_WRONLY) )
+        {
+            fdInfo->wrMutex = semMCreate(SEM_Q_PRIORITY | SEM_INVERSION_SAFE);
+            if (fdInfo->wrMutex == NULL)
+                goto ErrorExit;
+        }
         
         /* initialize select's wakeup list */            
         selWakeupListInit(&fdInfo->selWakeupList);
@@ -630,8 +782,8 @@ int wncDevIOOpen
         {
             /* Create input ring buffer */
             
-            ringBufSize = wncUtilCalcRingBufSize (WNCAN_DEFAULT_RINGBUF_SIZE);
-            fdInfo->fdtype.channel.inputBuf = rngCreate (ringBufSize);
+            fdInfo->fdtype.channel.inputBuf = 
+                wncRingCreate (WNCAN_DEFAULT_RINGBUF_SIZE, sizeof(WNCAN_CHNMSG));
             if (fdInfo->fdtype.channel.inputBuf == NULL)
             {
 #if DEVIO_DEBUG
@@ -650,8 +802,8 @@ int wncDevIOOpen
         {
             /* Create output ring buffer */
             
-            ringBufSize = wncUtilCalcRingBufSize (WNCAN_DEFAULT_RINGBUF_SIZE);
-            fdInfo->fdtype.channel.outputBuf = rngCreate (ringBufSize);
+            fdInfo->fdtype.channel.outputBuf = 
+                wncRingCreate (WNCAN_DEFAULT_RINGBUF_SIZE, sizeof(WNCAN_CHNMSG));
             if (fdInfo->fdtype.channel.outputBuf == NULL)
             {
 #if DEVIO_DEBUG
@@ -664,7 +816,7 @@ int wncDevIOOpen
                     * delete inputBuf before proceeding
                 */
                 if((flags == O_RDWR) && (fdInfo->fdtype.channel.inputBuf))
-                    rngDelete (fdInfo->fdtype.channel.inputBuf);
+                    wncRingDelete (fdInfo->fdtype.channel.inputBuf);
                 
                 goto ErrorExit;
             }
@@ -676,15 +828,54 @@ int wncDevIOOpen
         /* Finish initializing DevIO file descriptor struct */
         fdInfo->fdtype.channel.enabled = TRUE;
         fdInfo->fdtype.channel.flag = flags;
-        /* skip leading slash */
-        fdInfo->fdtype.channel.channel = (UINT32) stringToUlong(&name[1]);
+        fdInfo->fdtype.channel.txIdle = TRUE;
+        fdInfo->fdtype.channel.txLoaded = FALSE;
+        fdInfo->fdtype.channel.txExpiring = FALSE;
+        fdInfo->fdtype.channel.msgFormat = WNCAN_MSGFMT_STD;
+        fdInfo->fdtype.channel.rxSeqNum = 0;
+        fdInfo->fdtype.channel.ringShared = FALSE;
+        fdInfo->fdtype.channel.rxWakeThresh = 1;
+        fdInfo->fdtype.channel.txWakeThresh = 1;
+        fdInfo->fdtype.channel.rxWaiting = FALSE;
+        fdInfo->fdtype.channel.txWaiting = FALSE;
+        fdInfo->fdtype.channel.rxMaxLatency = 0;
+        fdInfo->fdtype.channel.rxLatencyTicks = 0;
+        fdInfo->fdtype.channel.rxLatencyWd = NULL;
+        fdInfo->fdtype.channel.rxWdArmed = FALSE;
+        fdInfo->fdtype.channel.rxFilter = NULL;
+        fdInfo->fdtype.channel.txSched = WNCAN_TXSCHED_FIFO;
+        fdInfo->fdtype.channel.txQueue = NULL;
+        fdInfo->fdtype.channel.txFormat = WNCAN_MSGFMT_STD;
+        fdInfo->fdtype.channel.txDeadline = 0;
+        fdInfo->fdtype.channel.txHandover = FALSE;
+        fdInfo->fdtype.channel.txDeadlineWd = NULL;
+        fdInfo->fdtype.channel.channel = chn;
         
-        /* store this channel's info into the device's info */
-        pDevInfo = WNCDRV_GET_DEVICEINFO(wncDrv);
-        pDevInfo->fdtype.device.chnInfo[fdInfo->fdtype.channel.channel] = fdInfo; 
+        /* 
+        Link this channel's info into the device's info. The ISR walks the 
+        list, so the descriptor is published with interrupts locked; a 
+        writer goes first, where the transmit interrupt looks for it 
+        */
+        key = intLock();
+        pHead = pDevInfo->fdtype.device.chnInfo[chn];
+        if ((fdInfo->fdtype.channel.outputBuf != NULL) || (pHead == NULL))
+        {
+            fdInfo->fdtype.channel.next = pHead;
+            pDevInfo->fdtype.device.chnInfo[chn] = fdInfo;
+        }
+        else
+        {
+            fdInfo->fdtype.channel.next = pHead->fdtype.channel.next;
+            pHead->fdtype.channel.next = fdInfo;
+        }
+        intUnlock(key);
         
         /* Indicate in DevIO driver struct that a channel was opened */
         wncDrv->numOpenChans++;
+        
+        /* a new reader takes every frame until it sets a filter */
+        if (fdInfo->fdtype.channel.inputBuf != NULL)
+            wncUtilAcceptUpdate(wncDrv);
     }
     
     /* unlock device */
@@ -705,7 +896,13 @@ ErrorExit:
     
     /* de-allocate memory, if needed */
     if (fdInfo)
+    {
+        if (fdInfo->rdMutex != NULL)
+            semDelete (fdInfo->rdMutex);
+        if (fdInfo->wrMutex != NULL)
+            semDelete (fdInfo->wrMutex);
         WNCDEV_FREE((char*)fdInfo);
+    }
     
     /* unlock device */
     semGive(wncDrv->mutex);
@@ -734,6 +931,7 @@ STATUS wncDevIOClose
 {
     WNCAN_DEVIO_DRVINFO*  wncDrv = NULL;
     WNCAN_DEVICE*         canDev = NULL;
+    WNCAN_BusOffCfg       busOffCfg;
     STATUS                status = ERROR;
     
     if (fdInfo == NULL)
@@ -771,64 +969,108 @@ STATUS wncDevIOClose
     /* Close CAN channel */
     if (fdInfo->devType == FD_WNCAN_CHANNEL)
     {
-        WNCAN_DEVIO_FDINFO  *pDevInfo = NULL;
+        WNCAN_DEVIO_FDINFO  *pDevInfo = WNCDRV_GET_DEVICEINFO(wncDrv);
+        WNCAN_DEVIO_FDINFO **ppLink;
+        ULONG                chn = fdInfo->fdtype.channel.channel;
+        int                  key;
         
-        /* Call WNCAN API functions to close channel */
+        /* 
+        Call WNCAN API functions to close channel, once the last descriptor 
+        open on it is closed 
+        */
         
-        status = CAN_DisableChannel (canDev, fdInfo->fdtype.channel.channel);
-        if (status == OK)
+        status = OK;
+        if ((pDevInfo->fdtype.device.chnInfo[chn] == fdInfo) && 
+            (fdInfo->fdtype.channel.next == NULL))
         {
-            status=CAN_FreeChannel (canDev, fdInfo->fdtype.channel.channel);
+            status = CAN_DisableChannel (canDev, chn);
             if (status == OK)
             {
-                /* Delete ring buffers */
-                
-                if (fdInfo->fdtype.channel.inputBuf)
-                    rngDelete (fdInfo->fdtype.channel.inputBuf);
-                fdInfo->fdtype.channel.inputBuf = 0;
-                if (fdInfo->fdtype.channel.outputBuf)
-                    rngDelete (fdInfo->fdtype.channel.outputBuf);
-                fdInfo->fdtype.channel.outputBuf = 0;
-                
-                
-                /* remove channel's info from the device's info */
-                pDevInfo = WNCDRV_GET_DEVICEINFO(wncDrv);
-                pDevInfo->fdtype.device.chnInfo[fdInfo->fdtype.channel.channel] =NULL; 
-                
-                
-                /* Cleanup DevIO file descriptor struct */
-                fdInfo->wnDevIODrv = NULL;
-                fdInfo->devType = FD_WNCAN_NONE;
-                fdInfo->fdtype.channel.enabled = FALSE;
-                fdInfo->fdtype.channel.flag = 0;
-                fdInfo->fdtype.channel.channel = 0;
-                
-                
-                /* release wake up list */
-                selWakeupListTerm(&fdInfo->selWakeupList);
-                
-                /* Free DevIO file descriptor struct */
-                WNCDEV_FREE((char*)fdInfo);
-                fdInfo = NULL;
-                
-                /* Decrement open channel counter */
-                wncDrv->numOpenChans--;
+                status=CAN_FreeChannel (canDev, chn);
+#if DEVIO_DEBUG
+                if (status != OK)
+                {
+                    logMsg("wncDevIOClose() ERROR: channel free failed on channel num %d\n", 
+                        chn,0,0,0,0,0);
+                }
+#endif      
             }
 #if DEVIO_DEBUG
             else
             {
-                logMsg("wncDevIOClose() ERROR: channel free failed on channel num %d\n", 
-                    fdInfo->fdtype.channel.channel,0,0,0,0,0);
+                logMsg("wncDevIOClose() ERROR: channel disable failed on channel num %d\n", 
+                    chn,0,0,0,0,0);
             }
 #endif      
         }
-#if DEVIO_DEBUG
-        else
+        
+        if (status == OK)
         {
-            logMsg("wncDevIOClose() ERROR: channel disable failed on channel num %d\n", 
-                fdInfo->fdtype.channel.channel,0,0,0,0,0);
+            /* remove channel's info from the device's info, before the 
+            ** buffers the ISR uses are deleted
+            */
+            key = intLock();
+            for (ppLink = &pDevInfo->fdtype.device.chnInfo[chn]; 
+                 *ppLink != fdInfo; 
+                 ppLink = &(*ppLink)->fdtype.channel.next)
+                ;
+            *ppLink = fdInfo->fdtype.channel.next;
+            intUnlock(key);
+            
+            if (fdInfo->fdtype.channel.inputBuf)
+                wncUtilAcceptUpdate(wncDrv);
+            
+            /* Delete ring buffers */
+            
+            if (fdInfo->fdtype.channel.inputBuf)
+                wncRingDelete (fdInfo->fdtype.channel.inputBuf);
+            fdInfo->fdtype.channel.inputBuf = 0;
+            if (fdInfo->fdtype.channel.outputBuf)
+                wncRingDelete (fdInfo->fdtype.channel.outputBuf);
+            fdInfo->fdtype.channel.outputBuf = 0;
+            if (fdInfo->fdtype.channel.txQueue)
+                wncTxqDelete (fdInfo->fdtype.channel.txQueue);
+            fdInfo->fdtype.channel.txQueue = NULL;
+            
+            if (fdInfo->rdMutex != NULL)
+                semDelete (fdInfo->rdMutex);
+            fdInfo->rdMutex = NULL;
+            if (fdInfo->wrMutex != NULL)
+                semDelete (fdInfo->wrMutex);
+            fdInfo->wrMutex = NULL;
+            
+            /* stop the max-latency timer */
+            if (fdInfo->fdtype.channel.rxLatencyWd != NULL)
+                wdDelete (fdInfo->fdtype.channel.rxLatencyWd);
+            fdInfo->fdtype.channel.rxLatencyWd = NULL;
+            if (fdInfo->fdtype.channel.txDeadlineWd != NULL)
+                wdDelete (fdInfo->fdtype.channel.txDeadlineWd);
+            fdInfo->fdtype.channel.txDeadlineWd = NULL;
+            
+            /* the ISR can no longer reach the filter */
+            if (fdInfo->fdtype.channel.rxFilter != NULL)
+                wncFilterDelete (fdInfo->fdtype.channel.rxFilter);
+            fdInfo->fdtype.channel.rxFilter = NULL;
+            
+            /* Cleanup DevIO file descriptor struct */
+            fdInfo->wnDevIODrv = NULL;
+            fdInfo->devType = FD_WNCAN_NONE;
+            fdInfo->fdtype.channel.enabled = FALSE;
+            fdInfo->fdtype.channel.flag = 0;
+            fdInfo->fdtype.channel.channel = 0;
+            fdInfo->fdtype.channel.next = NULL;
+            
+            
+            /* release wake up list */
+            selWakeupListTerm(&fdInfo->selWakeupList);
+            
+            /* Free DevIO file descriptor struct */
+            WNCDEV_FREE((char*)fdInfo);
+            fdInfo = NULL;
+            
+            /* Decrement open channel counter */
+            wncDrv->numOpenChans--;
         }
-#endif      
         
     }
     /* Close CAN device */
@@ -848,16 +1090,25 @@ STATUS wncDevIOClose
         } 
         else
         {
+            /* no bus-off recovery may restart the stopped controller */
+            bzero ((char *) &busOffCfg, sizeof(busOffCfg));
+            CAN_BusOffRecoverySet (canDev, &busOffCfg);
+            
             /* Call WNCAN API functions for closing device */
             CAN_TxAbort (canDev);
             CAN_Stop (canDev);
             CAN_DisableInt (canDev);
             
+            /* no more frames are staged, stop the deferred receive task */
+            wncUtilRxDeferStop (fdInfo);
+            
             /* Close the device */
             CAN_Close (canDev);
             
             /* free internal struct memory */
             WNCDEV_FREE((char*)fdInfo->fdtype.device.chnInfo);
+            wncRingDelete (fdInfo->fdtype.device.eventBuf);
+            semDelete (fdInfo->rdMutex);
             
             /* release wake up list */
             selWakeupListTerm(&fdInfo->selWakeupList);
@@ -894,10 +1145,16 @@ STATUS wncDevIOClose
 * wncDevIOReadBuf - device read routine
 *
 * This routine is called by the VxWorks I/O System when user code calls read().
-* It dequeues the next available CAN data message from the internal input data 
-* ring buffer and returns it to the caller.  A separate function responds to the
-* actual receive interrupt from the CAN controller and queues the CAN data message
-* to the input data buffer.
+* It dequeues as many complete CAN data messages as are available in the
+* internal input data ring buffer and fit in "maxbytes", and returns them to
+* the caller as an array of WNCAN_CHNMSG.  A caller passing room for a single
+* message receives at most one message, as before.  A separate function
+* responds to the actual receive interrupt from the CAN controller and queues
+* the CAN data message to the input data buffer.  That function is the only
+* producer and this routine the only consumer of the ring, so no interrupt
+* lock is needed; tasks reading the same descriptor are serialized by its
+* read mutex.  On the device descriptor it returns the queued controller
+* events instead, as an array of WNCAN_EVENT.
 *
 * RETURNS: number of bytes read, or ERROR
 *
@@ -908,15 +1165,15 @@ STATUS wncDevIOClose
 int wncDevIOReadBuf
 (
  WNCAN_DEVIO_FDINFO  *fdInfo,  /* pointer to DevIO file descriptor */
- char                *buffer,  /* pointer to WNCAN_CHNMSG buffer receiving bytes*/
+ char                *buffer,  /* pointer to WNCAN_CHNMSG array receiving bytes*/
  size_t               maxbytes /* max number of bytes to read */
  )
 {
-    int  key;
-    int  bytesRead = 0;
-    int  msgSize = sizeof(WNCAN_CHNMSG);
+    int               bytesRead = 0;
+    int               msgSize;
+    WNCAN_MSGRING_ID  ring;
     
-    if ( (fdInfo == NULL) || (buffer == NULL) )
+    if ( (fdInfo == NULL) || (buffer == NULL) || (fdInfo->rdMutex == NULL) )
     {       
 #if DEVIO_DEBUG
         logMsg("wncDevIOReadBuf() ERROR: Null parameters passed in \n", 
@@ -925,8 +1182,22 @@ int wncDevIOReadBuf
         goto ErrorExit;
     }
     
+    /* ioctl() replaces the buffer only while no read is in progress */
+    semTake (fdInfo->rdMutex, WAIT_FOREVER);
+    
+    /* a device descriptor reads its controller events */
+    ring = (fdInfo->devType == FD_WNCAN_DEVICE) ? 
+        fdInfo->fdtype.device.eventBuf : fdInfo->fdtype.channel.inputBuf;
+    
+    /* WNCAN_CHNMSG or WNCAN_CHNMSG_TS, depending on the read format, or 
+    ** WNCAN_EVENT
+    */
+    msgSize = ring->msgSize;
+    
     if (maxbytes < msgSize)
     {
+        semGive (fdInfo->rdMutex);
+        
 #if DEVIO_DEBUG
         logMsg("wncDevIOReadBuf() ERROR: Incomplete CAN message data requested "
             "(maxbytes too small)\n", 0,0,0,0,0,0);
@@ -935,11 +1206,9 @@ int wncDevIOReadBuf
         goto ErrorExit;
     }
     
-    /* ----------------- critical section to Read complete CAN message */
-    key = intLock();
-    bytesRead = rngBufGet (fdInfo->fdtype.channel.inputBuf, buffer, msgSize);
-    intUnlock(key);
-    /* ----------------- */
+    /* only whole messages are transferred */
+    bytesRead = wncRingGet (ring, buffer, maxbytes / msgSize) * msgSize;
+    semGive (fdInfo->rdMutex);
     
     if (bytesRead < 1)
     {
@@ -949,16 +1218,6 @@ int wncDevIOReadBuf
         logMsg("wncDevIOReadBuf() INFO: Input data buffer is empty\n", 
             0,0,0,0,0,0);
 #endif
-    } else if (bytesRead < msgSize)
-    {
-        /* Incomplete CAN message received */
-        
-#if DEVIO_DEBUG
-        logMsg("wncDevIOReadBuf() ERROR: Incomplete CAN message received\n", 
-            0,0,0,0,0,0);
-#endif
-        
-        goto ErrorExit;
     }
     
     return bytesRead;
@@ -976,11 +1235,22 @@ ErrorExit:
 * wncDevIOWriteBuf - device write routine 
 *
 * This routine is called by the VxWorks I/O System when user code calls write().
-* It queues the CAN data message in "buffer" to the internal output data ring 
-* buffer.  A separate function responds to the actual transmit interrupt from 
-* the CAN controller to send the CAN data message from the output data buffer.
+* It queues the array of CAN data messages in "buffer" to the internal output 
+* data ring buffer, as many complete messages as fit in the free space.  A 
+* trailing partial message in "buffer" is ignored.  A separate function 
+* responds to the actual transmit interrupt from the CAN controller to send 
+* the CAN data messages from the output data buffer; as the only consumer
+* of the ring it needs no interrupt lock against this routine.  Once the 
+* messages are queued, this routine looks with interrupts locked whether 
+* that function found the buffer empty and left the transmitter idle, and 
+* if so starts it.  Tasks writing the same descriptor are serialized by 
+* its write mutex, as the ring takes a single producer only.
+*
+* In the WNCAN_MSGFMT_DL write format "buffer" holds WNCAN_CHNMSG_DL 
+* messages, whose lifetimes are converted to deadlines here.
 *
-* RETURNS: number of bytes written, or ERROR
+* RETURNS: number of bytes written, which may be less than "maxbytes" if the
+* output data buffer fills up, or ERROR if no message could be queued
 *
 * ERRNO: S_ioLib_DEVICE_ERROR
 *        S_can_invalid_parameter
@@ -990,18 +1260,33 @@ ErrorExit:
 int wncDevIOWriteBuf
 (
  WNCAN_DEVIO_FDINFO   *fdInfo,     /* pointer to DevIO file descriptor */
- char                 *buffer,     /* pointer to WNCAN_CHNMSG buffer to write */
+ char                 *buffer,     /* pointer to WNCAN_CHNMSG array to write */
  size_t                maxbytes    /* number of bytes to write */
  )
 {
     int  bytesWritten = ERROR;
-    int  msgSize = sizeof(WNCAN_CHNMSG);
+    int  msgSize;
     int key;
     
     
     
     
-    if ( (fdInfo == NULL) || (buffer == NULL) || (maxbytes < msgSize) )
+    if ( (fdInfo == NULL) || (buffer == NULL) || 
+         (fdInfo->wrMutex == NULL) )
+    {
+#if DEVIO_DEBUG
+        logMsg("wncDevIOWriteBuf() ERROR: Null parameters passed in \n", 
+            0,0,0,0,0,0);
+#endif
+        
+        errnoSet (S_can_invalid_parameter);
+        return ERROR;
+    }
+    
+    /* ioctl() replaces the buffer only while no write is in progress */
+    semTake (fdInfo->wrMutex, WAIT_FOREVER);
+    
+    if (maxbytes < (msgSize = WNCDEV_TXMSG_SIZE(fdInfo)))
     {
 #if DEVIO_DEBUG
         logMsg("wncDevIOWriteBuf() ERROR: Incomplete CAN message data to be "
@@ -1012,19 +1297,35 @@ int wncDevIOWriteBuf
     }
     else
     {       
-        
-        BOOL ringEmptyBeforeAdd;
-        
-        /* ----------------- critical section to test and add to the queue */
-        
-        key = intLock();
-        
-        ringEmptyBeforeAdd = rngIsEmpty(fdInfo->fdtype.channel.outputBuf);
-        bytesWritten = rngBufPut (fdInfo->fdtype.channel.outputBuf, buffer, msgSize);
-        
-        intUnlock(key);
-        
-        /* ----------------- */
+        /* only whole messages are transferred */
+        if (fdInfo->fdtype.channel.txFormat == WNCAN_MSGFMT_DL)
+        {
+            WNCAN_CHNMSG_DL  msgDl;
+            WNCAN_TXMSG     *pSlot;
+            UINT64           now = (*wncDevIOTsFunc)();
+            UINT32           tsFreq = (wncDevIOTsFreq != 0) ? 
+                                 wncDevIOTsFreq : sysTimestampFreq();
+            int              numMsgs;
+            
+            for (numMsgs = 0; numMsgs < (int) (maxbytes / msgSize); numMsgs++)
+            {
+                pSlot = (WNCAN_TXMSG *) wncRingReserve(
+                    fdInfo->fdtype.channel.outputBuf);
+                if (pSlot == NULL)
+                    break;
+                
+                /* "buffer" need not be aligned */
+                memcpy (&msgDl, buffer + numMsgs * msgSize, msgSize);
+                pSlot->msg = msgDl.msg;
+                pSlot->deadline = (msgDl.lifetime == 0) ? 0 : 
+                    now + ((UINT64) msgDl.lifetime * tsFreq + 999999) / 1000000;
+                wncRingCommit (fdInfo->fdtype.channel.outputBuf, 1);
+            }
+            bytesWritten = numMsgs * msgSize;
+        }
+        else
+            bytesWritten = wncRingPut (fdInfo->fdtype.channel.outputBuf, buffer, 
+                maxbytes / msgSize) * msgSize;
         
         if (bytesWritten < msgSize)
         {
@@ -1035,29 +1336,28 @@ int wncDevIOWriteBuf
                 "failed\n", 0,0,0,0,0,0);
 #endif
             
-                /* note: since the size of the message is a multiple of the total
-                ** buffer size, if the buffer is full, then no portion of the message
-                ** was put into the buffer (i.e. bytesWritten=0 when trying to add
-                ** to a full buffer).
-            */
             errnoSet (S_can_buffer_overflow);
             bytesWritten = ERROR;
         }
         
-        /* if there was nothing in the buffer before adding this message,
-        ** need to 'jump start' the TX process
+        /* if no frame is in the controller, no TX interrupt will come to
+        ** send the messages, so 'jump start' the TX process; the TX 
+        ** interrupts then drain the rest of the batch. The ISR may have 
+        ** found the buffer empty up to the moment the messages were 
+        ** committed, so the test is made with interrupts locked
         */
-        if ((bytesWritten != ERROR) && (ringEmptyBeforeAdd))
+        if (bytesWritten != ERROR)
         {
-            /* initiate a TX by calling our handler */
             key = intLock();
-            wncDevIOIsrHandler(fdInfo->wnDevIODrv->wncDevice, 
-                WNCAN_INT_TXCLR, 
-                fdInfo->fdtype.channel.channel);
+            if (fdInfo->fdtype.channel.txIdle)
+                wncUtilTxPump(fdInfo->wnDevIODrv->wncDevice, fdInfo, 
+                    (UCHAR) fdInfo->fdtype.channel.channel, FALSE);
             intUnlock(key);
         }
     }
     
+    semGive (fdInfo->wrMutex);
+    
     return bytesWritten;
 }
 
@@ -1068,7 +1368,9 @@ int wncDevIOWriteBuf
 *
 * wncDevIOIsrHandler - WNC interrupt callback
 *
-* Service the WNC callback for TX,RX and error interrupts. 
+* Service the WNC callback for TX,RX and error interrupts. In deferred 
+* receive mode (see WNCAN_RXDEFER_SET) received frames are only staged 
+* for the deferred receive task.
 *
 * RETURNS: nothing
 *
@@ -1084,21 +1386,55 @@ LOCAL void wncDevIOIsrHandler
 {
     WNCAN_DEVIO_FDINFO  *pDevInfo = WNCDEV_GET_DEVICEINFO(pDev);
     WNCAN_DEVIO_FDINFO  *pChnInfo = pDevInfo->fdtype.device.chnInfo[chnNum];
-    WNCAN_CHNMSG         canMsg;
-    STATUS               status;
+    WNCAN_DEVIO_FDINFO  *pSub;      /* a descriptor reading the channel */
+    WNCAN_CHNMSG_TS      rxMsg;     /* scratch for a frame that is dropped */
+    WNCAN_CHNMSG_TS     *pRxMsg;
+    WNCAN_CHNMSG_TS     *pSlot;
+    UINT64               timeStamp = 0;
+    UINT64               isrStart = 0;
+    UINT64               isrEnd;
+    ULONG                id;
+    BOOL                 extId;
+    WNCAN_BusError       busError;
     
-    int     numBytes = 0;
-    int     msgSize = sizeof(WNCAN_CHNMSG);
     BOOL    newdata;  /* unused, but needed for the api call */    
     
+    if (pDevInfo->fdtype.device.isrHist)
+        isrStart = (*wncDevIOTsFunc)();
+    
     switch(intStatus)
     {
     case WNCAN_INT_ERROR:
+        /* classify the error while the controller still holds its code */
+        busError = wncUtilEventPost(pDev, pDevInfo, WNCAN_EVENT_ERROR);
+        pDevInfo->stats.busErrors++;
+        if (busError & WNCAN_ERR_BIT)
+            pDevInfo->stats.busErrBit++;
+        if (busError & WNCAN_ERR_ACK)
+            pDevInfo->stats.busErrAck++;
+        if (busError & WNCAN_ERR_CRC)
+            pDevInfo->stats.busErrCrc++;
+        if (busError & WNCAN_ERR_FORM)
+            pDevInfo->stats.busErrForm++;
+        if (busError & WNCAN_ERR_STUFF)
+            pDevInfo->stats.busErrStuff++;
+        selWakeupAll (&pDevInfo->selWakeupList, SELREAD);
+        break;
+        
     case WNCAN_INT_BUS_OFF:
+        pDevInfo->stats.busOff++;
+        /* fall through */
+        
+    case WNCAN_INT_BUS_STATE:
+        wncUtilBusOffTx(pDev, pDevInfo, intStatus);
+        /* fall through */
+        
     case WNCAN_INT_WAKE_UP:
     /* error or bus type of interrupt, wake up the device in case
     ** application is blocking on the device's file descriptor
         */  
+        wncUtilEventPost(pDev, pDevInfo, (intStatus == WNCAN_INT_WAKE_UP) ? 
+            WNCAN_EVENT_WAKEUP : WNCAN_EVENT_STATE);
         selWakeupAll (&pDevInfo->selWakeupList, SELREAD);
         break;
         
@@ -1113,118 +1449,1344 @@ LOCAL void wncDevIOIsrHandler
     ** we are sure that there is enough space in the buffer for a new
     ** message.
         */
-        selWakeupAll (&pChnInfo->selWakeupList, SELWRITE);
+        if ((pChnInfo == NULL) || (pChnInfo->fdtype.channel.outputBuf == NULL))
+            break;
+        
+        /* the frame the deadline was kept for has left the controller, 
+        ** unless the TXCLR just before loaded the next one
+        */
+        if (!pChnInfo->fdtype.channel.txHandover)
+            pChnInfo->fdtype.channel.txDeadline = 0;
+        pChnInfo->fdtype.channel.txHandover = FALSE;
+        
+        /* only a task that found too little room in FIOSELECT is pending, 
+        ** wake it once when enough has been freed
+        */
+        if (pChnInfo->fdtype.channel.txWaiting &&
+            ((wncRingFree(pChnInfo->fdtype.channel.outputBuf) >= 
+              pChnInfo->fdtype.channel.txWakeThresh) ||
+             wncRingIsEmpty(pChnInfo->fdtype.channel.outputBuf)))
+        {
+            pChnInfo->fdtype.channel.txWaiting = FALSE;
+            selWakeupAll (&pChnInfo->selWakeupList, SELWRITE);
+        }
         break;
         
     case WNCAN_INT_RX:
     case WNCAN_INT_RTR_RESPONSE:
-        /* get the message from the controller */
-        canMsg.id = CAN_ReadID(pDev, chnNum, &canMsg.extId);  /* get ID, extId */
-        /* read in the message, indicate full size (8) data buffer len */
-        canMsg.len = WNCAN_MAX_DATA_LEN;
-        CAN_ReadData(pDev, chnNum, canMsg.data, &canMsg.len, &newdata);
-        /* do a test for RTR because the api can return an error, and if no, then
-        ** the message is definately does not have RTR set
+        /* stamp the frame before the register reads add their latency, if 
+        ** any reader of the channel wants it
         */
-        canMsg.rtr = (CAN_IsRTR(pDev, chnNum) == TRUE ? TRUE : FALSE);
+        for (pSub = pChnInfo; pSub != NULL; pSub = pSub->fdtype.channel.next)
+        {
+            if (pSub->fdtype.channel.msgFormat == WNCAN_MSGFMT_TS)
+            {
+                timeStamp = (*wncDevIOTsFunc)();
+                break;
+            }
+        }
         
-        /* add into our buffer */
-        if (rngBufPut(pChnInfo->fdtype.channel.inputBuf, 
-            (char*)&canMsg, msgSize) == msgSize)
+        /* in deferred receive mode the task filters and queues the frame */
+        if ((pDevInfo->fdtype.device.rxStage != NULL) && (pChnInfo != NULL))
         {
-            /* wake up blocked tasks */
-            selWakeupAll (&pChnInfo->selWakeupList, SELREAD);
+            wncUtilRxStage(pDev, pDevInfo, chnNum, timeStamp);
+            break;
         }
-        else 
+        
+        /* the ID is all the filters need */
+        id = CAN_ReadID(pDev, chnNum, &extId);
+        
+        /* build the message in place in the input buffer of the first 
+        ** reader that accepts it and has room, and copy it from there to 
+        ** the other readers that accept it; when nobody takes it the frame 
+        ** is still read out, which releases it in the controller, and dropped
+        */
+        pRxMsg = NULL;
+        for (pSub = pChnInfo; pSub != NULL; pSub = pSub->fdtype.channel.next)
         {
-        /* internal buffer full, report error 
-        ** NOTE: it is not advised to use logmsg here because if the controller
-        ** is getting flooded, the logging of the error message will
-        ** just make the overflow condition worse.
-            */
-#if DEVIO_DEBUG
-            logMsg("wncDevIOIsrHandler() ERROR: Internal buffer full \n",0,0,0,0,0,0);
-#endif
-            errnoSet (S_can_buffer_overflow);
+            pSlot = (WNCAN_CHNMSG_TS *) wncUtilRxReserve(pSub, id, extId);
+            if (pSlot == NULL)
+                continue;
+            
+            if (pRxMsg == NULL)
+            {
+                pRxMsg = pSlot;
+                pRxMsg->msg.id = id;
+                pRxMsg->msg.extId = extId;
+                /* do a test for RTR because the api can return an error, and if no, then
+                ** the message is definately does not have RTR set; before the data, 
+                ** as reading the data releases the receive buffer
+                */
+                pRxMsg->msg.rtr = (CAN_IsRTR(pDev, chnNum) == TRUE ? TRUE : FALSE);
+                /* read in the message, indicate full size (8) data buffer len */
+                pRxMsg->msg.len = WNCAN_MAX_DATA_LEN;
+                CAN_ReadData(pDev, chnNum, pRxMsg->msg.data, &pRxMsg->msg.len, 
+                    &newdata);
+            }
+            else
+                pSlot->msg = pRxMsg->msg;
+            
+            wncUtilRxPublish(pSub, (char *) pSlot, timeStamp);
+        }
+        
+        if (pRxMsg == NULL)
+        {
+            rxMsg.msg.len = WNCAN_MAX_DATA_LEN;
+            CAN_ReadData(pDev, chnNum, rxMsg.msg.data, &rxMsg.msg.len, &newdata);
         }
         break;
         
         
+    case WNCAN_INT_TX_ABORTED:
+        /* the frame in the controller was not sent */
+        if ((pChnInfo == NULL) || (pChnInfo->fdtype.channel.outputBuf == NULL))
+            break;
+        
+        wncUtilTxLost(pChnInfo);
+        break;
+        
     case WNCAN_INT_TXCLR:
-        /* device ready to TX again if there is something in the buffer */
-        numBytes = rngBufGet(pChnInfo->fdtype.channel.outputBuf, 
-            (char*)&canMsg, msgSize);
-        if (numBytes == msgSize)
+        /* no descriptor is writing this channel */
+        if ((pChnInfo == NULL) || (pChnInfo->fdtype.channel.outputBuf == NULL))
+            break;
+        
+        /* the frame in the controller has been sent, unless 
+        ** WNCAN_INT_TX_ABORTED came first
+        */
+        if (pChnInfo->fdtype.channel.txLoaded)
         {
-            /* message is buffer, transmit it */
-            status = CAN_TxMsg(pDev, chnNum, canMsg.id, canMsg.extId, 
-                canMsg.data, canMsg.len);
-            
-            if (status == ERROR)
-            {  /* error in TX, just re-added back to the queue */
-                rngBufPut(pChnInfo->fdtype.channel.outputBuf, (char*)&canMsg, msgSize);
-            }
+            pChnInfo->stats.txFrames++;
+            pChnInfo->fdtype.channel.txLoaded = FALSE;
         }
-        /* else nothing in the buffer, so do nothing */
         
+        wncUtilTxPump(pDev, pChnInfo, chnNum, TRUE);
         break;
         
     default:
         break;
     }
     
+    if (isrStart != 0)
+    {
+        isrEnd = (*wncDevIOTsFunc)();
+        wncUtilIsrHistAdd(pDevInfo, (isrEnd > isrStart) ? isrEnd - isrStart : 0);
+    }
 }
 
 
 
 /************************************************************************
 *
-* wncDevIOIoctl - device I/O control routine
+* wncUtilTxPump - load the next frame of a channel into the controller
 *
-* This routine is called by the VxWorks I/O System when user code calls ioctl().
-* It calls the appropriate WNCAN API functions to process the specified command.
+* This routine services WNCAN_INT_TXCLR, and is called by write() with 
+* "txDone" FALSE to start an idle transmitter. Frames whose deadline has 
+* passed are dropped without being handed to the controller. The deadline 
+* of the frame that is loaded is kept until its TX interrupt, and a timer 
+* aborts the transmission if it is still pending when the deadline passes.
+* The routine records in txIdle whether a frame is left in the controller, 
+* whose TX interrupt calls it again, or whether write() has to. Called 
+* with interrupts locked.
 *
-* RETURNS: OK or ERROR
+* RETURNS: N/A
 *
 * ERRNO: N/A
 *
 */
-
-STATUS wncDevIOIoctl
+LOCAL void wncUtilTxPump
 (
- WNCAN_DEVIO_FDINFO   *fdInfo,      /* pointer to DevIO file descriptor */
- int                   command,     /* command function code */
- int                   arg          /* arbitrary argument */
+ struct WNCAN_Device *pDev,     /* CAN device */
+ WNCAN_DEVIO_FDINFO  *pChnInfo, /* the descriptor writing the channel */
+ UCHAR                chnNum,   /* channel number */
+ BOOL                 txDone    /* called for a TX interrupt */
  )
 {
-    WNCAN_DEVIO_DRVINFO*  wncDrv = NULL;
-    WNCAN_DEVICE*         canDev = NULL;
-    STATUS                status = ERROR;    /* pessimistic */
+    WNCAN_CHNMSG  *pTxMsg;
+    UINT64         deadline;
+    UINT64         now = 0;
+    STATUS         status;
     
-    if (fdInfo == NULL)
+    for (;;)
     {
-#if DEVIO_DEBUG
-        logMsg("wncDevIOIoctl() ERROR: pointer to DevIO file descriptor is null\n", 
-            0,0,0,0,0,0);
-#endif
-        return ERROR;
+        /* device ready to TX again if there is something in the buffer */
+        while ((pTxMsg = wncUtilTxNext(pChnInfo, &deadline)) != NULL)
+        {
+            if (deadline == 0)
+                break;
+            
+            if (now == 0)
+                now = (*wncDevIOTsFunc)();
+            if (now < deadline)
+                break;
+            
+            /* too late to be of use, keep the bus for fresh data */
+            pChnInfo->stats.txExpired++;
+            wncUtilTxRemove(pChnInfo);
+        }
+        
+        if (pTxMsg == NULL)
+        {
+            /* nothing in the buffer, the next write() starts the TX */
+            pChnInfo->fdtype.channel.txIdle = TRUE;
+            return;
+        }
+        
+        /* message is buffer, transmit it */
+        status = CAN_TxMsg(pDev, chnNum, pTxMsg->id, pTxMsg->extId, 
+            pTxMsg->data, pTxMsg->len);
+        
+        /* the message stays at the head of the queue while the
+        ** transmitter is busy, so it is retried on the next TX 
+        ** interrupt, unless a frame of higher priority has been 
+        ** queued in the meantime; any other error drops it, and the
+        ** next one is tried
+        */
+        if (status == OK)
+        {
+            /* counted when its TX interrupt shows how it left */
+            pChnInfo->fdtype.channel.txLoaded = TRUE;
+            pChnInfo->fdtype.channel.txExpiring = FALSE;
+            wncUtilTxRemove(pChnInfo);
+            
+            /* the previous frame has left the controller */
+            pChnInfo->fdtype.channel.txDeadline = deadline;
+            pChnInfo->fdtype.channel.txHandover = txDone;
+            if (deadline != 0)
+                wncUtilTxDeadlineStart(pChnInfo, now);
+            break;
+        }
+        else if (errnoGet() == S_can_busy)
+        {
+            pChnInfo->stats.txRetries++;
+            break;
+        }
+        
+        pChnInfo->stats.txDropped++;
+        wncUtilTxRemove(pChnInfo);
     }
     
-    wncDrv = fdInfo->wnDevIODrv;
-    if (wncDrv == NULL)
+    /* the TX interrupt of the frame in the controller loads the next */
+    pChnInfo->fdtype.channel.txIdle = FALSE;
+}
+
+
+/************************************************************************
+*
+* wncUtilTxNext - get the frame the channel sends next
+*
+* In the WNCAN_TXSCHED_PRIO mode this routine first moves the frames 
+* written to the output buffer into the priority queue, as far as it has 
+* room, so the frame that wins arbitration is chosen among all pending 
+* ones. Frames still in the priority queue after a switch back to 
+* WNCAN_TXSCHED_FIFO are sent before the output buffer. The deadline of 
+* the frame, or 0, is stored in "pDeadline". Called from the TX interrupt 
+* only.
+*
+* RETURNS: pointer to the frame, or NULL if nothing is pending
+*
+* ERRNO: N/A
+*
+*/
+LOCAL WNCAN_CHNMSG *wncUtilTxNext
+(
+ WNCAN_DEVIO_FDINFO  *pChnInfo,  /* the descriptor writing the channel */
+ UINT64              *pDeadline  /* where to store the frame's deadline */
+ )
+{
+    WNCAN_TXQUEUE_ID  txQueue = pChnInfo->fdtype.channel.txQueue;
+    BOOL              hasDeadline = 
+        (pChnInfo->fdtype.channel.txFormat == WNCAN_MSGFMT_DL);
+    char             *pRec;
+    int               recSize = pChnInfo->fdtype.channel.outputBuf->msgSize;
+    int               numMsgs;
+    int               i;
+    
+    if ((txQueue != NULL) && 
+        (pChnInfo->fdtype.channel.txSched == WNCAN_TXSCHED_PRIO))
     {
-#if DEVIO_DEBUG
-        logMsg("wncDevIOIoctl() ERROR: pointer to DevIO driver is null\n", 
-            0,0,0,0,0,0);
-#endif
-        return ERROR;
+        /* at most two runs, split where the slot array wraps */
+        while (!wncTxqIsFull(txQueue) &&
+               ((pRec = wncRingPeekRun(pChnInfo->fdtype.channel.outputBuf, 
+                   &numMsgs)) != NULL))
+        {
+            if (numMsgs > (int) wncTxqFree(txQueue))
+                numMsgs = (int) wncTxqFree(txQueue);
+            for (i = 0; i < numMsgs; i++, pRec += recSize)
+                (void) wncTxqPut(txQueue, (WNCAN_CHNMSG *) pRec, hasDeadline ? 
+                    ((WNCAN_TXMSG *) pRec)->deadline : 0);
+            wncRingRemove(pChnInfo->fdtype.channel.outputBuf, numMsgs);
+        }
     }
     
-    canDev = wncDrv->wncDevice;
-    if (canDev == NULL)
+    if ((txQueue != NULL) && !wncTxqIsEmpty(txQueue))
     {
-#if DEVIO_DEBUG
-        logMsg("wncDevIOIoctl() ERROR: pointer to DevIO device is null\n", 
+        *pDeadline = wncTxqDeadline(txQueue);
+        return wncTxqPeek(txQueue);
+    }
+    
+    pRec = wncRingPeek(pChnInfo->fdtype.channel.outputBuf);
+    *pDeadline = ((pRec != NULL) && hasDeadline) ? 
+        ((WNCAN_TXMSG *) pRec)->deadline : 0;
+    return (WNCAN_CHNMSG *) pRec;
+}
+
+
+/************************************************************************
+*
+* wncUtilTxRemove - remove the frame returned by wncUtilTxNext()
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void wncUtilTxRemove
+(
+ WNCAN_DEVIO_FDINFO  *pChnInfo   /* the descriptor writing the channel */
+ )
+{
+    WNCAN_TXQUEUE_ID  txQueue = pChnInfo->fdtype.channel.txQueue;
+    
+    if ((txQueue != NULL) && !wncTxqIsEmpty(txQueue))
+        wncTxqRemove(txQueue);
+    else
+        wncRingRemove(pChnInfo->fdtype.channel.outputBuf, 1);
+}
+
+
+/************************************************************************
+*
+* wncUtilTxDeadlineStart - time the deadline of the frame in the controller
+*
+* This routine starts the channel's deadline timer to expire at the first 
+* system clock tick after txDeadline. "now" is the current timestamp, or 0 
+* if it has not been read yet. Called with interrupts locked.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+LOCAL void wncUtilTxDeadlineStart
+(
+ WNCAN_DEVIO_FDINFO  *pChnInfo,  /* the descriptor writing the channel */
+ UINT64               now        /* current timestamp, or 0 */
+ )
+{
+    UINT32  tsFreq = (wncDevIOTsFreq != 0) ? 
+                     wncDevIOTsFreq : sysTimestampFreq();
+    UINT64  delay;
+    
+    if (pChnInfo->fdtype.channel.txDeadlineWd == NULL)
+        return;
+    
+    if (now == 0)
+        now = (*wncDevIOTsFunc)();
+    delay = (pChnInfo->fdtype.channel.txDeadline > now) ? 
+        pChnInfo->fdtype.channel.txDeadline - now : 0;
+    
+    wdStart (pChnInfo->fdtype.channel.txDeadlineWd, 
+        (int) (delay * sysClkRateGet() / tsFreq) + 1, 
+        (FUNCPTR) wncUtilTxDeadlineExpired, (int) pChnInfo);
+}
+
+
+/************************************************************************
+*
+* wncUtilTxDeadlineExpired - transmit deadline timer routine
+*
+* This watchdog routine aborts the transmission of the frame in the 
+* controller if it is still pending at its deadline, e.g. because it keeps 
+* losing arbitration or is not acknowledged. The TX interrupt that follows 
+* the abort loads the next frame. If the frame has already started on the 
+* bus, the controller completes it regardless.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilTxDeadlineExpired
+(
+ WNCAN_DEVIO_FDINFO  *pChnInfo  /* pointer to channel's DevIO descriptor */
+ )
+{
+    int  key;
+    
+    /* the CAN interrupt may preempt the system clock interrupt */
+    key = intLock();
+    if (pChnInfo->fdtype.channel.txDeadline != 0)
+    {
+        if ((*wncDevIOTsFunc)() < pChnInfo->fdtype.channel.txDeadline)
+        {
+            /* the system clock ran ahead of the timestamp */
+            wncUtilTxDeadlineStart(pChnInfo, 0);
+        }
+        else
+        {
+            /* counted as expired if the TX interrupt shows the abort
+            ** took effect before the frame was sent
+            */
+            CAN_TxAbort(pChnInfo->wnDevIODrv->wncDevice);
+            pChnInfo->fdtype.channel.txExpiring = TRUE;
+            pChnInfo->fdtype.channel.txDeadline = 0;
+        }
+    }
+    intUnlock(key);
+}
+
+
+/************************************************************************
+*
+* wncUtilRxReserve - get an input buffer slot for a received frame
+*
+* This routine decides for one descriptor reading a channel whether it 
+* takes the frame with the given ID, and if so reserves the slot the 
+* message is built in. It is called by the ISR handler for each descriptor 
+* open on the channel.
+*
+* RETURNS: pointer to the slot, or NULL if the descriptor does not read the 
+* channel, its filter rejects the frame or its input buffer is full
+*
+* ERRNO: S_can_buffer_overflow
+*
+*/
+
+LOCAL char *wncUtilRxReserve
+(
+ WNCAN_DEVIO_FDINFO  *pChnInfo,  /* pointer to channel's DevIO descriptor */
+ ULONG                id,        /* CAN ID of the frame */
+ BOOL                 extId      /* whether the ID is extended */
+ )
+{
+    char  *pSlot;
+    
+    /* write-only descriptor */
+    if (pChnInfo->fdtype.channel.inputBuf == NULL)
+        return NULL;
+    
+    pChnInfo->stats.rxFrames++;
+    
+    /* a frame the reader has not asked for is neither queued nor numbered */
+    if ((pChnInfo->fdtype.channel.rxFilter != NULL) &&
+        !wncFilterMatch(pChnInfo->fdtype.channel.rxFilter, id, extId))
+    {
+        pChnInfo->stats.rxFiltered++;
+        return NULL;
+    }
+    
+    pSlot = wncRingReserve(pChnInfo->fdtype.channel.inputBuf);
+    if (pSlot == NULL)
+    {
+    /* internal buffer full, report error 
+    ** NOTE: it is not advised to use logmsg here because if the controller
+    ** is getting flooded, the logging of the error message will
+    ** just make the overflow condition worse.
+        */
+#if DEVIO_DEBUG
+        logMsg("wncDevIOIsrHandler() ERROR: Internal buffer full \n",0,0,0,0,0,0);
+#endif
+        /* the dropped frame still takes a sequence number */
+        pChnInfo->fdtype.channel.rxSeqNum++;
+        pChnInfo->stats.rxDropped++;
+        errnoSet (S_can_buffer_overflow);
+    }
+    
+    return pSlot;
+}
+
+
+/************************************************************************
+*
+* wncUtilRxPublish - queue a received message to a reader
+*
+* This routine completes the message built in the slot returned by 
+* wncUtilRxReserve(), publishes it to the reader of the descriptor and 
+* wakes the reader as configured by WNCAN_CHNWAKEUP_SET.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilRxPublish
+(
+ WNCAN_DEVIO_FDINFO  *pChnInfo,  /* pointer to channel's DevIO descriptor */
+ char                *pSlot,     /* slot holding the message */
+ UINT64               timeStamp  /* receive time, WNCAN_MSGFMT_TS only */
+ )
+{
+    UINT32  seqNum;
+    UINT    count;
+    
+    /* the slots only hold the extra fields in the timestamped format */
+    seqNum = pChnInfo->fdtype.channel.rxSeqNum++;
+    if (pChnInfo->fdtype.channel.msgFormat == WNCAN_MSGFMT_TS)
+    {
+        ((WNCAN_CHNMSG_TS *) pSlot)->seqNum = seqNum;
+        ((WNCAN_CHNMSG_TS *) pSlot)->timeStamp = timeStamp;
+    }
+    
+    /* publish the message to the reader */
+    wncRingCommit(pChnInfo->fdtype.channel.inputBuf, 1);
+    
+    count = wncRingCount(pChnInfo->fdtype.channel.inputBuf);
+    if (count > pChnInfo->stats.rxHighWater)
+        pChnInfo->stats.rxHighWater = count;
+    
+    /* wake up blocked tasks; only a task that found too few 
+    ** messages in FIOSELECT is pending, so it is woken once on the 
+    ** message that reaches the threshold rather than on every one
+    */
+    if (pChnInfo->fdtype.channel.rxWaiting)
+    {
+        if ((count >= pChnInfo->fdtype.channel.rxWakeThresh) ||
+            wncRingIsFull(pChnInfo->fdtype.channel.inputBuf))
+            wncUtilRxWakeup(pChnInfo);
+        else if ((pChnInfo->fdtype.channel.rxLatencyTicks > 0) &&
+            !pChnInfo->fdtype.channel.rxWdArmed)
+        {
+            /* first message below the threshold, bound its wait */
+            pChnInfo->fdtype.channel.rxWdArmed = TRUE;
+            wdStart (pChnInfo->fdtype.channel.rxLatencyWd, 
+                pChnInfo->fdtype.channel.rxLatencyTicks, 
+                (FUNCPTR) wncUtilRxLatencyExpired, (int) pChnInfo);
+        }
+    }
+}
+
+
+/************************************************************************
+*
+* wncUtilRxWakeup - wake the readers pending on a channel
+*
+* This routine wakes the tasks pending in select() for reading on the 
+* channel and stops its max-latency timer. It is called at interrupt level 
+* or with interrupts locked.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilRxWakeup
+(
+ WNCAN_DEVIO_FDINFO  *pChnInfo  /* pointer to channel's DevIO descriptor */
+ )
+{
+    if (pChnInfo->fdtype.channel.rxWdArmed)
+    {
+        wdCancel (pChnInfo->fdtype.channel.rxLatencyWd);
+        pChnInfo->fdtype.channel.rxWdArmed = FALSE;
+    }
+    
+    pChnInfo->fdtype.channel.rxWaiting = FALSE;
+    selWakeupAll (&pChnInfo->selWakeupList, SELREAD);
+}
+
+
+/************************************************************************
+*
+* wncUtilRxLatencyExpired - max-latency timer routine
+*
+* This watchdog routine wakes the pending readers of a channel when the 
+* oldest queued message has waited the channel's maximum latency without 
+* the read threshold being reached.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilRxLatencyExpired
+(
+ WNCAN_DEVIO_FDINFO  *pChnInfo  /* pointer to channel's DevIO descriptor */
+ )
+{
+    int  key;
+    
+    /* the CAN interrupt may preempt the system clock interrupt */
+    key = intLock();
+    pChnInfo->fdtype.channel.rxWdArmed = FALSE;
+    if (pChnInfo->fdtype.channel.rxWaiting && 
+        !wncRingIsEmpty(pChnInfo->fdtype.channel.inputBuf))
+        wncUtilRxWakeup(pChnInfo);
+    intUnlock(key);
+}
+
+
+/************************************************************************
+*
+* wncUtilRxStage - stage a received frame for the deferred receive task
+*
+* This routine services the receive interrupt in deferred receive mode. It 
+* only reads the frame out of the controller into the staging buffer of the 
+* device and wakes the deferred receive task once per batch; filtering and 
+* queuing to the readers are left to the task. A frame that finds the 
+* staging buffer full is read out and dropped.
+*
+* RETURNS: N/A
+*
+* ERRNO: S_can_buffer_overflow
+*
+*/
+
+LOCAL void wncUtilRxStage
+(
+ struct WNCAN_Device *pDev,       /* CAN device */
+ WNCAN_DEVIO_FDINFO  *pDevInfo,   /* pointer to device's DevIO descriptor */
+ UCHAR                chnNum,     /* channel the frame was received on */
+ UINT64               timeStamp   /* receive time, if a reader wants it */
+ )
+{
+    WNCAN_STAGEMSG  *pStaged;
+    WNCAN_CHNMSG     rxMsg;     /* scratch for a frame that is dropped */
+    BOOL             extId;
+    BOOL             newdata;   /* unused, but needed for the api call */
+    
+    pStaged = (WNCAN_STAGEMSG *) wncRingReserve(pDevInfo->fdtype.device.rxStage);
+    if (pStaged == NULL)
+    {
+        rxMsg.len = WNCAN_MAX_DATA_LEN;
+        CAN_ReadData(pDev, chnNum, rxMsg.data, &rxMsg.len, &newdata);
+        pDevInfo->fdtype.device.stageDropped++;
+        errnoSet (S_can_buffer_overflow);
+        return;
+    }
+    
+    pStaged->msg.id = CAN_ReadID(pDev, chnNum, &extId);
+    pStaged->msg.extId = extId;
+    pStaged->msg.rtr = (CAN_IsRTR(pDev, chnNum) == TRUE ? TRUE : FALSE);
+    pStaged->msg.len = WNCAN_MAX_DATA_LEN;
+    CAN_ReadData(pDev, chnNum, pStaged->msg.data, &pStaged->msg.len, &newdata);
+    pStaged->timeStamp = timeStamp;
+    pStaged->chnNum = chnNum;
+    wncRingCommit(pDevInfo->fdtype.device.rxStage, 1);
+    pDevInfo->fdtype.device.staged++;
+    
+    /* the task drains everything staged up to its run, so one wakeup 
+    ** covers the frames that arrive before it gets there
+    */
+    if (!pDevInfo->fdtype.device.deferPosted)
+    {
+        pDevInfo->fdtype.device.deferPosted = TRUE;
+        semGive (pDevInfo->fdtype.device.deferSem);
+    }
+}
+
+
+/************************************************************************
+*
+* wncUtilRxDeferDrain - queue the staged frames to the readers
+*
+* This routine passes each frame in the staging buffer through the filters 
+* of the descriptors reading its channel and queues it to those that accept 
+* it, as the ISR does in ISR receive mode. Interrupts are locked for one 
+* frame at a time: the ISR remains the only other user of the input buffers, 
+* and the channel descriptors cannot be unlinked by close() in the middle of 
+* a frame.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilRxDeferDrain
+(
+ WNCAN_DEVIO_FDINFO  *pDevInfo   /* pointer to device's DevIO descriptor */
+ )
+{
+    WNCAN_MSGRING_ID     stage = pDevInfo->fdtype.device.rxStage;
+    WNCAN_STAGEMSG      *pStaged;
+    WNCAN_DEVIO_FDINFO  *pSub;      /* a descriptor reading the channel */
+    WNCAN_CHNMSG_TS     *pSlot;
+    int                  numMsgs;
+    int                  key;
+    
+    while ((pStaged = (WNCAN_STAGEMSG *) wncRingPeekRun(stage, &numMsgs)) != NULL)
+    {
+        for (; numMsgs > 0; numMsgs--, pStaged++)
+        {
+            key = intLock();
+            for (pSub = pDevInfo->fdtype.device.chnInfo[pStaged->chnNum]; 
+                 pSub != NULL; 
+                 pSub = pSub->fdtype.channel.next)
+            {
+                pSlot = (WNCAN_CHNMSG_TS *) 
+                    wncUtilRxReserve(pSub, pStaged->msg.id, pStaged->msg.extId);
+                if (pSlot == NULL)
+                    continue;
+                
+                pSlot->msg = pStaged->msg;
+                wncUtilRxPublish(pSub, (char *) pSlot, pStaged->timeStamp);
+            }
+            intUnlock(key);
+            
+            wncRingRemove(stage, 1);
+        }
+    }
+}
+
+
+/************************************************************************
+*
+* wncUtilRxDeferTask - deferred receive task
+*
+* This task waits for the ISR to stage frames and queues them to the 
+* readers with wncUtilRxDeferDrain(). It exits when "deferStop" is set.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilRxDeferTask
+(
+ WNCAN_DEVIO_FDINFO  *pDevInfo   /* pointer to device's DevIO descriptor */
+ )
+{
+    for (;;)
+    {
+        semTake (pDevInfo->fdtype.device.deferSem, WAIT_FOREVER);
+        if (pDevInfo->fdtype.device.deferStop)
+            break;
+        
+        /* frames staged from here on post the semaphore again */
+        pDevInfo->fdtype.device.deferPosted = FALSE;
+        pDevInfo->fdtype.device.deferRuns++;
+        wncUtilRxDeferDrain(pDevInfo);
+    }
+    
+    semGive (pDevInfo->fdtype.device.deferExit);
+}
+
+
+/************************************************************************
+*
+* wncUtilRxDeferStop - return a device to ISR receive mode
+*
+* This routine stops the deferred receive task, queues the frames still 
+* staged and deletes the staging buffer. The caller must hold the device 
+* mutex.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilRxDeferStop
+(
+ WNCAN_DEVIO_FDINFO  *pDevInfo   /* pointer to device's DevIO descriptor */
+ )
+{
+    WNCAN_MSGRING_ID  stage = pDevInfo->fdtype.device.rxStage;
+    int               key;
+    
+    if (stage == NULL)
+        return;
+    
+    pDevInfo->fdtype.device.deferStop = TRUE;
+    semGive (pDevInfo->fdtype.device.deferSem);
+    semTake (pDevInfo->fdtype.device.deferExit, WAIT_FOREVER);
+    
+    /* the ISR stages nothing more once the buffer is detached */
+    key = intLock();
+    wncUtilRxDeferDrain(pDevInfo);
+    pDevInfo->fdtype.device.rxStage = NULL;
+    intUnlock(key);
+    
+    wncRingDelete (stage);
+    semDelete (pDevInfo->fdtype.device.deferSem);
+    semDelete (pDevInfo->fdtype.device.deferExit);
+    pDevInfo->fdtype.device.deferSem = NULL;
+    pDevInfo->fdtype.device.deferExit = NULL;
+    pDevInfo->fdtype.device.deferTask = 0;
+    pDevInfo->fdtype.device.deferStop = FALSE;
+    pDevInfo->fdtype.device.deferPosted = FALSE;
+}
+
+
+/************************************************************************
+*
+* wncUtilRxDeferSet - select the receive mode of a device
+*
+* This routine processes WNCAN_RXDEFER_SET. A non-zero "stageSize" creates 
+* the staging buffer and spawns the deferred receive task; a device already 
+* in deferred receive mode is first returned to ISR receive mode, so the 
+* frames staged so far are queued before the buffer is replaced. The ISR 
+* run time histogram is cleared. The caller must hold the device mutex.
+*
+* RETURNS: OK, or ERROR if the buffer or the task cannot be created
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL STATUS wncUtilRxDeferSet
+(
+ WNCAN_DEVIO_FDINFO  *pDevInfo,  /* pointer to device's DevIO descriptor */
+ WNCAN_RXDEFER       *pDefer     /* new configuration */
+ )
+{
+    WNCAN_MSGRING_ID  stage;
+    UINT32            tsFreq = (wncDevIOTsFreq != 0) ? 
+                               wncDevIOTsFreq : sysTimestampFreq();
+    int               key;
+    
+    wncUtilRxDeferStop(pDevInfo);
+    
+    key = intLock();
+    pDevInfo->fdtype.device.isrHist = pDefer->isrHist;
+    pDevInfo->fdtype.device.isrBinTicks = 
+        (tsFreq >= 1000000) ? tsFreq / 1000000 : 1;    /* 1 usec */
+    pDevInfo->fdtype.device.isrMaxTicks = 0;
+    bzero ((char *) pDevInfo->fdtype.device.isrCount, 
+        sizeof(pDevInfo->fdtype.device.isrCount));
+    intUnlock(key);
+    
+    if (pDefer->stageSize == 0)
+        return OK;
+    
+    stage = wncRingCreate(pDefer->stageSize, sizeof(WNCAN_STAGEMSG));
+    if (stage == NULL)
+        return ERROR;
+    
+    pDevInfo->fdtype.device.deferSem = semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+    pDevInfo->fdtype.device.deferExit = semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+    if ((pDevInfo->fdtype.device.deferSem == NULL) || 
+        (pDevInfo->fdtype.device.deferExit == NULL))
+        goto ErrorExit;
+    
+    pDevInfo->fdtype.device.deferTask = taskSpawn("tCanRxDefer", 
+        WNCAN_DEFER_PRIORITY, 0, WNCAN_DEFER_STACK, 
+        (FUNCPTR) wncUtilRxDeferTask, (int) pDevInfo, 
+        0, 0, 0, 0, 0, 0, 0, 0, 0);
+    if (pDevInfo->fdtype.device.deferTask == ERROR)
+        goto ErrorExit;
+    
+    key = intLock();
+    pDevInfo->fdtype.device.rxStage = stage;
+    intUnlock(key);
+    
+    return OK;
+    
+ErrorExit:
+    if (pDevInfo->fdtype.device.deferSem != NULL)
+        semDelete (pDevInfo->fdtype.device.deferSem);
+    if (pDevInfo->fdtype.device.deferExit != NULL)
+        semDelete (pDevInfo->fdtype.device.deferExit);
+    pDevInfo->fdtype.device.deferSem = NULL;
+    pDevInfo->fdtype.device.deferExit = NULL;
+    pDevInfo->fdtype.device.deferTask = 0;
+    wncRingDelete (stage);
+    
+    return ERROR;
+}
+
+
+/************************************************************************
+*
+* wncUtilIsrHistAdd - record the run time of the ISR handler
+*
+* This routine adds one run of wncDevIOIsrHandler() to the ISR run time 
+* histogram of the device. The bin is found by doubling the bound of bin 0, 
+* which keeps divisions out of the ISR.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilIsrHistAdd
+(
+ WNCAN_DEVIO_FDINFO  *pDevInfo,  /* pointer to device's DevIO descriptor */
+ UINT64               ticks      /* run time, timestamp ticks */
+ )
+{
+    UINT64  bound = pDevInfo->fdtype.device.isrBinTicks;
+    int     bin = 0;
+    
+    while ((ticks >= bound) && (bin < WNCAN_ISRHIST_BINS - 1))
+    {
+        bound <<= 1;
+        bin++;
+    }
+    
+    pDevInfo->fdtype.device.isrCount[bin]++;
+    if (ticks > pDevInfo->fdtype.device.isrMaxTicks)
+        pDevInfo->fdtype.device.isrMaxTicks = ticks;
+}
+
+
+/************************************************************************
+*
+* wncUtilEventPost - queue a controller event to the device descriptor
+*
+* This routine is called by the ISR handler on error, bus state and wake 
+* up interrupts. It records the timestamp, the error state and, through the 
+* controller-specific ctrlEventGet routine, the error counters and the 
+* error code capture of a bus error. The error state is derived from the 
+* bus status and the counters: a controller with a counter of 128 or more 
+* is error passive. An event that finds the queue full is dropped, but 
+* still takes a sequence number.
+*
+* RETURNS: the bus error of a WNCAN_EVENT_ERROR, otherwise WNCAN_ERR_NONE
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL WNCAN_BusError wncUtilEventPost
+(
+ struct WNCAN_Device *pDev,       /* CAN device */
+ WNCAN_DEVIO_FDINFO  *pDevInfo,   /* pointer to device's DevIO descriptor */
+ UINT                 type        /* WNCAN_EVENT_xxx */
+ )
+{
+    WNCAN_DEVIO_DRVINFO  *wncDrv = pDevInfo->wnDevIODrv;
+    WNCAN_EVENT          *pEvent;
+    WNCAN_EVENT           event;    /* scratch for an event that is dropped */
+    WNCAN_BusStatus       busStatus;
+    
+    pEvent = (WNCAN_EVENT *) wncRingReserve(pDevInfo->fdtype.device.eventBuf);
+    if (pEvent == NULL)
+        pEvent = &event;
+    
+    pEvent->timeStamp = (*wncDevIOTsFunc)();
+    pEvent->seqNum = pDevInfo->fdtype.device.eventSeq++;
+    pEvent->busError = WNCAN_ERR_NONE;
+    pEvent->type = type;
+    pEvent->flags = 0;
+    pEvent->errCode = 0;
+    pEvent->errDir = 0;
+    pEvent->errSeg = 0;
+    pEvent->rxErrCnt = 0;
+    pEvent->txErrCnt = 0;
+    
+    if (wncDrv->ctrlEventGet != NULL)
+        (*wncDrv->ctrlEventGet)(wncDrv, pEvent);
+    else if (type == WNCAN_EVENT_ERROR)
+        pEvent->busError = CAN_GetBusError(pDev);
+    
+    busStatus = CAN_GetBusStatus(pDev);
+    if (busStatus == WNCAN_BUS_OFF)
+        pEvent->state = WNCAN_ERRSTATE_BUS_OFF;
+    else if ((pEvent->flags & WNCAN_EVFLAG_COUNTERS) &&
+             ((pEvent->rxErrCnt >= 128) || (pEvent->txErrCnt >= 128)))
+        pEvent->state = WNCAN_ERRSTATE_PASSIVE;
+    else if (busStatus == WNCAN_BUS_WARN)
+        pEvent->state = WNCAN_ERRSTATE_WARNING;
+    else
+        pEvent->state = WNCAN_ERRSTATE_ACTIVE;
+    
+    if (pEvent == &event)
+        pDevInfo->fdtype.device.eventsLost++;
+    else
+        wncRingCommit(pDevInfo->fdtype.device.eventBuf, 1);
+    
+    return pEvent->busError;
+}
+
+
+/************************************************************************
+*
+* wncDevIOTimestampSet - set the receive timestamp source
+*
+* This routine replaces the source of the timestamps stored in received 
+* messages of channels that use the WNCAN_MSGFMT_TS read format, e.g. with a 
+* free-running hardware counter of the board; it is also the clock of the 
+* WNCAN_MSGFMT_DL transmit deadlines. "tsFunc" is called from the CAN 
+* interrupt and must be callable at interrupt level, and must not go 
+* backwards; "tsFreq" is its frequency in ticks per second, as reported by 
+* WNCAN_CHNMSGFMT_GET. A NULL "tsFunc" restores the default source, which 
+* extends sysTimestampLock() with the system tick count.
+*
+* RETURNS: OK, or ERROR if "tsFunc" is given without a frequency
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS wncDevIOTimestampSet
+(
+ WNCAN_TSFUNC  tsFunc,   /* timestamp source, NULL for default */
+ UINT32        tsFreq    /* ticks per second of tsFunc */
+ )
+{
+    int  key;
+    
+    if ((tsFunc != NULL) && (tsFreq == 0))
+        return ERROR;
+    
+    key = intLock();
+    if (tsFunc == NULL)
+    {
+        wncDevIOTsFunc = wncUtilTimestamp;
+        wncDevIOTsFreq = 0;
+    }
+    else
+    {
+        wncDevIOTsFunc = tsFunc;
+        wncDevIOTsFreq = tsFreq;
+    }
+    intUnlock(key);
+    
+    return OK;
+}
+
+
+/************************************************************************
+*
+* wncUtilBusOffTx - handle the output buffers across a bus off
+*
+* The frame in the controller is lost at bus off, so no TX interrupt 
+* drains the output buffers until the controller is back on the bus. 
+* With the WNCAN_BUSOFF_TX_FLUSH policy of the bus-off recovery the 
+* buffers are emptied at bus off and the frames counted as dropped; 
+* otherwise they are kept, and on the first bus state interrupt that finds 
+* the controller on the bus again each transmitter is started anew. Called 
+* from the ISR handler.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilBusOffTx
+(
+ struct WNCAN_Device *pDev,       /* CAN device */
+ WNCAN_DEVIO_FDINFO  *pDevInfo,   /* pointer to device's DevIO descriptor */
+ WNCAN_IntType        intStatus   /* WNCAN_INT_BUS_OFF or _BUS_STATE */
+ )
+{
+    WNCAN_DEVIO_FDINFO  *pChnInfo;
+    WNCAN_BusOffCfg      busOffCfg;
+    int                  numChans;
+    int                  chn;
+    
+    if (intStatus != WNCAN_INT_BUS_OFF)
+    {
+        if (!pDevInfo->fdtype.device.txStalled || 
+            (CAN_GetBusStatus(pDev) == WNCAN_BUS_OFF))
+            return;
+        
+        pDevInfo->fdtype.device.txStalled = FALSE;
+        wncUtilTxRestart(pDev, pDevInfo);
+        return;
+    }
+    
+    pDevInfo->fdtype.device.txStalled = TRUE;
+    
+    /* the frame in each controller buffer is lost */
+    numChans = CAN_GetNumChannels(pDev);
+    for (chn = 0; chn < numChans; chn++)
+    {
+        pChnInfo = pDevInfo->fdtype.device.chnInfo[chn];
+        if ((pChnInfo != NULL) && (pChnInfo->fdtype.channel.outputBuf != NULL))
+            wncUtilTxLost(pChnInfo);
+    }
+    
+    if ((pDev->pBusOff == NULL) || 
+        (CAN_BusOffRecoveryGet(pDev, &busOffCfg, NULL) != OK) ||
+        (busOffCfg.txPolicy != WNCAN_BUSOFF_TX_FLUSH))
+        return;
+    
+    for (chn = 0; chn < numChans; chn++)
+    {
+        for (pChnInfo = pDevInfo->fdtype.device.chnInfo[chn]; 
+             pChnInfo != NULL; 
+             pChnInfo = pChnInfo->fdtype.channel.next)
+        {
+            if (pChnInfo->fdtype.channel.outputBuf == NULL)
+                continue;
+            
+            /* nothing is left in the controller */
+            pChnInfo->fdtype.channel.txDeadline = 0;
+            pChnInfo->fdtype.channel.txHandover = FALSE;
+            pChnInfo->fdtype.channel.txIdle = TRUE;
+            pChnInfo->stats.txDropped += 
+                wncRingCount(pChnInfo->fdtype.channel.outputBuf);
+            wncRingFlush(pChnInfo->fdtype.channel.outputBuf);
+            if (pChnInfo->fdtype.channel.txQueue != NULL)
+            {
+                pChnInfo->stats.txDropped += 
+                    wncTxqCount(pChnInfo->fdtype.channel.txQueue);
+                wncTxqFlush(pChnInfo->fdtype.channel.txQueue);
+            }
+            if (pChnInfo->fdtype.channel.txWaiting)
+            {
+                pChnInfo->fdtype.channel.txWaiting = FALSE;
+                selWakeupAll (&pChnInfo->selWakeupList, SELWRITE);
+            }
+        }
+    }
+}
+
+
+/************************************************************************
+*
+* wncUtilTxRestart - start the transmitter of each channel anew
+*
+* This routine is called with interrupts locked at the end of a bus off, 
+* which took the frame in the controller without a TX interrupt. That frame 
+* counts as not sent, if wncUtilBusOffTx() has not counted it already, its 
+* deadline is dropped, and each channel's writer loads its next frame.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilTxRestart
+(
+ struct WNCAN_Device *pDev,       /* CAN device */
+ WNCAN_DEVIO_FDINFO  *pDevInfo    /* pointer to device's DevIO descriptor */
+ )
+{
+    WNCAN_DEVIO_FDINFO  *pChnInfo;
+    int                  numChans;
+    int                  chn;
+    
+    numChans = CAN_GetNumChannels(pDev);
+    for (chn = 0; chn < numChans; chn++)
+    {
+        /* a writer is first on the channel's list */
+        pChnInfo = pDevInfo->fdtype.device.chnInfo[chn];
+        if ((pChnInfo == NULL) || (pChnInfo->fdtype.channel.outputBuf == NULL))
+            continue;
+        
+        wncUtilTxLost(pChnInfo);
+        
+        pChnInfo->fdtype.channel.txDeadline = 0;
+        pChnInfo->fdtype.channel.txHandover = FALSE;
+        wncUtilTxPump(pDev, pChnInfo, (UCHAR) chn, FALSE);
+    }
+}
+
+
+/************************************************************************
+*
+* wncUtilTxLost - count the frame in the controller as not sent
+*
+* This routine is called from the ISR handler when the frame a channel 
+* loaded into the controller left it without being sent, on an abort or a 
+* bus off. The frame counts as expired if the deadline timer aborted it, 
+* otherwise as dropped.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilTxLost
+(
+ WNCAN_DEVIO_FDINFO  *pChnInfo  /* the descriptor writing the channel */
+ )
+{
+    if (!pChnInfo->fdtype.channel.txLoaded)
+        return;
+    
+    if (pChnInfo->fdtype.channel.txExpiring)
+        pChnInfo->stats.txExpired++;
+    else
+        pChnInfo->stats.txDropped++;
+    
+    pChnInfo->fdtype.channel.txLoaded = FALSE;
+    pChnInfo->fdtype.channel.txExpiring = FALSE;
+}
+
+
+/************************************************************************
+*
+* wncDevIOAcceptWalk - enumerate the IDs the readers of a device subscribe to
+*
+* This routine calls "rtn" with each ID/mask pair that the software filters
+* of the descriptors open for reading on the device accept, so that the
+* controller-specific ctrlAcceptUpdate routine can derive a hardware 
+* acceptance filter from them. A reader without filter rules accepts every
+* frame and is reported as a zero mask for both frame formats. Nothing is
+* reported if no channel is open for reading. The caller must hold the
+* device mutex.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncDevIOAcceptWalk
+(
+ WNCAN_DEVIO_DRVINFO  *wncDrv,  /* pointer to driver descriptor */
+ WNCAN_ACCEPTFUNC      rtn,     /* called for each ID/mask pair */
+ void                 *arg      /* first argument of rtn */
+ )
+{
+    WNCAN_DEVIO_FDINFO  *pDevInfo;
+    WNCAN_DEVIO_FDINFO  *pChnInfo;
+    int                  numChans;
+    int                  chn;
+    
+    if (!wncDrv->isDeviceOpen || (wncDrv->wncDevice == NULL))
+        return;
+    
+    pDevInfo = WNCDRV_GET_DEVICEINFO(wncDrv);
+    numChans = CAN_GetNumChannels(wncDrv->wncDevice);
+    for (chn = 0; chn < numChans; chn++)
+    {
+        for (pChnInfo = pDevInfo->fdtype.device.chnInfo[chn]; 
+             pChnInfo != NULL; 
+             pChnInfo = pChnInfo->fdtype.channel.next)
+        {
+            if (pChnInfo->fdtype.channel.inputBuf == NULL)
+                continue;
+            
+            if ((pChnInfo->fdtype.channel.rxFilter == NULL) || 
+                wncFilterIsEmpty(pChnInfo->fdtype.channel.rxFilter))
+            {
+                (*rtn)(arg, 0, 0, FALSE);
+                (*rtn)(arg, 0, 0, TRUE);
+            }
+            else
+                wncFilterWalk(pChnInfo->fdtype.channel.rxFilter, rtn, arg);
+        }
+    }
+}
+
+
+/************************************************************************
+*
+* wncUtilAcceptUpdate - recompute the hardware acceptance filter
+*
+* This routine is called with the device mutex held whenever the set of 
+* readers or their software filters changes. It does nothing unless the 
+* controller computes its acceptance filter automatically. A controller 
+* that passes through reset mode for the update services the TX interrupt 
+* the reset takes itself, e.g. SJA1000_AcceptSet().
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL void wncUtilAcceptUpdate
+(
+ WNCAN_DEVIO_DRVINFO  *wncDrv   /* pointer to driver descriptor */
+ )
+{
+    if (wncDrv->ctrlAcceptUpdate == NULL)
+        return;
+    
+    if ((*wncDrv->ctrlAcceptUpdate)(wncDrv) != OK)
+    {
+#if DEVIO_DEBUG
+        logMsg("wncUtilAcceptUpdate() ERROR: cannot set the acceptance "
+            "filter\n",0,0,0,0,0,0);
+#endif
+    }
+}
+
+
+/************************************************************************
+*
+* wncUtilTimestamp - default receive timestamp source
+*
+* This routine returns a 64-bit timestamp in sysTimestampFreq() ticks. The 
+* BSP timestamp counter rolls over once per system clock tick, so it is 
+* combined with tick64Get() to keep the value monotonic across rollovers. 
+* With interrupts locked the counter may already have rolled over while 
+* the tick interrupt is still pending, so tick64Get() is one behind; this 
+* shows as a value below the last one returned, and one period is added. 
+* A rollover is only detected within the tick of the previous call, so 
+* interrupts must not stay locked for a whole tick.
+*
+* RETURNS: the current time
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL UINT64 wncUtilTimestamp (void)
+{
+    static UINT64  lastStamp = 0;   /* value returned by the last call */
+    UINT64  stamp;
+    UINT32  period;
+    int     key;
+    
+    key = intLock();
+    period = sysTimestampPeriod();
+    stamp = tick64Get() * period + sysTimestampLock();
+    
+    /* the tick interrupt of the rollover has not run yet */
+    if ((stamp < lastStamp) && (lastStamp - stamp <= period))
+        stamp += period;
+    lastStamp = stamp;
+    intUnlock(key);
+    
+    return stamp;
+}
+
+
+
+/************************************************************************
+*
+* wncDevIOIoctl - device I/O control routine
+*
+* This routine is called by the VxWorks I/O System when user code calls ioctl().
+* It calls the appropriate WNCAN API functions to process the specified command.
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS wncDevIOIoctl
+(
+ WNCAN_DEVIO_FDINFO   *fdInfo,      /* pointer to DevIO file descriptor */
+ int                   command,     /* command function code */
+ int                   arg          /* arbitrary argument */
+ )
+{
+    WNCAN_DEVIO_DRVINFO*  wncDrv = NULL;
+    WNCAN_DEVICE*         canDev = NULL;
+    STATUS                status = ERROR;    /* pessimistic */
+    
+    if (fdInfo == NULL)
+    {
+#if DEVIO_DEBUG
+        logMsg("wncDevIOIoctl() ERROR: pointer to DevIO file descriptor is null\n", 
+            0,0,0,0,0,0);
+#endif
+        return ERROR;
+    }
+    
+    wncDrv = fdInfo->wnDevIODrv;
+    if (wncDrv == NULL)
+    {
+#if DEVIO_DEBUG
+        logMsg("wncDevIOIoctl() ERROR: pointer to DevIO driver is null\n", 
+            0,0,0,0,0,0);
+#endif
+        return ERROR;
+    }
+    
+    canDev = wncDrv->wncDevice;
+    if (canDev == NULL)
+    {
+#if DEVIO_DEBUG
+        logMsg("wncDevIOIoctl() ERROR: pointer to DevIO device is null\n", 
             0,0,0,0,0,0);
 #endif
         return ERROR;
@@ -1241,14 +2803,23 @@ STATUS wncDevIOIoctl
             status = wncUtilIoctlDeviceFioCmds(fdInfo, command, arg);
         break;
         
-        /* assumes the following only apply to channels */
-    case FIONFREE:
+        /* the input buffer of a device is its event queue */
     case FIONREAD:
-    case FIONWRITE:
     case FIOFLUSH:
     case FIORFLUSH:
-    case FIOWFLUSH:
     case FIORBUFSET:
+        if (fdInfo->devType == FD_WNCAN_DEVICE)
+        {
+            status = wncUtilIoctlDeviceFioCmds(fdInfo, command, arg);
+            break;
+        }
+        status = wncUtilIoctlFioCmds (fdInfo, command, arg);
+        break;
+        
+        /* assumes the following only apply to channels */
+    case FIONFREE:
+    case FIONWRITE:
+    case FIOWFLUSH:
     case FIOWBUFSET:
         status = wncUtilIoctlFioCmds (fdInfo, command, arg);
         break;
@@ -1268,6 +2839,11 @@ STATUS wncDevIOIoctl
     case WNCAN_CONFIG_GET:
     case WNCAN_REG_SET:
     case WNCAN_REG_GET:
+    case WNCAN_RXDEFER_SET:
+    case WNCAN_RXDEFER_GET:
+    case WNCAN_ISRHIST_GET:
+    case WNCAN_BUSOFF_SET:
+    case WNCAN_BUSOFF_GET:
         status = wncUtilIoctlDeviceCmds (fdInfo, command, arg);
         break;
         
@@ -1278,6 +2854,18 @@ STATUS wncDevIOIoctl
     case WNCAN_CHN_TX:
     case WNCAN_CHNMSGLOST_GET:
     case WNCAN_CHNMSGLOST_CLEAR:
+    case WNCAN_CHNMSGFMT_SET:
+    case WNCAN_CHNMSGFMT_GET:
+    case WNCAN_CHNRING_GET:
+    case WNCAN_CHNRING_RELEASE:
+    case WNCAN_CHNRING_PUT:
+    case WNCAN_CHNWAKEUP_SET:
+    case WNCAN_CHNWAKEUP_GET:
+    case WNCAN_CHNFILTER_ADD:
+    case WNCAN_CHNFILTER_REMOVE:
+    case WNCAN_CHNFILTER_CLEAR:
+    case WNCAN_CHNTXSCHED_SET:
+    case WNCAN_CHNTXSCHED_GET:
         status = wncUtilIoctlChannelCmds (fdInfo, command, arg);
         break;
         
@@ -1286,6 +2874,12 @@ STATUS wncDevIOIoctl
     case WNCAN_CTLRCONFIG_GET:
         status = wncUtilIoctlCtlrCmds (fdInfo, command, arg);
         break;
+        
+        /* Statistics commands */
+    case WNCAN_STATS_GET:
+    case WNCAN_STATS_CLEAR:
+        status = wncUtilIoctlStatsCmds (fdInfo, command, arg);
+        break;
     }
     
     return status;
@@ -1318,6 +2912,10 @@ LOCAL STATUS wncUtilIoctlFioCmds
     int*                  numBytes = NULL;
     int                   bufSize = 0;
     int                   key;
+    WNCAN_MSGRING_ID      oldBuf;
+    WNCAN_MSGRING_ID      newBuf;
+    WNCAN_TXQUEUE_ID      oldQueue;
+    WNCAN_TXQUEUE_ID      newQueue;
     STATUS                retCode=OK;
     
     if (fdInfo == NULL)
@@ -1360,19 +2958,48 @@ LOCAL STATUS wncUtilIoctlFioCmds
     case FIOSELECT:
         selNodeAdd (&fdInfo->selWakeupList, (SEL_WAKEUP_NODE *) arg); 
         
+        /* 
+        The ISR only wakes the list after a task has been found waiting 
+        here; checking and arming under the lock cannot miss a message 
+        */
         key = intLock();
-        if ((selWakeupType ((SEL_WAKEUP_NODE *) arg) == SELREAD) &&
-            (!rngIsEmpty(fdInfo->fdtype.channel.inputBuf)))
-        { 
-            /* data available, make sure task does not pend */ 
-            selWakeup ((SEL_WAKEUP_NODE *) arg); 
-        } 
-        if ((selWakeupType ((SEL_WAKEUP_NODE *) arg) == SELWRITE) &&
-            (!rngIsFull(fdInfo->fdtype.channel.outputBuf)))
-        { 
-            /* device ready for writing, make sure task does not pend */ 
-            selWakeup ((SEL_WAKEUP_NODE *) arg); 
-        } 
+        if (selWakeupType ((SEL_WAKEUP_NODE *) arg) == SELREAD)
+        {
+            if ((wncRingCount(fdInfo->fdtype.channel.inputBuf) >= 
+                 fdInfo->fdtype.channel.rxWakeThresh) ||
+                wncRingIsFull(fdInfo->fdtype.channel.inputBuf))
+            { 
+                /* data available, make sure task does not pend */ 
+                selWakeup ((SEL_WAKEUP_NODE *) arg); 
+            } 
+            else
+            {
+                fdInfo->fdtype.channel.rxWaiting = TRUE;
+                
+                /* messages below the threshold are already waiting */
+                if (!wncRingIsEmpty(fdInfo->fdtype.channel.inputBuf) &&
+                    (fdInfo->fdtype.channel.rxLatencyTicks > 0) &&
+                    !fdInfo->fdtype.channel.rxWdArmed)
+                {
+                    fdInfo->fdtype.channel.rxWdArmed = TRUE;
+                    wdStart (fdInfo->fdtype.channel.rxLatencyWd, 
+                        fdInfo->fdtype.channel.rxLatencyTicks, 
+                        (FUNCPTR) wncUtilRxLatencyExpired, (int) fdInfo);
+                }
+            }
+        }
+        if (selWakeupType ((SEL_WAKEUP_NODE *) arg) == SELWRITE)
+        {
+            if ((wncRingFree(fdInfo->fdtype.channel.outputBuf) >= 
+                 fdInfo->fdtype.channel.txWakeThresh) ||
+                wncRingIsEmpty(fdInfo->fdtype.channel.outputBuf))
+            { 
+                /* device ready for writing, make sure task does not pend */ 
+                selWakeup ((SEL_WAKEUP_NODE *) arg); 
+            } 
+            else
+                fdInfo->fdtype.channel.txWaiting = TRUE;
+        }
         
         intUnlock(key);
         break;
@@ -1390,84 +3017,140 @@ LOCAL STATUS wncUtilIoctlFioCmds
     case FIONFREE:
         /* Get #free bytes in output data buffer */
         numBytes = (int *) arg;
-        *numBytes = rngFreeBytes (fdInfo->fdtype.channel.outputBuf);
+        *numBytes = wncRingFree (fdInfo->fdtype.channel.outputBuf) * 
+            WNCDEV_TXMSG_SIZE(fdInfo);
         break;
         
     case FIONREAD:
         /* Get #bytes ready to be read from the input data buffer */
         numBytes = (int *) arg;
-        *numBytes = rngNBytes (fdInfo->fdtype.channel.inputBuf);
+        *numBytes = wncRingCount (fdInfo->fdtype.channel.inputBuf) * 
+            fdInfo->fdtype.channel.inputBuf->msgSize;
         break;
         
     case FIONWRITE:
         /* Get #bytes written to the output data buffer */
         numBytes = (int *) arg;
-        *numBytes = rngNBytes (fdInfo->fdtype.channel.outputBuf);
+        *numBytes = wncRingCount (fdInfo->fdtype.channel.outputBuf) * 
+            WNCDEV_TXMSG_SIZE(fdInfo);
+        if (fdInfo->fdtype.channel.txQueue != NULL)
+            *numBytes += wncTxqCount (fdInfo->fdtype.channel.txQueue) * 
+                WNCDEV_TXMSG_SIZE(fdInfo);
         break;
         
     case FIOFLUSH:
-        /* Discard all bytes in both input and output data buffers */
-        key = intLock();
-        rngFlush (fdInfo->fdtype.channel.inputBuf);
-        rngFlush (fdInfo->fdtype.channel.outputBuf);
-        intUnlock(key);
-        break;
-        
     case FIORFLUSH:
-        /* Discard all bytes in the input data buffer */
-        key = intLock();
-        rngFlush (fdInfo->fdtype.channel.inputBuf);
-        intUnlock(key);
-        break;
+        /* Discard all bytes in the input data buffer; a reading task is
+        ** its other consumer
+        */
+        if (fdInfo->fdtype.channel.inputBuf != NULL)
+        {
+            semTake (fdInfo->rdMutex, WAIT_FOREVER);
+            key = intLock();
+            wncRingFlush (fdInfo->fdtype.channel.inputBuf);
+            intUnlock(key);
+            semGive (fdInfo->rdMutex);
+        }
+        if (command == FIORFLUSH)
+            break;
+        
+        /* FIOFLUSH discards the output data buffer as well */
         
     case FIOWFLUSH:
         /* Discard all bytes in the output data buffer */
+        if (fdInfo->fdtype.channel.outputBuf == NULL)
+            break;
         key = intLock();
-        rngFlush (fdInfo->fdtype.channel.outputBuf);
+        wncRingFlush (fdInfo->fdtype.channel.outputBuf);
+        if (fdInfo->fdtype.channel.txQueue != NULL)
+            wncTxqFlush (fdInfo->fdtype.channel.txQueue);
         intUnlock(key);
         break;
         
     case FIORBUFSET:
         /* Set the input data buffer size; User specifies #msgs */
-        bufSize = wncUtilCalcRingBufSize (arg);
-        if (bufSize)
+        bufSize = arg;
+        oldBuf = fdInfo->fdtype.channel.inputBuf;
+        if ((oldBuf == NULL) || fdInfo->fdtype.channel.ringShared)
         {
-            key = intLock();
-            rngFlush(fdInfo->fdtype.channel.inputBuf);
-            rngDelete(fdInfo->fdtype.channel.inputBuf);
-            fdInfo->fdtype.channel.inputBuf = rngCreate(bufSize);
-            if(fdInfo->fdtype.channel.inputBuf == NULL)
+            /* write-only channel, or a task is reading the buffer in place */
+            retCode = ERROR;
+        }
+        else if (bufSize > 0)
+        {
+            newBuf = wncRingCreate(bufSize, oldBuf->msgSize);
+            if (newBuf == NULL)
             {
 #if DEVIO_DEBUG
                 logMsg("wncUtilIoctlFioCmds() ERROR: FIORBUFSET ring create failed\n", 
                     0,0,0,0,0,0);
 #endif
-                retCode=ERROR;
-                
+                retCode = ERROR;
+                break;
             }
+            
+            /* the queued messages are discarded */
+            semTake (fdInfo->rdMutex, WAIT_FOREVER);
+            key = intLock();
+            fdInfo->fdtype.channel.inputBuf = newBuf;
             intUnlock(key);
+            semGive (fdInfo->rdMutex);
+            
+            wncRingDelete(oldBuf);
         }
         break;
         
     case FIOWBUFSET:
         /* Set the output data buffer size; User specifies #msgs */
-        bufSize = wncUtilCalcRingBufSize (arg);
-        if (bufSize)
+        bufSize = arg;
+        oldBuf = fdInfo->fdtype.channel.outputBuf;
+        if (oldBuf == NULL)
         {
-            key = intLock();
-            rngFlush(fdInfo->fdtype.channel.outputBuf);
-            rngDelete(fdInfo->fdtype.channel.outputBuf);
-            fdInfo->fdtype.channel.outputBuf = rngCreate(bufSize);
-            if(fdInfo->fdtype.channel.outputBuf == NULL)
+            /* read-only channel, the channel may have another writer */
+            retCode = ERROR;
+        }
+        else if (bufSize > 0)
+        {
+            newBuf = wncRingCreate(bufSize, oldBuf->msgSize);
+            
+            /* the priority queue holds as many frames as the ring */
+            oldQueue = fdInfo->fdtype.channel.txQueue;
+            newQueue = NULL;
+            if ((newBuf != NULL) && (oldQueue != NULL))
+            {
+                newQueue = wncTxqCreate(bufSize);
+                if (newQueue == NULL)
+                {
+                    wncRingDelete(newBuf);
+                    newBuf = NULL;
+                }
+            }
+            if (newBuf == NULL)
             {
 #if DEVIO_DEBUG
                 logMsg("wncUtilIoctlFioCmds() ERROR: FIOWBUFSET ring create failed\n", 
                     0,0,0,0,0,0);
 #endif
-                retCode=ERROR;
-                
-            }            
+                retCode = ERROR;
+                break;
+            }
+            
+            /* 
+            The frames not yet loaded into the controller are discarded; the 
+            frame in it still raises the TX interrupt that pumps the new 
+            buffer 
+            */
+            semTake (fdInfo->wrMutex, WAIT_FOREVER);
+            key = intLock();
+            fdInfo->fdtype.channel.outputBuf = newBuf;
+            if (oldQueue != NULL)
+                fdInfo->fdtype.channel.txQueue = newQueue;
             intUnlock(key);
+            semGive (fdInfo->wrMutex);
+            
+            wncRingDelete(oldBuf);
+            if (oldQueue != NULL)
+                wncTxqDelete(oldQueue);
         }
         break;
     }
@@ -1502,6 +3185,9 @@ LOCAL STATUS wncUtilIoctlDeviceFioCmds
 {
     WNCAN_DEVIO_DRVINFO*  wncDrv = NULL;
     WNCAN_DEVICE*         canDev = NULL;
+    WNCAN_MSGRING_ID      eventBuf;
+    WNCAN_MSGRING_ID      oldBuf;
+    STATUS                retCode = OK;
     int                   key;
     
     if (fdInfo == NULL)
@@ -1546,9 +3232,9 @@ LOCAL STATUS wncUtilIoctlDeviceFioCmds
         
         key = intLock();
         if ((selWakeupType ((SEL_WAKEUP_NODE *) arg) == SELREAD) &&
-            (CAN_GetBusStatus(canDev) != WNCAN_BUS_OK))
+            !wncRingIsEmpty(fdInfo->fdtype.device.eventBuf))
         { 
-            /* bus in an error/warning state, make sure task does not pend */ 
+            /* controller events are queued, make sure task does not pend */ 
             selWakeup ((SEL_WAKEUP_NODE *) arg); 
         }
         
@@ -1565,12 +3251,50 @@ LOCAL STATUS wncUtilIoctlDeviceFioCmds
         /* delete node from wakeup list */ 
         selNodeDelete (&fdInfo->selWakeupList, (SEL_WAKEUP_NODE *) arg); 
         break;
+        
+    case FIONREAD:
+        /* Get #bytes of events ready to be read */
+        *(int *) arg = wncRingCount (fdInfo->fdtype.device.eventBuf) * 
+            sizeof(WNCAN_EVENT);
+        break;
+        
+    case FIOFLUSH:
+    case FIORFLUSH:
+        /* Discard the queued events */
+        semTake (fdInfo->rdMutex, WAIT_FOREVER);
+        key = intLock();
+        wncRingFlush (fdInfo->fdtype.device.eventBuf);
+        intUnlock(key);
+        semGive (fdInfo->rdMutex);
+        break;
+        
+    case FIORBUFSET:
+        /* Set the event queue size; User specifies #events */
+        if (arg <= 0)
+            break;
+        
+        eventBuf = wncRingCreate(arg, sizeof(WNCAN_EVENT));
+        if (eventBuf == NULL)
+        {
+            retCode = ERROR;
+            break;
+        }
+        
+        /* the queued events are discarded */
+        semTake (fdInfo->rdMutex, WAIT_FOREVER);
+        key = intLock();
+        oldBuf = fdInfo->fdtype.device.eventBuf;
+        fdInfo->fdtype.device.eventBuf = eventBuf;
+        intUnlock(key);
+        semGive (fdInfo->rdMutex);
+        wncRingDelete (oldBuf);
+        break;
     }
     
     /* unlock device */
     semGive(wncDrv->mutex);
     
-    return OK;
+    return retCode;
 }
 
 
@@ -1794,6 +3518,75 @@ LOCAL STATUS wncUtilIoctlDeviceCmds
             regCfg->length);
         
         break;
+        
+    case WNCAN_RXDEFER_SET:
+        if ((WNCAN_RXDEFER *) arg == NULL)
+            break;
+        
+        status = wncUtilRxDeferSet (WNCDRV_GET_DEVICEINFO(wncDrv), 
+            (WNCAN_RXDEFER *) arg);
+        break;
+        
+    case WNCAN_RXDEFER_GET:
+        {
+            WNCAN_DEVIO_FDINFO  *pDevInfo = WNCDRV_GET_DEVICEINFO(wncDrv);
+            WNCAN_RXDEFER       *pDefer = (WNCAN_RXDEFER *) arg;
+            
+            if (pDefer == NULL)
+                break;
+            
+            pDefer->stageSize = (pDevInfo->fdtype.device.rxStage != NULL) ? 
+                pDevInfo->fdtype.device.rxStage->numMsgs : 0;
+            pDefer->isrHist = pDevInfo->fdtype.device.isrHist;
+        }
+        status = OK;
+        break;
+        
+    case WNCAN_ISRHIST_GET:
+        {
+            WNCAN_DEVIO_FDINFO  *pDevInfo = WNCDRV_GET_DEVICEINFO(wncDrv);
+            WNCAN_ISRHIST       *pHist = (WNCAN_ISRHIST *) arg;
+            UINT32               tsFreq = (wncDevIOTsFreq != 0) ? 
+                                     wncDevIOTsFreq : sysTimestampFreq();
+            UINT64               maxTicks;
+            int                  key;
+            
+            if (pHist == NULL)
+                break;
+            
+            /* take a consistent copy, the ISR updates the bins */
+            key = intLock();
+            bcopy ((char *) pDevInfo->fdtype.device.isrCount, 
+                (char *) pHist->count, sizeof(pHist->count));
+            maxTicks = pDevInfo->fdtype.device.isrMaxTicks;
+            intUnlock(key);
+            
+            pHist->binNs = (UINT32) 
+                (((UINT64) pDevInfo->fdtype.device.isrBinTicks * 1000000000) / 
+                 tsFreq);
+            pHist->maxNs = (UINT32) ((maxTicks * 1000000000) / tsFreq);
+            pHist->staged = pDevInfo->fdtype.device.staged;
+            pHist->stageDropped = pDevInfo->fdtype.device.stageDropped;
+            pHist->deferRuns = pDevInfo->fdtype.device.deferRuns;
+        }
+        status = OK;
+        break;
+        
+    case WNCAN_BUSOFF_SET:
+        if ((WNCAN_BusOffCfg *) arg == NULL)
+            break;
+        
+        status = CAN_BusOffRecoverySet (wncDrv->wncDevice, 
+            (WNCAN_BusOffCfg *) arg);
+        break;
+        
+    case WNCAN_BUSOFF_GET:
+        if ((WNCAN_BusOffStats *) arg == NULL)
+            break;
+        
+        status = CAN_BusOffRecoveryGet (wncDrv->wncDevice, NULL, 
+            (WNCAN_BusOffStats *) arg);
+        break;
     }
     
     /* unlock device */
@@ -1828,6 +3621,16 @@ LOCAL STATUS wncUtilIoctlChannelCmds
     WNCAN_DEVICE*         canDev = NULL;
     STATUS                status = ERROR;    /* pessimistic */
     WNCAN_CHNCONFIG*      chnCfg = NULL;
+    WNCAN_MSGFMT*         msgFmt = NULL;
+    WNCAN_WAKEUP*         wakeup = NULL;
+    WNCAN_FILTER*         filter = NULL;
+    WNCAN_TXQUEUE_ID      txQueue;
+    WNCAN_MSGRING_ID      newBuf;
+    WNCAN_MSGRING_ID      oldBuf;
+    WNCAN_MSGRING_ID      newTxBuf;
+    WNCAN_MSGRING_ID      oldTxBuf;
+    int                   msgSize;
+    int                   key;
     
     if (fdInfo == NULL)
     {
@@ -2040,6 +3843,345 @@ LOCAL STATUS wncUtilIoctlChannelCmds
     case WNCAN_CHNMSGLOST_CLEAR:
         status = CAN_ClearMessageLost (canDev, fdInfo->fdtype.channel.channel);
         break;
+        
+    case WNCAN_CHNMSGFMT_SET:
+        msgFmt = (WNCAN_MSGFMT *) arg;
+        
+        if (((msgFmt->format != WNCAN_MSGFMT_STD) && 
+             (msgFmt->format != WNCAN_MSGFMT_TS)) ||
+            ((msgFmt->txFormat != WNCAN_MSGFMT_STD) && 
+             (msgFmt->txFormat != WNCAN_MSGFMT_DL)))
+            break;
+        
+        /* 
+        Each buffer holds records of one size only, so a buffer whose 
+        format changes is replaced by one of the same capacity and its 
+        queued messages are discarded. Both new buffers are created before 
+        either is replaced, so a failure leaves the channel unchanged 
+        */
+        oldBuf = fdInfo->fdtype.channel.inputBuf;
+        oldTxBuf = fdInfo->fdtype.channel.outputBuf;
+        newBuf = NULL;
+        newTxBuf = NULL;
+        
+        if ((oldBuf != NULL) && 
+            (msgFmt->format != fdInfo->fdtype.channel.msgFormat))
+        {
+            /* a task is reading the buffer in place */
+            if (fdInfo->fdtype.channel.ringShared)
+                break;
+            
+            msgSize = (msgFmt->format == WNCAN_MSGFMT_TS) ? 
+                sizeof(WNCAN_CHNMSG_TS) : sizeof(WNCAN_CHNMSG);
+            newBuf = wncRingCreate(oldBuf->numMsgs, msgSize);
+            if (newBuf == NULL)
+            {
+#if DEVIO_DEBUG
+                logMsg("wncUtilIoctlChannelCmds() Error: Cannot create input" 
+                    " buffer\n",0,0,0,0,0,0);
+#endif
+                break;
+            }
+        }
+        
+        if ((oldTxBuf != NULL) && 
+            (msgFmt->txFormat != fdInfo->fdtype.channel.txFormat))
+        {
+            /* the WNCAN_MSGFMT_DL format also needs the deadline timer */
+            if ((msgFmt->txFormat == WNCAN_MSGFMT_DL) && 
+                (fdInfo->fdtype.channel.txDeadlineWd == NULL))
+                fdInfo->fdtype.channel.txDeadlineWd = wdCreate();
+            
+            msgSize = (msgFmt->txFormat == WNCAN_MSGFMT_DL) ? 
+                sizeof(WNCAN_TXMSG) : sizeof(WNCAN_CHNMSG);
+            if ((msgFmt->txFormat != WNCAN_MSGFMT_DL) || 
+                (fdInfo->fdtype.channel.txDeadlineWd != NULL))
+                newTxBuf = wncRingCreate(oldTxBuf->numMsgs, msgSize);
+            if (newTxBuf == NULL)
+            {
+#if DEVIO_DEBUG
+                logMsg("wncUtilIoctlChannelCmds() Error: Cannot create output" 
+                    " buffer\n",0,0,0,0,0,0);
+#endif
+                if (newBuf != NULL)
+                    wncRingDelete(newBuf);
+                break;
+            }
+        }
+        
+        /* no read() or write() may be using the buffers replaced */
+        if (fdInfo->rdMutex != NULL)
+            semTake (fdInfo->rdMutex, WAIT_FOREVER);
+        if (fdInfo->wrMutex != NULL)
+            semTake (fdInfo->wrMutex, WAIT_FOREVER);
+        
+        key = intLock();
+        if (newBuf != NULL)
+            fdInfo->fdtype.channel.inputBuf = newBuf;
+        if (newTxBuf != NULL)
+        {
+            fdInfo->fdtype.channel.outputBuf = newTxBuf;
+            if (fdInfo->fdtype.channel.txQueue != NULL)
+                wncTxqFlush(fdInfo->fdtype.channel.txQueue);
+        }
+        fdInfo->fdtype.channel.msgFormat = msgFmt->format;
+        fdInfo->fdtype.channel.txFormat = msgFmt->txFormat;
+        intUnlock(key);
+        
+        if (fdInfo->wrMutex != NULL)
+            semGive (fdInfo->wrMutex);
+        if (fdInfo->rdMutex != NULL)
+            semGive (fdInfo->rdMutex);
+        
+        if (newBuf != NULL)
+            wncRingDelete(oldBuf);
+        if (newTxBuf != NULL)
+            wncRingDelete(oldTxBuf);
+        status = OK;
+        break;
+        
+    case WNCAN_CHNRING_GET:
+        if ((arg == 0) || (fdInfo->fdtype.channel.inputBuf == NULL))
+            break;
+        
+        fdInfo->fdtype.channel.ringShared = TRUE;
+        *((WNCAN_MSGRING_ID *) arg) = fdInfo->fdtype.channel.inputBuf;
+        status = OK;
+        break;
+        
+    case WNCAN_CHNRING_RELEASE:
+        if ((arg < 0) || (fdInfo->fdtype.channel.inputBuf == NULL))
+            break;
+        
+        /* the task is the only consumer, no interrupt lock is needed */
+        wncRingRemove(fdInfo->fdtype.channel.inputBuf, arg);
+        status = OK;
+        break;
+        
+    case WNCAN_CHNRING_PUT:
+        /* only the buffer that was handed out can be handed back */
+        if (!fdInfo->fdtype.channel.ringShared || 
+            ((WNCAN_MSGRING_ID) arg != fdInfo->fdtype.channel.inputBuf))
+            break;
+        
+        /* the records still queued are left to read() */
+        fdInfo->fdtype.channel.ringShared = FALSE;
+        status = OK;
+        break;
+        
+    case WNCAN_CHNWAKEUP_SET:
+        wakeup = (WNCAN_WAKEUP *) arg;
+        if ((wakeup == NULL) || (wakeup->rxThreshold == 0) || 
+            (wakeup->txThreshold == 0))
+            break;
+        
+        /* the max-latency timer is created on first use */
+        if ((wakeup->rxMaxLatency != 0) && 
+            (fdInfo->fdtype.channel.rxLatencyWd == NULL))
+        {
+            fdInfo->fdtype.channel.rxLatencyWd = wdCreate();
+            if (fdInfo->fdtype.channel.rxLatencyWd == NULL)
+            {
+#if DEVIO_DEBUG
+                logMsg("wncUtilIoctlChannelCmds() Error: Cannot create" 
+                    " latency timer\n",0,0,0,0,0,0);
+#endif
+                break;
+            }
+        }
+        
+        /* a threshold above the buffer size acts as "buffer full" */
+        key = intLock();
+        fdInfo->fdtype.channel.rxWakeThresh = wakeup->rxThreshold;
+        fdInfo->fdtype.channel.txWakeThresh = wakeup->txThreshold;
+        fdInfo->fdtype.channel.rxMaxLatency = wakeup->rxMaxLatency;
+        fdInfo->fdtype.channel.rxLatencyTicks = (wakeup->rxMaxLatency == 0) ? 
+            0 : (int) (((UINT64) wakeup->rxMaxLatency * sysClkRateGet() + 
+            999999) / 1000000);
+        intUnlock(key);
+        status = OK;
+        break;
+        
+    case WNCAN_CHNWAKEUP_GET:
+        wakeup = (WNCAN_WAKEUP *) arg;
+        if (wakeup == NULL)
+            break;
+        
+        wakeup->rxThreshold = fdInfo->fdtype.channel.rxWakeThresh;
+        wakeup->txThreshold = fdInfo->fdtype.channel.txWakeThresh;
+        wakeup->rxMaxLatency = fdInfo->fdtype.channel.rxMaxLatency;
+        status = OK;
+        break;
+        
+    case WNCAN_CHNFILTER_ADD:
+        filter = (WNCAN_FILTER *) arg;
+        if ((filter == NULL) || (fdInfo->fdtype.channel.inputBuf == NULL))
+            break;
+        
+        /* the filter is created on first use */
+        if (fdInfo->fdtype.channel.rxFilter == NULL)
+        {
+            fdInfo->fdtype.channel.rxFilter = wncFilterCreate();
+            if (fdInfo->fdtype.channel.rxFilter == NULL)
+            {
+#if DEVIO_DEBUG
+                logMsg("wncUtilIoctlChannelCmds() Error: Cannot create" 
+                    " receive filter\n",0,0,0,0,0,0);
+#endif
+                break;
+            }
+        }
+        
+        status = wncFilterAdd(fdInfo->fdtype.channel.rxFilter, filter);
+        if (status == OK)
+            wncUtilAcceptUpdate(wncDrv);
+        break;
+        
+    case WNCAN_CHNFILTER_REMOVE:
+        filter = (WNCAN_FILTER *) arg;
+        if ((filter == NULL) || (fdInfo->fdtype.channel.rxFilter == NULL))
+            break;
+        
+        status = wncFilterRemove(fdInfo->fdtype.channel.rxFilter, filter);
+        if (status == OK)
+            wncUtilAcceptUpdate(wncDrv);
+        break;
+        
+    case WNCAN_CHNFILTER_CLEAR:
+        if (fdInfo->fdtype.channel.rxFilter != NULL)
+        {
+            wncFilterClear(fdInfo->fdtype.channel.rxFilter);
+            wncUtilAcceptUpdate(wncDrv);
+        }
+        status = OK;
+        break;
+        
+    case WNCAN_CHNMSGFMT_GET:
+        msgFmt = (WNCAN_MSGFMT *) arg;
+        msgFmt->format = fdInfo->fdtype.channel.msgFormat;
+        msgFmt->tsFreq = (wncDevIOTsFreq != 0) ? 
+            wncDevIOTsFreq : sysTimestampFreq();
+        msgFmt->txFormat = fdInfo->fdtype.channel.txFormat;
+        status = OK;
+        break;
+        
+    case WNCAN_CHNTXSCHED_SET:
+        if (fdInfo->fdtype.channel.outputBuf == NULL)
+            break;
+        if ((arg != WNCAN_TXSCHED_FIFO) && (arg != WNCAN_TXSCHED_PRIO))
+        {
+            errnoSet(S_can_invalid_parameter);
+            break;
+        }
+        
+        /* the queue is kept after a switch back to FIFO until it drains */
+        if ((arg == WNCAN_TXSCHED_PRIO) && 
+            (fdInfo->fdtype.channel.txQueue == NULL))
+        {
+            txQueue = wncTxqCreate(fdInfo->fdtype.channel.outputBuf->numMsgs);
+            if (txQueue == NULL)
+            {
+#if DEVIO_DEBUG
+                logMsg("wncUtilIoctlChannelCmds() Error: Cannot create" 
+                    " transmit queue\n",0,0,0,0,0,0);
+#endif
+                errnoSet(S_can_out_of_memory);
+                break;
+            }
+            
+            key = intLock();
+            fdInfo->fdtype.channel.txQueue = txQueue;
+            intUnlock(key);
+        }
+        
+        fdInfo->fdtype.channel.txSched = (UINT) arg;
+        status = OK;
+        break;
+        
+    case WNCAN_CHNTXSCHED_GET:
+        if (arg == 0)
+            break;
+        *(UINT *) arg = fdInfo->fdtype.channel.txSched;
+        status = OK;
+        break;
+    }
+    
+    /* unlock device */
+    semGive(wncDrv->mutex);
+    
+    return status;
+}
+
+
+/************************************************************************
+*
+* wncUtilIoctlStatsCmds - utility routine to process statistics ioctl() 
+*                         commands
+*
+* This routine returns or clears the counters kept by the ISR handler. On a 
+* channel descriptor WNCAN_STATS_GET returns the channel counters together 
+* with the controller counters and WNCAN_STATS_CLEAR clears the channel 
+* counters; on the device descriptor both act on the controller counters.
+*
+* RETURNS: OK or ERROR
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL STATUS wncUtilIoctlStatsCmds
+(
+ WNCAN_DEVIO_FDINFO   *fdInfo,      /* pointer to DevIO file descriptor */
+ int                   command,     /* command function code */
+ int                   arg          /* arbitrary argument */
+ )
+{
+    WNCAN_DEVIO_DRVINFO*  wncDrv = fdInfo->wnDevIODrv;
+    WNCAN_DEVIO_FDINFO*   pDevInfo;
+    WNCAN_STATS*          pStats;
+    STATUS                status = ERROR;    /* pessimistic */
+    int                   key;
+    
+    /* lock device */
+    semTake(wncDrv->mutex, WAIT_FOREVER);
+    
+    pDevInfo = WNCDRV_GET_DEVICEINFO(wncDrv);
+    if (pDevInfo == NULL)
+    {
+        semGive(wncDrv->mutex);
+        return ERROR;
+    }
+    
+    switch (command)
+    {
+    case WNCAN_STATS_GET:
+        pStats = (WNCAN_STATS *) arg;
+        if (pStats == NULL)
+            break;
+        
+        /* the counters are only ever incremented, no lock is needed */
+        if (fdInfo->devType == FD_WNCAN_CHANNEL)
+            *pStats = fdInfo->stats;
+        else
+            bzero((char*)pStats, sizeof(WNCAN_STATS));
+        
+        pStats->busErrors   = pDevInfo->stats.busErrors;
+        pStats->busErrBit   = pDevInfo->stats.busErrBit;
+        pStats->busErrAck   = pDevInfo->stats.busErrAck;
+        pStats->busErrCrc   = pDevInfo->stats.busErrCrc;
+        pStats->busErrForm  = pDevInfo->stats.busErrForm;
+        pStats->busErrStuff = pDevInfo->stats.busErrStuff;
+        pStats->busOff      = pDevInfo->stats.busOff;
+        status = OK;
+        break;
+        
+    case WNCAN_STATS_CLEAR:
+        /* the ISR is the only other writer */
+        key = intLock();
+        bzero((char*)&fdInfo->stats, sizeof(WNCAN_STATS));
+        intUnlock(key);
+        status = OK;
+        break;
     }
     
     /* unlock device */
@@ -2049,6 +4191,112 @@ LOCAL STATUS wncUtilIoctlChannelCmds
 }
 
 
+/************************************************************************
+*
+* wncDevIOShow - display the DevIO statistics
+*
+* This routine prints the controller counters of every DevIO device that is 
+* open and the counters of each of its open channels. It is called by 
+* WNCAN_Show() when the DevIO interface is included.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncDevIOShow(void)
+{
+    WNCAN_DEVIO_DRVINFO  *wncDrv;
+    WNCAN_DEVIO_FDINFO   *pDevInfo;
+    WNCAN_DEVIO_FDINFO   *pChnInfo;
+    WNCAN_STATS          *pStats;
+    int                   numChans;
+    int                   chn;
+    int                   bin;
+    WNCAN_BusOffStats     busOffStats;
+    
+    printf("\nDevIO devices:\n");
+    
+    for (wncDrv = wncDevIODevList; wncDrv != NULL; wncDrv = wncDrv->next)
+    {
+        semTake(wncDrv->mutex, WAIT_FOREVER);
+        
+        printf("\n\tDevice: %s\n", wncDrv->devHdr.name);
+        
+        pDevInfo = (wncDrv->isDeviceOpen && wncDrv->wncDevice) ? 
+            WNCDRV_GET_DEVICEINFO(wncDrv) : NULL;
+        if (pDevInfo == NULL)
+        {
+            printf("\t\tnot open\n");
+            semGive(wncDrv->mutex);
+            continue;
+        }
+        
+        pStats = &pDevInfo->stats;
+        printf("\t\tBus errors: %lu (bit %lu ack %lu crc %lu form %lu "
+            "stuff %lu)\n", pStats->busErrors, pStats->busErrBit, 
+            pStats->busErrAck, pStats->busErrCrc, pStats->busErrForm, 
+            pStats->busErrStuff);
+        printf("\t\tBus off: %lu\n", pStats->busOff);
+        if (CAN_BusOffRecoveryGet(wncDrv->wncDevice, NULL, &busOffStats) == OK)
+            printf("\t\tBus-off recovery: %s restarts %lu recoveries %lu "
+                "last delay %u ms\n", 
+                (busOffStats.state == WNCAN_BUSOFF_ON_BUS) ? "on bus" :
+                (busOffStats.state == WNCAN_BUSOFF_WAIT) ? "back-off" : 
+                "recovering", busOffStats.restarts, busOffStats.recoveries, 
+                busOffStats.delay);
+        printf("\t\tEvents: %u queued %lu lost\n", 
+            wncRingCount(pDevInfo->fdtype.device.eventBuf), 
+            pDevInfo->fdtype.device.eventsLost);
+        if (pDevInfo->fdtype.device.rxStage != NULL)
+            printf("\t\tDeferred receive: staged %lu dropped %lu runs %lu "
+                "buffer %u\n", pDevInfo->fdtype.device.staged, 
+                pDevInfo->fdtype.device.stageDropped, 
+                pDevInfo->fdtype.device.deferRuns, 
+                pDevInfo->fdtype.device.rxStage->numMsgs);
+        if (pDevInfo->fdtype.device.isrHist)
+        {
+            printf("\t\tISR runs by upper bound in timestamp ticks "
+                "(max %u):\n\t\t", 
+                (UINT) pDevInfo->fdtype.device.isrMaxTicks);
+            for (bin = 0; bin < WNCAN_ISRHIST_BINS - 1; bin++)
+                printf(" <%u:%u", 
+                    pDevInfo->fdtype.device.isrBinTicks << bin, 
+                    pDevInfo->fdtype.device.isrCount[bin]);
+            printf(" more:%u\n", pDevInfo->fdtype.device.isrCount[bin]);
+        }
+        
+        numChans = CAN_GetNumChannels(wncDrv->wncDevice);
+        for (chn = 0; chn < numChans; chn++)
+        {
+            /* one entry per descriptor open on the channel */
+            for (pChnInfo = pDevInfo->fdtype.device.chnInfo[chn]; 
+                 pChnInfo != NULL; 
+                 pChnInfo = pChnInfo->fdtype.channel.next)
+            {
+                pStats = &pChnInfo->stats;
+                printf("\t\tChannel %d, descriptor %#x:\n", chn, (int) pChnInfo);
+                if (pChnInfo->fdtype.channel.inputBuf != NULL)
+                    printf("\t\t\tRX frames: %lu dropped: %lu filtered: %lu "
+                        "high-water: %lu/%u\n", pStats->rxFrames, 
+                        pStats->rxDropped, pStats->rxFiltered, pStats->rxHighWater, 
+                        pChnInfo->fdtype.channel.inputBuf->numMsgs);
+                if (pChnInfo->fdtype.channel.outputBuf != NULL)
+                    printf("\t\t\tTX frames: %lu retries: %lu dropped: %lu "
+                        "expired: %lu%s\n", 
+                        pStats->txFrames, pStats->txRetries, pStats->txDropped, 
+                        pStats->txExpired, 
+                        (pChnInfo->fdtype.channel.txSched == WNCAN_TXSCHED_PRIO) ?
+                        " (priority order)" : "");
+            }
+        }
+        
+        semGive(wncDrv->mutex);
+    }
+}
+
+
 /************************************************************************
 *
 * wncUtilIoctlCtlrCmds - utility routine to process CAN controller-specific 
@@ -2127,7 +4375,7 @@ LOCAL STATUS wncUtilIoctlCtlrCmds
         /* Process TouCAN controller command */
         
         if (wncDrv->ctrlSetConfig)
-            (*wncDrv->ctrlSetConfig)(wncDrv, (void*)arg);
+            status = (*wncDrv->ctrlSetConfig)(wncDrv, (void*)arg);
         
         break;
         
@@ -2135,7 +4383,7 @@ LOCAL STATUS wncUtilIoctlCtlrCmds
         /* Process TouCAN controller command */
         
         if (wncDrv->ctrlGetConfig)
-            (*wncDrv->ctrlGetConfig)(wncDrv, (void*)arg);
+            status = (*wncDrv->ctrlGetConfig)(wncDrv, (void*)arg);
         
         break;
     }
@@ -2147,31 +4395,3 @@ LOCAL STATUS wncUtilIoctlCtlrCmds
 }
 
 
-/************************************************************************
-*
-* wncUtilCalcRingBufSize - utility routine to calculate ring buffer size
-*
-* This routine calculates the size of the ring buffer in bytes when the
-* user specifies the number of CAN data messages to be queued
-*
-* RETURNS: size in bytes
-*
-* ERRNO: N/A
-*
-*/
-
-LOCAL int wncUtilCalcRingBufSize
-(
- int  numCanMsgs    /* #CAN msgs to queue in ring buffer */
- )
-{
-/* User will specify internal input and output data buffer size in #CAN msgs;
-    Calculate #bytes here */
-    
-    int  numBytes = 0;
-    
-    numBytes = numCanMsgs * sizeof(WNCAN_CHNMSG);
-    return numBytes;
-}
-
-
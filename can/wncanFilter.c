@@ -0,0 +1,661 @@
+/* wncanFilter.c - software CAN acceptance filter */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+This file implements the software acceptance filter defined in
+wncanFilter.h. The DevIO interface keeps one filter per channel descriptor
+and evaluates it in the receive interrupt, after the ID has been read from
+the controller, so a frame the reader is not interested in is neither
+queued nor causes a wakeup.
+
+The routines that change a filter are serialized by the caller, the DevIO
+device mutex, so only the receive interrupt runs concurrently with them.
+Each update that the interrupt could observe half done is made with
+interrupts locked; the hash set is grown into a new array that replaces
+the old one in a single locked step, so no memory is allocated or freed
+with interrupts locked.
+*/
+
+/* includes */
+
+#include <vxWorks.h>
+#include <stdlib.h>
+#include <string.h>
+#include <intLib.h>
+#include <errnoLib.h>
+#include <CAN/wncanDevIO.h>
+#include <CAN/wncanFilter.h>
+
+#ifndef _WRS_VXWORKS_5_X
+#include <memLib.h>
+#include <memPartLib.h>
+#endif
+
+/* memory allocation for 5.5 and AE are different */
+#ifdef _WRS_KERNEL
+#define WNCFILTER_MALLOC(s)  malloc(s)
+#define WNCFILTER_FREE(s)    free(s)
+#endif
+
+#ifndef _WRS_KERNEL
+
+#ifdef _WRS_VXWORKS_5_X
+#define WNCFILTER_MALLOC(s)  malloc(s)
+#define WNCFILTER_FREE(s)    free(s)
+#else
+#define WNCFILTER_MALLOC(s)  KHEAP_ALIGNED_ALLOC(s, 4)
+#define WNCFILTER_FREE(s)    KHEAP_FREE(s)
+#endif
+
+#endif
+
+/* unused hash slot; not a valid 29-bit CAN ID */
+#define WNCFILTER_FREE_SLOT   0xFFFFFFFF
+
+/* smallest hash set, in slots */
+#define WNCFILTER_MIN_SLOTS   16
+
+/* home slot of an extended ID, Fibonacci hashing */
+#define WNCFILTER_HASH(f, id) \
+    ((UINT) (((UINT32) (id) * 0x9E3779B1) >> (f)->extShift))
+
+/* locals */
+
+LOCAL BOOL   wncUtilFilterRuleValid (const WNCAN_FILTER *pRule);
+LOCAL int    wncUtilFilterExtFind (WNCAN_RXFILTER_ID filter, ULONG id);
+LOCAL STATUS wncUtilFilterExtGrow (WNCAN_RXFILTER_ID filter);
+LOCAL UINT   wncUtilFilterLowBit (UINT32 bits);
+
+
+/************************************************************************
+*
+* wncFilterCreate - create an empty software acceptance filter
+*
+* RETURNS: ID of the filter, or NULL if memory cannot be allocated
+*
+* ERRNO: N/A
+*
+*/
+
+WNCAN_RXFILTER_ID wncFilterCreate (void)
+{
+    WNCAN_RXFILTER_ID  filter;
+
+    filter = (WNCAN_RXFILTER_ID) WNCFILTER_MALLOC(sizeof(WNCAN_RXFILTER));
+    if (filter == NULL)
+        return NULL;
+
+    bzero((char *) filter, sizeof(WNCAN_RXFILTER));
+    filter->extShift = 32;
+
+    return filter;
+}
+
+
+/************************************************************************
+*
+* wncFilterDelete - delete a software acceptance filter
+*
+* The filter must no longer be reachable from the receive interrupt.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncFilterDelete
+(
+ WNCAN_RXFILTER_ID  filter
+ )
+{
+    if (filter->extHash != NULL)
+        WNCFILTER_FREE(filter->extHash);
+    WNCFILTER_FREE(filter);
+}
+
+
+/************************************************************************
+*
+* wncFilterAdd - add a rule to a software acceptance filter
+*
+* This routine adds the rule "pRule" to the filter. A WNCAN_FILTER_ID rule
+* for both frame formats adds the ID to the standard and the extended set. A
+* rule that is already in the filter is not added twice.
+*
+* RETURNS: OK, or ERROR if the rule is invalid or the filter is full
+*
+* ERRNO: S_can_invalid_parameter
+*        S_can_out_of_memory
+*
+*/
+
+STATUS wncFilterAdd
+(
+ WNCAN_RXFILTER_ID    filter,
+ const WNCAN_FILTER  *pRule
+ )
+{
+    WNCAN_FILTER_RANGE *pMask;
+    ULONG               id;
+    ULONG               mask;
+    UINT                ndx;
+    UINT                i;
+    int                 key;
+
+    if (!wncUtilFilterRuleValid(pRule))
+    {
+        errnoSet(S_can_invalid_parameter);
+        return ERROR;
+    }
+
+    id = pRule->id;
+
+    if (pRule->type == WNCAN_FILTER_MASK)
+    {
+        mask = pRule->mask & COMPARE_ALL_EXT_IDS;
+
+        for (i = 0; i < filter->numMasks; i++)
+        {
+            pMask = &filter->masks[i];
+            if ((pMask->mask == mask) && (pMask->id == (id & mask)) &&
+                (pMask->frames == pRule->frames))
+                return OK;
+        }
+
+        if (filter->numMasks >= WNCAN_FILTER_MAX_MASKS)
+        {
+            errnoSet(S_can_out_of_memory);
+            return ERROR;
+        }
+
+        /* the rule is complete before the interrupt can see it */
+        pMask = &filter->masks[filter->numMasks];
+        pMask->id = id & mask;
+        pMask->mask = mask;
+        pMask->frames = pRule->frames;
+
+        key = intLock();
+        filter->numMasks++;
+        intUnlock(key);
+
+        return OK;
+    }
+
+    /* make room for the extended ID before anything is changed */
+    if ((pRule->frames & WNCAN_FILTER_EXT) &&
+        (wncUtilFilterExtFind(filter, id) < 0))
+    {
+        if (filter->numExt >= WNCAN_FILTER_MAX_EXTIDS)
+        {
+            errnoSet(S_can_out_of_memory);
+            return ERROR;
+        }
+
+        /* keep the set at most half full so that probe runs stay short */
+        if (2 * (filter->numExt + 1) > filter->extMask + 1)
+        {
+            if (wncUtilFilterExtGrow(filter) != OK)
+            {
+                errnoSet(S_can_out_of_memory);
+                return ERROR;
+            }
+        }
+
+        ndx = WNCFILTER_HASH(filter, id);
+        while (filter->extHash[ndx] != WNCFILTER_FREE_SLOT)
+            ndx = (ndx + 1) & filter->extMask;
+
+        key = intLock();
+        filter->extHash[ndx] = id;
+        filter->numExt++;
+        intUnlock(key);
+    }
+
+    if ((pRule->frames & WNCAN_FILTER_STD) &&
+        !(filter->stdIds[id >> 5] & (1 << (id & 31))))
+    {
+        key = intLock();
+        filter->stdIds[id >> 5] |= (1 << (id & 31));
+        filter->numStd++;
+        intUnlock(key);
+    }
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* wncFilterRemove - remove a rule from a software acceptance filter
+*
+* This routine removes the rule that wncFilterAdd() added for "pRule". A
+* WNCAN_FILTER_ID rule for both frame formats removes the ID from both sets.
+* When the last rule is removed the filter accepts every frame again.
+*
+* RETURNS: OK, or ERROR if the rule is invalid or not in the filter
+*
+* ERRNO: S_can_invalid_parameter
+*
+*/
+
+STATUS wncFilterRemove
+(
+ WNCAN_RXFILTER_ID    filter,
+ const WNCAN_FILTER  *pRule
+ )
+{
+    WNCAN_FILTER_RANGE *pMask;
+    ULONG               id;
+    ULONG               mask;
+    UINT                i;
+    UINT                j;
+    UINT                home;
+    int                 ndx;
+    int                 key;
+    BOOL                found = FALSE;
+
+    if (!wncUtilFilterRuleValid(pRule))
+    {
+        errnoSet(S_can_invalid_parameter);
+        return ERROR;
+    }
+
+    id = pRule->id;
+
+    if (pRule->type == WNCAN_FILTER_MASK)
+    {
+        mask = pRule->mask & COMPARE_ALL_EXT_IDS;
+
+        for (i = 0; i < filter->numMasks; i++)
+        {
+            pMask = &filter->masks[i];
+            if ((pMask->mask == mask) && (pMask->id == (id & mask)) &&
+                (pMask->frames == pRule->frames))
+                break;
+        }
+
+        if (i == filter->numMasks)
+        {
+            errnoSet(S_can_invalid_parameter);
+            return ERROR;
+        }
+
+        key = intLock();
+        for (; i + 1 < filter->numMasks; i++)
+            filter->masks[i] = filter->masks[i + 1];
+        filter->numMasks--;
+        intUnlock(key);
+
+        return OK;
+    }
+
+    if ((pRule->frames & WNCAN_FILTER_EXT) &&
+        ((ndx = wncUtilFilterExtFind(filter, id)) >= 0))
+    {
+        /*
+         * Linear probing needs no tombstones: the entries after the hole
+         * are moved back into it unless that would put them before their
+         * home slot.
+         */
+
+        key = intLock();
+        i = (UINT) ndx;
+        j = (i + 1) & filter->extMask;
+        while (filter->extHash[j] != WNCFILTER_FREE_SLOT)
+        {
+            home = WNCFILTER_HASH(filter, filter->extHash[j]);
+            if (((j - home) & filter->extMask) >= ((j - i) & filter->extMask))
+            {
+                filter->extHash[i] = filter->extHash[j];
+                i = j;
+            }
+            j = (j + 1) & filter->extMask;
+        }
+        filter->extHash[i] = WNCFILTER_FREE_SLOT;
+        filter->numExt--;
+        intUnlock(key);
+
+        found = TRUE;
+    }
+
+    if ((pRule->frames & WNCAN_FILTER_STD) &&
+        (filter->stdIds[id >> 5] & (1 << (id & 31))))
+    {
+        key = intLock();
+        filter->stdIds[id >> 5] &= ~(1 << (id & 31));
+        filter->numStd--;
+        intUnlock(key);
+
+        found = TRUE;
+    }
+
+    if (!found)
+    {
+        errnoSet(S_can_invalid_parameter);
+        return ERROR;
+    }
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* wncFilterClear - remove all rules from a software acceptance filter
+*
+* After this routine the filter accepts every frame.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncFilterClear
+(
+ WNCAN_RXFILTER_ID  filter
+ )
+{
+    ULONG  *extHash;
+    int     key;
+
+    /* an empty filter is never searched, so the tables can be reset after */
+    key = intLock();
+    extHash = filter->extHash;
+    filter->extHash = NULL;
+    filter->extMask = 0;
+    filter->extShift = 32;
+    filter->numStd = 0;
+    filter->numExt = 0;
+    filter->numMasks = 0;
+    intUnlock(key);
+
+    bzero((char *) filter->stdIds, sizeof(filter->stdIds));
+    if (extHash != NULL)
+        WNCFILTER_FREE(extHash);
+}
+
+
+/************************************************************************
+*
+* wncFilterMatch - test a received frame against a software filter
+*
+* This routine may be called at interrupt level.
+*
+* RETURNS: TRUE if the filter is empty or a rule matches the frame, else FALSE
+*
+* ERRNO: N/A
+*
+*/
+
+BOOL wncFilterMatch
+(
+ WNCAN_RXFILTER_ID  filter,
+ ULONG              id,      /* CAN ID of the frame */
+ BOOL               extId    /* whether the ID is extended */
+ )
+{
+    WNCAN_FILTER_RANGE *pMask;
+    ULONG               slot;
+    UINT                frames;
+    UINT                ndx;
+    UINT                i;
+
+    if (wncFilterIsEmpty(filter))
+        return TRUE;
+
+    if (!extId)
+    {
+        if ((id <= COMPARE_ALL_STD_IDS) &&
+            (filter->stdIds[id >> 5] & (1 << (id & 31))))
+            return TRUE;
+    }
+    else if (filter->numExt > 0)
+    {
+        ndx = WNCFILTER_HASH(filter, id);
+        while ((slot = filter->extHash[ndx]) != WNCFILTER_FREE_SLOT)
+        {
+            if (slot == id)
+                return TRUE;
+            ndx = (ndx + 1) & filter->extMask;
+        }
+    }
+
+    frames = extId ? WNCAN_FILTER_EXT : WNCAN_FILTER_STD;
+    for (i = 0; i < filter->numMasks; i++)
+    {
+        pMask = &filter->masks[i];
+        if ((pMask->frames & frames) && (((id ^ pMask->id) & pMask->mask) == 0))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+/************************************************************************
+*
+* wncFilterWalk - enumerate the rules of a software acceptance filter
+*
+* This routine calls "rtn" once for each rule of the filter with the ID and
+* the mask of the ID bits that must match: COMPARE_ALL_STD_IDS or
+* COMPARE_ALL_EXT_IDS for an exact ID. A rule for both frame formats is
+* reported once for each. An empty filter reports nothing. It must be called
+* with the filter updates serialized, like wncFilterAdd().
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncFilterWalk
+(
+ WNCAN_RXFILTER_ID  filter,
+ WNCAN_ACCEPTFUNC   rtn,     /* called for each rule */
+ void              *arg      /* first argument of rtn */
+ )
+{
+    WNCAN_FILTER_RANGE *pMask;
+    UINT32              bits;
+    UINT                i;
+
+    for (i = 0; (i < WNCAN_FILTER_STDID_WORDS) && (filter->numStd > 0); i++)
+    {
+        for (bits = filter->stdIds[i]; bits != 0; bits &= bits - 1)
+        {
+            (*rtn)(arg, (ULONG) (i * 32 + wncUtilFilterLowBit(bits)),
+                   COMPARE_ALL_STD_IDS, FALSE);
+        }
+    }
+
+    for (i = 0; (i <= filter->extMask) && (filter->numExt > 0); i++)
+    {
+        if (filter->extHash[i] != WNCFILTER_FREE_SLOT)
+            (*rtn)(arg, filter->extHash[i], COMPARE_ALL_EXT_IDS, TRUE);
+    }
+
+    for (i = 0; i < filter->numMasks; i++)
+    {
+        pMask = &filter->masks[i];
+        if (pMask->frames & WNCAN_FILTER_STD)
+            (*rtn)(arg, pMask->id & COMPARE_ALL_STD_IDS,
+                   pMask->mask & COMPARE_ALL_STD_IDS, FALSE);
+        if (pMask->frames & WNCAN_FILTER_EXT)
+            (*rtn)(arg, pMask->id, pMask->mask, TRUE);
+    }
+}
+
+
+/************************************************************************
+*
+* wncUtilFilterRuleValid - check a filter rule
+*
+* RETURNS: TRUE if the rule is well-formed, else FALSE
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL BOOL wncUtilFilterRuleValid
+(
+ const WNCAN_FILTER  *pRule
+ )
+{
+    if (pRule == NULL)
+        return FALSE;
+
+    if ((pRule->frames == 0) ||
+        (pRule->frames & ~(WNCAN_FILTER_STD | WNCAN_FILTER_EXT)))
+        return FALSE;
+
+    switch (pRule->type)
+    {
+    case WNCAN_FILTER_ID:
+        if ((pRule->frames & WNCAN_FILTER_STD) &&
+            (pRule->id > COMPARE_ALL_STD_IDS))
+            return FALSE;
+        return (pRule->id <= COMPARE_ALL_EXT_IDS) ? TRUE : FALSE;
+
+    case WNCAN_FILTER_MASK:
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+
+
+/************************************************************************
+*
+* wncUtilFilterExtFind - find an extended ID in the hash set
+*
+* RETURNS: slot index of the ID, or -1 if it is not in the set
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL int wncUtilFilterExtFind
+(
+ WNCAN_RXFILTER_ID  filter,
+ ULONG              id
+ )
+{
+    UINT  ndx;
+
+    if (filter->numExt == 0)
+        return -1;
+
+    ndx = WNCFILTER_HASH(filter, id);
+    while (filter->extHash[ndx] != WNCFILTER_FREE_SLOT)
+    {
+        if (filter->extHash[ndx] == id)
+            return (int) ndx;
+        ndx = (ndx + 1) & filter->extMask;
+    }
+
+    return -1;
+}
+
+
+/************************************************************************
+*
+* wncUtilFilterExtGrow - double the hash set of extended IDs
+*
+* This routine rehashes the extended IDs into a new slot array twice the
+* size of the current one and then replaces it with interrupts locked.
+*
+* RETURNS: OK, or ERROR if memory cannot be allocated
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL STATUS wncUtilFilterExtGrow
+(
+ WNCAN_RXFILTER_ID  filter
+ )
+{
+    WNCAN_RXFILTER  newSet;     /* only the hash fields are used */
+    ULONG          *oldHash = filter->extHash;
+    UINT            numSlots;
+    UINT            ndx;
+    UINT            i;
+    int             key;
+
+    numSlots = (oldHash == NULL) ? WNCFILTER_MIN_SLOTS :
+        2 * (filter->extMask + 1);
+
+    newSet.extHash = (ULONG *) WNCFILTER_MALLOC(numSlots * sizeof(ULONG));
+    if (newSet.extHash == NULL)
+        return ERROR;
+
+    newSet.extMask = numSlots - 1;
+    newSet.extShift = 32;
+    for (i = numSlots; i > 1; i >>= 1)
+        newSet.extShift--;
+
+    for (i = 0; i < numSlots; i++)
+        newSet.extHash[i] = WNCFILTER_FREE_SLOT;
+
+    if (oldHash != NULL)
+    {
+        for (i = 0; i <= filter->extMask; i++)
+        {
+            if (oldHash[i] == WNCFILTER_FREE_SLOT)
+                continue;
+
+            ndx = WNCFILTER_HASH(&newSet, oldHash[i]);
+            while (newSet.extHash[ndx] != WNCFILTER_FREE_SLOT)
+                ndx = (ndx + 1) & newSet.extMask;
+            newSet.extHash[ndx] = oldHash[i];
+        }
+    }
+
+    key = intLock();
+    filter->extHash = newSet.extHash;
+    filter->extMask = newSet.extMask;
+    filter->extShift = newSet.extShift;
+    intUnlock(key);
+
+    if (oldHash != NULL)
+        WNCFILTER_FREE(oldHash);
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* wncUtilFilterLowBit - get the position of the lowest set bit
+*
+* RETURNS: bit number 0..31 of the lowest set bit of "bits", which must not
+* be zero
+*
+* ERRNO: N/A
+*
+*/
+
+LOCAL UINT wncUtilFilterLowBit
+(
+ UINT32  bits
+ )
+{
+    UINT  n = 0;
+
+    while (!(bits & 1))
+    {
+        bits >>= 1;
+        n++;
+    }
+
+    return n;
+}
@@ -0,0 +1,426 @@
+/* wncanRing.c - single-producer/single-consumer CAN message ring */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+This file implements the CAN message ring defined in wncanRing.h. The
+DevIO interface uses one ring per direction and channel; the CAN ISR is
+the only producer of the input ring and the only consumer of the output
+ring, so the task-level read() and write() paths never need to lock out
+interrupts to access them.
+
+The ring is indexed by free-running head and tail counters, masked with
+the power-of-two slot count. The producer fills the slots before it
+publishes the new tail, and the consumer copies the slots out before it
+publishes the new head; a memory barrier orders each pair.
+*/
+
+/* includes */
+
+#include <vxWorks.h>
+#include <stdlib.h>
+#include <string.h>
+#include <CAN/wncanDevIO.h>
+#include <CAN/wncanRing.h>
+
+#ifndef _WRS_VXWORKS_5_X
+#include <memLib.h>
+#include <memPartLib.h>
+#include <vxAtomicLib.h>
+#endif
+
+/*
+uniprocessor systems without vxAtomicLib only need compiler ordering; an
+empty macro would let the compiler move the slot accesses across the
+index update
+*/
+#ifndef VX_MEM_BARRIER_R
+#define VX_MEM_BARRIER_R()   __asm__ volatile ("" ::: "memory")
+#endif
+#ifndef VX_MEM_BARRIER_W
+#define VX_MEM_BARRIER_W()   __asm__ volatile ("" ::: "memory")
+#endif
+#ifndef VX_MEM_BARRIER_RW
+#define VX_MEM_BARRIER_RW()  __asm__ volatile ("" ::: "memory")
+#endif
+
+/* memory allocation for 5.5 and AE are different */
+#ifdef _WRS_KERNEL
+#define WNCRING_MALLOC(s)  malloc(s)
+#define WNCRING_FREE(s)    free(s)
+#endif
+
+#ifndef _WRS_KERNEL
+
+#ifdef _WRS_VXWORKS_5_X
+#define WNCRING_MALLOC(s)  malloc(s)
+#define WNCRING_FREE(s)    free(s)
+#else
+#define WNCRING_MALLOC(s)  KHEAP_ALIGNED_ALLOC(s, 4)
+#define WNCRING_FREE(s)    KHEAP_FREE(s)
+#endif
+
+#endif
+
+
+/************************************************************************
+*
+* wncRingCreate - create a CAN message ring
+*
+* This routine creates a ring that holds up to "numMsgs" CAN message records
+* of "msgSize" bytes each. The slot array is rounded up to a power of two,
+* but the ring never accepts more than "numMsgs" messages.
+*
+* RETURNS: ID of the ring, or NULL if an argument is not positive or memory
+* cannot be allocated
+*
+* ERRNO: N/A
+*
+*/
+
+WNCAN_MSGRING_ID wncRingCreate
+(
+ int  numMsgs,   /* #CAN msgs to queue in the ring */
+ int  msgSize    /* size of a message record, e.g. sizeof(WNCAN_CHNMSG) */
+ )
+{
+    WNCAN_MSGRING_ID  ring;
+    UINT              numSlots = 1;
+
+    if ((numMsgs <= 0) || (msgSize <= 0))
+        return NULL;
+
+    while (numSlots < (UINT)numMsgs)
+        numSlots <<= 1;
+
+    ring = (WNCAN_MSGRING_ID) WNCRING_MALLOC(sizeof(WNCAN_MSGRING));
+    if (ring == NULL)
+        return NULL;
+
+    ring->slots = (char *) WNCRING_MALLOC(numSlots * msgSize);
+    if (ring->slots == NULL)
+    {
+        WNCRING_FREE(ring);
+        return NULL;
+    }
+
+    ring->head    = 0;
+    ring->tail    = 0;
+    ring->mask    = numSlots - 1;
+    ring->numMsgs = numMsgs;
+    ring->msgSize = msgSize;
+
+    return ring;
+}
+
+
+/************************************************************************
+*
+* wncRingDelete - delete a CAN message ring
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncRingDelete
+(
+ WNCAN_MSGRING_ID  ring
+ )
+{
+    WNCRING_FREE(ring->slots);
+    WNCRING_FREE(ring);
+}
+
+
+/************************************************************************
+*
+* wncRingPut - add messages to the ring
+*
+* This routine copies up to "numMsgs" consecutive message records from
+* "pMsgs" into the ring, as many as there is room for. It may only be
+* called by the producer of the ring. "pMsgs" need not be aligned.
+*
+* RETURNS: number of messages added
+*
+* ERRNO: N/A
+*
+*/
+
+int wncRingPut
+(
+ WNCAN_MSGRING_ID  ring,
+ const char       *pMsgs,
+ int               numMsgs
+ )
+{
+    UINT  tail = ring->tail;
+    UINT  ndx;
+    UINT  nFirst;
+    UINT  freeMsgs;
+
+    freeMsgs = ring->numMsgs - (tail - ring->head);
+    if (numMsgs > (int)freeMsgs)
+        numMsgs = (int)freeMsgs;
+    if (numMsgs <= 0)
+        return 0;
+
+    /* copy in up to two runs, split where the slot array wraps */
+    ndx = tail & ring->mask;
+    nFirst = ring->mask + 1 - ndx;
+    if (nFirst > (UINT)numMsgs)
+        nFirst = numMsgs;
+
+    memcpy(ring->slots + ndx * ring->msgSize, pMsgs, nFirst * ring->msgSize);
+    if (nFirst < (UINT)numMsgs)
+        memcpy(ring->slots, pMsgs + nFirst * ring->msgSize,
+            (numMsgs - nFirst) * ring->msgSize);
+
+    /* slots must be visible before the consumer sees the new tail */
+    VX_MEM_BARRIER_W();
+    ring->tail = tail + numMsgs;
+
+    return numMsgs;
+}
+
+
+/************************************************************************
+*
+* wncRingReserve - get the next free slot of the ring
+*
+* This routine returns a pointer to the slot the next message goes to, so
+* the producer can build the message in place instead of copying it in with
+* wncRingPut(). The message is not visible to the consumer until the
+* producer calls wncRingCommit(). It may only be called by the producer.
+*
+* RETURNS: pointer to the free slot, or NULL if the ring is full
+*
+* ERRNO: N/A
+*
+*/
+
+char *wncRingReserve
+(
+ WNCAN_MSGRING_ID  ring
+ )
+{
+    UINT  tail = ring->tail;
+
+    if (tail - ring->head >= ring->numMsgs)
+        return NULL;
+
+    return ring->slots + (tail & ring->mask) * ring->msgSize;
+}
+
+
+/************************************************************************
+*
+* wncRingCommit - publish messages built in reserved slots
+*
+* This routine makes the next "numMsgs" slots, filled in place after
+* wncRingReserve(), visible to the consumer. It may only be called by the
+* producer.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncRingCommit
+(
+ WNCAN_MSGRING_ID  ring,
+ int               numMsgs
+ )
+{
+    /* slots must be visible before the consumer sees the new tail */
+    VX_MEM_BARRIER_W();
+    ring->tail += numMsgs;
+}
+
+
+/************************************************************************
+*
+* wncRingGet - remove messages from the ring
+*
+* This routine copies up to "numMsgs" of the oldest messages in the ring to
+* "pMsgs" and removes them. It may only be called by the consumer of the
+* ring. "pMsgs" need not be aligned.
+*
+* RETURNS: number of messages removed
+*
+* ERRNO: N/A
+*
+*/
+
+int wncRingGet
+(
+ WNCAN_MSGRING_ID  ring,
+ char             *pMsgs,
+ int               numMsgs
+ )
+{
+    UINT  head = ring->head;
+    UINT  ndx;
+    UINT  nFirst;
+    UINT  count;
+
+    count = ring->tail - head;
+    if (numMsgs > (int)count)
+        numMsgs = (int)count;
+    if (numMsgs <= 0)
+        return 0;
+
+    /* read the slots only after the tail that published them */
+    VX_MEM_BARRIER_R();
+
+    ndx = head & ring->mask;
+    nFirst = ring->mask + 1 - ndx;
+    if (nFirst > (UINT)numMsgs)
+        nFirst = numMsgs;
+
+    memcpy(pMsgs, ring->slots + ndx * ring->msgSize, nFirst * ring->msgSize);
+    if (nFirst < (UINT)numMsgs)
+        memcpy(pMsgs + nFirst * ring->msgSize, ring->slots,
+            (numMsgs - nFirst) * ring->msgSize);
+
+    /* slots must be copied out before the producer may reuse them */
+    VX_MEM_BARRIER_RW();
+    ring->head = head + numMsgs;
+
+    return numMsgs;
+}
+
+
+/************************************************************************
+*
+* wncRingPeek - get the oldest message without removing it
+*
+* This routine returns a pointer to the oldest message in the ring. The
+* message stays in the ring until the consumer calls wncRingRemove(), so a
+* transmitter can retry it in place. It may only be called by the consumer.
+*
+* RETURNS: pointer to the oldest message, or NULL if the ring is empty
+*
+* ERRNO: N/A
+*
+*/
+
+char *wncRingPeek
+(
+ WNCAN_MSGRING_ID  ring
+ )
+{
+    UINT  head = ring->head;
+
+    if (ring->tail == head)
+        return NULL;
+
+    VX_MEM_BARRIER_R();
+    return ring->slots + (head & ring->mask) * ring->msgSize;
+}
+
+
+/************************************************************************
+*
+* wncRingPeekRun - get the oldest messages without removing them
+*
+* This routine returns a pointer to the oldest message in the ring and
+* stores in "pNumMsgs" how many messages follow it contiguously, up to the
+* point where the slot array wraps. The consumer processes them in place
+* and then removes them with wncRingRemove(); a second call returns the
+* messages after the wrap. It may only be called by the consumer.
+*
+* RETURNS: pointer to the oldest message, or NULL if the ring is empty
+*
+* ERRNO: N/A
+*
+*/
+
+char *wncRingPeekRun
+(
+ WNCAN_MSGRING_ID  ring,
+ int              *pNumMsgs
+ )
+{
+    UINT  head = ring->head;
+    UINT  count = ring->tail - head;
+    UINT  ndx;
+
+    if (count == 0)
+    {
+        *pNumMsgs = 0;
+        return NULL;
+    }
+
+    VX_MEM_BARRIER_R();
+
+    ndx = head & ring->mask;
+    if (count > ring->mask + 1 - ndx)
+        count = ring->mask + 1 - ndx;
+
+    *pNumMsgs = (int)count;
+    return ring->slots + ndx * ring->msgSize;
+}
+
+
+/************************************************************************
+*
+* wncRingRemove - discard the oldest messages
+*
+* This routine removes up to "numMsgs" of the oldest messages from the
+* ring, typically after wncRingPeek(). It may only be called by the
+* consumer.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncRingRemove
+(
+ WNCAN_MSGRING_ID  ring,
+ int               numMsgs
+ )
+{
+    UINT  head = ring->head;
+    UINT  count = ring->tail - head;
+
+    if (numMsgs > (int)count)
+        numMsgs = (int)count;
+    if (numMsgs <= 0)
+        return;
+
+    VX_MEM_BARRIER_RW();
+    ring->head = head + numMsgs;
+}
+
+
+/************************************************************************
+*
+* wncRingFlush - discard all messages in the ring
+*
+* This routine may be called by the consumer; the producer may only call it
+* while the consumer is locked out.
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncRingFlush
+(
+ WNCAN_MSGRING_ID  ring
+ )
+{
+    VX_MEM_BARRIER_RW();
+    ring->head = ring->tail;
+}
@@ -0,0 +1,265 @@
+/* wncanTxQueue.c - CAN transmit queue ordered by arbitration priority */
+
+/*
+modification history
+--------------------
+2026/10/17             written
+*/
+
+/*
+DESCRIPTION
+This file implements the priority transmit queue defined in wncanTxQueue.h.
+The DevIO transmit interrupt moves the messages written to a channel from
+its output ring into the queue and always loads the first message of the
+queue into the controller, so a frame that would win arbitration on the bus
+is not held up behind a backlog of lower priority frames.
+
+Each entry carries an arbitration key computed once when it is added and a
+sequence number; entries are compared on the key and then on the sequence
+number, which keeps messages with the same ID in order. Adding and removing
+a message costs O(log n) entry moves.
+*/
+
+/* includes */
+
+#include <vxWorks.h>
+#include <stdlib.h>
+#include <CAN/wncanDevIO.h>
+#include <CAN/wncanTxQueue.h>
+
+#ifndef _WRS_VXWORKS_5_X
+#include <memLib.h>
+#include <memPartLib.h>
+#endif
+
+/* memory allocation for 5.5 and AE are different */
+#ifdef _WRS_KERNEL
+#define WNCTXQ_MALLOC(s)  malloc(s)
+#define WNCTXQ_FREE(s)    free(s)
+#endif
+
+#ifndef _WRS_KERNEL
+
+#ifdef _WRS_VXWORKS_5_X
+#define WNCTXQ_MALLOC(s)  malloc(s)
+#define WNCTXQ_FREE(s)    free(s)
+#else
+#define WNCTXQ_MALLOC(s)  KHEAP_ALIGNED_ALLOC(s, 4)
+#define WNCTXQ_FREE(s)    KHEAP_FREE(s)
+#endif
+
+#endif
+
+/*
+ * Arbitration key of a message: the fields in the order they are sent on
+ * the bus, dominant (0) bits winning. The 11-bit base ID comes first; then
+ * a standard frame sends RTR and a dominant IDE bit, where an extended
+ * frame sends a recessive SRR and IDE bit followed by its 18-bit ID
+ * extension and RTR.
+ */
+
+#define WNCTXQ_KEY(m) \
+    ((m)->extId ? \
+     ((((UINT32) (m)->id & COMPARE_ALL_EXT_IDS) >> 18) << 21) | (3 << 19) | \
+     (((UINT32) (m)->id & 0x3FFFF) << 1) | ((m)->rtr ? 1 : 0) : \
+     (((UINT32) (m)->id & COMPARE_ALL_STD_IDS) << 21) | \
+     ((m)->rtr ? (1 << 20) : 0))
+
+/* entry a is sent before entry b */
+#define WNCTXQ_BEFORE(a, b) \
+    (((a)->key < (b)->key) || \
+     (((a)->key == (b)->key) && ((INT32) ((a)->seqNum - (b)->seqNum) < 0)))
+
+
+/************************************************************************
+*
+* wncTxqCreate - create a priority transmit queue
+*
+* RETURNS: ID of the queue, or NULL if "numMsgs" is not positive or memory
+* cannot be allocated
+*
+* ERRNO: N/A
+*
+*/
+
+WNCAN_TXQUEUE_ID wncTxqCreate
+(
+ int  numMsgs    /* #CAN msgs to queue */
+ )
+{
+    WNCAN_TXQUEUE_ID  queue;
+
+    if (numMsgs <= 0)
+        return NULL;
+
+    queue = (WNCAN_TXQUEUE_ID) WNCTXQ_MALLOC(sizeof(WNCAN_TXQUEUE));
+    if (queue == NULL)
+        return NULL;
+
+    queue->heap = (WNCAN_TXENTRY *) WNCTXQ_MALLOC(numMsgs *
+        sizeof(WNCAN_TXENTRY));
+    if (queue->heap == NULL)
+    {
+        WNCTXQ_FREE(queue);
+        return NULL;
+    }
+
+    queue->count   = 0;
+    queue->numMsgs = numMsgs;
+    queue->seqNum  = 0;
+
+    return queue;
+}
+
+
+/************************************************************************
+*
+* wncTxqDelete - delete a priority transmit queue
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncTxqDelete
+(
+ WNCAN_TXQUEUE_ID  queue
+ )
+{
+    WNCTXQ_FREE(queue->heap);
+    WNCTXQ_FREE(queue);
+}
+
+
+/************************************************************************
+*
+* wncTxqPut - add a message to a priority transmit queue
+*
+* The deadline is kept with the message but does not affect its order.
+*
+* RETURNS: OK, or ERROR if the queue is full
+*
+* ERRNO: N/A
+*
+*/
+
+STATUS wncTxqPut
+(
+ WNCAN_TXQUEUE_ID     queue,
+ const WNCAN_CHNMSG  *pMsg,
+ UINT64               deadline   /* timestamp to send by, 0 for none */
+ )
+{
+    WNCAN_TXENTRY  entry;
+    UINT           ndx;
+    UINT           parent;
+
+    if (queue->count >= queue->numMsgs)
+        return ERROR;
+
+    entry.key = WNCTXQ_KEY(pMsg);
+    entry.seqNum = queue->seqNum++;
+    entry.deadline = deadline;
+    entry.msg = *pMsg;
+
+    /* move the parents the new entry wins against down into the hole */
+    ndx = queue->count++;
+    while (ndx > 0)
+    {
+        parent = (ndx - 1) / 2;
+        if (!WNCTXQ_BEFORE(&entry, &queue->heap[parent]))
+            break;
+        queue->heap[ndx] = queue->heap[parent];
+        ndx = parent;
+    }
+    queue->heap[ndx] = entry;
+
+    return OK;
+}
+
+
+/************************************************************************
+*
+* wncTxqPeek - get the message to send next
+*
+* The message stays in the queue until wncTxqRemove() is called, so it can
+* be retried in place while the transmitter is busy. A message added in the
+* meantime that wins arbitration takes its place.
+*
+* RETURNS: pointer to the message, or NULL if the queue is empty
+*
+* ERRNO: N/A
+*
+*/
+
+WNCAN_CHNMSG *wncTxqPeek
+(
+ WNCAN_TXQUEUE_ID  queue
+ )
+{
+    if (queue->count == 0)
+        return NULL;
+
+    return &queue->heap[0].msg;
+}
+
+
+/************************************************************************
+*
+* wncTxqRemove - remove the message to send next
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncTxqRemove
+(
+ WNCAN_TXQUEUE_ID  queue
+ )
+{
+    WNCAN_TXENTRY *pLast;
+    UINT           ndx = 0;
+    UINT           child;
+
+    if (queue->count == 0)
+        return;
+
+    /* sift the last entry down from the root */
+    pLast = &queue->heap[--queue->count];
+    for (;;)
+    {
+        child = 2 * ndx + 1;
+        if (child >= queue->count)
+            break;
+        if ((child + 1 < queue->count) &&
+            WNCTXQ_BEFORE(&queue->heap[child + 1], &queue->heap[child]))
+            child++;
+        if (!WNCTXQ_BEFORE(&queue->heap[child], pLast))
+            break;
+        queue->heap[ndx] = queue->heap[child];
+        ndx = child;
+    }
+    queue->heap[ndx] = *pLast;
+}
+
+
+/************************************************************************
+*
+* wncTxqFlush - discard all messages in a priority transmit queue
+*
+* RETURNS: N/A
+*
+* ERRNO: N/A
+*
+*/
+
+void wncTxqFlush
+(
+ WNCAN_TXQUEUE_ID  queue
+ )
+{
+    queue->count = 0;
+}
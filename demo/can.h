@@ -50,6 +50,59 @@ extern "C" {
 #define WNCAN_REG_SET            (DEVIO_CANCMD_BASE + 20)
 #define WNCAN_REG_GET            (DEVIO_CANCMD_BASE + 21)
 
+/* Channel read and write format commands */
+
+#define WNCAN_CHNMSGFMT_SET      (DEVIO_CANCMD_BASE + 22)
+#define WNCAN_CHNMSGFMT_GET      (DEVIO_CANCMD_BASE + 23)
+
+/* Statistics commands */
+
+#define WNCAN_STATS_GET          (DEVIO_CANCMD_BASE + 24)
+#define WNCAN_STATS_CLEAR        (DEVIO_CANCMD_BASE + 25)
+
+/* select() wakeup threshold commands */
+
+#define WNCAN_CHNWAKEUP_SET      (DEVIO_CANCMD_BASE + 28)
+#define WNCAN_CHNWAKEUP_GET      (DEVIO_CANCMD_BASE + 29)
+
+/* Software receive filter commands */
+
+#define WNCAN_CHNFILTER_ADD      (DEVIO_CANCMD_BASE + 30)
+#define WNCAN_CHNFILTER_REMOVE   (DEVIO_CANCMD_BASE + 31)
+#define WNCAN_CHNFILTER_CLEAR    (DEVIO_CANCMD_BASE + 32)
+
+/* 
+   Transmit scheduling commands 
+   In WNCAN_TXSCHED_PRIO mode the channel sends the pending frame that 
+   would win bus arbitration first instead of the oldest one; frames with 
+   the same ID are still sent in the order they were written 
+*/
+
+#define WNCAN_CHNTXSCHED_SET     (DEVIO_CANCMD_BASE + 33)
+#define WNCAN_CHNTXSCHED_GET     (DEVIO_CANCMD_BASE + 34)
+
+/* 
+   Deferred receive commands, device only 
+   With a staging buffer set, the ISR only reads received frames out of 
+   the controller and stages them; a task of priority WNCAN_DEFER_PRIORITY 
+   runs the software filters and queues the frames to the readers. The 
+   ISR handler run times can be recorded in either mode, see WNCAN_ISRHIST
+*/
+
+#define WNCAN_RXDEFER_SET        (DEVIO_CANCMD_BASE + 35)
+#define WNCAN_RXDEFER_GET        (DEVIO_CANCMD_BASE + 36)
+#define WNCAN_ISRHIST_GET        (DEVIO_CANCMD_BASE + 37)
+
+/* 
+   Bus-off recovery commands, device only 
+   WNCAN_BUSOFF_SET takes a WNCAN_BusOffCfg and makes the driver restart 
+   the controller after each bus off, with a delay doubled on repeated bus 
+   offs; WNCAN_BUSOFF_GET returns the WNCAN_BusOffStats
+*/
+
+#define WNCAN_BUSOFF_SET         (DEVIO_CANCMD_BASE + 38)
+#define WNCAN_BUSOFF_GET         (DEVIO_CANCMD_BASE + 39)
+
 /* ==== CAN configuration access options ==== */
 
 /* 
@@ -75,6 +128,68 @@ extern "C" {
 #define WNCAN_CHNCFG_MODE         0x800    /* selects channel mode only */
 #define WNCAN_CHNCFG_ALL          0xF00    /* selects all elements */
 
+/* 
+   CAN channel read and write formats 
+   Used in format and txFormat fields of WNCAN_MSGFMT struct
+*/
+
+#define WNCAN_MSGFMT_STD          0        /* read() and write() use WNCAN_CHNMSG */
+#define WNCAN_MSGFMT_TS           1        /* read() returns WNCAN_CHNMSG_TS */
+#define WNCAN_MSGFMT_DL           2        /* write() takes WNCAN_CHNMSG_DL,
+                                              txFormat only */
+
+/* 
+   CAN software filter rules 
+   Used in type and frames fields of WNCAN_FILTER struct
+*/
+
+#define WNCAN_FILTER_ID           0        /* rule matches one ID */
+#define WNCAN_FILTER_MASK         1        /* rule matches an ID/mask range */
+
+#define WNCAN_FILTER_STD          0x1      /* rule applies to standard frames */
+#define WNCAN_FILTER_EXT          0x2      /* rule applies to extended frames */
+
+/* 
+   CAN channel transmit scheduling modes 
+   Used as argument of WNCAN_CHNTXSCHED_SET
+*/
+
+#define WNCAN_TXSCHED_FIFO        0        /* frames are sent in write order */
+#define WNCAN_TXSCHED_PRIO        1        /* lowest ID is sent first */
+
+/* 
+   Deferred receive task and ISR run time histogram 
+   Used by WNCAN_RXDEFER_SET and WNCAN_ISRHIST_GET
+*/
+
+#define WNCAN_DEFER_PRIORITY      45       /* deferred receive task */
+#define WNCAN_DEFER_STACK         4096
+#define WNCAN_ISRHIST_BINS        16       /* bins of WNCAN_ISRHIST */
+
+/* 
+   CAN controller events 
+   Used in type, state, flags and errDir fields of WNCAN_EVENT struct
+*/
+
+#define WNCAN_EVENT_BUF_SIZE      32       /* default #events queued by the
+                                              device descriptor */
+
+#define WNCAN_EVENT_ERROR         1        /* bus error */
+#define WNCAN_EVENT_STATE         2        /* error state changed */
+#define WNCAN_EVENT_WAKEUP        3        /* controller woke up */
+
+#define WNCAN_ERRSTATE_ACTIVE     0        /* error active */
+#define WNCAN_ERRSTATE_WARNING    1        /* error warning limit reached */
+#define WNCAN_ERRSTATE_PASSIVE    2        /* error passive */
+#define WNCAN_ERRSTATE_BUS_OFF    3        /* bus off */
+
+#define WNCAN_EVFLAG_COUNTERS     0x1      /* rxErrCnt and txErrCnt are valid */
+#define WNCAN_EVFLAG_CAPTURE      0x2      /* errCode, errDir and errSeg are 
+                                              valid */
+
+#define WNCAN_ERRDIR_TX           0        /* error while transmitting */
+#define WNCAN_ERRDIR_RX           1        /* error while receiving */
+
 /* ==== Structures used for setting/getting CAN configuration ==== */
 
 typedef struct tagCANVersionInfo
@@ -139,11 +254,42 @@ typedef UINT WNCAN_BusStatus;
 #define WNCAN_INT_RX       0x10
 #define WNCAN_INT_RTR_RESPONSE 0x20
 #define WNCAN_INT_TXCLR    0x40
+#define WNCAN_INT_BUS_STATE 0x80  /* error state changed, not to bus off */
+#define WNCAN_INT_TX_ABORTED 0x100 /* transmission aborted, frame not sent;
+                                     delivered before WNCAN_INT_TXCLR */
 #define WNCAN_INT_SPURIOUS 0xffffeeee
 #define WNCAN_INT_ALL      0xffffffff 
 
 typedef UINT WNCAN_IntType;
 
+/* bus-off recovery, see WNCAN_BUSOFF_SET */
+#define WNCAN_BUSOFF_TX_KEEP    0   /* queued frames are sent after recovery */
+#define WNCAN_BUSOFF_TX_FLUSH   1   /* queued frames are discarded at bus off */
+
+#define WNCAN_BUSOFF_ON_BUS     0   /* no recovery in progress */
+#define WNCAN_BUSOFF_WAIT       1   /* back-off delay before the restart */
+#define WNCAN_BUSOFF_RECOVER    2   /* restarted, bus idle not yet seen */
+
+typedef struct tagCANBusOffCfg
+{
+    BOOL  enable;       /* restart the controller after bus off */
+    UINT  minDelay;     /* ms before the first restart, not 0 */
+    UINT  maxDelay;     /* ms, bound of the doubled delay */
+    UINT  stableTime;   /* ms error active after which the next bus off 
+                           waits minDelay again */
+    UINT  txPolicy;     /* WNCAN_BUSOFF_TX_xxx */
+} WNCAN_BusOffCfg;
+
+typedef struct tagCANBusOffStats
+{
+    UINT  state;        /* WNCAN_BUSOFF_ON_BUS, _WAIT or _RECOVER */
+    UINT  backoff;      /* delays doubled for the next bus off */
+    UINT  delay;        /* ms waited before the last restart */
+    ULONG busOffs;      /* bus-off events */
+    ULONG restarts;     /* controller restarts */
+    ULONG recoveries;   /* returns to error active after a restart */
+} WNCAN_BusOffStats;
+
 
 /*Macro definitions to be used with filtering*/
 #define COMPARE_ALL_STD_IDS 0x7FF
@@ -300,6 +446,38 @@ typedef struct _wncan_ctlrconfig
 
     } flexcanData;
 
+        struct
+        {
+            BOOL  rxDrain;     /* drain the RX FIFO on every RX interrupt,
+                                  input for SET, output for GET */
+            ULONG rxInts;      /* RX interrupts serviced, GET only */
+            ULONG rxFrames;    /* frames received, GET only */
+            ULONG rxMaxBurst;  /* most frames per RX interrupt, GET only */
+
+            /* hybrid interrupt/polled receive, input for SET, output for
+               GET; see SJA1000_RxPollSet() */
+            UINT  rxPollInts;   /* RX interrupts per window that start
+                                   polling, 0 = never poll */
+            UINT  rxPollWindow; /* window length in ticks */
+            UINT  rxPollBudget; /* frames serviced per poll cycle */
+            UINT  rxPollIdle;   /* empty poll cycles before RX interrupts
+                                   resume */
+
+            BOOL  rxPolling;    /* RX is currently polled, GET only */
+            ULONG pollEnters;   /* switches to polling, GET only */
+            ULONG pollExits;    /* switches back to interrupts, GET only */
+            ULONG pollCycles;   /* poll cycles run, GET only */
+            ULONG pollFrames;   /* frames received by polling, GET only */
+
+            /* hardware acceptance filter derived from the software filters
+               of the open channels; see SJA1000_AcceptSet() */
+            BOOL  autoAccept;   /* compute the filter automatically, input
+                                   for SET, output for GET */
+            BOOL  accDual;      /* dual filter mode in use, GET only */
+            UCHAR acr[4];       /* acceptance code registers, GET only */
+            UCHAR amr[4];       /* acceptance mask registers, GET only */
+        } sja1000Data;
+
         /* Other controller-specific structs can be defined here */
         ULONG  dummy;  /* placeholder for future defs */
 
@@ -318,6 +496,131 @@ typedef struct _wncan_chnmsg
     UCHAR data[WNCAN_MAX_DATA_LEN];  /* message data */
 }  WNCAN_CHNMSG;
 
+/* CAN message with receive timestamp, see WNCAN_MSGFMT_TS */
+
+typedef struct _wncan_chnmsg_ts
+{
+    WNCAN_CHNMSG msg;        /* CAN message */
+    UINT32       seqNum;     /* receive sequence number of the channel; a
+                                gap means frames were lost */
+    UINT64       timeStamp;  /* receive time in ticks of WNCAN_MSGFMT.tsFreq,
+                                taken in the receive interrupt */
+}  WNCAN_CHNMSG_TS;
+
+
+/* CAN message with transmit deadline, see WNCAN_MSGFMT_DL */
+
+typedef struct _wncan_chnmsg_dl
+{
+    WNCAN_CHNMSG msg;        /* CAN message */
+    UINT32       lifetime;   /* microseconds after write() by which the
+                                frame must be sent, 0 for no deadline; a
+                                frame that is late is dropped, or aborted
+                                if it is already in the controller */
+}  WNCAN_CHNMSG_DL;
+
+/* CAN channel read and write formats */
+
+typedef struct _wncan_msgfmt
+{
+    UINT   format;    /* WNCAN_MSGFMT_STD or WNCAN_MSGFMT_TS */
+    UINT32 tsFreq;    /* timestamp ticks per second, GET only */
+    UINT   txFormat;  /* WNCAN_MSGFMT_STD or WNCAN_MSGFMT_DL */
+}  WNCAN_MSGFMT;
+
+/* CAN channel select() wakeup thresholds and receive coalescing */
+
+typedef struct _wncan_wakeup
+{
+    UINT rxThreshold;  /* #msgs queued before a reader is woken, >= 1 */
+    UINT txThreshold;  /* #msgs of free space before a writer is woken, >= 1 */
+    UINT rxMaxLatency; /* usec before a reader is woken anyway, 0 = none */
+}  WNCAN_WAKEUP;
+
+/* CAN software filter rule, a zero mask selects all frames of its kind */
+
+typedef struct _wncan_filter
+{
+    UINT  type;    /* WNCAN_FILTER_ID or WNCAN_FILTER_MASK */
+    UINT  frames;  /* WNCAN_FILTER_STD and/or WNCAN_FILTER_EXT */
+    ULONG id;      /* CAN ID */
+    ULONG mask;    /* WNCAN_FILTER_MASK only: bits of id that must match */
+}  WNCAN_FILTER;
+
+/* DevIO statistics, channel counters read as zero on the device descriptor */
+
+typedef struct _wncan_stats
+{
+    /* channel counters */
+    ULONG rxFrames;      /* frames received */
+    ULONG rxDropped;     /* frames dropped, input buffer full */
+    ULONG rxFiltered;    /* frames rejected by the software filter */
+    ULONG rxHighWater;   /* most messages held by the input buffer */
+    ULONG txFrames;      /* frames sent, counted on their TX interrupt */
+    ULONG txRetries;     /* transmissions deferred, controller busy */
+    ULONG txDropped;     /* frames dropped on a transmit error, an abort
+                            or a bus off */
+    ULONG txExpired;     /* frames dropped or aborted past their deadline */
+
+    /* controller counters */
+    ULONG busErrors;     /* bus error interrupts */
+    ULONG busErrBit;     /* bit errors */
+    ULONG busErrAck;     /* acknowledgement errors */
+    ULONG busErrCrc;     /* CRC errors */
+    ULONG busErrForm;    /* form errors */
+    ULONG busErrStuff;   /* stuff errors */
+    ULONG busOff;        /* bus-off events */
+}  WNCAN_STATS;
+
+
+/* deferred receive configuration, see WNCAN_RXDEFER_SET */
+
+typedef struct _wncan_rxdefer
+{
+    UINT   stageSize;     /* frames the staging buffer holds, 0 to queue 
+                             received frames in the ISR */
+    BOOL   isrHist;       /* record the ISR run time histogram */
+}  WNCAN_RXDEFER;
+
+/* 
+   ISR run time histogram, see WNCAN_ISRHIST_GET 
+   Bin 0 counts the runs shorter than binNs, each further bin the runs 
+   shorter than twice the bound of the previous one, the last bin the rest
+*/
+
+typedef struct _wncan_isrhist
+{
+    UINT32 binNs;         /* upper bound of bin 0, nanoseconds */
+    UINT32 count[WNCAN_ISRHIST_BINS];
+    UINT32 maxNs;         /* longest run */
+    ULONG  staged;        /* frames staged by the ISR */
+    ULONG  stageDropped;  /* frames dropped, staging buffer full */
+    ULONG  deferRuns;     /* deferred receive task runs */
+}  WNCAN_ISRHIST;
+
+/* 
+   CAN controller event, read from the device descriptor 
+   The ISR queues an event on each bus error, error state change and wake 
+   up; read() returns as many as fit, and select() reports the descriptor 
+   readable while any are queued. FIORBUFSET sets the number of events 
+   queued, and seqNum skips the events lost while the queue was full
+*/
+
+typedef struct _wncan_event
+{
+    UINT64 timeStamp;     /* ticks of WNCAN_MSGFMT.tsFreq */
+    UINT32 seqNum;        /* event number */
+    UINT32 busError;      /* WNCAN_ERR_xxx of a WNCAN_EVENT_ERROR */
+    UCHAR  type;          /* WNCAN_EVENT_xxx */
+    UCHAR  state;         /* WNCAN_ERRSTATE_xxx after the event */
+    UCHAR  flags;         /* WNCAN_EVFLAG_xxx */
+    UCHAR  errCode;       /* raw error code capture, controller specific */
+    UCHAR  errDir;        /* WNCAN_ERRDIR_xxx */
+    UCHAR  errSeg;        /* frame segment of the error, controller specific */
+    UCHAR  rxErrCnt;      /* receive error counter */
+    UCHAR  txErrCnt;      /* transmit error counter */
+}  WNCAN_EVENT;
+
 
 
 
@@ -0,0 +1,556 @@
+/* canbench.c - CAN throughput and latency benchmark */
+
+/*
+DESCRIPTION
+Sends frames from one CAN device to another through the DevIO interface
+with one of a set of standard load profiles and reports the frame rate,
+bus load, CPU time per frame, delivery latency percentiles and the frames
+lost on the way, together with the DevIO statistics of both channels.
+
+	canbench [profile [seconds [txDevice [rxDevice [baud]]]]]
+
+defaults to "full 10 /can/0 /can/1 1000000". The profiles are:
+
+	full	back to back 8 byte data frames, 100% bus load
+	mixdlc	back to back extended frames, DLC 0 to 8 in turn
+	rtr	back to back extended remote frames
+	burst	bursts of 64 8 byte frames, 20 ms apart
+	filter	frames with 256 different IDs, the receiver subscribes to 16
+		of them with software filters
+
+The two devices must be on the same bus, e.g. both controllers of a board
+or of the simulated board, DRV_PR6120_CAN_SIM.
+
+Latency is measured from write() on the transmit channel to the return of
+read() on the receive channel with CLOCK_MONOTONIC, whose resolution is
+reported; it is usually the system clock period. CPU time is measured with
+a spin loop at the lowest priority that is calibrated before the run, so
+it includes the time spent in the driver, its interrupts and other tasks.
+Bus load is computed from the nominal frame length without stuff bits,
+over the time until the last frame arrived.
+A latency percentile is the upper bound of its BENCH_HIST_US histogram
+bucket, but at most the largest latency measured.
+
+The program exits with 1 if a frame was lost or a sequence gap seen, or
+if the full profile kept the bus less than 90 % busy, 0 otherwise. can/host builds it for Linux against the simulated board and
+runs it in "make test", so a regression of the driver shows up there
+before the hardware is tested; the idle loop then runs with SCHED_IDLE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <ioLib.h>
+#include <sys/select.h>
+#include <errno.h>
+#include "can.h"
+
+#define BENCH_BATCH		8		/* frames per write() */
+#define BENCH_READ_MAX		64		/* frames per read() */
+#define BENCH_RBUF_SIZE		256		/* receive buffer, #msgs */
+#define BENCH_WBUF_SIZE		256		/* transmit buffer, #msgs */
+#define BENCH_DRAIN_MS		500		/* wait for late frames */
+
+#define BENCH_EXT_BASE		0x1000000	/* extended IDs carry the seq# */
+#define BENCH_STD_BASE		0x100
+
+#define BENCH_HIST_US		10		/* latency histogram bucket */
+#define BENCH_HIST_SIZE		20000		/* buckets, 200 ms */
+
+typedef struct BenchProfile{
+	const char *name;
+	BOOL ext;		/* extended frames */
+	BOOL rtr;		/* remote frames */
+	BOOL mixDlc;		/* DLC 0..8 in turn, else 8 */
+	int burst;		/* frames per burst, 0 = continuous */
+	int burstGapMs;		/* pause after a burst */
+	int numIds;		/* IDs sent in turn */
+	int subscribed;		/* IDs the receiver filters for, 0 = all */
+	int minLoad;		/* bus load in % the run must reach, 0 = any */
+}BenchProfile_t;
+
+typedef struct BenchPort{
+	int fdCtr;
+	int fdTx;
+	int fdRx;
+}BenchPort_t;
+
+static const BenchProfile_t profiles[]={
+	{"full",	FALSE,	FALSE,	FALSE,	0,	0,	1,	0,	90},
+	{"mixdlc",	TRUE,	FALSE,	TRUE,	0,	0,	1,	0,	0},
+	{"rtr",		TRUE,	TRUE,	TRUE,	0,	0,	1,	0,	0},
+	{"burst",	FALSE,	FALSE,	FALSE,	64,	20,	1,	0,	0},
+	{"filter",	FALSE,	FALSE,	FALSE,	0,	0,	256,	16,	0},
+};
+
+static const BenchProfile_t *prof;
+static BenchPort_t txPort;
+static BenchPort_t rxPort;
+
+static volatile BOOL stopTx=FALSE;
+static volatile BOOL stopRx=FALSE;
+static volatile BOOL stopIdle=FALSE;
+static volatile unsigned long idleCount;
+static BOOL idleValid=TRUE;		/* the idle loop runs below all */
+
+/* send time by seq#, written by the sender before the frame leaves */
+static unsigned long long sendNs[0x10000];
+
+static unsigned long framesSent;
+static unsigned long framesExpected;	/* sent and passing the filters */
+static unsigned long long bitsSent;
+static unsigned long framesRcvd;
+static unsigned long seqGaps;
+static unsigned int latHist[BENCH_HIST_SIZE+1];
+static unsigned long long latMaxNs;
+static unsigned long long lastRxNs;	/* the last frame arrived */
+
+static unsigned long long NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+static BOOL Subscribed(int ndx)
+{
+	if(prof->subscribed==0)
+		return TRUE;
+	return (ndx % (prof->numIds/prof->subscribed))==0;
+}
+
+static void BuildFrame(WNCAN_CHNMSG *pMsg, unsigned long seq)
+{
+	int i;
+	int ndx=seq % prof->numIds;
+
+	memset(pMsg, 0, sizeof(*pMsg));
+	pMsg->extId=prof->ext;
+	pMsg->rtr=prof->rtr;
+	pMsg->len=prof->mixDlc ? seq % 9 : 8;
+
+	/* the seq# is in the ID of extended frames, else in the data */
+	if(prof->ext)
+	{
+		pMsg->id=BENCH_EXT_BASE | (seq & 0xffff);
+	}
+	else
+	{
+		pMsg->id=BENCH_STD_BASE + ndx;
+		pMsg->data[0]=(UCHAR)(seq>>8);
+		pMsg->data[1]=(UCHAR)seq;
+		for(i=2;i<8;i++)
+			pMsg->data[i]=(UCHAR)(0x55+i);
+	}
+}
+
+static unsigned int FrameBits(const WNCAN_CHNMSG *pMsg)
+{
+	/* SOF to EOF plus interframe space, without stuff bits */
+	return (pMsg->extId ? 67 : 47) + (pMsg->rtr ? 0 : 8*pMsg->len);
+}
+
+static int FrameSeq(const WNCAN_CHNMSG *pMsg)
+{
+	if(pMsg->extId)
+		return pMsg->id & 0xffff;
+	if(pMsg->len<2)
+		return -1;
+	return (pMsg->data[0]<<8) | pMsg->data[1];
+}
+
+static void* Sender(void *pdata)
+{
+	WNCAN_CHNMSG msg[BENCH_BATCH];
+	fd_set writeFds;
+	struct timeval tv;
+	struct timespec gap;
+	unsigned long long now;
+	int inBurst=0;
+	int i,n;
+
+	while(!stopTx)
+	{
+		FD_ZERO(&writeFds);
+		FD_SET(txPort.fdTx, &writeFds);
+		tv.tv_sec=0;
+		tv.tv_usec=100000;
+		if(select(txPort.fdTx+1, NULL, &writeFds, NULL, &tv)<=0)
+			continue;
+
+		n=BENCH_BATCH;
+		if(prof->burst && (prof->burst-inBurst)<n)
+			n=prof->burst-inBurst;
+		for(i=0;i<n;i++)
+			BuildFrame(&msg[i], framesSent+i);
+
+		now=NowNs();
+		for(i=0;i<n;i++)
+			sendNs[(framesSent+i) & 0xffff]=now;
+
+		n=write(txPort.fdTx, (char*)msg, n*sizeof(WNCAN_CHNMSG));
+		if(n<0)
+		{
+			printf("write failed with error %d - %s\n",errno,strerror(errno));
+			break;
+		}
+		n/=sizeof(WNCAN_CHNMSG);
+
+		for(i=0;i<n;i++)
+		{
+			bitsSent+=FrameBits(&msg[i]);
+			if(Subscribed((framesSent+i) % prof->numIds))
+				framesExpected++;
+		}
+		framesSent+=n;
+
+		inBurst+=n;
+		if(prof->burst && inBurst>=prof->burst)
+		{
+			inBurst=0;
+			gap.tv_sec=0;
+			gap.tv_nsec=prof->burstGapMs*1000000L;
+			nanosleep(&gap, NULL);
+		}
+	}
+	return NULL;
+}
+
+static void* Receiver(void *pdata)
+{
+	WNCAN_CHNMSG msg[BENCH_READ_MAX];
+	fd_set readFds;
+	struct timeval tv;
+	unsigned long long now,lat;
+	int expect=-1;
+	int i,n,seq;
+
+	while(!stopRx)
+	{
+		FD_ZERO(&readFds);
+		FD_SET(rxPort.fdRx, &readFds);
+		tv.tv_sec=0;
+		tv.tv_usec=100000;
+		if(select(rxPort.fdRx+1, &readFds, NULL, NULL, &tv)<=0)
+			continue;
+
+		n=read(rxPort.fdRx, (char*)msg, sizeof(msg));
+		now=NowNs();
+		if(n<=0)
+			continue;
+		lastRxNs=now;
+		n/=sizeof(WNCAN_CHNMSG);
+
+		for(i=0;i<n;i++)
+		{
+			framesRcvd++;
+			seq=FrameSeq(&msg[i]);
+			if(seq<0)
+				continue;
+
+			/* frames the filter drops are not gaps */
+			if(expect>=0 && seq!=expect && prof->subscribed==0)
+				seqGaps++;
+			expect=(seq+1) & 0xffff;
+
+			lat=now-sendNs[seq];
+			if(lat>latMaxNs)
+				latMaxNs=lat;
+			lat/=1000*BENCH_HIST_US;
+			latHist[lat<BENCH_HIST_SIZE ? lat : BENCH_HIST_SIZE]++;
+		}
+	}
+	return NULL;
+}
+
+static void* IdleLoop(void *pdata)
+{
+	while(!stopIdle)
+		idleCount++;
+	return NULL;
+}
+
+static unsigned long LatPercentile(double pct)
+{
+	unsigned long long total=0,want,sum=0;
+	int i;
+
+	for(i=0;i<=BENCH_HIST_SIZE;i++)
+		total+=latHist[i];
+	if(total==0)
+		return 0;
+
+	want=(unsigned long long)(total*pct/100.0);
+	for(i=0;i<=BENCH_HIST_SIZE;i++)
+	{
+		sum+=latHist[i];
+		if(sum>want)
+			break;
+	}
+	/* the upper bound of the bucket, but no more than was measured */
+	if((unsigned long long)(i+1)*BENCH_HIST_US > latMaxNs/1000)
+		return (unsigned long)(latMaxNs/1000);
+	return (unsigned long)(i+1)*BENCH_HIST_US;
+}
+
+static void SetBaudRate(WNCAN_CONFIG *cfg, int baud)
+{
+	ULONG sysClkFreq;
+	ULONG ui;
+
+	sysClkFreq = cfg->info.xtalfreq/2; /* CDR default to 0 */
+
+	cfg->bittiming.oversample = FALSE;
+	cfg->bittiming.sjw = 0;
+	cfg->bittiming.tseg1 = 4;
+	cfg->bittiming.tseg2 = 1;
+
+	ui = (cfg->bittiming.tseg1+1)+(cfg->bittiming.tseg2+1)+1;
+
+	cfg->bittiming.brp = sysClkFreq/ui/baud-1;
+}
+
+static int OpenPort(BenchPort_t *pPort, const char *fn, int baud, BOOL rx)
+{
+	WNCAN_CONFIG devcfg;
+	WNCAN_CHNCONFIG chncfg;
+	WNCAN_FILTER filter;
+	UCHAR chan;
+	char chfn[128];
+	int i;
+
+	pPort->fdCtr=open(fn,O_RDWR,0);
+	if(pPort->fdCtr==ERROR)
+	{
+		printf("Open %s failed with error %d - %s\n",fn,errno,strerror(errno));
+		return -1;
+	}
+
+	devcfg.flags = WNCAN_CFG_INFO | WNCAN_CFG_GBLFILTER | WNCAN_CFG_BITTIMING;
+	if(ioctl(pPort->fdCtr, WNCAN_CONFIG_GET, (int)&devcfg) != OK)
+		return -1;
+
+	/* accept all frames in hardware */
+	devcfg.flags = WNCAN_CFG_GBLFILTER | WNCAN_CFG_BITTIMING;
+	devcfg.filter.mask = 0;
+	devcfg.filter.extended = prof->ext;
+	SetBaudRate(&devcfg, baud);
+	if(ioctl(pPort->fdCtr, WNCAN_CONFIG_SET, (int)&devcfg) != OK)
+		return -1;
+
+	if(ioctl(pPort->fdCtr, rx ? WNCAN_RXCHAN_GET : WNCAN_TXCHAN_GET,
+			(int)&chan) != OK)
+		return -1;
+
+	sprintf(chfn,"%s/%d",fn,chan);
+	if(rx)
+	{
+		pPort->fdRx=open(chfn,O_RDONLY,0);
+		if(pPort->fdRx==ERROR)
+			return -1;
+
+		ioctl(pPort->fdRx, FIORBUFSET, BENCH_RBUF_SIZE);
+
+		chncfg.flags = WNCAN_CHNCFG_CHANNEL;
+		chncfg.channel.id = 0;
+		chncfg.channel.extId = prof->ext;
+		chncfg.channel.len = 0;
+		if(ioctl(pPort->fdRx, WNCAN_CHNCONFIG_SET, (int)&chncfg) != OK)
+			return -1;
+
+		for(i=0;prof->subscribed && i<prof->numIds;i++)
+		{
+			if(!Subscribed(i))
+				continue;
+			filter.type = WNCAN_FILTER_ID;
+			filter.frames = WNCAN_FILTER_STD;
+			filter.id = BENCH_STD_BASE + i;
+			filter.mask = 0;
+			if(ioctl(pPort->fdRx, WNCAN_CHNFILTER_ADD, (int)&filter) != OK)
+				return -1;
+		}
+
+		ioctl(pPort->fdRx, WNCAN_CHN_ENABLE, TRUE);
+		ioctl(pPort->fdRx, WNCAN_STATS_CLEAR, 0);
+	}
+	else
+	{
+		pPort->fdTx=open(chfn,O_WRONLY,0);
+		if(pPort->fdTx==ERROR)
+			return -1;
+
+		/* room for the frames written while the TX interrupts drain it */
+		ioctl(pPort->fdTx, FIOWBUFSET, BENCH_WBUF_SIZE);
+
+		/* remote frames are selected per channel, not per message */
+		chncfg.flags = WNCAN_CHNCFG_RTR;
+		chncfg.rtr = prof->rtr;
+		if(ioctl(pPort->fdTx, WNCAN_CHNCONFIG_SET, (int)&chncfg) != OK)
+			return -1;
+
+		ioctl(pPort->fdTx, WNCAN_CHN_ENABLE, TRUE);
+		ioctl(pPort->fdTx, WNCAN_STATS_CLEAR, 0);
+	}
+
+	ioctl(pPort->fdCtr, WNCAN_HALT, FALSE);
+	return 0;
+}
+
+static void ClosePort(BenchPort_t *pPort, BOOL rx)
+{
+	ioctl(pPort->fdCtr, WNCAN_HALT, TRUE);
+	close(rx ? pPort->fdRx : pPort->fdTx);
+	close(pPort->fdCtr);
+}
+
+static int StartThread(pthread_t *pThread, void *(*rtn)(void*), BOOL idle)
+{
+	pthread_attr_t attr;
+	struct sched_param param;
+	int rc;
+
+	pthread_attr_init(&attr);
+	if(idle)
+	{
+		/* below everything else, it only runs when the CPU is idle */
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+#ifdef SCHED_IDLE
+		/* Linux, where SCHED_FIFO is above all normal threads */
+		pthread_attr_setschedpolicy(&attr, SCHED_IDLE);
+		param.sched_priority=0;
+#else
+		pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		param.sched_priority=sched_get_priority_min(SCHED_FIFO);
+#endif
+		pthread_attr_setschedparam(&attr, &param);
+	}
+	rc=pthread_create(pThread, &attr, rtn, NULL);
+	pthread_attr_destroy(&attr);
+
+	/* the policy may need privileges the process does not have */
+	if(rc!=0 && idle)
+	{
+		printf("idle thread: %s, CPU time not measured\n", strerror(rc));
+		rc=pthread_create(pThread, NULL, rtn, NULL);
+		idleValid=FALSE;
+	}
+	return rc;
+}
+
+static void ShowStats(const char *what, int fd)
+{
+	WNCAN_STATS st;
+
+	if(ioctl(fd, WNCAN_STATS_GET, (int)&st) != OK)
+		return;
+	printf("  %s: rx %lu dropped %lu filtered %lu high water %lu, "
+			"tx %lu retries %lu dropped %lu, bus errors %lu bus-off %lu\n",
+			what, st.rxFrames, st.rxDropped, st.rxFiltered, st.rxHighWater,
+			st.txFrames, st.txRetries, st.txDropped, st.busErrors, st.busOff);
+}
+
+int main(int argc, char **argv)
+{
+	const char *profName="full";
+	const char *txDev="/can/0";
+	const char *rxDev="/can/1";
+	int seconds=10;
+	int baud=1000000;
+	pthread_t txThread,rxThread,idleThread;
+	struct timespec res,wait;
+	unsigned long long t0,t1,idleBase,idleRun;
+	double secs,busy,load;
+	int i;
+
+	if(argc>1) profName=argv[1];
+	if(argc>2) seconds=atoi(argv[2]);
+	if(argc>3) txDev=argv[3];
+	if(argc>4) rxDev=argv[4];
+	if(argc>5) baud=atoi(argv[5]);
+
+	for(i=0;i<(int)(sizeof(profiles)/sizeof(profiles[0]));i++)
+		if(strcmp(profiles[i].name,profName)==0)
+			prof=&profiles[i];
+	if(prof==NULL || seconds<=0 || baud<=0)
+	{
+		printf("usage: canbench [full|mixdlc|rtr|burst|filter "
+				"[seconds [txDevice [rxDevice [baud]]]]]\n");
+		return -1;
+	}
+
+	if(OpenPort(&rxPort, rxDev, baud, TRUE) || OpenPort(&txPort, txDev, baud, FALSE))
+	{
+		printf("CAN setup failed\n");
+		return -1;
+	}
+
+	/* calibrate the idle loop on an idle system */
+	if(StartThread(&idleThread, IdleLoop, TRUE))
+		return -1;
+	wait.tv_sec=1;
+	wait.tv_nsec=0;
+	idleBase=idleCount;
+	t0=NowNs();
+	nanosleep(&wait, NULL);
+	t1=NowNs();
+	idleBase=(idleCount-idleBase)*1000000000ULL/(t1-t0);
+
+	StartThread(&rxThread, Receiver, FALSE);
+	StartThread(&txThread, Sender, FALSE);
+
+	idleRun=idleCount;
+	t0=NowNs();
+	wait.tv_sec=seconds;
+	nanosleep(&wait, NULL);
+	stopTx=TRUE;
+	pthread_join(txThread, NULL);
+	t1=NowNs();
+	idleRun=idleCount-idleRun;
+
+	/* let the frames still queued arrive */
+	wait.tv_sec=0;
+	wait.tv_nsec=BENCH_DRAIN_MS*1000000L;
+	nanosleep(&wait, NULL);
+	stopRx=TRUE;
+	pthread_join(rxThread, NULL);
+	stopIdle=TRUE;
+	pthread_join(idleThread, NULL);
+
+	secs=(t1-t0)/1e9;
+	busy=(idleValid && idleBase) ? 1.0-(double)idleRun/(idleBase*secs) : 0;
+	if(busy<0)
+		busy=0;
+	clock_getres(CLOCK_MONOTONIC, &res);
+
+	printf("profile %s: %.1f s at %d bit/s, %s -> %s\n",
+			prof->name, secs, baud, txDev, rxDev);
+	printf("  sent %lu frames, received %lu of %lu, lost %lu, "
+			"sequence gaps %lu\n", framesSent, framesRcvd, framesExpected,
+			framesExpected>framesRcvd ? framesExpected-framesRcvd : 0,
+			seqGaps);
+	/* the frames still queued when the sender stopped took the bus later */
+	load=100.0*bitsSent/(((lastRxNs>t1 ? lastRxNs : t1)-t0)/1e9*baud);
+	printf("  %.0f frames/s, bus load %.1f %%\n", framesSent/secs, load);
+	printf("  latency us: p50 %lu p99 %lu p99.9 %lu max %llu "
+			"(resolution %ld ns)\n",
+			LatPercentile(50), LatPercentile(99), LatPercentile(99.9),
+			latMaxNs/1000, res.tv_nsec + res.tv_sec*1000000000L);
+	printf("  cpu %.1f %%, %.1f us per frame\n", 100.0*busy,
+			framesSent ? busy*secs*1e6/framesSent : 0.0);
+	ShowStats("tx channel", txPort.fdTx);
+	ShowStats("rx channel", rxPort.fdRx);
+
+	/* the sender did not keep the bus busy */
+	if(load<prof->minLoad)
+		printf("  bus load below %d %%, the run does not measure a full "
+				"bus\n", prof->minLoad);
+
+	ClosePort(&txPort, FALSE);
+	ClosePort(&rxPort, TRUE);
+	return (framesRcvd<framesExpected || seqGaps || load<prof->minLoad) ? 1 : 0;
+}
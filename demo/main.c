@@ -285,18 +285,32 @@ static void ReleaseUdpChannel(IOChannel_t *pCh)
 		
 static int CanRead(void *handle, char *buffer, size_t maxbytes)
 {
+	static const char *stateName[]={"active","warning","passive","bus off"};
 	WNCAN_CHNMSG rxdata;
-	WNCAN_BUSINFO businfo;
+	WNCAN_EVENT events[8];
 	struct fd_set readFds;
-	int n;
+	int n,i;
 	CanPort_t *port=(CanPort_t*)handle;
 	int fd=port->fdRx;
 	FD_ZERO(&readFds);
 	FD_SET(fd, &readFds);
-	select(fd+1, &readFds, NULL, NULL, NULL);
-	//ioctl(port->fdCtr, WNCAN_BUSINFO_GET, (int)&businfo);
-	//if(businfo.busStatus || businfo.busError)
-	//	return -1;	
+	FD_SET(port->fdCtr, &readFds);
+	select((fd>port->fdCtr ? fd : port->fdCtr)+1, &readFds, NULL, NULL, NULL);
+	
+	/* controller events are queued, no need to poll the bus state */
+	if(FD_ISSET(port->fdCtr, &readFds))
+	{
+		n=read(port->fdCtr, (char*)events, sizeof(events));
+		for(i=0; i<n/(int)sizeof(WNCAN_EVENT); i++)
+		{
+			if(events[i].type==WNCAN_EVENT_STATE)
+				LogMsg("CAN state %s (rx errors %d, tx errors %d)\n",
+					stateName[events[i].state&3],
+					events[i].rxErrCnt, events[i].txErrCnt);
+		}
+		if(!FD_ISSET(fd, &readFds))
+			return 0;
+	}
 	
 	n=read(fd, (char*)&rxdata, sizeof(rxdata));
 	if(n==0)